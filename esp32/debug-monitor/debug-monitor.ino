@@ -5,6 +5,10 @@
  * debug messages from the pedal receiver via ESP-NOW.
  * 
  * The receiver sends debug messages that are displayed on Serial (USB).
+ *
+ * Serial commands:
+ *   d - ask the receiver for its flight recorder log ("FLT ..." lines, decode with
+ *       tools/flightlog_decode.py)
  */
 
 #include <Arduino.h>
@@ -21,6 +25,7 @@ static bool discoveryMode = true;
 static unsigned long lastDiscoverySend = 0;
 
 static bool gotAnyDebugMessage = false;
+static uint8_t receiverMAC[6];  // Sender of the first debug message
 
 #define DISCOVERY_SEND_INTERVAL 3000     // Send discovery every 3 seconds
 
@@ -38,12 +43,6 @@ static volatile int g_queueWriteIndex = 0;
 static volatile int g_queueReadIndex = 0;
 static volatile int g_queueCount = 0;
 
-// Debug monitor discovery request (receiver only checks msgType).
-typedef struct __attribute__((packed)) debug_monitor_req_message {
-  uint8_t msgType;        // MSG_DEBUG_MONITOR_REQ
-  uint8_t reserved[3];
-} debug_monitor_req_message;
-
 // Queue a formatted message line (called from ESP-NOW callback - must be fast/non-blocking)
 static bool queueMessage(const char* formattedLine) {
   // Check if queue is full (atomic check)
@@ -126,6 +125,9 @@ static void onMessageReceived(const uint8_t* senderMAC, const uint8_t* data, int
   // Queue the formatted line (non-blocking, fast)
   queueMessage(formattedLine);
 
+  if (!gotAnyDebugMessage) {
+    memcpy(receiverMAC, senderMAC, 6);
+  }
   gotAnyDebugMessage = true;
   discoveryMode = false;
 }
@@ -135,6 +137,25 @@ static void sendDiscoveryRequest() {
   espNowTransport_broadcast(&g_transport, (uint8_t*)&req, sizeof(req));
 }
 
+static void requestFlightLog() {
+  if (!gotAnyDebugMessage) {
+    queueMessage("[SYSTEM] No receiver yet - flight log request not sent\r\n");
+    return;
+  }
+  flight_log_req_message req = {MSG_FLIGHT_LOG_REQ, {0, 0, 0}};
+  espNowTransport_send(&g_transport, receiverMAC, (uint8_t*)&req, sizeof(req));
+  queueMessage("[SYSTEM] Flight log requested\r\n");
+}
+
+static void processSerialCommands() {
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    if (c == 'd' || c == 'D') {
+      requestFlightLog();
+    }
+  }
+}
+
 static void startDiscovery() {
   discoveryMode = true;
   lastDiscoverySend = 0;
@@ -183,6 +204,7 @@ void loop() {
   // Process queued messages first (print from main loop, not callback)
   bool hadMessages = (g_queueCount > 0);
   processMessageQueue();
+  processSerialCommands();
 
   if (discoveryMode) {
     // Keep sending discovery requests periodically (receiver may come online later)
@@ -211,4 +233,7 @@ void loop() {
 
 // Arduino IDE doesn't automatically compile shared .cpp files outside the sketch folder.
 // Include the transport implementation directly so the debug monitor shares the same ESP-NOW code.
+#include "../shared/domain/PeerCache.cpp"
+#include "../shared/infrastructure/EspNowPeers.cpp"
 #include "../shared/infrastructure/EspNowTransport.cpp"
+#include "../shared/infrastructure/Scheduler.cpp"
@@ -8,6 +8,7 @@
 
 // Clean Architecture: Include shared and domain modules
 #include "shared/messages.h"
+#include "shared/config.h"
 #include "shared/debug_format.h"
 #include "shared/domain/PairingState.h"
 #include "shared/domain/PedalReader.h"
@@ -20,6 +21,8 @@ void IRAM_ATTR debugToggleISR();
 #include "shared/infrastructure/EspNowTransport.h"
 #include "shared/application/PairingService.h"
 #include "shared/application/PedalService.h"
+#include "shared/application/ExpressionService.h"
+#include "shared/infrastructure/Scheduler.h"
 
 // ============================================================================
 // CONFIGURATION
@@ -30,10 +33,9 @@ void IRAM_ATTR debugToggleISR();
 
 #define PEDAL_1_PIN 13
 #define PEDAL_2_PIN 14
+#define EXPRESSION_PIN -1  // ADC1 pin of an expression pedal (e.g. 36 = A0), -1 = none
 #define DEBUG_PIN 27  // GPIO 27 (A5) - Ground this pin to enable debug output
 #define INACTIVITY_TIMEOUT 300000  // 5 minutes
-#define IDLE_DELAY_PAIRED 50  // 50ms delay when paired (reduced from 20ms since we don't poll GPIO anymore)
-#define IDLE_DELAY_UNPAIRED 200  // 200ms delay when not paired
 
 // Domain layer instances
 PairingState pairingState;
@@ -43,11 +45,19 @@ EspNowTransport transport;
 // Application layer instances
 PairingService pairingService;
 PedalService pedalService;
+ExpressionService expressionService;
 
 // System state
 unsigned long lastActivityTime = 0;
 unsigned long bootTime = 0;
 
+// Loop scheduling - the loop sleeps until the next deadline or an interrupt/ESP-NOW frame
+Scheduler scheduler;
+int inactivityTimer = -1;
+int pairingTimer = -1;
+int keepaliveTimer = -1;
+int expressionTimer = -1;
+
 // Debug support - toggle via GPIO27 button press
 volatile bool debugToggleFlag = false;
 bool debugEnabled = false;
@@ -56,6 +66,7 @@ Preferences debugPreferences; // NVS for storing debug state
 
 void IRAM_ATTR debugToggleISR() {
   debugToggleFlag = true;
+  scheduler_wakeFromISR(g_scheduler);
 }
 
 // Use shared utilities for debug/serial output
@@ -307,7 +318,7 @@ void onMessageReceived(const uint8_t* senderMAC, const uint8_t* data, int len, u
   
   if (pairingState_isPaired(&pairingState)) {
     // Already paired - check if message is from our paired receiver
-    if (memcmp(senderMAC, pairingState.pairedReceiverMAC, 6) == 0) {
+    if (macEqual(senderMAC, pairingState.pairedReceiverMAC)) {
       // Message from our paired receiver - handle MSG_ALIVE to send discovery request
       if (msg->msgType == MSG_ALIVE) {
         if (debugEnabled) {
@@ -364,12 +375,55 @@ void onMessageReceived(const uint8_t* senderMAC, const uint8_t* data, int len, u
 
 void goToDeepSleep() {
   if (debugEnabled) {
+    uint32_t rate = scheduler_wakeupsPerSecondX10(&scheduler);
+    Serial.printf("Loop wakeups: %lu.%lu/s (%lu timer, %lu event)\n",
+                  (unsigned long)(rate / 10), (unsigned long)(rate % 10),
+                  (unsigned long)scheduler.timerWakeups, (unsigned long)scheduler.eventWakeups);
     Serial.println("Going to deep sleep...");
   }
   esp_sleep_enable_ext0_wakeup((gpio_num_t)PEDAL_1_PIN, LOW);
   esp_deep_sleep_start();
 }
 
+static bool isPedalPressed() {
+  bool pedalPressed = (digitalRead(PEDAL_1_PIN) == LOW);
+  if (PEDAL_MODE == 0) {  // DUAL mode
+    bool rightPedalPressed = (digitalRead(PEDAL_2_PIN) == LOW);
+    pedalPressed = pedalPressed || rightPedalPressed;
+  }
+  return pedalPressed;
+}
+
+// Enter deep sleep after INACTIVITY_TIMEOUT without activity. Activity only moves
+// lastActivityTime; the timer re-arms itself from it when it fires early.
+static void onInactivityTimer(void* context, unsigned long now) {
+  // CRITICAL: a held pedal counts as activity, so the timer never runs out mid-press
+  if (isPedalPressed()) {
+    onActivity();
+  }
+  
+  unsigned long timeSinceActivity = now - lastActivityTime;
+  if (timeSinceActivity > INACTIVITY_TIMEOUT) {
+    if (debugEnabled) {
+      debugPrint("Inactivity timeout reached: %lu ms - entering deep sleep", timeSinceActivity);
+    }
+    goToDeepSleep();
+  }
+  scheduler_arm(&scheduler, inactivityTimer, lastActivityTime + INACTIVITY_TIMEOUT + 1);
+}
+
+static void onPairingTimer(void* context, unsigned long now) {
+  if (pairingService_checkDiscoveryTimeout(&pairingService, now)) {
+    if (debugEnabled) {
+      Serial.println("Discovery response timeout");
+    }
+  }
+}
+
+static void onExpressionTimer(void* context, unsigned long now) {
+  expressionService_sample(&expressionService, now);
+}
+
 void setup() {
   // Always initialize Serial first
   Serial.begin(115200);
@@ -420,6 +474,14 @@ void setup() {
   bootTime = millis();
   lastActivityTime = millis();
   
+  // Scheduler before interrupts, so the ISRs can wake the loop
+  scheduler_init(&scheduler);
+  g_scheduler = &scheduler;
+  inactivityTimer = scheduler_addTimer(&scheduler, onInactivityTimer, NULL);
+  pairingTimer = scheduler_addTimer(&scheduler, onPairingTimer, NULL);
+  keepaliveTimer = scheduler_addTimer(&scheduler, NULL, NULL);  // Wake only - pedalService_update() sends it
+  scheduler_arm(&scheduler, inactivityTimer, lastActivityTime + INACTIVITY_TIMEOUT + 1);
+  
   // Check wakeup cause to determine if we woke from deep sleep
   esp_sleep_wakeup_cause_t wakeupCause = esp_sleep_get_wakeup_cause();
   bool wokeFromDeepSleep = (wakeupCause == ESP_SLEEP_WAKEUP_EXT0 || wakeupCause == ESP_SLEEP_WAKEUP_EXT1);
@@ -436,7 +498,7 @@ void setup() {
     size_t macLen = preferences.getBytes("pairedMAC", savedMAC, 6);
     preferences.end();
     
-    if (macLen == 6 && !macEqual(savedMAC, (uint8_t[6]){0,0,0,0,0,0})) {
+    if (macLen == 6 && !macIsZero(savedMAC)) {
       // Restore paired state from NVS (only after deep sleep wakeup)
       memcpy(pairingState.pairedReceiverMAC, savedMAC, 6);
       pairingState.isPaired = true;
@@ -494,6 +556,13 @@ void setup() {
   pedalService.onActivity = onActivity;
   pedalService_setPairingService(&pairingService);
   
+  // Expression pedal: sampled at EXPRESSION_SAMPLE_HZ for as long as the transmitter is awake
+  if (EXPRESSION_PIN >= 0) {
+    expressionService_init(&expressionService, EXPRESSION_PIN, 0, &pairingState, &transport, &lastActivityTime);
+    expressionTimer = scheduler_addTimer(&scheduler, onExpressionTimer, NULL);
+    scheduler_armPeriodic(&scheduler, expressionTimer, millis(), EXPRESSION_SAMPLE_INTERVAL_MS);
+  }
+  
   // CRITICAL: If we restored pairing from NVS, add the peer now so pedal events can be sent
   if (pairingState_isPaired(&pairingState)) {
     bool peerAdded = espNowTransport_addPeer(&transport, pairingState.pairedReceiverMAC, 0);
@@ -518,6 +587,9 @@ void setup() {
 void loop() {
   unsigned long currentTime = millis();
   
+  // Timers that are due (inactivity, pairing timeouts)
+  scheduler_run(&scheduler, currentTime);
+  
   // Check if debug toggle button was pressed
   if (debugToggleFlag) {
     debugToggleFlag = false;
@@ -568,63 +640,30 @@ void loop() {
   // This must be done in main loop, not in callback context
   pairingService_processPendingDiscovery(&pairingService);
   
-  // Check discovery timeout
-  if (pairingService_checkDiscoveryTimeout(&pairingService, currentTime)) {
-    if (debugEnabled) {
-      Serial.println("Discovery response timeout");
-    }
-  }
-  
-  // CRITICAL: Check if pedal is currently pressed and reset activity timer
-  // This prevents the timer from counting up while pedal is held down
-  bool pedalPressed = (digitalRead(PEDAL_1_PIN) == LOW);
-  if (PEDAL_MODE == 0) {  // DUAL mode
-    bool rightPedalPressed = (digitalRead(PEDAL_2_PIN) == LOW);
-    pedalPressed = pedalPressed || rightPedalPressed;
-  }
-  
-  if (pedalPressed) {
-    // Pedal is currently pressed - reset activity timer to prevent sleep
-    onActivity();
-  }
+  // Update pedal service only when interrupts occur or a keepalive is due
+  // This eliminates unnecessary polling - pedalService_update() checks internally
+  pedalService_update(&pedalService);
   
-  // Check inactivity timeout and enter deep sleep if inactive for 5 minutes
-  unsigned long timeSinceActivity = currentTime - lastActivityTime;
-  if (timeSinceActivity > INACTIVITY_TIMEOUT) {
-    // Don't go to sleep if pedal is currently pressed
-    if (pedalPressed) {
-      onActivity();
-    } else {
-      if (debugEnabled) {
-        debugPrint("Inactivity timeout reached: %lu ms - entering deep sleep", timeSinceActivity);
-      }
-      goToDeepSleep();
-    }
-  }
+  // Deadlines that depend on what just happened
+  currentTime = millis();
+  scheduler_armIn(&scheduler, pairingTimer, currentTime, pairingService_timeUntilNextMs(&pairingService, currentTime));
+  scheduler_armIn(&scheduler, keepaliveTimer, currentTime, pedalService_timeUntilNextMs(&pedalService, currentTime));
   
-  // Update pedal service only when interrupts occur or debouncing needs checking
-  // This eliminates unnecessary polling - pedalService_update() checks internally
-  bool hasWork = pedalService_update(&pedalService);
-  
-  // Battery optimization: Use shorter delay when debouncing (needs frequent checks)
-  // or longer delay when idle (nothing to do)
-  if (hasWork) {
-    // Debouncing in progress - check frequently
-    delay(20);
-  } else if (pairingState_isPaired(&pairingState)) {
-    // Paired and idle - can sleep longer
-    delay(100);
-  } else {
-    // Unpaired and idle - even longer delay
-    delay(IDLE_DELAY_UNPAIRED);
-  }
+  // Battery optimization: sleep until the next deadline; pedal/debug interrupts and
+  // ESP-NOW frames wake the loop early
+  scheduler_sleep(&scheduler, LOOP_MAX_SLEEP_MS);
 }
 
 // Include implementation files (Arduino IDE doesn't auto-compile .cpp files in subdirectories)
 #include "shared/domain/PairingState.cpp"
 #include "shared/domain/PedalReader.cpp"
 #include "shared/debug_format.cpp"
+#include "shared/domain/PeerCache.cpp"
+#include "shared/infrastructure/EspNowPeers.cpp"
 #include "shared/infrastructure/EspNowTransport.cpp"
+#include "shared/infrastructure/Scheduler.cpp"
 #include "shared/infrastructure/TransmitterUtils.cpp"
 #include "shared/application/PairingService.cpp"
 #include "shared/application/PedalService.cpp"
+#include "shared/domain/ExpressionCodec.cpp"
+#include "shared/application/ExpressionService.cpp"
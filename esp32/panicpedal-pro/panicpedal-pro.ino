@@ -18,6 +18,7 @@
 #include "shared/infrastructure/EspNowTransport.h"
 #include "shared/application/PairingService.h"
 #include "shared/application/PedalService.h"
+#include "shared/infrastructure/Scheduler.h"
 
 // ============================================================================
 // CONFIGURATION
@@ -174,11 +175,10 @@ void IRAM_ATTR debugButtonISR() {
   // Just set flag - no other operations
   // Must return immediately - no delays, no Serial, no other operations
   debugButtonInterruptFlag = true;
+  scheduler_wakeFromISR(g_scheduler);
 }
 
 #define INACTIVITY_TIMEOUT 300000  // 5 minutes of inactivity before deep sleep
-#define IDLE_DELAY_PAIRED 10       // 10ms delay when paired and idle
-#define IDLE_DELAY_UNPAIRED 200    // 200ms delay when not paired (longer to save power)
 
 // Domain layer instances
 PairingState pairingState;
@@ -193,6 +193,12 @@ PedalService pedalService;
 unsigned long lastActivityTime = 0;
 unsigned long bootTime = 0;
 
+// Loop scheduling - the loop sleeps until the next deadline or an interrupt/ESP-NOW frame
+Scheduler scheduler;
+int inactivityTimer = -1;
+int pairingTimer = -1;
+int keepaliveTimer = -1;
+
 // Forward declarations
 void onMessageReceived(const uint8_t* senderMAC, const uint8_t* data, int len, uint8_t channel);
 void onPaired(const uint8_t* receiverMAC);
@@ -397,7 +403,7 @@ void onMessageReceived(const uint8_t* senderMAC, const uint8_t* data, int len, u
   
   if (pairingState_isPaired(&pairingState)) {
     // Already paired - check if message is from our paired receiver
-    if (memcmp(senderMAC, pairingState.pairedReceiverMAC, 6) == 0) {
+    if (macEqual(senderMAC, pairingState.pairedReceiverMAC)) {
       // Message from our paired receiver
       if (msg->msgType == MSG_ALIVE) {
         debugPrint("Received MSG_ALIVE from paired receiver - calling handleAlive");
@@ -576,6 +582,49 @@ void goToDeepSleep() {
   // Code never reaches here - device enters deep sleep
 }
 
+static bool isPedalPressed() {
+  bool pedalPressed = (digitalRead(PEDAL_LEFT_NO_PIN) == LOW);
+  if (pedalReader.pedalMode == 0) {  // DUAL mode
+    bool rightPedalPressed = (digitalRead(PEDAL_RIGHT_NO_PIN) == LOW);
+    pedalPressed = pedalPressed || rightPedalPressed;
+  }
+  return pedalPressed;
+}
+
+// Enter deep sleep after INACTIVITY_TIMEOUT without activity. Activity only moves
+// lastActivityTime; the timer re-arms itself from it when it fires early.
+static void onInactivityTimer(void* context, unsigned long now) {
+  // CRITICAL: a held pedal counts as activity, so the timer never runs out mid-press
+  if (isPedalPressed() || lastActivityTime == 0) {
+    onActivity();
+  }
+  
+  unsigned long timeSinceActivity = now - lastActivityTime;
+  if (timeSinceActivity > INACTIVITY_TIMEOUT) {
+    uint32_t rate = scheduler_wakeupsPerSecondX10(&scheduler);
+    debugPrint("Loop wakeups: %lu.%lu/s (%lu timer, %lu event)", (unsigned long)(rate / 10),
+               (unsigned long)(rate % 10), (unsigned long)scheduler.timerWakeups,
+               (unsigned long)scheduler.eventWakeups);
+    debugPrint("Inactivity timeout reached: %lu ms - entering deep sleep", timeSinceActivity);
+    goToDeepSleep();
+  }
+  scheduler_arm(&scheduler, inactivityTimer, lastActivityTime + INACTIVITY_TIMEOUT + 1);
+}
+
+static void onPairingTimer(void* context, unsigned long now) {
+  if (pairingService_checkDiscoveryTimeout(&pairingService, now)) {
+    debugPrint("Discovery response timeout");
+  }
+  
+  // MSG_PAIRING_CONFIRMED was sent and no ACK arrived - send MSG_TRANSMITTER_ONLINE for discovery
+  if (pairingService_checkPairingConfirmedTimeout(&pairingService, now)) {
+    if (DEBUG_ENABLED) {
+      debugPrint("MSG_PAIRING_CONFIRMED timeout - no ACK received, sending MSG_TRANSMITTER_ONLINE");
+    }
+    pairingService_broadcastOnline(&pairingService);
+  }
+}
+
 void setup() {
   // CRITICAL: For ESP32-S3, you MUST enable USB CDC On Boot in Arduino IDE:
   // Tools > USB CDC On Boot > Enabled
@@ -652,6 +701,14 @@ void setup() {
   
   lastActivityTime = millis();
   
+  // Scheduler before interrupts and ESP-NOW, so their callbacks can wake the loop
+  scheduler_init(&scheduler);
+  g_scheduler = &scheduler;
+  inactivityTimer = scheduler_addTimer(&scheduler, onInactivityTimer, NULL);
+  pairingTimer = scheduler_addTimer(&scheduler, onPairingTimer, NULL);
+  keepaliveTimer = scheduler_addTimer(&scheduler, NULL, NULL);  // Wake only - pedalService_update() sends it
+  scheduler_arm(&scheduler, inactivityTimer, lastActivityTime + INACTIVITY_TIMEOUT + 1);
+  
   // Determine pedal mode
   uint8_t detectedMode = PEDAL_MODE;
   if (PEDAL_MODE == PEDAL_MODE_AUTO) {
@@ -674,7 +731,7 @@ void setup() {
     size_t macLen = preferences.getBytes("pairedMAC", savedMAC, 6);
     preferences.end();
     
-    if (macLen == 6 && !macEqual(savedMAC, (uint8_t[6]){0,0,0,0,0,0})) {
+    if (macLen == 6 && !macIsZero(savedMAC)) {
       // Restore paired state from NVS (only after deep sleep wakeup)
       memcpy(pairingState.pairedReceiverMAC, savedMAC, 6);
       pairingState.isPaired = true;
@@ -888,6 +945,9 @@ void setup() {
 void loop() {
   unsigned long currentTime = millis();
   
+  // Timers that are due (inactivity, pairing timeouts)
+  scheduler_run(&scheduler, currentTime);
+  
   // Process any pending discovery requests (deferred from ESP-NOW callback)
   // This must be done in main loop, not in callback context
   pairingService_processPendingDiscovery(&pairingService);
@@ -898,64 +958,8 @@ void loop() {
     debugPrint("%s", pendingDebugMessage);
   }
   
-  // Check discovery timeout
-  if (pairingService_checkDiscoveryTimeout(&pairingService, currentTime)) {
-    debugPrint("Discovery response timeout");
-  }
-  
-  // Check if MSG_PAIRING_CONFIRMED was sent and no ACK received within timeout
-  // If timeout occurred, send MSG_TRANSMITTER_ONLINE for discovery
-  if (pairingService.waitingForPairingConfirmedAck && pairingService.pairingConfirmedSentTime > 0) {
-    unsigned long timeSinceSent = currentTime - pairingService.pairingConfirmedSentTime;
-    if (timeSinceSent >= PAIRING_CONFIRMED_TIMEOUT_MS) {
-      // Timeout - no ACK received, send MSG_TRANSMITTER_ONLINE for discovery
-      pairingService.waitingForPairingConfirmedAck = false;
-      pairingService.pairingConfirmedSentTime = 0;
-      
-      if (DEBUG_ENABLED) {
-        debugPrint("MSG_PAIRING_CONFIRMED timeout - no ACK received, sending MSG_TRANSMITTER_ONLINE");
-      }
-      pairingService_broadcastOnline(&pairingService);
-    }
-  }
-  
-  // CRITICAL: Check if pedal is currently pressed and reset activity timer
-  // This prevents the timer from counting up while pedal is held down
-  bool pedalPressed = (digitalRead(PEDAL_LEFT_NO_PIN) == LOW);
-  if (pedalReader.pedalMode == 0) {  // DUAL mode
-    bool rightPedalPressed = (digitalRead(PEDAL_RIGHT_NO_PIN) == LOW);
-    pedalPressed = pedalPressed || rightPedalPressed;
-  }
-  
-  if (pedalPressed) {
-    // Pedal is currently pressed - reset activity timer to prevent sleep
-    onActivity();
-  }
-  
-  // Check inactivity timeout and enter deep sleep if inactive for 5 minutes
-  // Handle millis() wrap-around (happens after ~49 days) and ensure lastActivityTime is valid
-  unsigned long timeSinceActivity;
-  if (lastActivityTime == 0) {
-    // Not initialized yet - treat as just started
-    timeSinceActivity = 0;
-  } else if (currentTime >= lastActivityTime) {
-    timeSinceActivity = currentTime - lastActivityTime;
-  } else {
-    // Wrap-around case: calculate time since wrap (shouldn't happen in practice)
-    timeSinceActivity = ((unsigned long)-1 - lastActivityTime) + currentTime + 1;
-  }
-  if (timeSinceActivity > INACTIVITY_TIMEOUT) {
-    // Don't go to sleep if pedal is currently pressed
-    if (pedalPressed) {
-      onActivity();
-    } else {
-      debugPrint("Inactivity timeout reached: %lu ms - entering deep sleep", timeSinceActivity);
-    goToDeepSleep();
-  }
-  }
-  
-  // Update pedal service (only processes when interrupts occur)
-  bool hasWork = pedalService_update(&pedalService);
+  // Update pedal service (only processes when interrupts occur or a keepalive is due)
+  pedalService_update(&pedalService);
   
   // Process debug button interrupt (interrupt-driven, power optimized)
   if (debugButtonInterruptFlag) {
@@ -984,20 +988,24 @@ void loop() {
     }
   }
   
-  // Power-optimized idle loop: use longer delays when not paired (saves power)
-  if (!hasWork) {
-    bool isPaired = pairingState_isPaired(&pairingState);
-    delay(isPaired ? IDLE_DELAY_PAIRED : IDLE_DELAY_UNPAIRED);
-  } else {
-    yield();  // Work to do - process immediately
-  }
+  // Deadlines that depend on what just happened
+  currentTime = millis();
+  scheduler_armIn(&scheduler, pairingTimer, currentTime, pairingService_timeUntilNextMs(&pairingService, currentTime));
+  scheduler_armIn(&scheduler, keepaliveTimer, currentTime, pedalService_timeUntilNextMs(&pedalService, currentTime));
+  
+  // Power-optimized idle: sleep until the next deadline; pedal/debug interrupts and
+  // ESP-NOW frames wake the loop early
+  scheduler_sleep(&scheduler, LOOP_MAX_SLEEP_MS);
 }
 
 // Include implementation files (Arduino IDE doesn't auto-compile .cpp files in subdirectories)
 #include "shared/domain/PairingState.cpp"
 #include "shared/domain/PedalReader.cpp"
 #include "shared/debug_format.cpp"
+#include "shared/domain/PeerCache.cpp"
+#include "shared/infrastructure/EspNowPeers.cpp"
 #include "shared/infrastructure/EspNowTransport.cpp"
+#include "shared/infrastructure/Scheduler.cpp"
 #include "shared/infrastructure/TransmitterUtils.cpp"
 #include "shared/application/PairingService.cpp"
 #include "shared/application/PedalService.cpp"
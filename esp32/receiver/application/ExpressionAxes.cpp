@@ -0,0 +1,83 @@
+#include "ExpressionAxes.h"
+#include "../shared/config.h"
+#include <string.h>
+#include <stdio.h>
+
+void expressionAxes_init(ExpressionAxes* axes, KeyBindings* bindings) {
+  memset(axes, 0, sizeof(ExpressionAxes));
+  axes->bindings = bindings;
+}
+
+static ExpressionAxis* expressionAxes_find(ExpressionAxes* axes, int transmitterIndex, uint8_t input) {
+  for (int i = 0; i < axes->count; i++) {
+    if (axes->axes[i].transmitterIndex == transmitterIndex && axes->axes[i].input == input) {
+      return &axes->axes[i];
+    }
+  }
+  if (axes->count >= HID_GAMEPAD_AXES) {
+    return nullptr;
+  }
+  ExpressionAxis* axis = &axes->axes[axes->count++];
+  axis->transmitterIndex = (int8_t)transmitterIndex;
+  axis->input = input;
+  expressionDecoder_init(&axis->decoder);
+  return axis;
+}
+
+bool expressionAxes_handleFrame(ExpressionAxes* axes, MacAddr txMAC, const uint8_t* data, int len) {
+  axes->frames++;
+  
+  KeyBindingAction action;
+  if (len < 2 || !keyBindings_lookup(axes->bindings, txMAC, '1', &action)) {
+    axes->unassigned++;
+    return false;
+  }
+  ExpressionAxis* axis = expressionAxes_find(axes, action.transmitterIndex, EXPRESSION_INPUT(data[1]));
+  if (!axis) {
+    axes->unassigned++;
+    return false;
+  }
+  
+  if (!expressionDecoder_apply(&axis->decoder, data, len)) {
+    return false;
+  }
+  axes->report.axes[axis - axes->axes] = expressionDecoder_axis(&axis->decoder);
+  axes->dirty = true;
+  return true;
+}
+
+bool expressionAxes_forwardsLease(ExpressionAxes* axes, MacAddr txMAC, uint32_t nowMs) {
+  KeyBindingAction action;
+  if (!keyBindings_lookup(axes->bindings, txMAC, '1', &action)) {
+    return false;
+  }
+  int slot = action.transmitterIndex;
+  uint32_t bit = 1u << slot;
+  if ((axes->leaseForwarded & bit) && nowMs - axes->leaseForwardMs[slot] < EXPRESSION_LEASE_FORWARD_MS) {
+    return false;
+  }
+  axes->leaseForwarded |= bit;
+  axes->leaseForwardMs[slot] = nowMs;
+  return true;
+}
+
+bool expressionAxes_flush(ExpressionAxes* axes) {
+  if (!axes->dirty || !hidGamepad_send(&axes->report)) {
+    return false;
+  }
+  axes->dirty = false;
+  axes->reports++;
+  return true;
+}
+
+void expressionAxes_format(const ExpressionAxes* axes, char* buffer, size_t bufferSize) {
+  if (!buffer || bufferSize == 0) return;
+  
+  uint32_t missed = 0;
+  for (int i = 0; i < axes->count; i++) {
+    missed += axes->axes[i].decoder.missed;
+  }
+  snprintf(buffer, bufferSize, "%d axis/axes, %lu frame(s), %lu missed, %lu unassigned, %lu report(s)",
+           axes->count, (unsigned long)axes->frames, (unsigned long)missed,
+           (unsigned long)axes->unassigned, (unsigned long)axes->reports);
+}
@@ -0,0 +1,49 @@
+#ifndef EXPRESSION_AXES_H
+#define EXPRESSION_AXES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../domain/KeyBindings.h"
+#include "../infrastructure/HidGamepad.h"
+#include "../shared/domain/ExpressionCodec.h"
+
+// Expression pedal frames -> joystick axes. Each (transmitter slot, expression input) gets
+// the next free axis the first time it sends, and keeps it until reboot. Runs on the HID
+// output task; frames from unpaired transmitters are ignored.
+typedef struct {
+  int8_t transmitterIndex;
+  uint8_t input;
+  ExpressionDecoder decoder;
+} ExpressionAxis;
+
+typedef struct {
+  KeyBindings* bindings;
+  ExpressionAxis axes[HID_GAMEPAD_AXES];
+  int count;
+  HidGamepadReport report;
+  bool dirty;            // report changed since it was last sent
+  uint32_t leaseForwardMs[MAX_PEDAL_SLOTS];  // Last frame passed on, per transmitter slot
+  uint32_t leaseForwarded;                   // Bit per slot with a frame passed on
+
+  // Instrumentation
+  uint32_t frames;
+  uint32_t unassigned;   // Frames dropped: unpaired transmitter or no free axis
+  uint32_t reports;
+} ExpressionAxes;
+
+void expressionAxes_init(ExpressionAxes* axes, KeyBindings* bindings);
+
+// MSG_EXPRESSION_VALUE / MSG_EXPRESSION_DELTA; returns true if an axis moved
+bool expressionAxes_handleFrame(ExpressionAxes* axes, MacAddr txMAC, const uint8_t* data, int len);
+
+// True for the first frame from a paired transmitter and then at most once per
+// EXPRESSION_LEASE_FORWARD_MS: that frame goes on to the housekeeping task, the rest do not
+bool expressionAxes_forwardsLease(ExpressionAxes* axes, MacAddr txMAC, uint32_t nowMs);
+
+// Send the axes if they moved since the last report; returns true if one was sent
+bool expressionAxes_flush(ExpressionAxes* axes);
+
+void expressionAxes_format(const ExpressionAxes* axes, char* buffer, size_t bufferSize);
+
+#endif // EXPRESSION_AXES_H
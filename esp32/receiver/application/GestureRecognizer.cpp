@@ -0,0 +1,142 @@
+#include "GestureRecognizer.h"
+#include <string.h>
+#include "../shared/config.h"
+#include "../infrastructure/FlightRecorder.h"
+
+void gestureRecognizer_init(GestureRecognizer* recognizer, HidReportBuilder* report, KeySequencer* sequencer) {
+  memset(recognizer, 0, sizeof(GestureRecognizer));
+  recognizer->report = report;
+  recognizer->sequencer = sequencer;
+}
+
+bool gestureRecognizer_bind(GestureRecognizer* recognizer, const GestureBinding* binding) {
+  uint8_t c = (uint8_t)binding->primaryKey;
+  if (c == 0 || c >= 128) return false;
+
+  int index = gestureRecognizer_find(recognizer, binding->primaryKey);
+  if (index < 0) {
+    if (recognizer->count >= GESTURE_MAX_BINDINGS) return false;
+    index = recognizer->count++;
+    recognizer->byKey[c] = (uint8_t)(index + 1);
+  }
+
+  GesturePedal* pedal = &recognizer->pedals[index];
+  memset(pedal, 0, sizeof(GesturePedal));
+  pedal->binding = *binding;
+  pedal->sequence = -1;
+  return true;
+}
+
+static void gestureRecognizer_log(const GesturePedal* pedal, GestureKind kind, char emitted, uint32_t afterPressMs) {
+  flightRecorder_log(g_flightRecorder, FLIGHT_EVENT_GESTURE, (uint8_t)kind, (uint8_t)pedal->binding.primaryKey,
+                     (uint8_t)emitted, afterPressMs);
+}
+
+// Put the upgraded key down, after a Backspace for the primary keystroke if asked to.
+// Falls back to no compensation when every sequencer slot is busy.
+static bool gestureRecognizer_upgrade(GestureRecognizer* recognizer, GesturePedal* pedal,
+                                      const GestureAction* action, uint32_t nowMs) {
+  pedal->state = GESTURE_PEDAL_UPGRADED;
+  pedal->heldKey = action->key;
+  pedal->sequence = -1;
+
+  if (action->undoPrimary) {
+    pedal->steps[0] = {'\b', true, 0};
+    pedal->steps[1] = {'\b', false, GESTURE_STEP_MS};
+    pedal->steps[2] = {action->key, true, GESTURE_STEP_MS};
+    pedal->sequence = keySequencer_start(recognizer->sequencer, pedal->steps, 3, nowMs);
+    if (pedal->sequence >= 0) {
+      recognizer->compensations++;
+      return false;  // The sequencer makes the changes
+    }
+  }
+  return hidReportBuilder_press(recognizer->report, action->key);
+}
+
+bool gestureRecognizer_press(GestureRecognizer* recognizer, int index, uint32_t eventMs) {
+  if (index < 0 || index >= recognizer->count) return false;
+  GesturePedal* pedal = &recognizer->pedals[index];
+  const GestureBinding* binding = &pedal->binding;
+
+  pedal->pressMs = eventMs;
+  pedal->holdArmed = false;
+
+  // Decided at press time: the tap before it is already typed
+  if (binding->doubleTap.key && pedal->lastWasTap &&
+      eventMs - pedal->releaseMs <= GESTURE_DOUBLE_TAP_MS) {
+    pedal->lastWasTap = false;
+    recognizer->doubleTaps++;
+    gestureRecognizer_log(pedal, GESTURE_DOUBLE_TAP, binding->doubleTap.key, 0);
+    return gestureRecognizer_upgrade(recognizer, pedal, &binding->doubleTap, eventMs);
+  }
+
+  // Speculative: the primary key goes out now, exactly as without a binding
+  pedal->state = GESTURE_PEDAL_PRIMARY;
+  pedal->heldKey = binding->primaryKey;
+  if (binding->hold.key) {
+    pedal->holdDeadlineMs = eventMs + GESTURE_LONG_PRESS_MS;
+    pedal->holdArmed = true;
+  }
+  return hidReportBuilder_press(recognizer->report, binding->primaryKey);
+}
+
+bool gestureRecognizer_release(GestureRecognizer* recognizer, int index, uint32_t eventMs) {
+  if (index < 0 || index >= recognizer->count) return false;
+  GesturePedal* pedal = &recognizer->pedals[index];
+
+  bool changed = false;
+  if (pedal->state == GESTURE_PEDAL_PRIMARY) {
+    pedal->lastWasTap = true;
+    pedal->releaseMs = eventMs;
+    recognizer->taps++;
+    gestureRecognizer_log(pedal, GESTURE_TAP, pedal->binding.primaryKey, 0);
+  } else {
+    pedal->lastWasTap = false;
+  }
+  if (pedal->state != GESTURE_PEDAL_IDLE) {
+    // Only ours: a finished sequence's slot may since run someone else's steps
+    if (pedal->sequence >= 0 && recognizer->sequencer->sequences[pedal->sequence].steps == pedal->steps) {
+      keySequencer_cancel(recognizer->sequencer, pedal->sequence);
+    }
+    changed = hidReportBuilder_release(recognizer->report, pedal->heldKey);
+  }
+  pedal->state = GESTURE_PEDAL_IDLE;
+  pedal->holdArmed = false;
+  pedal->sequence = -1;
+  pedal->heldKey = 0;
+  return changed;
+}
+
+int gestureRecognizer_run(GestureRecognizer* recognizer, uint32_t nowMs) {
+  int changes = 0;
+  for (int i = 0; i < recognizer->count; i++) {
+    GesturePedal* pedal = &recognizer->pedals[i];
+    if (!pedal->holdArmed || (int32_t)(pedal->holdDeadlineMs - nowMs) > 0) continue;
+
+    pedal->holdArmed = false;
+    recognizer->holds++;
+    gestureRecognizer_log(pedal, GESTURE_HOLD, pedal->binding.hold.key, nowMs - pedal->pressMs);
+    if (hidReportBuilder_release(recognizer->report, pedal->binding.primaryKey)) {
+      changes++;
+    }
+    // Upgrade from the deadline, not from a late wakeup
+    if (gestureRecognizer_upgrade(recognizer, pedal, &pedal->binding.hold, pedal->holdDeadlineMs)) {
+      changes++;
+    }
+  }
+  return changes;
+}
+
+uint32_t gestureRecognizer_timeUntilNextMs(const GestureRecognizer* recognizer, uint32_t nowMs) {
+  uint32_t next = GESTURE_NO_DEADLINE;
+  for (int i = 0; i < recognizer->count; i++) {
+    const GesturePedal* pedal = &recognizer->pedals[i];
+    if (!pedal->holdArmed) continue;
+    int32_t remaining = (int32_t)(pedal->holdDeadlineMs - nowMs);
+    uint32_t wait = remaining > 0 ? (uint32_t)remaining : 0;
+    if (wait < next) {
+      next = wait;
+    }
+  }
+  return next;
+}
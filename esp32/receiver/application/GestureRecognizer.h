@@ -0,0 +1,92 @@
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "KeySequencer.h"
+#include "../infrastructure/HidReportBuilder.h"
+
+// Tap / double-tap / hold actions per pedal key, with no added latency for a plain tap.
+// The pedal's own (primary) key goes down at press time, as without gestures. A press
+// that is held past GESTURE_LONG_PRESS_MS is upgraded to the hold action, and a press
+// that follows a tap within GESTURE_DOUBLE_TAP_MS emits the double-tap action instead of
+// the primary key. The speculative primary keystroke can be compensated with a Backspace
+// before the upgrade (undoPrimary), played through the key sequencer.
+// Pedals without a binding never reach the recognizer. Times are milliseconds from the
+// receiver's event timestamps (wrap-safe), passed in by the caller.
+
+#define GESTURE_MAX_BINDINGS 8
+#define GESTURE_NO_DEADLINE 0xFFFFFFFFu
+
+typedef struct {
+  char key;          // 0 = no action for this gesture
+  bool undoPrimary;  // Backspace the speculative primary keystroke first
+} GestureAction;
+
+typedef struct {
+  char primaryKey;   // The pedal's assigned key
+  GestureAction doubleTap;
+  GestureAction hold;
+} GestureBinding;
+
+typedef enum {
+  GESTURE_TAP,
+  GESTURE_DOUBLE_TAP,
+  GESTURE_HOLD
+} GestureKind;
+
+typedef enum {
+  GESTURE_PEDAL_IDLE,
+  GESTURE_PEDAL_PRIMARY,     // Primary key down, hold not confirmed yet
+  GESTURE_PEDAL_UPGRADED     // Double-tap or hold action key down
+} GesturePedalState;
+
+typedef struct {
+  GestureBinding binding;
+  GesturePedalState state;
+  char heldKey;              // Key the pedal currently holds (or will, once the sequence reaches it)
+  uint32_t pressMs;
+  uint32_t holdDeadlineMs;
+  bool holdArmed;
+  bool lastWasTap;           // Previous gesture was a tap that ended at releaseMs
+  uint32_t releaseMs;
+  KeyStep steps[3];          // Compensation: Backspace tap, then the upgraded key down
+  int sequence;              // Sequencer handle running steps, or -1
+} GesturePedal;
+
+typedef struct {
+  HidReportBuilder* report;
+  KeySequencer* sequencer;
+  GesturePedal pedals[GESTURE_MAX_BINDINGS];
+  int count;
+  uint8_t byKey[128];        // Primary key -> pedal index + 1 (0 = no binding)
+
+  // Instrumentation
+  uint32_t taps;
+  uint32_t doubleTaps;
+  uint32_t holds;
+  uint32_t compensations;
+} GestureRecognizer;
+
+void gestureRecognizer_init(GestureRecognizer* recognizer, HidReportBuilder* report, KeySequencer* sequencer);
+
+// Add (or replace) the binding for binding->primaryKey. False if the table is full.
+bool gestureRecognizer_bind(GestureRecognizer* recognizer, const GestureBinding* binding);
+
+// Pedal index for a primary key, or -1 when it has no gesture binding
+static inline int gestureRecognizer_find(const GestureRecognizer* recognizer, char key) {
+  uint8_t c = (uint8_t)key;
+  return c < 128 ? (int)recognizer->byKey[c] - 1 : -1;
+}
+
+// Pedal edges; return true if the held set changed
+bool gestureRecognizer_press(GestureRecognizer* recognizer, int pedal, uint32_t eventMs);
+bool gestureRecognizer_release(GestureRecognizer* recognizer, int pedal, uint32_t eventMs);
+
+// Confirm holds that are due; returns the number of key changes made
+int gestureRecognizer_run(GestureRecognizer* recognizer, uint32_t nowMs);
+
+// Milliseconds until the next hold is confirmed (0 if overdue), or GESTURE_NO_DEADLINE
+uint32_t gestureRecognizer_timeUntilNextMs(const GestureRecognizer* recognizer, uint32_t nowMs);
+
+#endif // GESTURE_RECOGNIZER_H
@@ -0,0 +1,128 @@
+#include "HidOutputTask.h"
+#include "../shared/config.h"
+#include "../shared/messages.h"
+#include "../infrastructure/Telemetry.h"
+#include <esp_timer.h>
+#include <Arduino.h>
+
+// Transport callbacks carry no context; there is only one HID task
+static HidOutputTask* activeHidTask = nullptr;
+
+// Send the coalesced report and account its latency against every change it carries
+static void hidOutputTask_flush(HidOutputTask* hidTask) {
+  if (keyboardService_flush(hidTask->keyboard)) {
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < hidTask->pendingCount; i++) {
+      uint32_t latencyUs = (uint32_t)(now - hidTask->pendingRxTimeUs[i]);
+      latencyHistogram_record(&hidTask->latency, latencyUs);
+      telemetry_latency(g_telemetry, latencyUs);
+    }
+  }
+  hidTask->pendingCount = 0;
+  
+  // Axis moves since the last pass go out as one joystick report
+  if (hidTask->keyboard->usbMounted) {
+    expressionAxes_flush(hidTask->expression);
+  }
+}
+
+static void hidOutputTask_onFrame(const IngressFrame* frame) {
+  HidOutputTask* hidTask = activeHidTask;
+  
+  // Pedal fast path - same exact-length rule as the message dispatcher
+  bool changed = false;
+  if (frame->len == sizeof(struct_message) && frame->data[0] == MSG_PEDAL_EVENT) {
+    changed = keyboardService_handlePedalEvent(hidTask->keyboard, frame->addr, (const struct_message*)frame->data,
+                                               frame->rxTimeUs);
+  } else if (frame->len == sizeof(timed_pedal_message) && frame->data[0] == MSG_PEDAL_EVENT_TIMED) {
+    // Held back until its playout time unless that has already come
+    changed = keyboardService_handleTimedPedalEvent(hidTask->keyboard, frame->addr,
+                                                    (const timed_pedal_message*)frame->data, frame->rxTimeUs);
+  } else if (frame->len == sizeof(keepalive_message) && frame->data[0] == MSG_KEEPALIVE) {
+    keyboardService_handleKeepalive(hidTask->keyboard, frame->addr, (uint32_t)(frame->rxTimeUs / 1000));
+  } else if (frame->data[0] == MSG_EXPRESSION_VALUE || frame->data[0] == MSG_EXPRESSION_DELTA) {
+    // 200 Hz per pedal while it moves; the housekeeping task only needs the odd one
+    expressionAxes_handleFrame(hidTask->expression, frame->addr, frame->data, frame->len);
+    if (!expressionAxes_forwardsLease(hidTask->expression, frame->addr, (uint32_t)(frame->rxTimeUs / 1000))) {
+      return;
+    }
+  }
+  
+  if (changed) {
+    if (hidTask->pendingCount == INGRESS_QUEUE_CAPACITY) {
+      hidOutputTask_flush(hidTask);
+    }
+    hidTask->pendingRxTimeUs[hidTask->pendingCount++] = frame->rxTimeUs;
+  }
+  
+  // Everything else (and the pedal event's bookkeeping) runs on the housekeeping task
+  if (xQueueSend(hidTask->controlQueue, frame, 0) != pdTRUE) {
+    hidTask->controlDropped++;
+  }
+}
+
+// The tick-based wait below is only millisecond-accurate; buffered pedal events are woken
+// for at their exact playout time so their spacing is kept to tens of microseconds
+static void hidOutputTask_onPlayoutTimer(void* arg) {
+  xTaskNotifyGive(((HidOutputTask*)arg)->task);
+}
+
+static void hidOutputTask_armPlayoutTimer(HidOutputTask* hidTask) {
+  uint32_t untilUs = playoutBuffer_timeUntilNextUs(&hidTask->keyboard->playout, (uint32_t)esp_timer_get_time());
+  if (untilUs == PLAYOUT_NO_DEADLINE || untilUs == 0) return;
+  esp_timer_stop(hidTask->playoutTimer);  // Fails harmlessly if it is not running
+  esp_timer_start_once(hidTask->playoutTimer, untilUs);
+}
+
+static void hidOutputTask_run(void* arg) {
+  HidOutputTask* hidTask = (HidOutputTask*)arg;
+  for (;;) {
+    // Sleep until a frame arrives, a sequencer step or buffered pedal event is due or a
+    // held-key lease runs out
+    uint32_t waitMs = keyboardService_timeUntilNextTimerMs(hidTask->keyboard, millis());
+    if (waitMs > HID_TASK_IDLE_WAIT_MS) {
+      waitMs = HID_TASK_IDLE_WAIT_MS;
+    }
+    hidOutputTask_armPlayoutTimer(hidTask);
+    receiverEspNowTransport_waitForFrames(hidTask->transport, waitMs);
+    
+    // Live pedal changes first, then timers; one HID report carries both
+    receiverEspNowTransport_dispatch(hidTask->transport);
+    keyboardService_runTimers(hidTask->keyboard, millis());
+    hidOutputTask_flush(hidTask);
+  }
+}
+
+void hidOutputTask_start(HidOutputTask* hidTask, ReceiverEspNowTransport* transport, KeyboardService* keyboard,
+                         ExpressionAxes* expression) {
+  hidTask->transport = transport;
+  hidTask->keyboard = keyboard;
+  hidTask->expression = expression;
+  hidTask->controlDropped = 0;
+  hidTask->pendingCount = 0;
+  latencyHistogram_init(&hidTask->latency);
+  hidTask->controlQueue = xQueueCreate(CONTROL_QUEUE_LENGTH, sizeof(IngressFrame));
+  
+  esp_timer_create_args_t playoutTimerArgs = {};
+  playoutTimerArgs.callback = hidOutputTask_onPlayoutTimer;
+  playoutTimerArgs.arg = hidTask;
+  playoutTimerArgs.dispatch_method = ESP_TIMER_TASK;
+  playoutTimerArgs.name = "playout";
+  esp_timer_create(&playoutTimerArgs, &hidTask->playoutTimer);
+  
+  activeHidTask = hidTask;
+  receiverEspNowTransport_registerReceiveCallback(transport, hidOutputTask_onFrame);
+  
+  xTaskCreatePinnedToCore(hidOutputTask_run, "hid_out", HID_TASK_STACK_SIZE, hidTask,
+                          HID_TASK_PRIORITY, &hidTask->task, HID_TASK_CORE);
+  
+  // Wake on USB mount to replay events that arrived before the host was ready
+  keyboard->outputTask = hidTask->task;
+  if (keyboard->usbMounted) {
+    xTaskNotifyGive(hidTask->task);
+  }
+}
+
+bool hidOutputTask_receiveControlFrame(HidOutputTask* hidTask, IngressFrame* frame, uint32_t timeoutMs) {
+  return xQueueReceive(hidTask->controlQueue, frame, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
@@ -0,0 +1,39 @@
+#ifndef HID_OUTPUT_TASK_H
+#define HID_OUTPUT_TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <esp_timer.h>
+#include "KeyboardService.h"
+#include "ExpressionAxes.h"
+#include "../infrastructure/EspNowTransport.h"
+#include "../infrastructure/LatencyHistogram.h"
+
+// High-priority task that owns the path from ESP-NOW ingress to the USB HID report.
+// It drains the ingress ring, acts on pedal events immediately, and forwards every frame
+// (pedal events included, for bookkeeping and logging) to the housekeeping task through
+// the control queue. It never logs, persists or sends over ESP-NOW itself.
+typedef struct {
+  ReceiverEspNowTransport* transport;
+  KeyboardService* keyboard;
+  ExpressionAxes* expression;        // Expression pedal frames -> joystick axes
+  QueueHandle_t controlQueue;
+  TaskHandle_t task;
+  esp_timer_handle_t playoutTimer;   // Wakes the task when the next buffered pedal event is due
+  LatencyHistogram latency;          // Frame arrival -> HID report submitted
+  int64_t pendingRxTimeUs[INGRESS_QUEUE_CAPACITY];  // Arrival times of changes awaiting the next report
+  int pendingCount;
+  volatile uint32_t controlDropped;  // Frames lost because the control queue was full
+} HidOutputTask;
+
+// Registers the transport receive callback, so call before adding ESP-NOW peers
+void hidOutputTask_start(HidOutputTask* hidTask, ReceiverEspNowTransport* transport, KeyboardService* keyboard,
+                         ExpressionAxes* expression);
+
+// Housekeeping side: take the next forwarded frame, blocking up to timeoutMs (0 = poll)
+bool hidOutputTask_receiveControlFrame(HidOutputTask* hidTask, IngressFrame* frame, uint32_t timeoutMs);
+
+#endif // HID_OUTPUT_TASK_H
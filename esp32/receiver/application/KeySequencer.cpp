@@ -0,0 +1,123 @@
+#include "KeySequencer.h"
+#include <string.h>
+
+void keySequencer_init(KeySequencer* sequencer, HidReportBuilder* report) {
+  memset(sequencer, 0, sizeof(KeySequencer));
+  sequencer->report = report;
+}
+
+static bool keySequencer_isDue(uint32_t deadlineMs, uint32_t nowMs) {
+  return (int32_t)(deadlineMs - nowMs) <= 0;
+}
+
+static bool keySequencer_isRunning(const KeySequencer* sequencer, int handle) {
+  for (int i = 0; i < sequencer->queued; i++) {
+    if (sequencer->queue[i] == handle) return true;
+  }
+  return false;
+}
+
+// Insert into the deadline queue, after any entry due at the same time (keeps start order)
+static void keySequencer_enqueue(KeySequencer* sequencer, int handle) {
+  uint32_t deadline = sequencer->sequences[handle].deadlineMs;
+  int pos = sequencer->queued;
+  while (pos > 0 && (int32_t)(sequencer->sequences[sequencer->queue[pos - 1]].deadlineMs - deadline) > 0) {
+    sequencer->queue[pos] = sequencer->queue[pos - 1];
+    pos--;
+  }
+  sequencer->queue[pos] = (uint8_t)handle;
+  sequencer->queued++;
+}
+
+static void keySequencer_dequeue(KeySequencer* sequencer, int position) {
+  for (int i = position; i < sequencer->queued - 1; i++) {
+    sequencer->queue[i] = sequencer->queue[i + 1];
+  }
+  sequencer->queued--;
+}
+
+int keySequencer_start(KeySequencer* sequencer, const KeyStep* steps, uint8_t stepCount, uint32_t nowMs) {
+  if (!steps || stepCount == 0) return -1;
+  
+  for (int handle = 0; handle < KEY_SEQUENCER_MAX_SEQUENCES; handle++) {
+    if (keySequencer_isRunning(sequencer, handle)) continue;
+    
+    KeySequence* sequence = &sequencer->sequences[handle];
+    sequence->steps = steps;
+    sequence->stepCount = stepCount;
+    sequence->nextStep = 0;
+    sequence->deadlineMs = nowMs + steps[0].delayMs;
+    keySequencer_enqueue(sequencer, handle);
+    sequencer->started++;
+    return handle;
+  }
+  
+  sequencer->rejected++;
+  return -1;
+}
+
+void keySequencer_cancel(KeySequencer* sequencer, int handle) {
+  for (int i = 0; i < sequencer->queued; i++) {
+    if (sequencer->queue[i] != handle) continue;
+    
+    // Release keys pressed by steps already played and not released by a later played step
+    KeySequence* sequence = &sequencer->sequences[handle];
+    for (int s = 0; s < sequence->nextStep; s++) {
+      if (!sequence->steps[s].pressed) continue;
+      bool releasedLater = false;
+      for (int t = s + 1; t < sequence->nextStep; t++) {
+        if (!sequence->steps[t].pressed && sequence->steps[t].key == sequence->steps[s].key) {
+          releasedLater = true;
+          break;
+        }
+      }
+      if (!releasedLater) {
+        hidReportBuilder_release(sequencer->report, sequence->steps[s].key);
+      }
+    }
+    keySequencer_dequeue(sequencer, i);
+    return;
+  }
+}
+
+int keySequencer_run(KeySequencer* sequencer, uint32_t nowMs) {
+  int applied = 0;
+  
+  while (sequencer->queued > 0) {
+    int handle = sequencer->queue[0];
+    KeySequence* sequence = &sequencer->sequences[handle];
+    if (!keySequencer_isDue(sequence->deadlineMs, nowMs)) break;
+    
+    const KeyStep* step = &sequence->steps[sequence->nextStep];
+    if (hidReportBuilder_isPending(sequencer->report, step->key) &&
+        hidReportBuilder_isPressed(sequencer->report, step->key) != step->pressed) {
+      // Would cancel a change the host has not seen; play it once that report is sent
+      sequencer->deferred++;
+      break;
+    }
+    if (step->pressed) {
+      hidReportBuilder_press(sequencer->report, step->key);
+    } else {
+      hidReportBuilder_release(sequencer->report, step->key);
+    }
+    applied++;
+    
+    keySequencer_dequeue(sequencer, 0);
+    sequence->nextStep++;
+    if (sequence->nextStep < sequence->stepCount) {
+      // Schedule from the previous deadline, not from nowMs, so late wakeups don't stretch timing
+      sequence->deadlineMs += sequence->steps[sequence->nextStep].delayMs;
+      keySequencer_enqueue(sequencer, handle);
+    }
+  }
+  
+  return applied;
+}
+
+uint32_t keySequencer_timeUntilNextMs(const KeySequencer* sequencer, uint32_t nowMs) {
+  if (sequencer->queued == 0) return KEY_SEQUENCER_NO_DEADLINE;
+  
+  uint32_t deadline = sequencer->sequences[sequencer->queue[0]].deadlineMs;
+  if (keySequencer_isDue(deadline, nowMs)) return 0;
+  return deadline - nowMs;
+}
@@ -0,0 +1,57 @@
+#ifndef KEY_SEQUENCER_H
+#define KEY_SEQUENCER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../infrastructure/HidReportBuilder.h"
+
+// Plays timed key sequences (macros, tap outputs) without blocking. Each running sequence
+// sits in a deadline queue ordered by when its next step is due; keySequencer_run() applies
+// every step that is due into the report builder, so steps from different sequences and live
+// pedal changes made in the same cycle go out together in one HID report. A step that would
+// reverse a key the pending report already changes ends the pass instead: it stays at its
+// deadline and plays on the next pass, after that report has gone out.
+// Time is passed in by the caller (milliseconds, wrap-safe), so the module has no clock of its own.
+
+#define KEY_SEQUENCER_MAX_SEQUENCES 4
+#define KEY_SEQUENCER_NO_DEADLINE 0xFFFFFFFFu
+
+typedef struct {
+  char key;
+  bool pressed;
+  uint16_t delayMs;  // Wait after the previous step (or after start, for the first step)
+} KeyStep;
+
+typedef struct {
+  const KeyStep* steps;  // Must stay valid while the sequence runs
+  uint8_t stepCount;
+  uint8_t nextStep;
+  uint32_t deadlineMs;   // When steps[nextStep] is due
+} KeySequence;
+
+typedef struct {
+  HidReportBuilder* report;
+  KeySequence sequences[KEY_SEQUENCER_MAX_SEQUENCES];
+  uint8_t queue[KEY_SEQUENCER_MAX_SEQUENCES];  // Running sequence indices, earliest deadline first
+  int queued;
+  uint32_t started;
+  uint32_t rejected;  // Starts refused because all sequence slots were busy
+  uint32_t deferred;  // Passes ended early by a step waiting for the pending report
+} KeySequencer;
+
+void keySequencer_init(KeySequencer* sequencer, HidReportBuilder* report);
+
+// Returns a handle, or -1 if every slot is busy
+int keySequencer_start(KeySequencer* sequencer, const KeyStep* steps, uint8_t stepCount, uint32_t nowMs);
+
+// Stop a sequence early, releasing any keys its steps pressed but had not yet released
+void keySequencer_cancel(KeySequencer* sequencer, int handle);
+
+// Apply the steps due at nowMs, up to one that must wait for the pending report to be sent.
+// Returns the number of steps applied.
+int keySequencer_run(KeySequencer* sequencer, uint32_t nowMs);
+
+// Milliseconds until the next step is due (0 if overdue), or KEY_SEQUENCER_NO_DEADLINE
+uint32_t keySequencer_timeUntilNextMs(const KeySequencer* sequencer, uint32_t nowMs);
+
+#endif // KEY_SEQUENCER_H
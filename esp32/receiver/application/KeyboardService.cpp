@@ -3,52 +3,427 @@
 #include <USBHIDKeyboard.h>
 #include <string.h>
 #include <Arduino.h>
+#include <esp_timer.h>
+#include "../infrastructure/FlightRecorder.h"
+#include "../infrastructure/UsbMidi.h"
+#include "../infrastructure/HidNkroKeyboard.h"
 
 USBHIDKeyboard Keyboard;
 
-void keyboardService_init(KeyboardService* service, TransmitterManager* manager) {
-  service->manager = manager;
-  memset(service->keysPressed, 0, sizeof(service->keysPressed));
+// USB event callbacks carry no context; there is only one keyboard
+static KeyboardService* activeKeyboardService = nullptr;
+
+static void keyboardService_onUsbEvent(void*, esp_event_base_t base, int32_t eventId, void*) {
+  KeyboardService* service = activeKeyboardService;
+  if (!service || base != ARDUINO_USB_EVENTS) return;
   
-  USB.begin();
-  delay(500);
+  switch (eventId) {
+    case ARDUINO_USB_STARTED_EVENT:
+    case ARDUINO_USB_RESUME_EVENT:
+      if (!service->usbMounted) {
+        service->usbMountedUs = esp_timer_get_time();
+        service->usbMounted = true;
+        TaskHandle_t outputTask = service->outputTask;
+        if (outputTask) {
+          xTaskNotifyGive(outputTask);
+        }
+      }
+      break;
+    case ARDUINO_USB_STOPPED_EVENT:
+    case ARDUINO_USB_SUSPEND_EVENT:
+      service->usbMounted = false;
+      break;
+    default:
+      break;
+  }
+}
+
+static bool keyboardService_flushConflict(void* context);
+
+void keyboardService_init(KeyboardService* service, KeyBindings* bindings) {
+  service->bindings = bindings;
+  hidReportBuilder_init(&service->report);
+  hidReportBuilder_setFlush(&service->report, keyboardService_flushConflict, service);
+  keySequencer_init(&service->sequencer, &service->report);
+  gestureRecognizer_init(&service->gestures, &service->report, &service->sequencer);
+  midiService_init(&service->midi, usbMidi_sink());
+  service->usbMounted = false;
+  service->outputTask = nullptr;
+  service->usbMountedUs = 0;
+  service->preReadyCount = 0;
+  service->preReadyDropped = 0;
+  service->preReadyReplayed = 0;
+  service->firstKeystrokeUs = 0;
+  service->nkroReport = HID_KEYBOARD_NKRO;
+  service->reportSendFailures = 0;
+  memset(service->leases, 0, sizeof(service->leases));
+  service->leaseExpiries = 0;
+  playoutBuffer_init(&service->playout, PLAYOUT_DELAY_MS);
+  
+  // Don't wait for enumeration - the mount event tells us when reports can be sent
+  activeKeyboardService = service;
+  USB.onEvent(keyboardService_onUsbEvent);
   Keyboard.begin();
-  delay(2000);
+#if HID_KEYBOARD_NKRO
+  hidNkroKeyboard_begin();
+#endif
+  usbMidi_begin();
+  USB.begin();
+}
+
+void keyboardService_setGestures(KeyboardService* service, const GestureBinding* bindings) {
+  for (const GestureBinding* binding = bindings; binding && binding->primaryKey; binding++) {
+    gestureRecognizer_bind(&service->gestures, binding);
+  }
 }
 
-void keyboardService_handlePedalEvent(KeyboardService* service, const uint8_t* txMAC, 
-                                       const struct_message* msg) {
-  int transmitterIndex = transmitterManager_findIndex(service->manager, txMAC);
-  if (transmitterIndex < 0) {
-    return;  // Unknown transmitter
+void keyboardService_setMidi(KeyboardService* service, const MidiBinding* bindings) {
+  for (const MidiBinding* binding = bindings; binding && binding->key; binding++) {
+    midiService_bind(&service->midi, binding);
+  }
+}
+
+// Route a key change to its output: MIDI, the gesture recognizer or the keyboard report.
+// Returns true if something is waiting for the next flush.
+static bool keyboardService_output(KeyboardService* service, char key, bool pressed, uint32_t eventMs) {
+  int midi = midiService_find(&service->midi, key);
+  if (midi >= 0) {
+    return midiService_pedal(&service->midi, midi, pressed);
+  }
+  int gesture = gestureRecognizer_find(&service->gestures, key);
+  if (gesture >= 0) {
+    return pressed ? gestureRecognizer_press(&service->gestures, gesture, eventMs)
+                   : gestureRecognizer_release(&service->gestures, gesture, eventMs);
+  }
+  return pressed ? hidReportBuilder_press(&service->report, key) : hidReportBuilder_release(&service->report, key);
+}
+
+// eventTimeUs is when the edge counts as happening for gesture timing: arrival for plain
+// events, playout time for timed ones
+static bool keyboardService_applyPedalEvent(KeyboardService* service, MacAddr txMAC, const struct_message* msg,
+                                            int64_t rxTimeUs, int64_t eventTimeUs) {
+  KeyBindingAction action;
+  bool bound = keyBindings_lookup(service->bindings, txMAC, msg->key, &action) && action.key != 0;
+  flightRecorder_log(g_flightRecorder, FLIGHT_EVENT_PEDAL, bound ? (uint8_t)action.transmitterIndex : 0xFF,
+                     (uint8_t)msg->key, msg->pressed, bound ? (uint8_t)action.key : 0);
+  if (!bound) {
+    return false;  // Unknown transmitter or unbound pedal
   }
   
-  // Update last seen
-  service->manager->transmitters[transmitterIndex].lastSeen = millis();
+  if (!service->usbMounted) {
+    if (service->preReadyCount >= PRE_READY_QUEUE_CAPACITY) {
+      // Never lose a release while keeping its press: drop the pair instead
+      if (!msg->pressed) {
+        for (int i = service->preReadyCount - 1; i >= 0; i--) {
+          if (service->preReady[i].key == action.key && service->preReady[i].pressed) {
+            memmove(&service->preReady[i], &service->preReady[i + 1],
+                    (service->preReadyCount - i - 1) * sizeof(PendingKeyEvent));
+            service->preReadyCount--;
+            service->preReadyDropped++;
+            break;
+          }
+        }
+      }
+      service->preReadyDropped++;
+      return false;
+    }
+    PendingKeyEvent* pending = &service->preReady[service->preReadyCount++];
+    pending->rxTimeUs = rxTimeUs;
+    pending->key = action.key;
+    pending->pressed = msg->pressed;
+    return false;
+  }
   
-  // Determine key to press
-  char keyToPress;
-  if (service->manager->transmitters[transmitterIndex].pedalMode == 0) {
-    // DUAL pedal: '1' -> 'l', '2' -> 'r'
-    keyToPress = (msg->key == '1') ? 'l' : 'r';
-  } else {
-    // SINGLE pedal: '1' -> assigned key based on pairing order
-    if (msg->key != '1') return;
-    keyToPress = transmitterManager_getAssignedKey(service->manager, transmitterIndex);
+  // Track what this transmitter holds so a lost release can be recovered by lease expiry
+  if (action.transmitterIndex >= 0 && action.transmitterIndex < MAX_PEDAL_SLOTS) {
+    HeldKeyLease* lease = &service->leases[action.transmitterIndex];
+    int pedal = getPedalInput(msg->key);
+    if (pedal >= 0) {
+      lease->keys[pedal] = msg->pressed ? action.key : 0;
+      if (msg->pressed) {
+        lease->heldMask |= (uint8_t)(1u << pedal);
+      } else {
+        lease->heldMask &= (uint8_t)~(1u << pedal);
+      }
+    }
+    if (msg->pressed) {
+      lease->enforced = (msg->pedalMode & PEDAL_EVENT_FLAG_KEEPALIVE) != 0;
+      lease->expiresMs = (uint32_t)(rxTimeUs / 1000) + HELD_KEY_LEASE_MS;
+    }
   }
   
-  uint8_t keyIndex = (uint8_t)keyToPress;
+  return keyboardService_output(service, action.key, msg->pressed, (uint32_t)(eventTimeUs / 1000));
+}
+
+bool keyboardService_handlePedalEvent(KeyboardService* service, MacAddr txMAC, 
+                                       const struct_message* msg, int64_t rxTimeUs) {
+  return keyboardService_applyPedalEvent(service, txMAC, msg, rxTimeUs, rxTimeUs);
+}
+
+// Apply a timed event now and record when it went out, for the spacing measurement
+static bool keyboardService_playTimedEvent(KeyboardService* service, const PlayoutEvent* event) {
+  int64_t eventTimeUs = event->rxTimeUs + (int32_t)(event->dueUs - (uint32_t)event->rxTimeUs);
+  bool changed = keyboardService_applyPedalEvent(service, event->addr, &event->msg, event->rxTimeUs, eventTimeUs);
+  playoutBuffer_notePlayed(&service->playout, event->transmitterIndex, getPedalInput(event->msg.key),
+                           event->msg.pressed, event->edgeUs, (uint32_t)event->rxTimeUs,
+                           (uint32_t)esp_timer_get_time());
+  return changed;
+}
+
+// Play queued events due no later than dueUs, earliest first. A transmitter's due times
+// only grow, so this covers every queued event of its own that came before one due at dueUs.
+static int keyboardService_playEventsDueBy(KeyboardService* service, uint32_t dueUs) {
+  int changes = 0;
+  PlayoutEvent event;
+  while (playoutBuffer_popDue(&service->playout, dueUs, &event)) {
+    if (keyboardService_playTimedEvent(service, &event)) {
+      changes++;
+    }
+  }
+  return changes;
+}
+
+bool keyboardService_handleTimedPedalEvent(KeyboardService* service, MacAddr txMAC,
+                                            const timed_pedal_message* msg, int64_t rxTimeUs) {
+  PlayoutEvent event;
+  event.edgeUs = msg->edgeUs;
+  event.rxTimeUs = rxTimeUs;
+  event.addr = txMAC;
+  event.msg.msgType = MSG_PEDAL_EVENT;
+  event.msg.key = msg->key;
+  event.msg.pressed = msg->pressed;
+  event.msg.pedalMode = msg->pedalMode;
   
-  if (msg->pressed) {
-    if (!service->keysPressed[keyIndex]) {
-      Keyboard.press(keyToPress);
-      service->keysPressed[keyIndex] = true;
+  // Unknown transmitters and events before mount skip the buffer (logged/queued as usual).
+  // After an unmount, whatever is still buffered reaches the pre-ready queue first.
+  int changes = 0;
+  KeyBindingAction action;
+  if (!service->usbMounted || !keyBindings_lookup(service->bindings, txMAC, msg->key, &action)) {
+    PlayoutEvent queued;
+    while (!service->usbMounted && playoutBuffer_popNext(&service->playout, &queued)) {
+      keyboardService_playTimedEvent(service, &queued);
+    }
+    event.transmitterIndex = -1;
+    return keyboardService_handlePedalEvent(service, txMAC, &event.msg, rxTimeUs);
+  }
+  event.transmitterIndex = (int8_t)action.transmitterIndex;
+  
+  uint32_t nowUs = (uint32_t)esp_timer_get_time();
+  event.dueUs = playoutBuffer_schedule(&service->playout, action.transmitterIndex, getPedalInput(msg->key),
+                                       msg->pressed, msg->edgeUs, (uint32_t)rxTimeUs, nowUs);
+  if ((int32_t)(event.dueUs - nowUs) > 0) {
+    // Queue full: play the earliest event ahead of time to make room, unless this one is
+    // due first - then nothing queued can be overtaken by playing it now
+    PlayoutEvent earliest;
+    if (playoutBuffer_evictEarliest(&service->playout, event.dueUs, &earliest) &&
+        keyboardService_playTimedEvent(service, &earliest)) {
+      changes++;
+    }
+    if (playoutBuffer_push(&service->playout, &event)) {
+      return changes > 0;
     }
   } else {
-    if (service->keysPressed[keyIndex]) {
-      Keyboard.release(keyToPress);
-      service->keysPressed[keyIndex] = false;
+    // Late: what was queued ahead of it and is due by now goes out first
+    changes += keyboardService_playEventsDueBy(service, event.dueUs);
+  }
+  if (keyboardService_playTimedEvent(service, &event)) {
+    changes++;
+  }
+  return changes > 0;
+}
+
+static int keyboardService_playDueEvents(KeyboardService* service) {
+  return keyboardService_playEventsDueBy(service, (uint32_t)esp_timer_get_time());
+}
+
+void keyboardService_handleKeepalive(KeyboardService* service, MacAddr txMAC, uint32_t nowMs) {
+  KeyBindingAction action;
+  if (!keyBindings_lookup(service->bindings, txMAC, '1', &action)) return;
+  if (action.transmitterIndex < 0 || action.transmitterIndex >= MAX_PEDAL_SLOTS) return;
+  
+  HeldKeyLease* lease = &service->leases[action.transmitterIndex];
+  if (lease->heldMask) {
+    lease->expiresMs = nowMs + HELD_KEY_LEASE_MS;
+  }
+}
+
+static bool keyboardService_isLeaseArmed(const HeldKeyLease* lease) {
+  return lease->enforced && lease->heldMask;
+}
+
+static int keyboardService_expireLeases(KeyboardService* service, uint32_t nowMs) {
+  int changes = 0;
+  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
+    HeldKeyLease* lease = &service->leases[i];
+    if (!keyboardService_isLeaseArmed(lease) || (int32_t)(lease->expiresMs - nowMs) > 0) continue;
+    
+    for (int pedal = 0; pedal < MAX_PEDAL_INPUTS; pedal++) {
+      char key = lease->keys[pedal];
+      if (key && keyboardService_output(service, key, false, nowMs)) {
+        changes++;
+      }
+      lease->keys[pedal] = 0;
+    }
+    flightRecorder_log(g_flightRecorder, FLIGHT_EVENT_LEASE_EXPIRED, (uint8_t)i, lease->heldMask, 0, 0);
+    lease->heldMask = 0;
+    service->leaseExpiries++;
+  }
+  return changes;
+}
+
+int keyboardService_playSequence(KeyboardService* service, const KeyStep* steps, uint8_t stepCount, uint32_t nowMs) {
+  return keySequencer_start(&service->sequencer, steps, stepCount, nowMs);
+}
+
+int keyboardService_runTimers(KeyboardService* service, uint32_t nowMs) {
+  // Holds first, so a compensation sequence they start can play in this same pass
+  int changes = gestureRecognizer_run(&service->gestures, nowMs);
+  return changes + keySequencer_run(&service->sequencer, nowMs) + keyboardService_playDueEvents(service) +
+         keyboardService_expireLeases(service, nowMs);
+}
+
+uint32_t keyboardService_timeUntilNextTimerMs(const KeyboardService* service, uint32_t nowMs) {
+  // Without a host no report goes out, so a step waiting for one would only spin the task;
+  // the mount notification wakes it instead
+  uint32_t next = service->usbMounted ? keySequencer_timeUntilNextMs(&service->sequencer, nowMs)
+                                      : KEY_SEQUENCER_NO_DEADLINE;
+  if (service->usbMounted && service->report.dirty && next > HID_REPORT_RETRY_MS) {
+    next = HID_REPORT_RETRY_MS;  // A report the host was not ready for
+  }
+  uint32_t untilHold = gestureRecognizer_timeUntilNextMs(&service->gestures, nowMs);
+  if (untilHold < next) {
+    next = untilHold;
+  }
+  uint32_t untilPlayoutUs = playoutBuffer_timeUntilNextUs(&service->playout, (uint32_t)esp_timer_get_time());
+  if (untilPlayoutUs != PLAYOUT_NO_DEADLINE) {
+    uint32_t untilPlayout = (untilPlayoutUs + 999) / 1000;  // Never wake before it is due
+    if (untilPlayout < next) {
+      next = untilPlayout;
+    }
+  }
+  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
+    const HeldKeyLease* lease = &service->leases[i];
+    if (!keyboardService_isLeaseArmed(lease)) continue;
+    int32_t remaining = (int32_t)(lease->expiresMs - nowMs);
+    uint32_t untilExpiry = remaining > 0 ? (uint32_t)remaining : 0;
+    if (untilExpiry < next) {
+      next = untilExpiry;
+    }
+  }
+  return next;
+}
+
+// The report form follows the host's protocol. A switch empties the report it leaves (so
+// nothing stays held there) and resends the whole held set in the new form.
+static bool keyboardService_sendKeyboardReport(KeyboardService* service) {
+#if HID_KEYBOARD_NKRO
+  bool nkro = hidNkroKeyboard_active();
+  if (nkro != service->nkroReport) {
+    // Clear the form the host was reading; if that fails, the switch is retried next pass
+    if (nkro) {
+      KeyReport empty = {};
+      Keyboard.sendReport(&empty);
+    } else {
+      HidNkroReport empty = {};
+      if (!hidNkroKeyboard_send(&empty)) {
+        service->reportSendFailures++;
+        return false;
+      }
+    }
+    service->nkroReport = nkro;
+    hidReportBuilder_invalidate(&service->report);
+  }
+  if (nkro) {
+    HidNkroReport report;
+    if (!hidReportBuilder_buildNkro(&service->report, &report)) {
+      return false;
+    }
+    if (!hidNkroKeyboard_send(&report)) {
+      // The build consumed the changes; the next pass resends the whole held set
+      hidReportBuilder_invalidate(&service->report);
+      service->reportSendFailures++;
+      return false;
+    }
+    return true;
+  }
+#endif
+  HidKeyboardReport report;
+  if (!hidReportBuilder_build(&service->report, &report)) {
+    return false;
+  }
+  
+  static_assert(sizeof(HidKeyboardReport) == sizeof(KeyReport), "HID report layout mismatch");
+  Keyboard.sendReport((KeyReport*)&report);
+  return true;
+}
+
+static bool keyboardService_sendReport(KeyboardService* service) {
+  if (!keyboardService_sendKeyboardReport(service)) {
+    return false;
+  }
+  if (service->firstKeystrokeUs == 0) {
+    service->firstKeystrokeUs = esp_timer_get_time();
+  }
+  return true;
+}
+
+// Builder hook: a change is about to undo one in the pending report, so send that report now
+static bool keyboardService_flushConflict(void* context) {
+  KeyboardService* service = (KeyboardService*)context;
+  if (!service->usbMounted) {
+    return false;
+  }
+  return keyboardService_sendReport(service);
+}
+
+// Play the gesture holds and sequencer steps that were due by an early event's time before
+// the event itself, one report per pass as they would have gone out live
+static bool keyboardService_catchUpTimers(KeyboardService* service, uint32_t eventMs) {
+  bool sent = false;
+  while (gestureRecognizer_run(&service->gestures, eventMs) + keySequencer_run(&service->sequencer, eventMs) > 0) {
+    if (!keyboardService_sendReport(service)) break;
+    sent = true;
+  }
+  return sent;
+}
+
+// Replay early events one report each, so a tap that happened before mount stays a tap and
+// a double-tap or hold is still recognized. MIDI edges queue in order and go out with the
+// caller's flush.
+static bool keyboardService_replayPreReady(KeyboardService* service) {
+  int64_t now = esp_timer_get_time();
+  bool sent = false;
+  
+  for (int i = 0; i < service->preReadyCount; i++) {
+    const PendingKeyEvent* pending = &service->preReady[i];
+    if (now - pending->rxTimeUs > (int64_t)PRE_READY_MAX_AGE_MS * 1000) {
+      service->preReadyDropped++;
+      continue;
+    }
+    uint32_t eventMs = (uint32_t)(pending->rxTimeUs / 1000);
+    sent = keyboardService_catchUpTimers(service, eventMs) || sent;
+    keyboardService_output(service, pending->key, pending->pressed, eventMs);
+    if (keyboardService_sendReport(service)) {
+      sent = true;
     }
+    service->preReadyReplayed++;
   }
+  
+  service->preReadyCount = 0;
+  return sent;
 }
 
+bool keyboardService_flush(KeyboardService* service) {
+  if (!service->usbMounted) {
+    return false;  // Changes stay in the builder until the host is there
+  }
+  
+  bool sent = false;
+  if (service->preReadyCount > 0) {
+    sent = keyboardService_replayPreReady(service);
+  }
+  if (midiService_flush(&service->midi) > 0) {
+    sent = true;
+  }
+  return keyboardService_sendReport(service) || sent;
+}
@@ -3,17 +3,95 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "../domain/TransmitterManager.h"
+#include "../domain/KeyBindings.h"
+#include "../infrastructure/HidReportBuilder.h"
+#include "KeySequencer.h"
+#include "PlayoutBuffer.h"
+#include "GestureRecognizer.h"
+#include "MidiService.h"
+#include "../shared/config.h"
 #include "../shared/messages.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
+// Key change received before the HID interface was mounted
 typedef struct {
-  TransmitterManager* manager;
-  bool keysPressed[256];
+  int64_t rxTimeUs;
+  char key;
+  bool pressed;
+} PendingKeyEvent;
+
+// Keys a transmitter currently holds. For transmitters that send keepalives while holding,
+// the keys are released if the lease runs out (transmitter lost mid-press).
+typedef struct {
+  char keys[MAX_PEDAL_INPUTS];  // Held key per pedal input (0 = none)
+  uint8_t heldMask;             // Bit per input with a held key
+  bool enforced;                // Transmitter advertised PEDAL_EVENT_FLAG_KEEPALIVE
+  uint32_t expiresMs;
+} HeldKeyLease;
+
+typedef struct {
+  KeyBindings* bindings;
+  HidReportBuilder report;
+  KeySequencer sequencer;
+  GestureRecognizer gestures;  // Tap/double-tap/hold actions for bound pedal keys
+  MidiService midi;            // MIDI CC/note output for pedal keys bound to it (instead of typing)
+  
+  // USB mount state (written from the USB event task)
+  volatile bool usbMounted;
+  TaskHandle_t volatile outputTask;  // Notified on mount so early events are replayed promptly
+  volatile int64_t usbMountedUs;
+  
+  // Pre-ready queue, replayed in order on mount
+  PendingKeyEvent preReady[PRE_READY_QUEUE_CAPACITY];
+  int preReadyCount;
+  uint32_t preReadyDropped;   // Queue full or too old at mount time
+  uint32_t preReadyReplayed;
+  
+  volatile int64_t firstKeystrokeUs;  // esp_timer time of the first report sent after boot
+  bool nkroReport;                    // Form of the last report: NKRO bitmap or 6-key boot
+  uint32_t reportSendFailures;        // Reports the host was not ready for (resent next pass)
+  
+  HeldKeyLease leases[MAX_PEDAL_SLOTS];  // Indexed by transmitter slot
+  uint32_t leaseExpiries;                // Times held keys were released by lease expiry
+  
+  PlayoutBuffer playout;  // Timed pedal events waiting for their playout time
 } KeyboardService;
 
-void keyboardService_init(KeyboardService* service, TransmitterManager* manager);
-void keyboardService_handlePedalEvent(KeyboardService* service, const uint8_t* txMAC, 
-                                       const struct_message* msg);
+// Starts USB without waiting for enumeration; call first so it overlaps radio bring-up
+void keyboardService_init(KeyboardService* service, KeyBindings* bindings);
+
+// Gesture actions, up to an entry with primaryKey 0. Call before the HID output task starts.
+void keyboardService_setGestures(KeyboardService* service, const GestureBinding* bindings);
+
+// MIDI outputs, up to an entry with key 0. Call before the HID output task starts.
+void keyboardService_setMidi(KeyboardService* service, const MidiBinding* bindings);
+
+// Runs on the HID output task. Records the key change (returns true if the held set
+// changed); nothing reaches the host until keyboardService_flush(). Before the HID
+// interface is mounted the change goes to the pre-ready queue instead.
+bool keyboardService_handlePedalEvent(KeyboardService* service, MacAddr txMAC, 
+                                       const struct_message* msg, int64_t rxTimeUs);
+
+// Timed pedal event: played now if its playout time has come (returns true if the held set
+// changed, as above), otherwise held in the playout buffer for keyboardService_runTimers().
+// Queued events due before one played now go out first, so one input's edges never swap.
+bool keyboardService_handleTimedPedalEvent(KeyboardService* service, MacAddr txMAC,
+                                            const timed_pedal_message* msg, int64_t rxTimeUs);
+
+// Renew the held-key lease of the sending transmitter
+void keyboardService_handleKeepalive(KeyboardService* service, MacAddr txMAC, uint32_t nowMs);
+
+// Timed sequences (macros, tap outputs). HID output task only, like the calls above.
+int keyboardService_playSequence(KeyboardService* service, const KeyStep* steps, uint8_t stepCount, uint32_t nowMs);
+
+// Due sequence steps, hold gestures, buffered pedal events and held-key lease expiry; returns the number of key changes made
+int keyboardService_runTimers(KeyboardService* service, uint32_t nowMs);
+uint32_t keyboardService_timeUntilNextTimerMs(const KeyboardService* service, uint32_t nowMs);
+
+// Send queued MIDI messages and one report covering every change since the last flush,
+// replaying the pre-ready queue first after a mount. Returns true if anything was sent.
+bool keyboardService_flush(KeyboardService* service);
 
 #endif // KEYBOARD_SERVICE_H
 
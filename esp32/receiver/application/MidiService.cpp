@@ -0,0 +1,75 @@
+#include "MidiService.h"
+#include <string.h>
+#include <stdio.h>
+
+#define MIDI_NOTE_OFF       0x80
+#define MIDI_NOTE_ON        0x90
+#define MIDI_CONTROL_CHANGE 0xB0
+
+void midiService_init(MidiService* midi, MidiSink sink) {
+  memset(midi, 0, sizeof(MidiService));
+  midi->sink = sink;
+}
+
+bool midiService_bind(MidiService* midi, const MidiBinding* binding) {
+  uint8_t c = (uint8_t)binding->key;
+  if (c == 0 || c >= 128 || binding->channel < 1 || binding->channel > 16 || binding->number > 127 ||
+      binding->pressValue > 127 || binding->releaseValue > 127) {
+    return false;
+  }
+  if (binding->kind == MIDI_OUTPUT_NOTE && binding->pressValue == 0) {
+    return false;  // Velocity 0 would be a note off
+  }
+  
+  int index = midiService_find(midi, binding->key);
+  if (index < 0) {
+    if (midi->count >= MIDI_MAX_BINDINGS) return false;
+    index = midi->count++;
+    midi->byKey[c] = (uint8_t)(index + 1);
+  }
+  midi->bindings[index] = *binding;
+  return true;
+}
+
+bool midiService_pedal(MidiService* midi, int binding, bool pressed) {
+  if (binding < 0 || binding >= midi->count) return false;
+  if (midi->queued >= MIDI_QUEUE_CAPACITY) {
+    midi->dropped++;
+    return false;
+  }
+  
+  const MidiBinding* b = &midi->bindings[binding];
+  uint8_t channel = (uint8_t)(b->channel - 1);
+  MidiMessage* message = &midi->queue[midi->queued++];
+  message->data1 = b->number;
+  if (b->kind == MIDI_OUTPUT_NOTE) {
+    message->status = (uint8_t)((pressed ? MIDI_NOTE_ON : MIDI_NOTE_OFF) | channel);
+    message->data2 = pressed ? b->pressValue : 0;
+  } else {
+    message->status = (uint8_t)(MIDI_CONTROL_CHANGE | channel);
+    message->data2 = pressed ? b->pressValue : b->releaseValue;
+  }
+  return true;
+}
+
+int midiService_flush(MidiService* midi) {
+  int delivered = 0;
+  for (int i = 0; i < midi->queued; i++) {
+    const MidiMessage* message = &midi->queue[i];
+    if (midi->sink.send && midi->sink.send(midi->sink.context, message->status, message->data1, message->data2)) {
+      delivered++;
+    } else {
+      midi->dropped++;
+    }
+  }
+  midi->queued = 0;
+  midi->sent += delivered;
+  return delivered;
+}
+
+void midiService_format(const MidiService* midi, char* buffer, size_t bufferSize) {
+  if (!buffer || bufferSize == 0) return;
+  
+  snprintf(buffer, bufferSize, "%d binding(s), %lu message(s) sent, %lu dropped",
+           midi->count, (unsigned long)midi->sent, (unsigned long)midi->dropped);
+}
@@ -0,0 +1,77 @@
+#ifndef MIDI_SERVICE_H
+#define MIDI_SERVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// MIDI output for pedals, as an alternative to keystrokes: a pedal key bound here sends a
+// control change (e.g. CC 64 sustain) or a note instead of typing. MIDI reaches the DAW
+// whether or not it has keyboard focus, and skips the host's key-repeat handling.
+// Driven from the keyboard service's pedal path on the HID output task: edges queue
+// messages, and keyboardService_flush() hands them to the sink with the HID report.
+
+#define MIDI_MAX_BINDINGS 16
+#define MIDI_QUEUE_CAPACITY 16
+
+typedef enum {
+  MIDI_OUTPUT_CC,    // Control change: pressValue on press, releaseValue on release
+  MIDI_OUTPUT_NOTE   // Note on (velocity pressValue) on press, note off on release
+} MidiOutputKind;
+
+typedef struct {
+  char key;              // The pedal's assigned key (0 ends a binding table)
+  MidiOutputKind kind;
+  uint8_t channel;       // 1..16
+  uint8_t number;        // Controller or note number, 0..127
+  uint8_t pressValue;    // CC value or note velocity (1..127)
+  uint8_t releaseValue;  // CC value on release; unused for notes
+} MidiBinding;
+
+// Where messages go: USB MIDI on the receiver (infrastructure/UsbMidi.h), a recorder in
+// host tests. send() returns false if the message could not be delivered.
+typedef struct {
+  bool (*send)(void* context, uint8_t status, uint8_t data1, uint8_t data2);
+  void* context;
+} MidiSink;
+
+typedef struct {
+  uint8_t status;
+  uint8_t data1;
+  uint8_t data2;
+} MidiMessage;
+
+typedef struct {
+  MidiSink sink;
+  MidiBinding bindings[MIDI_MAX_BINDINGS];
+  int count;
+  uint8_t byKey[128];    // Pedal key -> binding index + 1 (0 = typed as a key)
+  MidiMessage queue[MIDI_QUEUE_CAPACITY];
+  int queued;
+  
+  // Instrumentation
+  uint32_t sent;
+  uint32_t dropped;      // Queue full or refused by the sink
+} MidiService;
+
+void midiService_init(MidiService* midi, MidiSink sink);
+
+// Add (or replace) the binding for binding->key. False if the table is full or a field is
+// out of range.
+bool midiService_bind(MidiService* midi, const MidiBinding* binding);
+
+// Binding index for a pedal key, or -1 when the key is typed
+static inline int midiService_find(const MidiService* midi, char key) {
+  uint8_t c = (uint8_t)key;
+  return c < 128 ? (int)midi->byKey[c] - 1 : -1;
+}
+
+// Queue the message for a pedal edge; true if one was queued
+bool midiService_pedal(MidiService* midi, int binding, bool pressed);
+
+// Hand queued messages to the sink, in order; returns the number delivered
+int midiService_flush(MidiService* midi);
+
+void midiService_format(const MidiService* midi, char* buffer, size_t bufferSize);
+
+#endif // MIDI_SERVICE_H
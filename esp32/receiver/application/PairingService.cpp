@@ -4,24 +4,48 @@
 #include <Arduino.h>
 #include "../domain/SlotManager.h"
 #include "../shared/domain/PedalSlots.h"
+#include "../shared/domain/MacUtils.h"
+#include "../infrastructure/FlightRecorder.h"
 #include "../shared/config.h"
 
+static PairingEvent receiverPairingService_onPingSent(void* context, unsigned long now);
+static PairingEvent receiverPairingService_onInitialWaitDone(void* context, unsigned long now);
+static PairingEvent receiverPairingService_onBeaconDue(void* context, unsigned long now);
+static PairingEvent receiverPairingService_onGraceExpired(void* context, unsigned long now);
+static PairingEvent receiverPairingService_onSlotsFull(void* context, unsigned long now);
+
+// Receiver pairing flow - see docs/PAIRING_STATE_MACHINE.md
+static const PairingTransition pairingTransitions[] = {
+  {PAIRING_STATE_BOOT,         PAIRING_EVENT_PING_SENT,         PAIRING_STATE_INITIAL_WAIT,     receiverPairingService_onPingSent},
+  {PAIRING_STATE_INITIAL_WAIT, PAIRING_EVENT_INITIAL_WAIT_DONE, PAIRING_STATE_GRACE_PERIOD,     receiverPairingService_onInitialWaitDone},
+  {PAIRING_STATE_GRACE_PERIOD, PAIRING_EVENT_BEACON_DUE,        PAIRING_STATE_GRACE_PERIOD,     receiverPairingService_onBeaconDue},
+  {PAIRING_STATE_GRACE_PERIOD, PAIRING_EVENT_GRACE_EXPIRED,     PAIRING_STATE_NORMAL_OPERATION, receiverPairingService_onGraceExpired},
+  {PAIRING_STATE_GRACE_PERIOD, PAIRING_EVENT_SLOTS_FULL,        PAIRING_STATE_SLOTS_FULL,       receiverPairingService_onSlotsFull},
+};
+
+static void receiverPairingService_onTransition(void* context, PairingState from, PairingState to, PairingEvent event) {
+  flightRecorder_log(g_flightRecorder, FLIGHT_EVENT_PAIRING, (uint8_t)from, (uint8_t)to, (uint8_t)event, 0);
+}
+
 void receiverPairingService_init(ReceiverPairingService* service, TransmitterManager* manager, 
                                   ReceiverEspNowTransport* transport, unsigned long bootTime) {
   service->manager = manager;
   service->transport = transport;
   service->bootTime = bootTime;
-  service->lastBeaconTime = 0;
-  service->initialPingTime = 0;  // Will be set when ping is actually sent
-  service->gracePeriodCheckDone = false;
-  service->initialPingSent = false;
-  service->gracePeriodSkipped = false;
-  service->slotReassignmentDone = false;
+  service->graceStartTime = 0;
+  pairingStateMachine_init(&service->fsm, pairingTransitions,
+                           sizeof(pairingTransitions) / sizeof(pairingTransitions[0]),
+                           service, PAIRING_STATE_BOOT, bootTime);
+  pairingStateMachine_setObserver(&service->fsm, receiverPairingService_onTransition);
+  service->observedVersion = manager->version;
   service->debugCallback = NULL;
+  service->warmUnconfirmed = manager->responsive;  // Restored by persistence_load()
+  service->warmRestored = __builtin_popcount(manager->responsive);
+  service->warmReleased = 0;
   memset(service->pendingNewTransmitterMAC, 0, 6);
   service->waitingForAliveResponses = false;
+  service->alivePingTime = 0;
   service->aliveResponseTimeout = 0;
-  memset(service->transmitterResponded, false, sizeof(service->transmitterResponded));
 }
 
 void receiverPairingService_setDebugCallback(ReceiverPairingService* service, DebugCallback callback) {
@@ -38,7 +62,7 @@ void receiverPairingService_handleDiscoveryRequest(ReceiverPairingService* servi
   }
   
   // Reject new pairing requests if grace period was skipped (slots are full)
-  if (service->gracePeriodSkipped) {
+  if (receiverPairingService_isGracePeriodSkipped(service)) {
     if (service->debugCallback) {
       service->debugCallback("Discovery request rejected: grace period skipped (slots full)");
     }
@@ -46,13 +70,14 @@ void receiverPairingService_handleDiscoveryRequest(ReceiverPairingService* servi
   }
   
   // Check if this is a known transmitter (response to initial ping)
-  int knownIndex = transmitterManager_findIndex(service->manager, txMAC);
+  int knownIndex = transmitterManager_findIndex(service->manager, macAddr_fromBytes(txMAC));
   bool isKnownTransmitter = (knownIndex >= 0);
   
-  // Reject NEW pairing requests during initial ping wait period
+  // Reject NEW pairing requests until the initial ping wait is over
   // But ACCEPT discovery requests from known transmitters (they're responding to initial ping)
   unsigned long timeSinceBoot = currentTime - service->bootTime;
-  if (timeSinceBoot < INITIAL_PING_WAIT && !isKnownTransmitter) {
+  bool inInitialWait = (service->fsm.state == PAIRING_STATE_BOOT || service->fsm.state == PAIRING_STATE_INITIAL_WAIT);
+  if (inInitialWait && !isKnownTransmitter) {
     if (service->debugCallback) {
       service->debugCallback("Discovery request rejected: still in initial ping wait, not known transmitter");
     }
@@ -98,8 +123,10 @@ void receiverPairingService_handleDiscoveryRequest(ReceiverPairingService* servi
       return;
     }
     
-    service->manager->transmitters[knownIndex].seenOnBoot = true;
-    service->manager->transmitters[knownIndex].lastSeen = currentTime;
+    // New mode first, so a reconnecting transmitter allocates only the slots it needs now
+    transmitterManager_setPedalMode(service->manager, knownIndex, pedalMode);
+    transmitterManager_setResponsive(service->manager, knownIndex, true);
+    transmitterManager_renewLease(service->manager, knownIndex, currentTime);
   } else {
     // New transmitter - check if slots available using SlotManager
     if (!slotManager_canFitNewTransmitter(service->manager, slotsNeeded)) {
@@ -126,69 +153,35 @@ void receiverPairingService_handleDiscoveryRequest(ReceiverPairingService* servi
   }
   if (sent) {
     // Check if transmitter already exists
-    int existingIndex = transmitterManager_findIndex(service->manager, txMAC);
+    int existingIndex = transmitterManager_findIndex(service->manager, macAddr_fromBytes(txMAC));
     
     // Count how many responsive transmitters exist (excluding this one)
-    int responsiveCount = 0;
-    for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-      bool slotOccupied = false;
-      for (int j = 0; j < 6; j++) {
-        if (service->manager->transmitters[i].mac[j] != 0) {
-          slotOccupied = true;
-          break;
-        }
-      }
-      if (slotOccupied && service->manager->transmitters[i].seenOnBoot && i != existingIndex) {
-        responsiveCount++;
-      }
+    uint32_t others = service->manager->responsive;
+    if (existingIndex >= 0) {
+      others &= ~(1u << existingIndex);
     }
+    int responsiveCount = __builtin_popcount(others);
     
     // If this is the first responsive transmitter (or only one), ensure it goes to slot 0
     if (responsiveCount == 0) {
       // If transmitter already exists, just update it
       if (existingIndex >= 0) {
         // Update existing transmitter
-        service->manager->transmitters[existingIndex].seenOnBoot = true;
-        service->manager->transmitters[existingIndex].lastSeen = millis();
-        service->manager->transmitters[existingIndex].pedalMode = pedalMode;
+        transmitterManager_setResponsive(service->manager, existingIndex, true);
+        transmitterManager_renewLease(service->manager, existingIndex, millis());
+        transmitterManager_setPedalMode(service->manager, existingIndex, pedalMode);
       } else {
-        // New transmitter - find first empty slot (starting from 0)
-        int emptyIndex = -1;
-        for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-          bool isEmpty = true;
-          for (int j = 0; j < 6; j++) {
-            if (service->manager->transmitters[i].mac[j] != 0) {
-              isEmpty = false;
-              break;
-            }
-          }
-          if (isEmpty) {
-            emptyIndex = i;
-            break;
-          }
-        }
-        
-        if (emptyIndex >= 0) {
-          // Found empty slot - assign transmitter there
-          memcpy(service->manager->transmitters[emptyIndex].mac, txMAC, 6);
-          service->manager->transmitters[emptyIndex].pedalMode = pedalMode;
-          service->manager->transmitters[emptyIndex].seenOnBoot = true;
-          service->manager->transmitters[emptyIndex].lastSeen = millis();
-          
-          // Update count if needed
-          if (emptyIndex >= service->manager->count) {
-            service->manager->count = emptyIndex + 1;
-          }
-        }
+        // New transmitter - first empty slot (starting from 0), no stored slot budget check.
         // If no empty slot, receiver is full - can't add new transmitter
+        transmitterManager_place(service->manager, txMAC, pedalMode);
       }
     } else {
       // Use normal add function for subsequent transmitters
       // But if transmitter already exists, just update it
       if (existingIndex >= 0) {
-        service->manager->transmitters[existingIndex].seenOnBoot = true;
-        service->manager->transmitters[existingIndex].lastSeen = millis();
-        service->manager->transmitters[existingIndex].pedalMode = pedalMode;
+        transmitterManager_setResponsive(service->manager, existingIndex, true);
+        transmitterManager_renewLease(service->manager, existingIndex, millis());
+        transmitterManager_setPedalMode(service->manager, existingIndex, pedalMode);
       } else {
     transmitterManager_add(service->manager, txMAC, pedalMode);
       }
@@ -198,7 +191,7 @@ void receiverPairingService_handleDiscoveryRequest(ReceiverPairingService* servi
 
 void receiverPairingService_handleTransmitterOnline(ReceiverPairingService* service, const uint8_t* txMAC, 
                                                      uint8_t channel) {
-  int transmitterIndex = transmitterManager_findIndex(service->manager, txMAC);
+  int transmitterIndex = transmitterManager_findIndex(service->manager, macAddr_fromBytes(txMAC));
   
   if (transmitterIndex >= 0) {
     // Known transmitter (was paired before) - use SlotManager for checks
@@ -247,7 +240,7 @@ void receiverPairingService_handleTransmitterOnline(ReceiverPairingService* serv
           service->debugCallback("Transmitter %s not currently paired and slots full (%d + %d > %d) - not responding", 
                                  macStr, result.currentSlotsUsed, slotsNeeded, MAX_PEDAL_SLOTS);
         }
-        service->manager->transmitters[transmitterIndex].lastSeen = millis();
+        transmitterManager_renewLease(service->manager, transmitterIndex, millis());
         return;
       }
     }
@@ -282,9 +275,9 @@ void receiverPairingService_handleTransmitterOnline(ReceiverPairingService* serv
     }
     
     // Mark as seen now (since we're confirming pairing)
-    service->manager->transmitters[transmitterIndex].seenOnBoot = true;
+    transmitterManager_setResponsive(service->manager, transmitterIndex, true);
     
-    service->manager->transmitters[transmitterIndex].lastSeen = millis();
+    transmitterManager_renewLease(service->manager, transmitterIndex, millis());
   } else {
     // Unknown transmitter (or previously known but removed)
     int currentSlots = slotManager_getCurrentSlotsUsed(service->manager);
@@ -292,18 +285,26 @@ void receiverPairingService_handleTransmitterOnline(ReceiverPairingService* serv
     bool gracePeriodEnded = (timeSinceBoot >= TRANSMITTER_TIMEOUT);
     
     if (slotManager_areAllSlotsFull(service->manager)) {
-      // Receiver full - try to replace unresponsive transmitters
+      // Transmitters whose lease expired are asleep or gone - free their slots without a ping round
+      int released = transmitterManager_releaseExpired(service->manager, millis());
+      if (released > 0 && service->debugCallback) {
+        service->debugCallback("Released %d transmitter(s) with expired lease to make room", released);
+      }
+    }
+    
+    if (slotManager_areAllSlotsFull(service->manager)) {
+      // Receiver full and every lease is live - ping paired transmitters; the ones that stay
+      // silent until the timeout are released
       memcpy(service->pendingNewTransmitterMAC, txMAC, 6);
       
-      // Ping all paired transmitters
       struct_message ping = {MSG_ALIVE, 0, false, 0};
-      for (int i = 0; i < service->manager->count; i++) {
-        service->transmitterResponded[i] = false;
-        receiverEspNowTransport_send(service->transport, service->manager->transmitters[i].mac, 
+      for (uint32_t bits = service->manager->occupied; bits; bits &= bits - 1) {
+        receiverEspNowTransport_send(service->transport, service->manager->transmitters[__builtin_ctz(bits)].mac,
                                      (uint8_t*)&ping, sizeof(ping));
       }
       
       service->waitingForAliveResponses = true;
+      service->alivePingTime = millis();
       service->aliveResponseTimeout = millis() + ALIVE_RESPONSE_TIMEOUT;
     } else if (gracePeriodEnded) {
       // Grace period ended and slots available - send MSG_ALIVE to request discovery
@@ -328,40 +329,36 @@ void receiverPairingService_handleTransmitterPaired(ReceiverPairingService* serv
   uint8_t ourMAC[6];
   WiFi.macAddress(ourMAC);
   
-  int transmitterIndex = transmitterManager_findIndex(service->manager, txMAC);
-  bool pairedWithUs = (memcmp(rxMAC, ourMAC, 6) == 0);
+  int transmitterIndex = transmitterManager_findIndex(service->manager, macAddr_fromBytes(txMAC));
+  bool pairedWithUs = macEqual(rxMAC, ourMAC);
   
   if (transmitterIndex >= 0 && !pairedWithUs) {
     // Transmitter paired with another receiver - don't remove it
     // The transmitter will send DELETE_RECORD if it wants to be removed
     // Just update last seen to keep it in the list
-    service->manager->transmitters[transmitterIndex].lastSeen = millis();
+    transmitterManager_renewLease(service->manager, transmitterIndex, millis());
   } else if (transmitterIndex >= 0 && pairedWithUs) {
     // Transmitter paired with us - update last seen
-    service->manager->transmitters[transmitterIndex].lastSeen = millis();
-    if (!service->gracePeriodCheckDone) {
-      service->manager->transmitters[transmitterIndex].seenOnBoot = true;
+    transmitterManager_renewLease(service->manager, transmitterIndex, millis());
+    if (!receiverPairingService_isGracePeriodDone(service)) {
+      transmitterManager_setResponsive(service->manager, transmitterIndex, true);
     }
   }
 }
 
 void receiverPairingService_handleAlive(ReceiverPairingService* service, const uint8_t* txMAC) {
-  int transmitterIndex = transmitterManager_findIndex(service->manager, txMAC);
+  int transmitterIndex = transmitterManager_findIndex(service->manager, macAddr_fromBytes(txMAC));
   if (transmitterIndex >= 0) {
     // Known transmitter responded - keep it in its original slot
     bool wasSeen = service->manager->transmitters[transmitterIndex].seenOnBoot;
     
-    service->manager->transmitters[transmitterIndex].lastSeen = millis();
-    
-    if (service->waitingForAliveResponses) {
-      service->transmitterResponded[transmitterIndex] = true;
-    }
+    transmitterManager_renewLease(service->manager, transmitterIndex, millis());
     
     if (!wasSeen) {
       // First time this transmitter responded - mark as seen
       // Keep it in its original slot (don't reorder)
-      // calculateSlotsUsed() will count this transmitter now that seenOnBoot = true
-      service->manager->transmitters[transmitterIndex].seenOnBoot = true;
+      // Takes its slots back (its previous ones if still free)
+      transmitterManager_setResponsive(service->manager, transmitterIndex, true);
     }
   }
 }
@@ -391,12 +388,12 @@ void receiverPairingService_sendBeacon(ReceiverPairingService* service) {
 // This happens BEFORE grace period so known transmitters get priority
 // Transmitters will accept this immediately and restore their pairing state
 void receiverPairingService_pingKnownTransmittersOnBoot(ReceiverPairingService* service) {
-  if (service->initialPingSent) {
+  if (service->fsm.state != PAIRING_STATE_BOOT) {
     return;  // Already sent initial ping
   }
   
-  // Send MSG_PAIRING_CONFIRMED ONLY to known transmitters that are NOT currently paired (seenOnBoot = false)
-  // On boot, all transmitters loaded from EEPROM start with seenOnBoot = false
+  // Send MSG_PAIRING_CONFIRMED ONLY to known transmitters that are NOT currently paired (seenOnBoot = false),
+  // plus the warm-restored ones, whose answer confirms them
   // This gives them priority over new transmitters during grace period
   pairing_confirmed_message confirm;
   confirm.msgType = MSG_PAIRING_CONFIRMED;
@@ -408,18 +405,11 @@ void receiverPairingService_pingKnownTransmittersOnBoot(ReceiverPairingService*
   }
   
   for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-    // Check if slot is occupied
-    bool slotOccupied = false;
-    for (int j = 0; j < 6; j++) {
-      if (service->manager->transmitters[i].mac[j] != 0) {
-        slotOccupied = true;
-        break;
-      }
-    }
-    
     // Only send MSG_PAIRING_CONFIRMED to known transmitters that are NOT currently paired
     // (seenOnBoot = false means they haven't responded yet, so they're not currently paired)
-    if (slotOccupied && !service->manager->transmitters[i].seenOnBoot) {
+    bool unconfirmed = (service->warmUnconfirmed >> i) & 1;
+    if (transmitterManager_isPaired(service->manager, i) &&
+        (!service->manager->transmitters[i].seenOnBoot || unconfirmed)) {
       uint8_t* mac = service->manager->transmitters[i].mac;
       receiverEspNowTransport_addPeer(service->transport, mac, 0);
       bool sent = receiverEspNowTransport_send(service->transport, mac, (uint8_t*)&confirm, sizeof(confirm));
@@ -440,11 +430,6 @@ void receiverPairingService_pingKnownTransmittersOnBoot(ReceiverPairingService*
     }
   }
   
-  // Always set initialPingSent and initialPingTime, even if no transmitters to ping
-  // This ensures grace period timing is correct
-  service->initialPingSent = true;
-  service->initialPingTime = millis();  // Record when ping was actually sent
-  
   if (pingCount > 0) {
     if (service->debugCallback) {
       service->debugCallback("Initial pairing confirmation complete: %d previously known transmitter(s) notified (before grace period)", pingCount);
@@ -454,6 +439,9 @@ void receiverPairingService_pingKnownTransmittersOnBoot(ReceiverPairingService*
       service->debugCallback("No previously known transmitters to notify");
     }
   }
+  
+  // Post even if no transmitters were pinged - the initial wait is timed from here
+  pairingStateMachine_post(&service->fsm, PAIRING_EVENT_PING_SENT, millis());
 }
 
 void receiverPairingService_pingKnownTransmitters(ReceiverPairingService* service) {
@@ -474,199 +462,125 @@ void receiverPairingService_pingKnownTransmitters(ReceiverPairingService* servic
   // The initial ping on boot is sufficient
 }
 
-void receiverPairingService_update(ReceiverPairingService* service, unsigned long currentTime) {
-    unsigned long timeSinceBoot = currentTime - service->bootTime;
-  
-  // Wait 1 second after initial ping was sent, then check slot reassignment (only once)
-  // Only check if ping was actually sent and 1 second has elapsed since then
-  if (!service->slotReassignmentDone && service->initialPingSent && service->initialPingTime > 0) {
-    unsigned long timeSincePing = currentTime - service->initialPingTime;
-    if (timeSincePing >= INITIAL_PING_WAIT) {
-      service->slotReassignmentDone = true;
-    
-    // Count how many transmitters responded to initial ping
-    int responsiveCount = 0;
-    uint8_t responsiveMACs[2][6] = {0};
-    uint8_t responsivePedalModes[2] = {0};
-    
-    for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-      bool slotOccupied = false;
-      for (int j = 0; j < 6; j++) {
-        if (service->manager->transmitters[i].mac[j] != 0) {
-          slotOccupied = true;
-          break;
-        }
-      }
-      if (slotOccupied && service->manager->transmitters[i].seenOnBoot) {
-        if (responsiveCount < 2) {
-          memcpy(responsiveMACs[responsiveCount], service->manager->transmitters[i].mac, 6);
-          responsivePedalModes[responsiveCount] = service->manager->transmitters[i].pedalMode;
-          responsiveCount++;
-        }
-      }
-    }
-    
-    // If only 1 pedal responded, mark it as seen (keep it in its current slot)
-    // If 2 pedals responded, keep their slot assignments
-    if (responsiveCount == 1) {
-      // Find which slot the responsive transmitter is currently in
-      int currentSlot = transmitterManager_findIndex(service->manager, responsiveMACs[0]);
-      
-      if (currentSlot >= 0) {
-        // Transmitter already exists - just mark as seen
-        service->manager->transmitters[currentSlot].seenOnBoot = true;
-        service->manager->transmitters[currentSlot].lastSeen = millis();
-      }
-      
-      if (service->debugCallback) {
-        char macStr[18];
-        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-                 responsiveMACs[0][0], responsiveMACs[0][1], responsiveMACs[0][2],
-                 responsiveMACs[0][3], responsiveMACs[0][4], responsiveMACs[0][5]);
-        service->debugCallback("Single pedal responded - keeping in slot %d: %s", currentSlot + 1, macStr);
-      }
-    } else if (responsiveCount == 2) {
-      // Both pedals responded - keep their slot assignments (already in correct slots)
-      if (service->debugCallback) {
-        service->debugCallback("Both pedals responded - keeping slot assignments");
-      }
-    } else if (responsiveCount == 0) {
-      // No known transmitters responded after initial wait - they might come online later during grace period
-      if (service->debugCallback) {
-        service->debugCallback("No known pedals replied to initial ping - preserving loaded transmitters");
-      }
-      // Don't modify anything - transmitters remain loaded from EEPROM
-    }
-    }
+static PairingEvent receiverPairingService_onPingSent(void* context, unsigned long now) {
+  ReceiverPairingService* service = (ReceiverPairingService*)context;
+  pairingStateMachine_arm(&service->fsm, PAIRING_EVENT_INITIAL_WAIT_DONE, now + INITIAL_PING_WAIT);
+  return PAIRING_EVENT_NONE;
+}
+
+static PairingEvent receiverPairingService_onInitialWaitDone(void* context, unsigned long now) {
+  ReceiverPairingService* service = (ReceiverPairingService*)context;
+  service->graceStartTime = now;
+  
+  // Warm-restored transmitters that stayed silent are asleep or gone; they keep their
+  // preferred slots (and keys, unless someone else takes them) like any unresponsive one
+  for (uint32_t bits = service->warmUnconfirmed; bits; bits &= bits - 1) {
+    transmitterManager_setResponsive(service->manager, __builtin_ctz(bits), false);
+    service->warmReleased++;
+  }
+  service->warmUnconfirmed = 0;
+  if (service->warmReleased > 0 && service->debugCallback) {
+    service->debugCallback("%d of %d warm-restored transmitter(s) did not answer - releasing their slots",
+                          service->warmReleased, service->warmRestored);
   }
   
-  // Continue with grace period logic
-  // Check continuously if all slots are filled - end grace period early if so
-  // Note: Only bypass if transmitters RESPONDED during initial wait, not just if slots are reserved
-  // Only start grace period checks after initial ping was sent and 1 second has elapsed
-  if (!service->gracePeriodCheckDone && service->initialPingSent && service->initialPingTime > 0) {
-    unsigned long timeSincePing = currentTime - service->initialPingTime;
-    if (timeSincePing >= INITIAL_PING_WAIT) {
-    
-    // Check if all slots are filled by responsive transmitters (those that responded)
-    bool allSlotsFilled = slotManager_areAllSlotsFull(service->manager);
-    
-    if (allSlotsFilled) {
-      // All slots filled by responsive transmitters - bypass/end grace period
-      service->gracePeriodCheckDone = true;
-      service->gracePeriodSkipped = true;
-      
-      // Don't remove unresponsive transmitters - they stay in EEPROM until DELETE_RECORD is received
-      // Recalculate slotsUsed based on responsive transmitters only
-      int currentSlots = slotManager_getCurrentSlotsUsed(service->manager);
-      service->manager->slotsUsed = currentSlots;
-      
-      // Count paired transmitters (responsive ones)
-      int pairedCount = 0;
-      for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-        bool slotOccupied = false;
-        for (int j = 0; j < 6; j++) {
-          if (service->manager->transmitters[i].mac[j] != 0) {
-            slotOccupied = true;
-            break;
-          }
-        }
-        if (slotOccupied && service->manager->transmitters[i].seenOnBoot) {
-          pairedCount++;
-        }
-      }
-      
-      if (service->debugCallback) {
-        if (timeSinceBoot <= INITIAL_PING_WAIT + 100) {
-          // Slots filled immediately after initial wait - bypass grace period
-          service->debugCallback("All slots filled immediately - bypassing grace period: %d pedal(s) paired (%d/%d slots used)", 
-                                pairedCount, currentSlots, MAX_PEDAL_SLOTS);
-        } else {
-          // Slots filled during grace period - ended early
-          service->debugCallback("Grace period ended early: %d pedal(s) paired (%d/%d slots used)", 
-                                pairedCount, currentSlots, MAX_PEDAL_SLOTS);
-        }
-      }
-      return;  // End grace period, don't send beacons
+  // Transmitters that answered the initial ping already hold their slots (kept in their
+  // original positions); the rest stay loaded and can still come back during the grace period
+  int responsiveCount = transmitterManager_responsiveCount(service->manager);
+  if (service->debugCallback) {
+    if (responsiveCount == 0) {
+      service->debugCallback("No known pedals replied to initial ping - preserving loaded transmitters");
+    } else {
+      service->debugCallback("%d pedal(s) responded - keeping slot assignments", responsiveCount);
     }
-    
-    // Slots are available - continue grace period normally
-    // Grace period will continue until timeout or slots fill up (checked continuously above)
-    if (timeSinceBoot >= TRANSMITTER_TIMEOUT) {
-      // Grace period timeout reached
-      service->gracePeriodCheckDone = true;
-      
-      // After grace period timeout, update slotsUsed to match only responsive transmitters
-      // Don't remove unresponsive transmitters - they stay in EEPROM until DELETE_RECORD is received
-      // Recalculate slotsUsed based on responsive transmitters only
-      int finalSlots = slotManager_getCurrentSlotsUsed(service->manager);
-      service->manager->slotsUsed = finalSlots;
-      
-      // Count paired transmitters
-      int pairedCount = 0;
-      for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-        bool slotOccupied = false;
-        for (int j = 0; j < 6; j++) {
-          if (service->manager->transmitters[i].mac[j] != 0) {
-            slotOccupied = true;
-            break;
-          }
-        }
-        if (slotOccupied && service->manager->transmitters[i].seenOnBoot) {
-          pairedCount++;
-        }
-      }
-      
-      if (service->debugCallback) {
-        int reservedSlots = transmitterManager_calculateReservedSlots(service->manager);
-        if (pairedCount == 0) {
-          if (reservedSlots >= MAX_PEDAL_SLOTS) {
-            // All slots reserved by known transmitters, but none responded
-            service->debugCallback("Grace period ended: All slots reserved by known transmitters (%d/%d), but none replied - preserving loaded transmitters", 
-                                  reservedSlots, MAX_PEDAL_SLOTS);
-          } else {
-            // No slots reserved, no pedals paired
-            service->debugCallback("Grace period ended: No pedals paired - preserving loaded transmitters");
-          }
-        } else {
-          service->debugCallback("Grace period ended: %d pedal(s) paired (%d/%d slots used)", 
-                                pairedCount, finalSlots, MAX_PEDAL_SLOTS);
-        }
-      }
+  }
+  
+  pairingStateMachine_arm(&service->fsm, PAIRING_EVENT_GRACE_EXPIRED, service->bootTime + TRANSMITTER_TIMEOUT);
+  pairingStateMachine_arm(&service->fsm, PAIRING_EVENT_BEACON_DUE, now);
+  
+  // Only bypass if transmitters RESPONDED during the initial wait, not just if slots are reserved
+  return slotManager_areAllSlotsFull(service->manager) ? PAIRING_EVENT_SLOTS_FULL : PAIRING_EVENT_NONE;
+}
+
+static PairingEvent receiverPairingService_onBeaconDue(void* context, unsigned long now) {
+  ReceiverPairingService* service = (ReceiverPairingService*)context;
+  // Only beacon while slots are available (allows new pairing). Known transmitters are not
+  // pinged again - they answer the boot MSG_PAIRING_CONFIRMED when they come online.
+  if (!slotManager_areAllSlotsFull(service->manager)) {
+    receiverPairingService_sendBeacon(service);
+  }
+  pairingStateMachine_arm(&service->fsm, PAIRING_EVENT_BEACON_DUE, now + BEACON_INTERVAL);
+  return PAIRING_EVENT_NONE;
+}
+
+static PairingEvent receiverPairingService_onGraceExpired(void* context, unsigned long now) {
+  ReceiverPairingService* service = (ReceiverPairingService*)context;
+  if (!service->debugCallback) return PAIRING_EVENT_NONE;
+  
+  // Don't remove unresponsive transmitters - they stay in EEPROM until DELETE_RECORD is received
+  // (they no longer hold slots, so only responsive transmitters count)
+  int finalSlots = slotManager_getCurrentSlotsUsed(service->manager);
+  int pairedCount = transmitterManager_responsiveCount(service->manager);
+  int reservedSlots = transmitterManager_calculateReservedSlots(service->manager);
+  if (pairedCount == 0) {
+    if (reservedSlots >= MAX_PEDAL_SLOTS) {
+      // All slots reserved by known transmitters, but none responded
+      service->debugCallback("Grace period ended: All slots reserved by known transmitters (%d/%d), but none replied - preserving loaded transmitters", 
+                            reservedSlots, MAX_PEDAL_SLOTS);
+    } else {
+      // No slots reserved, no pedals paired
+      service->debugCallback("Grace period ended: No pedals paired - preserving loaded transmitters");
     }
-    // Note: If slots fill up during grace period, the check at the top of this block will catch it
-    // and end grace period early (already handled above)
-    }  // Close: if (timeSincePing >= INITIAL_PING_WAIT)
-  }  // Close: if (!service->gracePeriodCheckDone && service->initialPingSent && service->initialPingTime > 0)
-  
-  // Send beacons during grace period only (after initial wait)
-  // Only send beacons if slots are still available (known transmitters haven't filled all slots)
-  // Note: We don't ping known transmitters periodically - we already sent MSG_PAIRING_CONFIRMED on boot
-  // If they're online, they'll respond with pedal events or MSG_TRANSMITTER_ONLINE
-  // Only send beacons after initial ping was sent and 1 second has elapsed
-  if (!service->gracePeriodCheckDone && service->initialPingSent && service->initialPingTime > 0) {
-    unsigned long timeSincePing = currentTime - service->initialPingTime;
-    if (timeSincePing >= INITIAL_PING_WAIT) {
-      int currentSlots = transmitterManager_calculateSlotsUsed(service->manager);
-      bool slotsAvailable = (currentSlots < MAX_PEDAL_SLOTS);
-      
-      // Only send beacons if slots are available (allows new pairing)
-      // If all known transmitters responded, no beacons = no new pairing
-      if (slotsAvailable && (currentTime - service->lastBeaconTime > BEACON_INTERVAL)) {
-        receiverPairingService_sendBeacon(service);
-        service->lastBeaconTime = currentTime;
-      }
+  } else {
+    service->debugCallback("Grace period ended: %d pedal(s) paired (%d/%d slots used)", 
+                          pairedCount, finalSlots, MAX_PEDAL_SLOTS);
+  }
+  return PAIRING_EVENT_NONE;
+}
+
+static PairingEvent receiverPairingService_onSlotsFull(void* context, unsigned long now) {
+  ReceiverPairingService* service = (ReceiverPairingService*)context;
+  if (!service->debugCallback) return PAIRING_EVENT_NONE;
+  
+  // Don't remove unresponsive transmitters - they stay in EEPROM until DELETE_RECORD is received
+  int currentSlots = slotManager_getCurrentSlotsUsed(service->manager);
+  int pairedCount = transmitterManager_responsiveCount(service->manager);
+  if (now - service->graceStartTime <= 100) {
+    // Slots filled immediately after initial wait - bypass grace period
+    service->debugCallback("All slots filled immediately - bypassing grace period: %d pedal(s) paired (%d/%d slots used)", 
+                          pairedCount, currentSlots, MAX_PEDAL_SLOTS);
+  } else {
+    // Slots filled during grace period - ended early
+    service->debugCallback("Grace period ended early: %d pedal(s) paired (%d/%d slots used)", 
+                          pairedCount, currentSlots, MAX_PEDAL_SLOTS);
+  }
+  return PAIRING_EVENT_NONE;
+}
+
+void receiverPairingService_update(ReceiverPairingService* service, unsigned long currentTime) {
+  // Slot state only changes with the manager's version, so this is a compare on most passes
+  if (service->manager->version != service->observedVersion) {
+    service->observedVersion = service->manager->version;
+    if (slotManager_areAllSlotsFull(service->manager)) {
+      pairingStateMachine_post(&service->fsm, PAIRING_EVENT_SLOTS_FULL, currentTime);
     }
   }
   
+  pairingStateMachine_update(&service->fsm, currentTime);
+  
   // Check for transmitter replacement timeout
-  if (service->waitingForAliveResponses && currentTime >= service->aliveResponseTimeout) {
-    // Don't remove unresponsive transmitters - they stay in EEPROM until DELETE_RECORD is received
-    // Just send MSG_ALIVE to new transmitter if we have free slots
-    uint8_t broadcastMAC[] = BROADCAST_MAC;
+  if (service->waitingForAliveResponses && (long)(currentTime - service->aliveResponseTimeout) >= 0) {
+    // Don't remove unresponsive transmitters - they stay in EEPROM until DELETE_RECORD is received.
+    // Any frame renews a lease, so transmitters silent since the ping just lose their slots.
+    int released = transmitterManager_releaseSilentSince(service->manager, service->alivePingTime);
+    if (released > 0 && service->debugCallback) {
+      service->debugCallback("%d transmitter(s) did not answer MSG_ALIVE - releasing their slots", released);
+    }
+    
+    // Send MSG_ALIVE to new transmitter if we have free slots
     int currentSlots = slotManager_getCurrentSlotsUsed(service->manager);
     if (!slotManager_areAllSlotsFull(service->manager) && 
-        memcmp(service->pendingNewTransmitterMAC, broadcastMAC, 6) != 0) {
+        !macIsBroadcast(service->pendingNewTransmitterMAC)) {
       receiverEspNowTransport_addPeer(service->transport, service->pendingNewTransmitterMAC, 0);
       
       struct_message alive = {MSG_ALIVE, 0, false, 0};
@@ -677,7 +591,19 @@ void receiverPairingService_update(ReceiverPairingService* service, unsigned lon
     // Clear replacement state
     service->waitingForAliveResponses = false;
     memset(service->pendingNewTransmitterMAC, 0, 6);
+    service->alivePingTime = 0;
     service->aliveResponseTimeout = 0;
   }
 }
 
+unsigned long receiverPairingService_timeUntilNextMs(const ReceiverPairingService* service, unsigned long currentTime) {
+  unsigned long next = pairingStateMachine_timeUntilNextMs(&service->fsm, currentTime);
+  if (service->waitingForAliveResponses) {
+    long remaining = (long)(service->aliveResponseTimeout - currentTime);
+    unsigned long wait = remaining > 0 ? (unsigned long)remaining : 0;
+    if (wait < next) {
+      next = wait;
+    }
+  }
+  return next;
+}
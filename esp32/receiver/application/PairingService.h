@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include "../domain/TransmitterManager.h"
 #include "../domain/SlotManager.h"
+#include "../domain/PairingStateMachine.h"
 #include "../infrastructure/EspNowTransport.h"
 #include "../shared/messages.h"
 #include "../shared/config.h"
@@ -22,19 +23,23 @@ typedef struct {
   TransmitterManager* manager;
   ReceiverEspNowTransport* transport;
   unsigned long bootTime;
-  unsigned long lastBeaconTime;
-  unsigned long initialPingTime;  // Track when initial ping was sent (for 1-second wait)
-  bool gracePeriodCheckDone;
-  bool initialPingSent;  // Track if initial ping to known transmitters has been sent
-  bool gracePeriodSkipped;  // Track if grace period was skipped because slots are full
-  bool slotReassignmentDone;  // Track if slot reassignment check has been performed
+  unsigned long graceStartTime;
+  PairingStateMachine fsm;     // Boot / initial wait / grace period flow
+  uint32_t observedVersion;    // TransmitterManager version last checked for full slots
   DebugCallback debugCallback;  // Callback for debug messages
   
+  // Warm session: transmitters restored responsive from the last session are live at once
+  // and confirmed by their first frame; the ones still silent when the initial wait ends
+  // give their slots back
+  uint32_t warmUnconfirmed;     // Bit per position
+  int warmRestored;
+  int warmReleased;
+  
   // Transmitter replacement mechanism
   uint8_t pendingNewTransmitterMAC[6];
   bool waitingForAliveResponses;
+  unsigned long alivePingTime;  // Transmitters silent since this lose their slots at the timeout
   unsigned long aliveResponseTimeout;
-  bool transmitterResponded[MAX_PEDAL_SLOTS];
 } ReceiverPairingService;
 
 void receiverPairingService_init(ReceiverPairingService* service, TransmitterManager* manager, 
@@ -47,10 +52,29 @@ void receiverPairingService_handleTransmitterOnline(ReceiverPairingService* serv
 void receiverPairingService_handleTransmitterPaired(ReceiverPairingService* service, 
                                                      const transmitter_paired_message* msg);
 void receiverPairingService_handleAlive(ReceiverPairingService* service, const uint8_t* txMAC);
+// Any frame from the known transmitter at index (confirms a warm-restored one)
+static inline void receiverPairingService_noteFrame(ReceiverPairingService* service, int index) {
+  service->warmUnconfirmed &= ~(1u << index);
+}
 void receiverPairingService_sendBeacon(ReceiverPairingService* service);
 void receiverPairingService_pingKnownTransmittersOnBoot(ReceiverPairingService* service);  // Immediate ping on boot
 void receiverPairingService_pingKnownTransmitters(ReceiverPairingService* service);  // Periodic ping during grace period
 void receiverPairingService_update(ReceiverPairingService* service, unsigned long currentTime);
+// Milliseconds until the pairing flow has timed work to do (ULONG_MAX if none)
+unsigned long receiverPairingService_timeUntilNextMs(const ReceiverPairingService* service, unsigned long currentTime);
+
+static inline bool receiverPairingService_isInitialWait(const ReceiverPairingService* service) {
+  return service->fsm.state == PAIRING_STATE_INITIAL_WAIT;
+}
+
+// Grace period over (timed out, or skipped/ended early because slots filled)
+static inline bool receiverPairingService_isGracePeriodDone(const ReceiverPairingService* service) {
+  return service->fsm.state == PAIRING_STATE_NORMAL_OPERATION || service->fsm.state == PAIRING_STATE_SLOTS_FULL;
+}
+
+static inline bool receiverPairingService_isGracePeriodSkipped(const ReceiverPairingService* service) {
+  return service->fsm.state == PAIRING_STATE_SLOTS_FULL;
+}
 
 #endif // RECEIVER_PAIRING_SERVICE_H
 
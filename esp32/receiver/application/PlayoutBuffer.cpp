@@ -0,0 +1,171 @@
+#include "PlayoutBuffer.h"
+#include <string.h>
+#include <stdio.h>
+
+void playoutBuffer_init(PlayoutBuffer* playout, uint32_t delayMs) {
+  memset(playout, 0, sizeof(PlayoutBuffer));
+  playout->delayUs = delayMs * 1000;
+  latencyHistogram_init(&playout->rawJitter);
+  latencyHistogram_init(&playout->playedJitter);
+}
+
+static bool playoutBuffer_isDue(uint32_t dueUs, uint32_t nowUs) {
+  return (int32_t)(dueUs - nowUs) <= 0;
+}
+
+static void playoutBuffer_anchor(PlayoutBuffer* playout, PlayoutClock* clock, uint32_t sampleUs) {
+  clock->anchored = true;
+  clock->offsetUs = sampleUs;
+  playout->reanchors++;
+}
+
+uint32_t playoutBuffer_schedule(PlayoutBuffer* playout, int transmitterIndex, int pedal, bool pressed,
+                                uint32_t edgeUs, uint32_t rxUs, uint32_t nowUs) {
+  playout->scheduled++;
+  if (playout->delayUs == 0 || transmitterIndex < 0 || transmitterIndex >= MAX_PEDAL_SLOTS ||
+      pedal < 0 || pedal >= MAX_PEDAL_INPUTS) {
+    return nowUs;
+  }
+
+  PlayoutClock* clock = &playout->clocks[transmitterIndex];
+  uint32_t sampleUs = rxUs - edgeUs;
+
+  // A transmitter that rebooted or slept restarts its clock; a long silence lets drift build up
+  if (!clock->anchored || (int32_t)(edgeUs - clock->lastEdgeUs) < 0 ||
+      rxUs - clock->lastRxUs > (uint32_t)PLAYOUT_REANCHOR_MS * 1000) {
+    playoutBuffer_anchor(playout, clock, sampleUs);
+    clock->scheduledMask = 0;
+  } else if ((int32_t)(sampleUs - clock->offsetUs) < 0) {
+    clock->offsetUs = sampleUs;  // Faster delivery than any seen so far
+  }
+  clock->lastEdgeUs = edgeUs;
+  clock->lastRxUs = rxUs;
+
+  uint8_t bit = (uint8_t)(1u << pedal);
+  PlayoutInput* input = &clock->inputs[pedal];
+  uint32_t dueUs;
+  if (!pressed && (clock->scheduledMask & bit)) {
+    dueUs = input->dueUs + (edgeUs - input->edgeUs);  // Exactly the held duration after the press
+  } else {
+    dueUs = edgeUs + clock->offsetUs + playout->delayUs;
+    if (playoutBuffer_isDue(dueUs, nowUs) && clock->scheduledMask == 0) {
+      // Delivery got slower (drift, channel change) while nothing is held: re-measure
+      // rather than playing every following event late
+      playoutBuffer_anchor(playout, clock, sampleUs);
+      dueUs = edgeUs + clock->offsetUs + playout->delayUs;
+    }
+  }
+  if ((int32_t)(dueUs - clock->lastDueUs) < 0 && (clock->scheduledMask || clock->queued)) {
+    dueUs = clock->lastDueUs;  // Keep this transmitter's events in edge order
+  }
+  clock->lastDueUs = dueUs;
+
+  if (pressed) {
+    input->edgeUs = edgeUs;
+    input->dueUs = dueUs;
+    clock->scheduledMask |= bit;
+  } else {
+    clock->scheduledMask &= (uint8_t)~bit;
+  }
+
+  if (playoutBuffer_isDue(dueUs, nowUs)) {
+    playout->late++;
+  }
+  return dueUs;
+}
+
+// Insert after any event due at the same time (keeps arrival order)
+bool playoutBuffer_push(PlayoutBuffer* playout, const PlayoutEvent* event) {
+  if (playout->queued >= PLAYOUT_BUFFER_CAPACITY) {
+    playout->overflows++;
+    return false;
+  }
+  int pos = playout->queued;
+  while (pos > 0 && (int32_t)(playout->queue[pos - 1].dueUs - event->dueUs) > 0) {
+    playout->queue[pos] = playout->queue[pos - 1];
+    pos--;
+  }
+  playout->queue[pos] = *event;
+  playout->queued++;
+  playout->deferred++;
+  if (event->transmitterIndex >= 0 && event->transmitterIndex < MAX_PEDAL_SLOTS) {
+    playout->clocks[event->transmitterIndex].queued++;
+  }
+  return true;
+}
+
+bool playoutBuffer_popNext(PlayoutBuffer* playout, PlayoutEvent* event) {
+  if (playout->queued == 0) {
+    return false;
+  }
+  *event = playout->queue[0];
+  playout->queued--;
+  memmove(&playout->queue[0], &playout->queue[1], playout->queued * sizeof(PlayoutEvent));
+  if (event->transmitterIndex >= 0 && event->transmitterIndex < MAX_PEDAL_SLOTS) {
+    playout->clocks[event->transmitterIndex].queued--;
+  }
+  return true;
+}
+
+bool playoutBuffer_popDue(PlayoutBuffer* playout, uint32_t nowUs, PlayoutEvent* event) {
+  if (playout->queued == 0 || !playoutBuffer_isDue(playout->queue[0].dueUs, nowUs)) {
+    return false;
+  }
+  return playoutBuffer_popNext(playout, event);
+}
+
+bool playoutBuffer_evictEarliest(PlayoutBuffer* playout, uint32_t dueUs, PlayoutEvent* event) {
+  if (playout->queued < PLAYOUT_BUFFER_CAPACITY || !playoutBuffer_popDue(playout, dueUs, event)) {
+    return false;
+  }
+  playout->overflows++;
+  return true;
+}
+
+uint32_t playoutBuffer_timeUntilNextUs(const PlayoutBuffer* playout, uint32_t nowUs) {
+  if (playout->queued == 0) {
+    return PLAYOUT_NO_DEADLINE;
+  }
+  int32_t remaining = (int32_t)(playout->queue[0].dueUs - nowUs);
+  return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+static uint32_t playoutBuffer_spacingError(uint32_t actualUs, uint32_t originalUs) {
+  int32_t error = (int32_t)(actualUs - originalUs);
+  return error < 0 ? (uint32_t)-error : (uint32_t)error;
+}
+
+void playoutBuffer_notePlayed(PlayoutBuffer* playout, int transmitterIndex, int pedal, bool pressed,
+                              uint32_t edgeUs, uint32_t rxUs, uint32_t playedUs) {
+  if (transmitterIndex < 0 || transmitterIndex >= MAX_PEDAL_SLOTS || pedal < 0 || pedal >= MAX_PEDAL_INPUTS) {
+    return;
+  }
+
+  PlayoutClock* clock = &playout->clocks[transmitterIndex];
+  PlayoutInput* input = &clock->inputs[pedal];
+  uint8_t bit = (uint8_t)(1u << pedal);
+  if (pressed) {
+    input->playedEdgeUs = edgeUs;
+    input->rxUs = rxUs;
+    input->playedUs = playedUs;
+    clock->playedMask |= bit;
+    return;
+  }
+  if (!(clock->playedMask & bit)) {
+    return;  // Press was not timed (or predates a reboot) - nothing to compare against
+  }
+  clock->playedMask &= (uint8_t)~bit;
+
+  uint32_t heldUs = edgeUs - input->playedEdgeUs;
+  latencyHistogram_record(&playout->rawJitter, playoutBuffer_spacingError(rxUs - input->rxUs, heldUs));
+  latencyHistogram_record(&playout->playedJitter, playoutBuffer_spacingError(playedUs - input->playedUs, heldUs));
+}
+
+void playoutBuffer_format(const PlayoutBuffer* playout, char* buffer, size_t bufferSize) {
+  if (!buffer || bufferSize == 0) return;
+
+  snprintf(buffer, bufferSize, "%lums delay, %lu timed event(s), %lu deferred, %lu late, %lu overflow(s), %lu re-anchor(s)",
+           (unsigned long)(playout->delayUs / 1000), (unsigned long)playout->scheduled,
+           (unsigned long)playout->deferred, (unsigned long)playout->late,
+           (unsigned long)playout->overflows, (unsigned long)playout->reanchors);
+}
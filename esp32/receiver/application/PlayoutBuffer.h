@@ -0,0 +1,99 @@
+#ifndef PLAYOUT_BUFFER_H
+#define PLAYOUT_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../shared/config.h"
+#include "../shared/messages.h"
+#include "../shared/domain/MacUtils.h"
+#include "../shared/domain/PedalSlots.h"
+#include "../infrastructure/LatencyHistogram.h"
+
+// Jitter buffer for timed pedal events (MSG_PEDAL_EVENT_TIMED). Each transmitter's edge
+// clock is mapped onto ours with the smallest arrival-minus-edge offset seen (the fastest
+// delivery), and every edge is played at edge + offset + delay. A release is played exactly
+// its held duration after its press, so press/release spacing survives radio jitter up to
+// the delay; anything later plays on arrival and is counted as late.
+// Times are esp_timer microseconds truncated to 32 bits (wrap-safe), passed in by the caller.
+
+#define PLAYOUT_NO_DEADLINE 0xFFFFFFFFu
+
+// An event waiting for its playout time, with what keyboardService_handlePedalEvent() needs
+typedef struct {
+  uint32_t dueUs;
+  uint32_t edgeUs;
+  int64_t rxTimeUs;
+  MacAddr addr;
+  struct_message msg;
+  int8_t transmitterIndex;
+} PlayoutEvent;
+
+typedef struct {
+  uint32_t edgeUs;     // Scheduling: edge and playout time of the held press
+  uint32_t dueUs;
+  uint32_t playedEdgeUs;  // Measurement: the press as it arrived and as it was played
+  uint32_t rxUs;
+  uint32_t playedUs;
+} PlayoutInput;
+
+// Per-transmitter clock mapping
+typedef struct {
+  bool anchored;
+  uint32_t offsetUs;    // Arrival minus edge time for the fastest delivery since anchoring
+  uint32_t lastEdgeUs;
+  uint32_t lastRxUs;
+  uint32_t lastDueUs;   // Playout order never goes backwards for one transmitter
+  uint8_t scheduledMask;  // Bit per input with a press scheduled and its release not yet
+  uint8_t playedMask;     // Bit per input with a press played and its release not yet
+  uint8_t queued;         // This transmitter's events waiting in the queue
+  PlayoutInput inputs[MAX_PEDAL_INPUTS];
+} PlayoutClock;
+
+typedef struct {
+  uint32_t delayUs;  // 0 = play on arrival
+  PlayoutClock clocks[MAX_PEDAL_SLOTS];  // Indexed by transmitter slot
+  PlayoutEvent queue[PLAYOUT_BUFFER_CAPACITY];  // Earliest due first
+  int queued;
+
+  // Instrumentation
+  uint32_t scheduled;   // Timed events seen
+  uint32_t deferred;    // Events held back for their playout time
+  uint32_t late;        // Arrived after their playout time (played on arrival)
+  uint32_t overflows;   // Played ahead of their time because the queue was full
+  uint32_t reanchors;
+  LatencyHistogram rawJitter;     // |arrival spacing - edge spacing| per press/release pair
+  LatencyHistogram playedJitter;  // |played spacing - edge spacing| per press/release pair
+} PlayoutBuffer;
+
+void playoutBuffer_init(PlayoutBuffer* playout, uint32_t delayMs);
+
+// Playout time for an edge of one transmitter's pedal input (updates the clock mapping).
+// Due at or before nowUs means play it now.
+uint32_t playoutBuffer_schedule(PlayoutBuffer* playout, int transmitterIndex, int pedal, bool pressed,
+                                uint32_t edgeUs, uint32_t rxUs, uint32_t nowUs);
+
+// Hold an event until its dueUs; false if the queue is full (play it now instead)
+bool playoutBuffer_push(PlayoutBuffer* playout, const PlayoutEvent* event);
+
+// Queue full: take the earliest event if it is due no later than dueUs, to be played ahead
+// of time so an event due at dueUs fits without overtaking it. False if there is room or
+// every queued event is due later.
+bool playoutBuffer_evictEarliest(PlayoutBuffer* playout, uint32_t dueUs, PlayoutEvent* event);
+
+// Take the earliest event due at nowUs; false if none is due
+bool playoutBuffer_popDue(PlayoutBuffer* playout, uint32_t nowUs, PlayoutEvent* event);
+
+// Take the earliest event whatever its time; false if the queue is empty
+bool playoutBuffer_popNext(PlayoutBuffer* playout, PlayoutEvent* event);
+
+// Microseconds until the next event is due (0 if overdue), or PLAYOUT_NO_DEADLINE
+uint32_t playoutBuffer_timeUntilNextUs(const PlayoutBuffer* playout, uint32_t nowUs);
+
+// Record when an edge actually reached the report; a release closes its pair's jitter sample
+void playoutBuffer_notePlayed(PlayoutBuffer* playout, int transmitterIndex, int pedal, bool pressed,
+                              uint32_t edgeUs, uint32_t rxUs, uint32_t playedUs);
+
+void playoutBuffer_format(const PlayoutBuffer* playout, char* buffer, size_t bufferSize);
+
+#endif // PLAYOUT_BUFFER_H
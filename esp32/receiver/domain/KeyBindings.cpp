@@ -0,0 +1,89 @@
+#include "KeyBindings.h"
+#include <string.h>
+
+void keyBindings_init(KeyBindings* bindings) {
+  memset((void*)bindings, 0, sizeof(KeyBindings));
+  bindings->managerVersion = ~0u;  // Never matches, so the first refresh builds
+}
+
+static int keyBindings_build(KeyBinding* entries, const TransmitterManager* manager) {
+  int count = 0;
+  memset(entries, 0, sizeof(KeyBinding) * MAX_PEDAL_SLOTS);
+  
+  for (uint32_t bits = manager->occupied; bits; bits &= bits - 1) {
+    int i = __builtin_ctz(bits);
+    const TransmitterInfo* info = &manager->transmitters[i];
+    
+    KeyBinding* entry = &entries[count++];
+    entry->addr = macAddr_fromBytes(info->mac);
+    entry->transmitterIndex = (int8_t)i;
+    // Keys come from the transmitter's slots; inputs beyond its mode stay unbound
+    for (int input = 0; input < MAX_PEDAL_INPUTS; input++) {
+      entry->keys[input] = transmitterManager_getAssignedKey(manager, i, '1' + input);
+    }
+  }
+  return count;
+}
+
+bool keyBindings_refresh(KeyBindings* bindings, const TransmitterManager* manager) {
+  if (bindings->managerVersion == manager->version) {
+    return false;
+  }
+  
+  // Only this task flips active, so the published table is stable here
+  uint32_t current = bindings->active;
+  uint32_t target = current ^ 1;
+  KeyBindingTable* table = &bindings->tables[target];
+  
+  // A lookup that picked the target table before the last flip may still be reading it.
+  // Leave managerVersion stale so the next call retries instead of waiting here.
+  if (__atomic_load_n(&bindings->readers[target], __ATOMIC_SEQ_CST) != 0) {
+    bindings->deferred++;
+    return false;
+  }
+  bindings->managerVersion = manager->version;
+  
+  table->count = keyBindings_build(table->entries, manager);
+  const KeyBindingTable* published = &bindings->tables[current];
+  if (table->count == published->count &&
+      memcmp(table->entries, published->entries, sizeof(table->entries)) == 0) {
+    return false;
+  }
+  
+  macIndex_init(&table->index);
+  for (int i = 0; i < table->count; i++) {
+    macIndex_insert(&table->index, table->entries[i].addr, i);
+  }
+  
+  __atomic_store_n(&bindings->active, target, __ATOMIC_SEQ_CST);
+  bindings->rebuilds++;
+  return true;
+}
+
+bool keyBindings_lookup(KeyBindings* bindings, MacAddr mac, char pedalKey,
+                        KeyBindingAction* action) {
+  int pedal = getPedalInput(pedalKey);
+  
+  // Register in the table we are about to read, then confirm it is still the active one.
+  // A mismatch means a publish completed in between, so retrying never waits on the writer.
+  uint32_t active;
+  while (true) {
+    active = __atomic_load_n(&bindings->active, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&bindings->readers[active], 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&bindings->active, __ATOMIC_SEQ_CST) == active) break;
+    __atomic_fetch_sub(&bindings->readers[active], 1, __ATOMIC_SEQ_CST);
+  }
+  
+  const KeyBindingTable* table = &bindings->tables[active];
+  bool found = false;
+  int position = macIndex_find(&table->index, mac);
+  if (position >= 0 && position < table->count) {
+    const KeyBinding* entry = &table->entries[position];
+    action->transmitterIndex = entry->transmitterIndex;
+    action->key = (pedal >= 0) ? entry->keys[pedal] : 0;
+    found = true;
+  }
+  
+  __atomic_fetch_sub(&bindings->readers[active], 1, __ATOMIC_RELEASE);
+  return found;
+}
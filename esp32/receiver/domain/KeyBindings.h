@@ -0,0 +1,53 @@
+#ifndef KEY_BINDINGS_H
+#define KEY_BINDINGS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "TransmitterManager.h"
+#include "MacIndex.h"
+#include "../shared/domain/PedalSlots.h"
+
+// Precomputed (transmitter, pedal) -> key table for the pedal-event fast path.
+// Rebuilt by the housekeeping task whenever pairing or slot state changes and read by the
+// HID output task. Double-buffered: the writer fills the inactive table and publishes it by
+// flipping `active`, so a lookup never waits on the writer. Each table counts the lookups
+// inside it; the writer skips a table that still has readers and retries on its next call.
+
+typedef struct {
+  MacAddr addr;
+  int8_t transmitterIndex;
+  char keys[MAX_PEDAL_INPUTS];  // Key for pedal '1'..'8' (0 = unbound)
+} KeyBinding;
+
+typedef struct {
+  KeyBinding entries[MAX_PEDAL_SLOTS];
+  int count;
+  MacIndex index;  // MAC -> position in entries[]
+} KeyBindingTable;
+
+typedef struct {
+  KeyBindingTable tables[2];
+  volatile uint32_t active;      // Table lookups use
+  volatile uint32_t readers[2];  // Lookups in progress per table
+  uint32_t managerVersion;  // TransmitterManager version the active table was built from
+  uint32_t rebuilds;
+  uint32_t deferred;  // Publishes postponed because the target table was still being read
+} KeyBindings;
+
+typedef struct {
+  int transmitterIndex;
+  char key;  // 0 when this pedal has no binding (e.g. pedal '2' on a single-pedal transmitter)
+} KeyBindingAction;
+
+void keyBindings_init(KeyBindings* bindings);
+
+// Housekeeping side: recompute from the manager, publishing only if something changed.
+// O(1) when the manager's version is unchanged. Returns true when the table was republished;
+// a publish deferred by an in-flight lookup happens on a later call.
+bool keyBindings_refresh(KeyBindings* bindings, const TransmitterManager* manager);
+
+// Any task: resolve a pedal event without blocking. Returns false for unknown transmitters.
+bool keyBindings_lookup(KeyBindings* bindings, MacAddr mac, char pedalKey,
+                        KeyBindingAction* action);
+
+#endif // KEY_BINDINGS_H
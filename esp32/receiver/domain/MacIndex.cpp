@@ -0,0 +1,72 @@
+#include "MacIndex.h"
+#include <string.h>
+
+static_assert((MAC_INDEX_BUCKETS & (MAC_INDEX_BUCKETS - 1)) == 0, "MAC_INDEX_BUCKETS must be a power of two");
+static_assert(MAC_INDEX_BUCKETS >= 2 * MAX_PEDAL_SLOTS, "MAC_INDEX_BUCKETS too small for MAX_PEDAL_SLOTS");
+
+#define MAC_INDEX_MASK (MAC_INDEX_BUCKETS - 1)
+
+static inline uint32_t macIndex_home(MacAddr key) {
+  return (macAddr_hash(key) >> 8) & MAC_INDEX_MASK;
+}
+
+void macIndex_init(MacIndex* index) {
+  memset(index, 0, sizeof(MacIndex));
+}
+
+int macIndex_find(const MacIndex* index, MacAddr key) {
+  if (macAddr_isZero(key)) return -1;
+  
+  // Bounded so a lookup on a full table still terminates
+  uint32_t slot = macIndex_home(key);
+  for (int probes = 0; probes < MAC_INDEX_BUCKETS; probes++, slot = (slot + 1) & MAC_INDEX_MASK) {
+    if (macAddr_equal(index->keys[slot], key)) return index->values[slot];
+    if (macAddr_isZero(index->keys[slot])) return -1;
+  }
+  return -1;
+}
+
+bool macIndex_insert(MacIndex* index, MacAddr key, int value) {
+  if (macAddr_isZero(key)) return false;
+  
+  for (uint32_t slot = macIndex_home(key); ; slot = (slot + 1) & MAC_INDEX_MASK) {
+    if (macAddr_equal(index->keys[slot], key)) {
+      index->values[slot] = (int8_t)value;
+      return true;
+    }
+    if (macAddr_isZero(index->keys[slot])) {
+      if (index->count >= MAC_INDEX_BUCKETS - 1) return false;  // Keep one bucket empty to end probes
+      index->keys[slot] = key;
+      index->values[slot] = (int8_t)value;
+      index->count++;
+      return true;
+    }
+  }
+}
+
+void macIndex_remove(MacIndex* index, MacAddr key) {
+  if (macAddr_isZero(key)) return;
+  
+  uint32_t slot = macIndex_home(key);
+  while (!macAddr_equal(index->keys[slot], key)) {
+    if (macAddr_isZero(index->keys[slot])) return;  // Not present
+    slot = (slot + 1) & MAC_INDEX_MASK;
+  }
+  
+  // Backward-shift: pull later entries of the probe run into the hole if their home
+  // position allows it, so lookups never need tombstones
+  uint32_t hole = slot;
+  for (uint32_t next = (hole + 1) & MAC_INDEX_MASK; !macAddr_isZero(index->keys[next]); next = (next + 1) & MAC_INDEX_MASK) {
+    uint32_t home = macIndex_home(index->keys[next]);
+    // Entry at next may move to hole unless its home lies cyclically in (hole, next]
+    bool homeBetween = (hole <= next) ? (home > hole && home <= next) : (home > hole || home <= next);
+    if (!homeBetween) {
+      index->keys[hole] = index->keys[next];
+      index->values[hole] = index->values[next];
+      hole = next;
+    }
+  }
+  index->keys[hole] = MAC_ADDR_ZERO;
+  index->values[hole] = 0;
+  index->count--;
+}
@@ -0,0 +1,27 @@
+#ifndef MAC_INDEX_H
+#define MAC_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../shared/config.h"
+#include "../shared/domain/MacUtils.h"
+
+// Open-addressed hash index from a 48-bit MAC address to a small table index.
+// Linear probing with backward-shift deletion (no tombstones), sized at least twice the
+// number of transmitters so probe sequences stay short. The all-zero MAC marks an empty
+// bucket; it is never a valid transmitter address.
+
+#define MAC_INDEX_BUCKETS 64  // Power of two, >= 2 * MAX_PEDAL_SLOTS
+
+typedef struct {
+  MacAddr keys[MAC_INDEX_BUCKETS];   // MAC_ADDR_ZERO = empty
+  int8_t values[MAC_INDEX_BUCKETS];
+  int count;
+} MacIndex;
+
+void macIndex_init(MacIndex* index);
+int macIndex_find(const MacIndex* index, MacAddr mac);  // -1 if absent
+bool macIndex_insert(MacIndex* index, MacAddr mac, int value);  // Inserts or updates
+void macIndex_remove(MacIndex* index, MacAddr mac);
+
+#endif // MAC_INDEX_H
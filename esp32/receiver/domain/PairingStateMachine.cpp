@@ -0,0 +1,139 @@
+#include "PairingStateMachine.h"
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+
+// Follow-up events chained from one post; a table with a cycle stops here
+#define PAIRING_MAX_FOLLOW_UPS 4
+
+static const char* const stateNames[PAIRING_STATE_COUNT] = {
+  "BOOT", "INITIAL_WAIT", "GRACE_PERIOD", "NORMAL_OPERATION", "SLOTS_FULL"
+};
+
+void pairingStateMachine_init(PairingStateMachine* fsm, const PairingTransition* table, int tableSize,
+                              void* context, PairingState initial, unsigned long now) {
+  memset(fsm, 0, sizeof(PairingStateMachine));
+  fsm->table = table;
+  fsm->tableSize = (tableSize > PAIRING_MAX_TRANSITIONS) ? PAIRING_MAX_TRANSITIONS : tableSize;
+  fsm->context = context;
+  fsm->state = initial;
+  fsm->stateEnteredAt = now;
+}
+
+void pairingStateMachine_setObserver(PairingStateMachine* fsm, PairingObserver observer) {
+  fsm->observer = observer;
+}
+
+static int pairingStateMachine_findRow(const PairingStateMachine* fsm, PairingEvent event) {
+  for (int i = 0; i < fsm->tableSize; i++) {
+    if (fsm->table[i].from == fsm->state && fsm->table[i].event == event) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool pairingStateMachine_post(PairingStateMachine* fsm, PairingEvent event, unsigned long now) {
+  bool handled = false;
+
+  for (int chain = 0; event != PAIRING_EVENT_NONE && chain <= PAIRING_MAX_FOLLOW_UPS; chain++) {
+    int row = pairingStateMachine_findRow(fsm, event);
+    if (row < 0) {
+      fsm->ignoredEvents++;
+      break;
+    }
+
+    const PairingTransition* transition = &fsm->table[row];
+    fsm->transitionCounts[row]++;
+    if (transition->to != fsm->state) {
+      if (fsm->observer) {
+        fsm->observer(fsm->context, fsm->state, transition->to, event);
+      }
+      fsm->dwellMs[fsm->state] += now - fsm->stateEnteredAt;
+      fsm->state = transition->to;
+      fsm->stateEnteredAt = now;
+      fsm->armed = 0;  // Timers belong to the state that armed them
+    }
+    if (chain == 0) {
+      handled = true;
+    }
+
+    event = transition->action ? transition->action(fsm->context, now) : PAIRING_EVENT_NONE;
+  }
+  return handled;
+}
+
+void pairingStateMachine_arm(PairingStateMachine* fsm, PairingEvent event, unsigned long deadline) {
+  if (event <= PAIRING_EVENT_NONE || event >= PAIRING_EVENT_COUNT) return;
+  fsm->deadline[event] = deadline;
+  fsm->armed |= 1u << event;
+}
+
+void pairingStateMachine_disarm(PairingStateMachine* fsm, PairingEvent event) {
+  if (event <= PAIRING_EVENT_NONE || event >= PAIRING_EVENT_COUNT) return;
+  fsm->armed &= ~(1u << event);
+}
+
+int pairingStateMachine_update(PairingStateMachine* fsm, unsigned long now) {
+  int posted = 0;
+  // Each post can re-arm or clear timers, so rescan after every one
+  for (uint32_t due = 1; due && fsm->armed; ) {
+    due = 0;
+    for (uint32_t bits = fsm->armed; bits; bits &= bits - 1) {
+      int event = __builtin_ctz(bits);
+      if ((long)(now - fsm->deadline[event]) >= 0) {
+        due = 1;
+        fsm->armed &= ~(1u << event);
+        pairingStateMachine_post(fsm, (PairingEvent)event, now);
+        posted++;
+        break;
+      }
+    }
+  }
+  return posted;
+}
+
+unsigned long pairingStateMachine_timeUntilNextMs(const PairingStateMachine* fsm, unsigned long now) {
+  unsigned long next = ULONG_MAX;
+  for (uint32_t bits = fsm->armed; bits; bits &= bits - 1) {
+    long remaining = (long)(fsm->deadline[__builtin_ctz(bits)] - now);
+    unsigned long wait = remaining > 0 ? (unsigned long)remaining : 0;
+    if (wait < next) {
+      next = wait;
+    }
+  }
+  return next;
+}
+
+unsigned long pairingStateMachine_dwellMs(const PairingStateMachine* fsm, PairingState state, unsigned long now) {
+  if (state < 0 || state >= PAIRING_STATE_COUNT) return 0;
+  unsigned long dwell = fsm->dwellMs[state];
+  if (state == fsm->state) {
+    dwell += now - fsm->stateEnteredAt;
+  }
+  return dwell;
+}
+
+const char* pairingStateMachine_stateName(PairingState state) {
+  if (state < 0 || state >= PAIRING_STATE_COUNT) return "?";
+  return stateNames[state];
+}
+
+void pairingStateMachine_format(const PairingStateMachine* fsm, unsigned long now, char* buffer, size_t bufferSize) {
+  if (!buffer || bufferSize == 0) return;
+
+  uint32_t transitions = 0;
+  for (int i = 0; i < fsm->tableSize; i++) {
+    transitions += fsm->transitionCounts[i];
+  }
+  int len = snprintf(buffer, bufferSize, "%s, %lu transition(s), %lu ignored event(s) |",
+                     pairingStateMachine_stateName(fsm->state), (unsigned long)transitions,
+                     (unsigned long)fsm->ignoredEvents);
+
+  // Append visited states as "name:dwellMs"
+  for (int i = 0; i < PAIRING_STATE_COUNT && len > 0 && len < (int)bufferSize; i++) {
+    unsigned long dwell = pairingStateMachine_dwellMs(fsm, (PairingState)i, now);
+    if (dwell == 0 && i != fsm->state) continue;
+    len += snprintf(buffer + len, bufferSize - len, " %s:%lums", stateNames[i], dwell);
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef PAIRING_STATE_MACHINE_H
+#define PAIRING_STATE_MACHINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Table-driven state machine for the receiver pairing flow (docs/PAIRING_STATE_MACHINE.md).
+// Events come from the pairing service or from timers armed by transition actions; work
+// only happens when a row of the table matches. No Arduino dependencies, so scripted
+// event sequences can run on the host.
+
+typedef enum {
+  PAIRING_STATE_BOOT,              // Known transmitters not pinged yet
+  PAIRING_STATE_INITIAL_WAIT,      // Known transmitters pinged, waiting INITIAL_PING_WAIT_MS for replies
+  PAIRING_STATE_GRACE_PERIOD,      // Beaconing, new transmitters can pair
+  PAIRING_STATE_NORMAL_OPERATION,  // Grace period timed out
+  PAIRING_STATE_SLOTS_FULL,        // Grace period skipped/ended early because all slots filled
+  PAIRING_STATE_COUNT
+} PairingState;
+
+typedef enum {
+  PAIRING_EVENT_NONE,
+  PAIRING_EVENT_PING_SENT,           // Initial MSG_PAIRING_CONFIRMED round sent
+  PAIRING_EVENT_INITIAL_WAIT_DONE,   // Timer
+  PAIRING_EVENT_BEACON_DUE,          // Timer
+  PAIRING_EVENT_GRACE_EXPIRED,       // Timer
+  PAIRING_EVENT_SLOTS_FULL,          // Every slot is held by a responsive transmitter
+  PAIRING_EVENT_COUNT
+} PairingEvent;
+
+// Runs after the state changed; may return a follow-up event (PAIRING_EVENT_NONE for none)
+typedef PairingEvent (*PairingAction)(void* context, unsigned long now);
+// Told about every state change, before the row's action runs
+typedef void (*PairingObserver)(void* context, PairingState from, PairingState to, PairingEvent event);
+
+typedef struct {
+  PairingState from;
+  PairingEvent event;
+  PairingState to;
+  PairingAction action;  // May be NULL
+} PairingTransition;
+
+#define PAIRING_MAX_TRANSITIONS 16
+
+typedef struct {
+  const PairingTransition* table;
+  int tableSize;
+  void* context;
+  PairingObserver observer;  // May be NULL
+
+  PairingState state;
+  unsigned long stateEnteredAt;
+
+  // One-shot timers, one per event. Leaving a state disarms all of them.
+  unsigned long deadline[PAIRING_EVENT_COUNT];
+  uint32_t armed;  // Bit per event
+
+  // Instrumentation
+  uint32_t transitionCounts[PAIRING_MAX_TRANSITIONS];  // Per table row
+  unsigned long dwellMs[PAIRING_STATE_COUNT];          // Completed time in each state
+  uint32_t ignoredEvents;                              // Events with no row for the current state
+} PairingStateMachine;
+
+void pairingStateMachine_init(PairingStateMachine* fsm, const PairingTransition* table, int tableSize,
+                              void* context, PairingState initial, unsigned long now);
+void pairingStateMachine_setObserver(PairingStateMachine* fsm, PairingObserver observer);
+
+// Run the matching row (and any follow-up events). Returns false if the event was ignored.
+bool pairingStateMachine_post(PairingStateMachine* fsm, PairingEvent event, unsigned long now);
+
+void pairingStateMachine_arm(PairingStateMachine* fsm, PairingEvent event, unsigned long deadline);
+void pairingStateMachine_disarm(PairingStateMachine* fsm, PairingEvent event);
+
+// Post every timer event that is due; returns the number posted
+int pairingStateMachine_update(PairingStateMachine* fsm, unsigned long now);
+// Milliseconds until the next armed timer (0 if one is due, ULONG_MAX if none is armed)
+unsigned long pairingStateMachine_timeUntilNextMs(const PairingStateMachine* fsm, unsigned long now);
+
+// Total time spent in state, including the current visit
+unsigned long pairingStateMachine_dwellMs(const PairingStateMachine* fsm, PairingState state, unsigned long now);
+const char* pairingStateMachine_stateName(PairingState state);
+void pairingStateMachine_format(const PairingStateMachine* fsm, unsigned long now, char* buffer, size_t bufferSize);
+
+#endif // PAIRING_STATE_MACHINE_H
@@ -0,0 +1,47 @@
+#include "SlotAllocator.h"
+
+void slotAllocator_init(SlotAllocator* allocator) {
+  allocator->allocated = 0;
+}
+
+uint32_t slotAllocator_lowestBits(uint32_t bits, int count) {
+  uint32_t mask = 0;
+  while (bits && count-- > 0) {
+    uint32_t lowest = bits & (~bits + 1);
+    mask |= lowest;
+    bits &= bits - 1;
+  }
+  return mask;
+}
+
+uint32_t slotAllocator_allocate(SlotAllocator* allocator, uint32_t preferredMask, int slotsNeeded) {
+  if (slotsNeeded <= 0 || !slotAllocator_canFit(allocator, slotsNeeded)) {
+    return 0;
+  }
+  
+  uint32_t freeBits = SLOT_ALLOCATOR_ALL & ~allocator->allocated;
+  uint32_t mask = slotAllocator_lowestBits(preferredMask & freeBits, slotsNeeded);
+  mask |= slotAllocator_lowestBits(freeBits & ~mask, slotsNeeded - __builtin_popcount(mask));
+  allocator->allocated |= mask;
+  return mask;
+}
+
+void slotAllocator_release(SlotAllocator* allocator, uint32_t mask) {
+  allocator->allocated &= ~mask;
+}
+
+uint32_t slotAllocator_resize(SlotAllocator* allocator, uint32_t mask, int slotsNeeded) {
+  int current = __builtin_popcount(mask);
+  if (slotsNeeded <= current) {
+    uint32_t kept = slotAllocator_lowestBits(mask, slotsNeeded);
+    slotAllocator_release(allocator, mask & ~kept);
+    return kept;
+  }
+  
+  if (!slotAllocator_canFit(allocator, slotsNeeded - current)) {
+    return mask;
+  }
+  uint32_t added = slotAllocator_lowestBits(SLOT_ALLOCATOR_ALL & ~allocator->allocated, slotsNeeded - current);
+  allocator->allocated |= added;
+  return mask | added;
+}
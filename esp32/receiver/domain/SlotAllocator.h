@@ -0,0 +1,44 @@
+#ifndef SLOT_ALLOCATOR_H
+#define SLOT_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../shared/config.h"
+
+// Bitmap of pedal slots held by responsive transmitters. Each transmitter owns a slot mask
+// (one bit per input); admission and usage queries are a mask and a popcount.
+
+static_assert(MAX_PEDAL_SLOTS <= 32, "Slot bitmap is 32 bits wide");
+#define SLOT_ALLOCATOR_ALL ((MAX_PEDAL_SLOTS == 32) ? 0xFFFFFFFFu : ((1u << MAX_PEDAL_SLOTS) - 1))
+
+typedef struct {
+  uint32_t allocated;
+} SlotAllocator;
+
+static inline int slotAllocator_usedCount(const SlotAllocator* allocator) {
+  return __builtin_popcount(allocator->allocated);
+}
+
+static inline int slotAllocator_freeCount(const SlotAllocator* allocator) {
+  return __builtin_popcount(SLOT_ALLOCATOR_ALL & ~allocator->allocated);
+}
+
+static inline bool slotAllocator_canFit(const SlotAllocator* allocator, int slotsNeeded) {
+  return slotAllocator_freeCount(allocator) >= slotsNeeded;
+}
+
+void slotAllocator_init(SlotAllocator* allocator);
+
+// Allocate slotsNeeded slots, reusing free bits of preferredMask first. Returns the new
+// mask, or 0 (nothing allocated) if there is not enough room.
+uint32_t slotAllocator_allocate(SlotAllocator* allocator, uint32_t preferredMask, int slotsNeeded);
+void slotAllocator_release(SlotAllocator* allocator, uint32_t mask);
+
+// Grow or shrink an allocated mask in place, keeping its lowest bits. Returns the new mask,
+// or the unchanged mask if growing does not fit.
+uint32_t slotAllocator_resize(SlotAllocator* allocator, uint32_t mask, int slotsNeeded);
+
+// Lowest count set bits of bits
+uint32_t slotAllocator_lowestBits(uint32_t bits, int count);
+
+#endif // SLOT_ALLOCATOR_H
@@ -3,8 +3,7 @@
 #include "../shared/config.h"
 
 bool slotManager_canFitNewTransmitter(const TransmitterManager* manager, int slotsNeeded) {
-  int currentSlots = transmitterManager_calculateSlotsUsed(manager);
-  return (currentSlots + slotsNeeded <= MAX_PEDAL_SLOTS);
+  return slotAllocator_canFit(&manager->slots, slotsNeeded);
 }
 
 SlotAvailabilityResult slotManager_checkModeChange(const TransmitterManager* manager, 
@@ -16,19 +15,14 @@ SlotAvailabilityResult slotManager_checkModeChange(const TransmitterManager* man
     return result;
   }
   
-  result.currentSlotsUsed = transmitterManager_calculateSlotsUsed(manager);
-  int oldSlotsNeeded = getSlotsNeeded(manager->transmitters[transmitterIndex].pedalMode);
+  const TransmitterInfo* info = &manager->transmitters[transmitterIndex];
+  result.currentSlotsUsed = slotAllocator_usedCount(&manager->slots);
   
-  if (newSlotsNeeded == oldSlotsNeeded) {
-    // No change - always fits
-    result.canFit = true;
-    result.slotsAfterChange = result.currentSlotsUsed;
-    return result;
-  }
-  
-  // Calculate slots after mode change
-  result.slotsAfterChange = result.currentSlotsUsed - oldSlotsNeeded + newSlotsNeeded;
-  result.canFit = (result.slotsAfterChange <= MAX_PEDAL_SLOTS);
+  // Slots it holds now (only while responsive) count as free for its new mode
+  uint32_t held = info->seenOnBoot ? info->slotMask : 0;
+  int available = slotAllocator_freeCount(&manager->slots) + __builtin_popcount(held);
+  result.slotsAfterChange = result.currentSlotsUsed - __builtin_popcount(held) + newSlotsNeeded;
+  result.canFit = (newSlotsNeeded <= available);
   
   return result;
 }
@@ -43,7 +37,7 @@ SlotAvailabilityResult slotManager_checkReconnection(const TransmitterManager* m
   }
   
   bool wasAlreadyResponsive = manager->transmitters[transmitterIndex].seenOnBoot;
-  result.currentSlotsUsed = transmitterManager_calculateSlotsUsed(manager);
+  result.currentSlotsUsed = slotAllocator_usedCount(&manager->slots);
   
   if (wasAlreadyResponsive) {
     // Already responsive - no change in slot usage
@@ -52,20 +46,20 @@ SlotAvailabilityResult slotManager_checkReconnection(const TransmitterManager* m
   } else {
     // Becoming responsive - add its slots
     result.slotsAfterChange = result.currentSlotsUsed + slotsNeeded;
-    result.canFit = (result.slotsAfterChange <= MAX_PEDAL_SLOTS);
+    result.canFit = slotAllocator_canFit(&manager->slots, slotsNeeded);
   }
   
   return result;
 }
 
 int slotManager_getCurrentSlotsUsed(const TransmitterManager* manager) {
-  return transmitterManager_calculateSlotsUsed(manager);
+  return slotAllocator_usedCount(&manager->slots);
 }
 
 int slotManager_getAvailableSlots(const TransmitterManager* manager) {
-  return MAX_PEDAL_SLOTS - slotManager_getCurrentSlotsUsed(manager);
+  return slotAllocator_freeCount(&manager->slots);
 }
 
 bool slotManager_areAllSlotsFull(const TransmitterManager* manager) {
-  return slotManager_getCurrentSlotsUsed(manager) >= MAX_PEDAL_SLOTS;
+  return (manager->slots.allocated & SLOT_ALLOCATOR_ALL) == SLOT_ALLOCATOR_ALL;
 }
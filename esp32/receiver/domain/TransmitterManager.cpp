@@ -1,168 +1,244 @@
 #include "TransmitterManager.h"
 #include <string.h>
 #include <Arduino.h>
+#include "../shared/config.h"
+#include "../shared/domain/PedalSlots.h"
+
+// Key typed for each pedal slot. 'l' and 'r' come first so a receiver with one or two
+// transmitters types the same keys as before.
+static const char keyPool[] = "lr" "abcdefghijkmnopqstuvwxyz" "123456";
+static_assert(sizeof(keyPool) - 1 >= MAX_PEDAL_SLOTS, "Key pool smaller than MAX_PEDAL_SLOTS");
+
+static bool transmitterManager_hasMAC(const TransmitterInfo* info) {
+  return !macAddr_isZero(macAddr_fromBytes(info->mac));
+}
+
+static void transmitterManager_updateCount(TransmitterManager* manager) {
+  manager->count = manager->occupied ? 32 - __builtin_clz(manager->occupied) : 0;
+}
 
 void transmitterManager_init(TransmitterManager* manager) {
   memset(manager->transmitters, 0, sizeof(manager->transmitters));
   manager->count = 0;
-  manager->slotsUsed = 0;
+  manager->occupied = 0;
+  manager->responsive = 0;
+  manager->reservedSlots = 0;
+  manager->version = 0;
+  slotAllocator_init(&manager->slots);
+  macIndex_init(&manager->index);
 }
 
-int transmitterManager_findIndex(const TransmitterManager* manager, const uint8_t* mac) {
-  // Search all slots (not just up to count) since we now allow gaps
-  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-    if (memcmp(mac, manager->transmitters[i].mac, 6) == 0) {
-      return i;
-    }
-  }
-  return -1;
+int transmitterManager_findIndex(const TransmitterManager* manager, MacAddr mac) {
+  return macIndex_find(&manager->index, mac);
 }
 
 bool transmitterManager_add(TransmitterManager* manager, const uint8_t* mac, uint8_t pedalMode) {
-  int index = transmitterManager_findIndex(manager, mac);
+  int index = transmitterManager_findIndex(manager, macAddr_fromBytes(mac));
   if (index >= 0) {
     // Already exists - update last seen
     manager->transmitters[index].lastSeen = millis();
-    manager->transmitters[index].seenOnBoot = true;
-    return true;
+    return transmitterManager_setResponsive(manager, index, true);
   }
   
-  int slotsNeeded = (pedalMode == 0) ? 2 : 1;
-  if (manager->slotsUsed + slotsNeeded > MAX_PEDAL_SLOTS) {
+  if (!slotAllocator_canFit(&manager->slots, getSlotsNeeded(pedalMode))) {
     return false;  // Not enough slots
   }
+  return transmitterManager_place(manager, mac, pedalMode) >= 0;
+}
+
+int transmitterManager_place(TransmitterManager* manager, const uint8_t* mac, uint8_t pedalMode) {
+  // First empty position (starting from index 0) so the first pedal gets position 0 (pedal 1)
+  uint32_t empty = SLOT_ALLOCATOR_ALL & ~manager->occupied;
+  if (empty == 0) {
+    return -1;  // Table full
+  }
+  int emptyIndex = __builtin_ctz(empty);
   
-  // Find first empty slot (starting from index 0) to ensure first pedal gets slot 0 (pedal 1)
-  int emptyIndex = -1;
-  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-    // Check if slot is empty (all zeros in MAC means empty)
-    bool isEmpty = true;
-    for (int j = 0; j < 6; j++) {
-      if (manager->transmitters[i].mac[j] != 0) {
-        isEmpty = false;
-        break;
-      }
-    }
-    if (isEmpty) {
-      emptyIndex = i;
-      break;
+  TransmitterInfo* info = &manager->transmitters[emptyIndex];
+  memcpy(info->mac, mac, 6);
+  info->pedalMode = pedalMode;
+  info->seenOnBoot = false;
+  info->lastSeen = millis();
+  info->slotMask = 0;
+  macIndex_insert(&manager->index, macAddr_fromBytes(mac), emptyIndex);
+  manager->occupied |= 1u << emptyIndex;
+  manager->reservedSlots += getSlotsNeeded(pedalMode);
+  manager->version++;
+  transmitterManager_updateCount(manager);
+  transmitterManager_setResponsive(manager, emptyIndex, true);
+  return emptyIndex;
+}
+
+bool transmitterManager_setPedalMode(TransmitterManager* manager, int index, uint8_t pedalMode) {
+  if (index < 0 || index >= MAX_PEDAL_SLOTS) return false;
+  TransmitterInfo* info = &manager->transmitters[index];
+  if (info->pedalMode == pedalMode) return true;
+  
+  int slotsNeeded = getSlotsNeeded(pedalMode);
+  if (info->seenOnBoot) {
+    uint32_t resized = slotAllocator_resize(&manager->slots, info->slotMask, slotsNeeded);
+    if (__builtin_popcount(resized) != slotsNeeded) {
+      return false;  // No room to grow
     }
+    info->slotMask = resized;
+  } else {
+    // Not holding slots - just trim the preference; it is completed on allocation
+    info->slotMask = slotAllocator_lowestBits(info->slotMask, slotsNeeded);
   }
-  
-  // If no empty slot found, append at the end
-  if (emptyIndex < 0) {
-    emptyIndex = manager->count;
+  if (transmitterManager_isPaired(manager, index)) {
+    manager->reservedSlots += slotsNeeded - getSlotsNeeded(info->pedalMode);
   }
+  info->pedalMode = pedalMode;
+  manager->version++;
+  return true;
+}
+
+bool transmitterManager_setResponsive(TransmitterManager* manager, int index, bool responsive) {
+  if (index < 0 || index >= MAX_PEDAL_SLOTS) return false;
+  TransmitterInfo* info = &manager->transmitters[index];
+  if (info->seenOnBoot == responsive) return true;
   
-  memcpy(manager->transmitters[emptyIndex].mac, mac, 6);
-  manager->transmitters[emptyIndex].pedalMode = pedalMode;
-  manager->transmitters[emptyIndex].seenOnBoot = true;
-  manager->transmitters[emptyIndex].lastSeen = millis();
-  
-  // Update count if we added beyond current count
-  if (emptyIndex >= manager->count) {
-    manager->count = emptyIndex + 1;
+  if (responsive) {
+    uint32_t mask = slotAllocator_allocate(&manager->slots, info->slotMask, getSlotsNeeded(info->pedalMode));
+    if (mask == 0) {
+      return false;  // No room
+    }
+    info->slotMask = mask;
+    manager->responsive |= 1u << index;
+  } else {
+    slotAllocator_release(&manager->slots, info->slotMask);  // Mask stays as the preference
+    manager->responsive &= ~(1u << index);
   }
-  
-  manager->slotsUsed += slotsNeeded;
-  
+  info->seenOnBoot = responsive;
+  manager->version++;
   return true;
 }
 
-void transmitterManager_remove(TransmitterManager* manager, int index) {
-  if (index < 0 || index >= MAX_PEDAL_SLOTS) return;
+void transmitterManager_reindex(TransmitterManager* manager) {
+  macIndex_init(&manager->index);
+  slotAllocator_init(&manager->slots);
+  manager->occupied = 0;
+  manager->responsive = 0;
+  manager->reservedSlots = 0;
   
-  // Check if slot is actually occupied
-  bool isEmpty = true;
-  for (int j = 0; j < 6; j++) {
-    if (manager->transmitters[index].mac[j] != 0) {
-      isEmpty = false;
-      break;
+  // Preferred slots in table order, so keys stay stable across reboots whatever order
+  // transmitters come back in
+  SlotAllocator preferred;
+  slotAllocator_init(&preferred);
+  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
+    TransmitterInfo* info = &manager->transmitters[i];
+    info->seenOnBoot = false;
+    info->slotMask = 0;
+    if (!transmitterManager_hasMAC(info)) continue;
+    macIndex_insert(&manager->index, macAddr_fromBytes(info->mac), i);
+    info->slotMask = slotAllocator_allocate(&preferred, 0, getSlotsNeeded(info->pedalMode));
+    manager->occupied |= 1u << i;
+    manager->reservedSlots += getSlotsNeeded(info->pedalMode);
+  }
+  transmitterManager_updateCount(manager);
+  manager->version++;
+}
+
+int transmitterManager_restoreSession(TransmitterManager* manager, const uint32_t* slotMasks,
+                                      uint32_t responsive, unsigned long now) {
+  for (uint32_t bits = manager->occupied; bits; bits &= bits - 1) {
+    int i = __builtin_ctz(bits);
+    TransmitterInfo* info = &manager->transmitters[i];
+    uint32_t mask = slotMasks[i] & SLOT_ALLOCATOR_ALL;
+    if (__builtin_popcount(mask) == getSlotsNeeded(info->pedalMode)) {
+      info->slotMask = mask;
     }
   }
-  if (isEmpty) return;  // Already empty
   
-  int slotsFreed = (manager->transmitters[index].pedalMode == 0) ? 2 : 1;
+  int restored = 0;
+  for (uint32_t bits = responsive & manager->occupied; bits; bits &= bits - 1) {
+    int i = __builtin_ctz(bits);
+    if (transmitterManager_setResponsive(manager, i, true)) {
+      manager->transmitters[i].lastSeen = now;
+      restored++;
+    }
+  }
+  manager->version++;
+  return restored;
+}
+
+void transmitterManager_remove(TransmitterManager* manager, int index) {
+  if (index < 0 || index >= MAX_PEDAL_SLOTS) return;
+  if (!transmitterManager_isPaired(manager, index)) return;  // Already empty
+  
+  transmitterManager_setResponsive(manager, index, false);
   
   // Clear the slot instead of shifting - this allows new transmitters to fill empty slots
   // starting from index 0, ensuring first pedal always gets slot 0 (pedal 1)
+  manager->reservedSlots -= getSlotsNeeded(manager->transmitters[index].pedalMode);
+  macIndex_remove(&manager->index, macAddr_fromBytes(manager->transmitters[index].mac));
   memset(&manager->transmitters[index], 0, sizeof(TransmitterInfo));
-  
-  manager->slotsUsed -= slotsFreed;
-  
-  // Update count - find the highest occupied index
-  manager->count = 0;
-  for (int i = MAX_PEDAL_SLOTS - 1; i >= 0; i--) {
-    bool slotOccupied = false;
-    for (int j = 0; j < 6; j++) {
-      if (manager->transmitters[i].mac[j] != 0) {
-        slotOccupied = true;
-        break;
-      }
-    }
-    if (slotOccupied) {
-      manager->count = i + 1;
-      break;
-    }
-  }
+  manager->occupied &= ~(1u << index);
+  manager->version++;
+  transmitterManager_updateCount(manager);
 }
 
-// Calculate slots used by only counting transmitters that have responded (seenOnBoot == true)
+// Slots held by transmitters that have responded (seenOnBoot == true)
 int transmitterManager_calculateSlotsUsed(const TransmitterManager* manager) {
-  int slots = 0;
-  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-    // Check if slot is occupied
-    bool slotOccupied = false;
-    for (int j = 0; j < 6; j++) {
-      if (manager->transmitters[i].mac[j] != 0) {
-        slotOccupied = true;
-        break;
-      }
-    }
-    // Only count slots occupied by transmitters that have responded
-    if (slotOccupied && manager->transmitters[i].seenOnBoot) {
-      int slotsForThis = (manager->transmitters[i].pedalMode == 0) ? 2 : 1;
-      slots += slotsForThis;
-    }
-  }
-  return slots;
+  return slotAllocator_usedCount(&manager->slots);
 }
 
 // Calculate slots reserved by ALL loaded transmitters (including unresponsive ones)
 // This is used to determine if grace period should be bypassed
 int transmitterManager_calculateReservedSlots(const TransmitterManager* manager) {
-  int slots = 0;
-  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-    // Check if slot is occupied
-    bool slotOccupied = false;
-    for (int j = 0; j < 6; j++) {
-      if (manager->transmitters[i].mac[j] != 0) {
-        slotOccupied = true;
-        break;
-      }
-    }
-    // Count ALL loaded transmitters (responsive or not) - they reserve slots
-    if (slotOccupied) {
-      int slotsForThis = (manager->transmitters[i].pedalMode == 0) ? 2 : 1;
-      slots += slotsForThis;
-    }
-  }
-  return slots;
+  return manager->reservedSlots;
 }
 
 bool transmitterManager_hasFreeSlots(const TransmitterManager* manager, int slotsNeeded) {
-  // Use calculated slots (only responsive transmitters) instead of stored slotsUsed
-  int currentSlots = transmitterManager_calculateSlotsUsed(manager);
-  return (currentSlots + slotsNeeded <= MAX_PEDAL_SLOTS);
+  return slotAllocator_canFit(&manager->slots, slotsNeeded);
 }
 
 int transmitterManager_getAvailableSlots(const TransmitterManager* manager) {
-  // Use calculated slots (only responsive transmitters) instead of stored slotsUsed
-  int currentSlots = transmitterManager_calculateSlotsUsed(manager);
-  return MAX_PEDAL_SLOTS - currentSlots;
+  return slotAllocator_freeCount(&manager->slots);
+}
+
+char transmitterManager_getAssignedKey(const TransmitterManager* manager, int index, char pedalKey) {
+  if (index < 0 || index >= MAX_PEDAL_SLOTS) return 0;
+  const TransmitterInfo* info = &manager->transmitters[index];
+  
+  int input = pedalKey - '1';
+  if (input < 0 || input >= getSlotsNeeded(info->pedalMode)) return 0;
+  
+  // An unresponsive transmitter's preferred slots may now belong to someone else
+  uint32_t mask = info->slotMask;
+  if (!info->seenOnBoot && (mask & manager->slots.allocated)) return 0;
+  
+  // The input-th set bit of the mask
+  for (int i = 0; i < input && mask; i++) {
+    mask &= mask - 1;
+  }
+  return mask ? keyPool[__builtin_ctz(mask)] : 0;
 }
 
-char transmitterManager_getAssignedKey(const TransmitterManager* manager, int index) {
-  return (index == 0) ? 'l' : 'r';
+void transmitterManager_renewLease(TransmitterManager* manager, int index, unsigned long currentTime) {
+  if (index < 0 || index >= MAX_PEDAL_SLOTS) return;
+  manager->transmitters[index].lastSeen = currentTime;
+}
+
+bool transmitterManager_isLeaseLive(const TransmitterManager* manager, int index, unsigned long currentTime) {
+  if (index < 0 || index >= MAX_PEDAL_SLOTS) return false;
+  return (currentTime - manager->transmitters[index].lastSeen) < TRANSMITTER_LEASE_MS;
+}
+
+int transmitterManager_releaseSilentSince(TransmitterManager* manager, unsigned long sinceTime) {
+  int released = 0;
+  for (uint32_t bits = manager->responsive; bits; bits &= bits - 1) {
+    int i = __builtin_ctz(bits);
+    TransmitterInfo* info = &manager->transmitters[i];
+    if ((long)(info->lastSeen - sinceTime) < 0) {
+      // Stays stored (it can reconnect if slots allow) but no longer holds slots
+      transmitterManager_setResponsive(manager, i, false);
+      released++;
+    }
+  }
+  return released;
 }
 
+int transmitterManager_releaseExpired(TransmitterManager* manager, unsigned long currentTime) {
+  return transmitterManager_releaseSilentSince(manager, currentTime - TRANSMITTER_LEASE_MS);
+}
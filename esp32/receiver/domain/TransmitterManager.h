@@ -3,31 +3,80 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-
-#define MAX_PEDAL_SLOTS 2
+#include "MacIndex.h"
+#include "SlotAllocator.h"
+#include "../shared/config.h"
 
 typedef struct {
   uint8_t mac[6];
   uint8_t pedalMode;
-  bool seenOnBoot;
-  unsigned long lastSeen;
+  bool seenOnBoot;         // Responsive - only change through transmitterManager_setResponsive()
+  unsigned long lastSeen;  // Start of the current liveness lease
+  uint32_t slotMask;       // Pedal slots, one per input in bit order. Held in the allocator while
+                           // responsive; kept as the preferred slots while not.
 } TransmitterInfo;
 
+// Occupancy and slot counts are kept current by every add/remove/mode/responsiveness
+// change, so all queries below are O(1).
 typedef struct {
   TransmitterInfo transmitters[MAX_PEDAL_SLOTS];
-  int count;
-  int slotsUsed;
+  int count;               // Highest occupied position + 1
+  uint32_t occupied;       // Bit per position holding a transmitter
+  uint32_t responsive;     // Bit per position whose transmitter is responsive
+  int reservedSlots;       // Slots all stored transmitters need, responsive or not
+  uint32_t version;        // Bumped on every change that can affect key bindings
+  SlotAllocator slots;     // Slots held by responsive transmitters
+  MacIndex index;          // MAC -> position in transmitters[]
 } TransmitterManager;
 
+static inline bool transmitterManager_isPaired(const TransmitterManager* manager, int index) {
+  return (manager->occupied >> index) & 1;
+}
+
+static inline int transmitterManager_pairedCount(const TransmitterManager* manager) {
+  return __builtin_popcount(manager->occupied);
+}
+
+static inline int transmitterManager_responsiveCount(const TransmitterManager* manager) {
+  return __builtin_popcount(manager->responsive);
+}
+
 void transmitterManager_init(TransmitterManager* manager);
-int transmitterManager_findIndex(const TransmitterManager* manager, const uint8_t* mac);
+int transmitterManager_findIndex(const TransmitterManager* manager, MacAddr mac);
 bool transmitterManager_add(TransmitterManager* manager, const uint8_t* mac, uint8_t pedalMode);
+// Store in the first empty position as responsive without an admission check (caller
+// already checked). Returns the position, or -1 if the table is full.
+int transmitterManager_place(TransmitterManager* manager, const uint8_t* mac, uint8_t pedalMode);
+// Mode change in place: keeps the transmitter's lowest slots and grows/shrinks the rest.
+// Returns false (mode unchanged) if a responsive transmitter cannot grow.
+bool transmitterManager_setPedalMode(TransmitterManager* manager, int index, uint8_t pedalMode);
+// Responsive transmitters hold their slots. Returns false (stays unresponsive) if there is
+// no room for its slots.
+bool transmitterManager_setResponsive(TransmitterManager* manager, int index, bool responsive);
+// Rebuild the MAC index and preferred slots after transmitters[] was filled directly (loading)
+void transmitterManager_reindex(TransmitterManager* manager);
+// After reindex: adopt the saved slot masks (where they still fit the pedal mode) and make
+// the saved responsive set responsive again, leases starting at now. Returns how many came
+// back responsive.
+int transmitterManager_restoreSession(TransmitterManager* manager, const uint32_t* slotMasks,
+                                      uint32_t responsive, unsigned long now);
 void transmitterManager_remove(TransmitterManager* manager, int index);
-int transmitterManager_calculateSlotsUsed(const TransmitterManager* manager);  // Count only responsive transmitters
-int transmitterManager_calculateReservedSlots(const TransmitterManager* manager);  // Count ALL loaded transmitters (reserved slots)
+int transmitterManager_calculateSlotsUsed(const TransmitterManager* manager);  // Slots held by responsive transmitters
+int transmitterManager_calculateReservedSlots(const TransmitterManager* manager);  // Slots ALL loaded transmitters need
 bool transmitterManager_hasFreeSlots(const TransmitterManager* manager, int slotsNeeded);
 int transmitterManager_getAvailableSlots(const TransmitterManager* manager);
-char transmitterManager_getAssignedKey(const TransmitterManager* manager, int index);
+// Key for pedal '1'..'8' of a transmitter, from its slot mask (0 = none)
+char transmitterManager_getAssignedKey(const TransmitterManager* manager, int index, char pedalKey);
+
+// Liveness leases: any frame from a transmitter renews its lease for TRANSMITTER_LEASE_MS
+void transmitterManager_renewLease(TransmitterManager* manager, int index, unsigned long currentTime);
+bool transmitterManager_isLeaseLive(const TransmitterManager* manager, int index, unsigned long currentTime);
+
+// Mark responsive transmitters as unresponsive (freeing their slots, keeping them stored)
+// when their lease expired / when nothing was heard from them since sinceTime.
+// Both return the number of transmitters released.
+int transmitterManager_releaseExpired(TransmitterManager* manager, unsigned long currentTime);
+int transmitterManager_releaseSilentSince(TransmitterManager* manager, unsigned long sinceTime);
 
 #endif // TRANSMITTER_MANAGER_H
 
@@ -2,14 +2,17 @@
 #include "../shared/debug_format.h"
 #include "../shared/messages.h"
 #include "Persistence.h"
+#include "Telemetry.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <string.h>
 #include <stdarg.h>
 
-void debugMonitor_init(DebugMonitor* monitor, ReceiverEspNowTransport* transport, unsigned long bootTime) {
+void debugMonitor_init(DebugMonitor* monitor, ReceiverEspNowTransport* transport, Persistence* persistence,
+                       unsigned long bootTime) {
   if (!monitor) return;
   monitor->transport = transport;
+  monitor->persistence = persistence;
   monitor->bootTime = bootTime;
   monitor->paired = false;
   monitor->espNowInitialized = false;
@@ -20,20 +23,26 @@ void debugMonitor_load(DebugMonitor* monitor) {
   if (!monitor) return;
   // Load debug monitor pairing state from persistence
   bool isPaired = false;
-  persistence_loadDebugMonitor(monitor->mac, &isPaired);
+  persistence_loadDebugMonitor(monitor->persistence, monitor->mac, &isPaired);
   monitor->paired = isPaired;
 }
 
 void debugMonitor_save(DebugMonitor* monitor) {
   if (!monitor) return;
-  // Save debug monitor pairing state to persistence
+  // Save debug monitor pairing state to persistence (committed with the next blob write)
   if (monitor->paired) {
-    persistence_saveDebugMonitor(monitor->mac);
+    persistence_saveDebugMonitor(monitor->persistence, monitor->mac);
   }
 }
 
+// Goes to the USB telemetry host when one is connected and to the paired debug monitor over
+// ESP-NOW, so a monitor keeps getting lines (and the flight log dump it asked for) while a
+// host has the CDC port open
 void debugMonitor_print(DebugMonitor* monitor, const char* format, ...) {
-  if (!monitor || !monitor->paired || !monitor->espNowInitialized) return;
+  if (!monitor) return;
+  bool toUsb = telemetry_isConnected(g_telemetry);
+  bool toRadio = monitor->paired && monitor->espNowInitialized;
+  if (!toUsb && !toRadio) return;
   
   // Get receiver MAC address
   uint8_t receiverMAC[6];
@@ -46,15 +55,21 @@ void debugMonitor_print(DebugMonitor* monitor, const char* format, ...) {
   debugFormat_message_va(buffer, sizeof(buffer), receiverMAC, true, monitor->bootTime, format, args);
   va_end(args);
   
-  // Send to debug monitor via ESP-NOW
-  debug_message debugMsg;
-  debugMsg.msgType = MSG_DEBUG;
   // Remove trailing newline if present
   int len = strlen(buffer);
   if (len > 0 && buffer[len-1] == '\n') {
     buffer[len-1] = '\0';
     len--;
   }
+  
+  if (toUsb) {
+    telemetry_log(g_telemetry, buffer);
+  }
+  if (!toRadio) return;
+  
+  // Send to debug monitor via ESP-NOW
+  debug_message debugMsg;
+  debugMsg.msgType = MSG_DEBUG;
   strncpy(debugMsg.message, buffer, sizeof(debugMsg.message) - 1);
   debugMsg.message[sizeof(debugMsg.message) - 1] = '\0';
   
@@ -5,16 +5,19 @@
 #include <stdbool.h>
 #include <stdarg.h>
 #include "../infrastructure/EspNowTransport.h"
+#include "Persistence.h"
 
 typedef struct {
   ReceiverEspNowTransport* transport;
+  Persistence* persistence;
   uint8_t mac[6];
   bool paired;
   bool espNowInitialized;
   unsigned long bootTime;
 } DebugMonitor;
 
-void debugMonitor_init(DebugMonitor* monitor, ReceiverEspNowTransport* transport, unsigned long bootTime);
+void debugMonitor_init(DebugMonitor* monitor, ReceiverEspNowTransport* transport, Persistence* persistence,
+                       unsigned long bootTime);
 void debugMonitor_load(DebugMonitor* monitor);
 void debugMonitor_save(DebugMonitor* monitor);
 void debugMonitor_print(DebugMonitor* monitor, const char* format, ...);
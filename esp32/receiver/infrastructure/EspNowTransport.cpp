@@ -1,25 +1,39 @@
 #include "EspNowTransport.h"
 #include <esp_now.h>
 #include <WiFi.h>
+#include <esp_wifi.h>
 #include <string.h>
 #include <Arduino.h>
+#include <esp_timer.h>
 #include "../shared/messages.h"
+#include "FlightRecorder.h"
 
 static ReceiverMessageCallback g_receiveCallback = nullptr;
+static ReceiverEspNowTransport* g_receiveTransport = nullptr;
 
+// Runs on the WiFi task - only copy the frame into the ingress ring and wake the dispatcher
 void OnDataRecvWrapper(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
-  if (g_receiveCallback) {
-    uint8_t* senderMAC = (uint8_t*)info->src_addr;
-    uint8_t channel = info->rx_ctrl ? info->rx_ctrl->channel : 0;
-    g_receiveCallback(senderMAC, data, len, channel);
+  ReceiverEspNowTransport* transport = g_receiveTransport;
+  if (!transport) return;
+  
+  int64_t rxTimeUs = esp_timer_get_time();
+  uint8_t channel = info->rx_ctrl ? info->rx_ctrl->channel : 0;
+  if (ingressQueue_push(&transport->ingress, info->src_addr, data, len, channel, rxTimeUs)) {
+    TaskHandle_t dispatcher = transport->dispatcherTask;
+    if (dispatcher) {
+      xTaskNotifyGive(dispatcher);
+    }
   }
 }
 
 void receiverEspNowTransport_init(ReceiverEspNowTransport* transport) {
+  ingressQueue_init(&transport->ingress);
+  transport->dispatcherTask = nullptr;
+  espNowPeers_init(&transport->peers);
+  
+  // Both calls complete synchronously; no settling delay is needed before esp_now_init()
   WiFi.mode(WIFI_STA);
-  delay(100);
   WiFi.disconnect();
-  delay(100);
   
   if (esp_now_init() == ESP_OK) {
     transport->initialized = true;
@@ -31,32 +45,29 @@ void receiverEspNowTransport_init(ReceiverEspNowTransport* transport) {
 bool receiverEspNowTransport_send(ReceiverEspNowTransport* transport, const uint8_t* mac, const uint8_t* data, int len) {
   if (!transport->initialized) return false;
   
-  // Ensure peer exists before sending
-  esp_now_peer_info_t peerInfo;
-  if (esp_now_get_peer(mac, &peerInfo) != ESP_OK) {
-    receiverEspNowTransport_addPeer(transport, mac, 0);
+  esp_err_t result = espNowPeers_send(&transport->peers, mac, data, len);
+  if (result != ESP_OK) {
+    flightRecorder_log(g_flightRecorder, FLIGHT_EVENT_SEND_FAILED, len > 0 ? data[0] : 0, (uint8_t)result, 0,
+                       ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5]);
   }
-  
-  esp_err_t result = esp_now_send(mac, data, len);
   return (result == ESP_OK);
 }
 
 bool receiverEspNowTransport_addPeer(ReceiverEspNowTransport* transport, const uint8_t* mac, uint8_t channel) {
   if (!transport->initialized) return false;
-  
-  esp_now_peer_info_t peerInfo = {};
-  memcpy(peerInfo.peer_addr, mac, 6);
-  peerInfo.channel = channel;
-  peerInfo.encrypt = false;
-  
-  esp_err_t result = esp_now_add_peer(&peerInfo);
-  return (result == ESP_OK || result == ESP_ERR_ESPNOW_EXIST);
+  return espNowPeers_register(&transport->peers, mac, channel);
+}
+
+bool receiverEspNowTransport_setChannel(ReceiverEspNowTransport* transport, uint8_t channel) {
+  if (!transport->initialized || channel < 1 || channel > 13) return false;
+  return esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE) == ESP_OK;
 }
 
 void receiverEspNowTransport_registerReceiveCallback(ReceiverEspNowTransport* transport, ReceiverMessageCallback callback) {
   if (!transport->initialized) return;
   
   g_receiveCallback = callback;
+  g_receiveTransport = transport;
   esp_now_register_recv_cb(OnDataRecvWrapper);
 }
 
@@ -65,3 +76,25 @@ void receiverEspNowTransport_broadcast(ReceiverEspNowTransport* transport, const
   receiverEspNowTransport_send(transport, broadcastMAC, data, len);
 }
 
+
+void receiverEspNowTransport_waitForFrames(ReceiverEspNowTransport* transport, uint32_t timeoutMs) {
+  // Publish the waiting task before checking the ring so a frame queued in between still wakes us
+  transport->dispatcherTask = xTaskGetCurrentTaskHandle();
+  if (!ingressQueue_isEmpty(&transport->ingress)) {
+    return;
+  }
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+}
+
+int receiverEspNowTransport_dispatch(ReceiverEspNowTransport* transport) {
+  if (!g_receiveCallback) return 0;
+  
+  int handled = 0;
+  const IngressFrame* frame;
+  while ((frame = ingressQueue_peek(&transport->ingress)) != nullptr) {
+    g_receiveCallback(frame);
+    ingressQueue_release(&transport->ingress);
+    handled++;
+  }
+  return handled;
+}
@@ -3,19 +3,36 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "IngressQueue.h"
+#include "../shared/infrastructure/EspNowPeers.h"
 
 // ESP-NOW transport abstraction for receiver
+// Received frames are queued by the ESP-NOW callback and handed to the message
+// callback later from receiverEspNowTransport_dispatch() on a normal task.
+// Peers are registered on first send and tracked in a cache (LRU eviction when the
+// ESP-NOW peer table is full), so a send to a known peer makes no peer-table calls.
 typedef struct {
   bool initialized;
+  IngressQueue ingress;
+  TaskHandle_t volatile dispatcherTask;  // Task woken when a frame is queued
+  EspNowPeers peers;
 } ReceiverEspNowTransport;
 
-typedef void (*ReceiverMessageCallback)(const uint8_t* senderMAC, const uint8_t* data, int len, uint8_t channel);
+typedef void (*ReceiverMessageCallback)(const IngressFrame* frame);
 
 void receiverEspNowTransport_init(ReceiverEspNowTransport* transport);
 bool receiverEspNowTransport_send(ReceiverEspNowTransport* transport, const uint8_t* mac, const uint8_t* data, int len);
 bool receiverEspNowTransport_addPeer(ReceiverEspNowTransport* transport, const uint8_t* mac, uint8_t channel);
+// Move the radio to channel (1-13) - used to come back on the last session's channel
+bool receiverEspNowTransport_setChannel(ReceiverEspNowTransport* transport, uint8_t channel);
 void receiverEspNowTransport_registerReceiveCallback(ReceiverEspNowTransport* transport, ReceiverMessageCallback callback);
 void receiverEspNowTransport_broadcast(ReceiverEspNowTransport* transport, const uint8_t* data, int len);
 
-#endif // RECEIVER_ESPNOW_TRANSPORT_H
+// Block the calling task until a frame is queued or timeoutMs elapses
+void receiverEspNowTransport_waitForFrames(ReceiverEspNowTransport* transport, uint32_t timeoutMs);
+// Drain queued frames through the registered callback; returns number of frames handled
+int receiverEspNowTransport_dispatch(ReceiverEspNowTransport* transport);
 
+#endif // RECEIVER_ESPNOW_TRANSPORT_H
@@ -0,0 +1,299 @@
+#include "FlightRecorder.h"
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "Telemetry.h"
+
+static_assert((FLIGHT_RECORDER_STAGE_CAPACITY & (FLIGHT_RECORDER_STAGE_CAPACITY - 1)) == 0,
+              "FLIGHT_RECORDER_STAGE_CAPACITY must be a power of two");
+
+#define FLIGHT_STAGE_MASK (FLIGHT_RECORDER_STAGE_CAPACITY - 1)
+#define FLIGHT_RECORDER_PARTITION_LABEL "flightrec"
+#define FLIGHT_RECORDER_PARTITION_SUBTYPE 0x40
+
+FlightRecorder* g_flightRecorder = nullptr;
+
+// ============================================================================
+// Partition backend
+// ============================================================================
+
+static bool flightRecorder_partitionRead(void* context, uint32_t offset, void* buffer, uint32_t len) {
+  return esp_partition_read((const esp_partition_t*)context, offset, buffer, len) == ESP_OK;
+}
+
+static bool flightRecorder_partitionWrite(void* context, uint32_t offset, const void* data, uint32_t len) {
+  return esp_partition_write((const esp_partition_t*)context, offset, data, len) == ESP_OK;
+}
+
+static bool flightRecorder_partitionErase(void* context, uint32_t offset) {
+  return esp_partition_erase_range((const esp_partition_t*)context, offset, FLIGHT_RECORDER_SECTOR_SIZE) == ESP_OK;
+}
+
+bool flightRecorder_partitionFlash(FlightRecorderFlash* flash) {
+  const esp_partition_t* partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)FLIGHT_RECORDER_PARTITION_SUBTYPE,
+      FLIGHT_RECORDER_PARTITION_LABEL);
+  if (!partition) return false;
+  
+  flash->context = (void*)partition;
+  flash->size = partition->size - (partition->size % FLIGHT_RECORDER_SECTOR_SIZE);
+  flash->read = flightRecorder_partitionRead;
+  flash->write = flightRecorder_partitionWrite;
+  flash->erase = flightRecorder_partitionErase;
+  return true;
+}
+
+// ============================================================================
+// Sectors
+// ============================================================================
+
+static uint32_t flightRecorder_recordOffset(int sector, int record) {
+  return (uint32_t)sector * FLIGHT_RECORDER_SECTOR_SIZE + (uint32_t)record * FLIGHT_RECORD_SIZE;
+}
+
+static bool flightRecorder_readHeader(FlightRecorder* recorder, int sector, FlightSectorHeader* header) {
+  if (!recorder->flash.read(recorder->flash.context, flightRecorder_recordOffset(sector, 0),
+                            header, sizeof(FlightSectorHeader))) {
+    recorder->flashErrors++;
+    return false;
+  }
+  return header->magic == FLIGHT_RECORDER_MAGIC && header->check == ~header->sequence &&
+         header->version == FLIGHT_RECORDER_VERSION && header->recordSize == FLIGHT_RECORD_SIZE;
+}
+
+static bool flightRecorder_isErased(FlightRecorder* recorder, int sector, int record) {
+  FlightEvent event;
+  if (!recorder->flash.read(recorder->flash.context, flightRecorder_recordOffset(sector, record),
+                            &event, sizeof(event))) {
+    recorder->flashErrors++;
+    return false;  // Treat as used so we never program over it
+  }
+  return event.type == FLIGHT_EVENT_ERASED;
+}
+
+// Erase the sector after the head and make it the new head
+static bool flightRecorder_openSector(FlightRecorder* recorder, int sector, uint32_t sequence) {
+  FlightSectorHeader header = {FLIGHT_RECORDER_MAGIC, sequence, ~sequence, FLIGHT_RECORDER_VERSION,
+                               FLIGHT_RECORD_SIZE, {0, 0}};
+  if (!recorder->flash.erase(recorder->flash.context, flightRecorder_recordOffset(sector, 0)) ||
+      !recorder->flash.write(recorder->flash.context, flightRecorder_recordOffset(sector, 0),
+                             &header, sizeof(header))) {
+    recorder->flashErrors++;
+    return false;
+  }
+  recorder->sectorsErased++;
+  recorder->headSector = sector;
+  recorder->headSequence = sequence;
+  recorder->writeRecord = 1;
+  return true;
+}
+
+bool flightRecorder_mount(FlightRecorder* recorder, const FlightRecorderFlash* flash) {
+  memset(recorder, 0, sizeof(FlightRecorder));
+  recorder->flash = *flash;
+  recorder->lock = portMUX_INITIALIZER_UNLOCKED;
+  recorder->sectorCount = flash->size / FLIGHT_RECORDER_SECTOR_SIZE;
+  if (recorder->sectorCount < 2) return false;
+  
+  int newest = -1;
+  uint32_t newestSequence = 0;
+  for (int sector = 0; sector < recorder->sectorCount; sector++) {
+    FlightSectorHeader header;
+    if (!flightRecorder_readHeader(recorder, sector, &header)) continue;
+    if (newest < 0 || (int32_t)(header.sequence - newestSequence) > 0) {
+      newest = sector;
+      newestSequence = header.sequence;
+    }
+  }
+  
+  if (newest < 0) {
+    // Blank or foreign contents: start the ring at sector 0
+    if (!flightRecorder_openSector(recorder, 0, 1)) return false;
+  } else {
+    recorder->headSector = newest;
+    recorder->headSequence = newestSequence;
+    // Records are appended in order, so the programmed ones form a prefix
+    int lo = 1, hi = FLIGHT_RECORDS_PER_SECTOR;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (flightRecorder_isErased(recorder, newest, mid)) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    recorder->writeRecord = lo;
+  }
+  
+  recorder->mounted = true;
+  flightRecorder_log(recorder, FLIGHT_EVENT_BOOT, 0, 0, 0, recorder->headSequence);
+  return true;
+}
+
+// ============================================================================
+// Stage
+// ============================================================================
+
+void flightRecorder_log(FlightRecorder* recorder, uint8_t type, uint8_t a, uint8_t b, uint8_t c, uint32_t value) {
+  telemetry_event(g_telemetry, type, a, b, c, value);  // Live copy for a USB host, if any
+  if (!recorder || !recorder->mounted) return;
+  FlightEvent event = {esp_timer_get_time(), type, a, b, c, value};
+  
+  portENTER_CRITICAL(&recorder->lock);
+  uint32_t head = recorder->stageHead;
+  if (head - recorder->stageTail >= FLIGHT_RECORDER_STAGE_CAPACITY) {
+    recorder->dropped++;
+  } else {
+    if (head == recorder->stageTail) {
+      recorder->oldestStagedAt = millis();
+    }
+    recorder->stage[head & FLIGHT_STAGE_MASK] = event;
+    recorder->stageHead = head + 1;
+    recorder->logged++;
+  }
+  portEXIT_CRITICAL(&recorder->lock);
+}
+
+static uint32_t flightRecorder_stagedCount(const FlightRecorder* recorder) {
+  return recorder->stageHead - recorder->stageTail;
+}
+
+int flightRecorder_flush(FlightRecorder* recorder) {
+  if (!recorder->mounted) return 0;
+  
+  int written = 0;
+  FlightEvent page[FLIGHT_RECORDS_PER_PAGE];
+  
+  for (;;) {
+    portENTER_CRITICAL(&recorder->lock);
+    uint32_t tail = recorder->stageTail;
+    uint32_t staged = recorder->stageHead - tail;
+    portEXIT_CRITICAL(&recorder->lock);
+    if (staged == 0) break;
+    
+    if (recorder->writeRecord >= FLIGHT_RECORDS_PER_SECTOR) {
+      int next = (recorder->headSector + 1) % recorder->sectorCount;
+      if (!flightRecorder_openSector(recorder, next, recorder->headSequence + 1)) break;
+    }
+    
+    // One program operation: up to a page, never crossing the sector end
+    uint32_t count = staged;
+    if (count > FLIGHT_RECORDS_PER_PAGE) count = FLIGHT_RECORDS_PER_PAGE;
+    uint32_t room = FLIGHT_RECORDS_PER_SECTOR - recorder->writeRecord;
+    if (count > room) count = room;
+    for (uint32_t i = 0; i < count; i++) {
+      page[i] = recorder->stage[(tail + i) & FLIGHT_STAGE_MASK];
+    }
+    
+    if (!recorder->flash.write(recorder->flash.context,
+                               flightRecorder_recordOffset(recorder->headSector, recorder->writeRecord),
+                               page, count * FLIGHT_RECORD_SIZE)) {
+      recorder->flashErrors++;
+      // Skip past the damaged slots rather than programming them twice
+      recorder->writeRecord += count;
+      break;
+    }
+    recorder->writeRecord += count;
+    recorder->pagesWritten++;
+    written += count;
+    
+    portENTER_CRITICAL(&recorder->lock);
+    recorder->stageTail = tail + count;
+    if (recorder->stageHead != recorder->stageTail) {
+      recorder->oldestStagedAt = millis();
+    }
+    portEXIT_CRITICAL(&recorder->lock);
+  }
+  return written;
+}
+
+int flightRecorder_update(FlightRecorder* recorder, unsigned long now) {
+  if (!recorder->mounted) return 0;
+  uint32_t staged = flightRecorder_stagedCount(recorder);
+  if (staged == 0) return 0;
+  if (staged < FLIGHT_RECORDS_PER_PAGE && now - recorder->oldestStagedAt < FLIGHT_RECORDER_FLUSH_MS) {
+    return 0;  // Wait for a full page
+  }
+  return flightRecorder_flush(recorder);
+}
+
+unsigned long flightRecorder_timeUntilFlushMs(const FlightRecorder* recorder, unsigned long now) {
+  uint32_t staged = flightRecorder_stagedCount(recorder);
+  if (!recorder->mounted || staged == 0) return ULONG_MAX;
+  if (staged >= FLIGHT_RECORDS_PER_PAGE) return 0;
+  unsigned long elapsed = now - recorder->oldestStagedAt;
+  return (elapsed >= FLIGHT_RECORDER_FLUSH_MS) ? 0 : FLIGHT_RECORDER_FLUSH_MS - elapsed;
+}
+
+// ============================================================================
+// Dump
+// ============================================================================
+
+void flightRecorder_beginDump(FlightRecorder* recorder) {
+  if (!recorder->mounted) return;
+  flightRecorder_flush(recorder);
+  recorder->dumping = true;
+  recorder->dumpSector = (recorder->headSector + 1) % recorder->sectorCount;  // Oldest
+  recorder->dumpRecord = -1;  // BEGIN line first
+  recorder->dumpSectorsLeft = recorder->sectorCount;
+  recorder->dumpRecords = 0;
+}
+
+static void flightRecorder_nextDumpSector(FlightRecorder* recorder) {
+  recorder->dumpSector = (recorder->dumpSector + 1) % recorder->sectorCount;
+  recorder->dumpRecord = 0;
+  recorder->dumpSectorsLeft--;
+}
+
+bool flightRecorder_dumpNext(FlightRecorder* recorder, char* line, size_t lineSize) {
+  static const char hex[] = "0123456789ABCDEF";
+  if (!recorder->dumping || lineSize < 8) return false;
+  
+  if (recorder->dumpRecord < 0) {
+    recorder->dumpRecord = 0;
+    snprintf(line, lineSize, "FLT BEGIN v%d %d sector(s)", FLIGHT_RECORDER_VERSION, recorder->sectorCount);
+    return true;
+  }
+  
+  size_t len = snprintf(line, lineSize, "FLT ");
+  int inLine = 0;
+  while (recorder->dumpSectorsLeft > 0 && inLine < FLIGHT_RECORDS_PER_DUMP_LINE &&
+         len + 2 * FLIGHT_RECORD_SIZE < lineSize) {
+    if (recorder->dumpRecord == 0) {
+      FlightSectorHeader header;
+      if (!flightRecorder_readHeader(recorder, recorder->dumpSector, &header)) {
+        flightRecorder_nextDumpSector(recorder);  // Never used yet
+        continue;
+      }
+      recorder->dumpRecord = 1;
+    }
+    
+    FlightEvent event;
+    if (recorder->dumpRecord >= FLIGHT_RECORDS_PER_SECTOR ||
+        !recorder->flash.read(recorder->flash.context,
+                              flightRecorder_recordOffset(recorder->dumpSector, recorder->dumpRecord),
+                              &event, sizeof(event)) ||
+        event.type == FLIGHT_EVENT_ERASED) {
+      flightRecorder_nextDumpSector(recorder);
+      continue;
+    }
+    
+    const uint8_t* bytes = (const uint8_t*)&event;
+    for (int i = 0; i < FLIGHT_RECORD_SIZE; i++) {
+      line[len++] = hex[bytes[i] >> 4];
+      line[len++] = hex[bytes[i] & 0x0F];
+    }
+    line[len] = '\0';
+    recorder->dumpRecord++;
+    recorder->dumpRecords++;
+    inLine++;
+  }
+  if (inLine > 0) return true;
+  
+  snprintf(line, lineSize, "FLT END %lu record(s)", (unsigned long)recorder->dumpRecords);
+  recorder->dumping = false;
+  return true;
+}
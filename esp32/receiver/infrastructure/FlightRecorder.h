@@ -0,0 +1,121 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include "../shared/config.h"
+
+// Persistent circular event log in the "flightrec" flash partition (see partitions.csv).
+//
+// Events are 16-byte records staged in RAM from any task and appended to flash by the loop
+// task a page at a time. Flash is a ring of 4 KB sectors, each starting with a header
+// that carries a sequence number; the sector after the newest is erased and reused when
+// the newest fills up, so every sector is erased once per lap (wear leveling) and each
+// record is programmed exactly once. Decoded on the host by tools/flightlog_decode.py.
+// Every event is also streamed as USB telemetry while a host is connected.
+
+#define FLIGHT_RECORDER_MAGIC 0x52465050u  // "PPFR"
+#define FLIGHT_RECORDER_VERSION 1
+#define FLIGHT_RECORDER_SECTOR_SIZE 4096
+#define FLIGHT_RECORDER_PAGE_SIZE 256
+#define FLIGHT_RECORD_SIZE 16
+#define FLIGHT_RECORDS_PER_SECTOR (FLIGHT_RECORDER_SECTOR_SIZE / FLIGHT_RECORD_SIZE)  // Slot 0 is the header
+#define FLIGHT_RECORDS_PER_PAGE (FLIGHT_RECORDER_PAGE_SIZE / FLIGHT_RECORD_SIZE)
+#define FLIGHT_RECORDS_PER_DUMP_LINE 4
+
+typedef enum {
+  FLIGHT_EVENT_BOOT = 1,           // value = sector sequence at boot
+  FLIGHT_EVENT_PEDAL = 2,          // a = transmitter (0xFF unknown), b = key, c = pressed
+  FLIGHT_EVENT_PAIRING = 3,        // a = from state, b = to state, c = event
+  FLIGHT_EVENT_SEND_FAILED = 4,    // a = msgType, b = esp_err_t & 0xFF, value = last 4 MAC bytes
+  FLIGHT_EVENT_LEASE_EXPIRED = 5,  // a = transmitter, b = held mask
+  FLIGHT_EVENT_GESTURE = 6,        // a = GestureKind, b = primary key, c = key emitted, value = ms after press
+  FLIGHT_EVENT_ERASED = 0xFF       // Unprogrammed flash
+} FlightEventType;
+
+typedef struct __attribute__((packed)) {
+  int64_t timeUs;  // esp_timer_get_time() - microseconds since this boot
+  uint8_t type;
+  uint8_t a;
+  uint8_t b;
+  uint8_t c;
+  uint32_t value;
+} FlightEvent;
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint32_t sequence;  // Newest sector has the highest
+  uint32_t check;     // ~sequence, catches a torn header write
+  uint8_t version;
+  uint8_t recordSize;
+  uint8_t reserved[2];
+} FlightSectorHeader;
+
+static_assert(sizeof(FlightEvent) == FLIGHT_RECORD_SIZE, "FlightEvent must be one record");
+static_assert(sizeof(FlightSectorHeader) == FLIGHT_RECORD_SIZE, "Sector header must be one record");
+
+// Flash backend: the partition on the device, an in-memory array for host tests
+typedef struct {
+  void* context;
+  uint32_t size;  // Bytes, a multiple of FLIGHT_RECORDER_SECTOR_SIZE
+  bool (*read)(void* context, uint32_t offset, void* buffer, uint32_t len);
+  bool (*write)(void* context, uint32_t offset, const void* data, uint32_t len);
+  bool (*erase)(void* context, uint32_t offset);  // One sector
+} FlightRecorderFlash;
+
+typedef struct {
+  FlightRecorderFlash flash;
+  bool mounted;
+  int sectorCount;
+  int headSector;          // Sector being appended to
+  uint32_t headSequence;
+  int writeRecord;         // Next free record slot in headSector
+
+  // RAM stage, multi-producer (HID task, loop), drained by the loop
+  FlightEvent stage[FLIGHT_RECORDER_STAGE_CAPACITY];
+  uint32_t stageHead;
+  uint32_t stageTail;
+  portMUX_TYPE lock;
+  unsigned long oldestStagedAt;
+
+  // Dump cursor (loop only)
+  bool dumping;
+  int dumpSector;
+  int dumpRecord;
+  int dumpSectorsLeft;
+  uint32_t dumpRecords;
+
+  // Instrumentation
+  uint32_t logged;
+  uint32_t dropped;        // Stage full
+  uint32_t pagesWritten;
+  uint32_t sectorsErased;
+  uint32_t flashErrors;
+} FlightRecorder;
+
+// Set once mounted, so other modules can log without a handle (NULL-safe)
+extern FlightRecorder* g_flightRecorder;
+
+// Backend over the "flightrec" data partition; false if the partition table has none
+bool flightRecorder_partitionFlash(FlightRecorderFlash* flash);
+
+// Find the newest sector and the append position; formats the flash if nothing valid is found
+bool flightRecorder_mount(FlightRecorder* recorder, const FlightRecorderFlash* flash);
+
+// Any task: stage one event. Never touches flash.
+void flightRecorder_log(FlightRecorder* recorder, uint8_t type, uint8_t a, uint8_t b, uint8_t c, uint32_t value);
+
+// Loop task: write staged events once a page is full or FLIGHT_RECORDER_FLUSH_MS passed
+int flightRecorder_update(FlightRecorder* recorder, unsigned long now);
+// Loop task: write everything staged now
+int flightRecorder_flush(FlightRecorder* recorder);
+// Milliseconds until update() has work (ULONG_MAX if nothing is staged)
+unsigned long flightRecorder_timeUntilFlushMs(const FlightRecorder* recorder, unsigned long now);
+
+// Dump oldest to newest as text lines: "FLT BEGIN", "FLT <hex records>"..., "FLT END <n>"
+void flightRecorder_beginDump(FlightRecorder* recorder);
+bool flightRecorder_dumpNext(FlightRecorder* recorder, char* line, size_t lineSize);  // false when done
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,52 @@
+#include "HidGamepad.h"
+#include <string.h>
+#include <USB.h>
+#include <USBHID.h>
+
+static const uint8_t hidGamepad_descriptor[] = {
+  0x05, 0x01,                   // Usage Page (Generic Desktop)
+  0x09, 0x04,                   // Usage (Joystick)
+  0xA1, 0x01,                   // Collection (Application)
+  0x85, HID_REPORT_ID_GAMEPAD,  //   Report ID
+  0x09, 0x01,                   //   Usage (Pointer)
+  0xA1, 0x00,                   //   Collection (Physical)
+  0x09, 0x30,                   //     Usage (X)
+  0x09, 0x31,                   //     Usage (Y)
+  0x09, 0x32,                   //     Usage (Z)
+  0x09, 0x33,                   //     Usage (Rx)
+  0x15, 0x00,                   //     Logical Minimum (0)
+  0x26, 0xFF, 0x7F,             //     Logical Maximum (32767)
+  0x75, 0x10,                   //     Report Size (16)
+  0x95, HID_GAMEPAD_AXES,       //     Report Count
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0xC0,                         //   End Collection
+  0xC0                          // End Collection
+};
+
+class HidGamepadDevice : public USBHIDDevice {
+public:
+  USBHID hid;
+
+  HidGamepadDevice() {
+    USBHID::addDevice(this, sizeof(hidGamepad_descriptor));
+  }
+
+  uint16_t _onGetDescriptor(uint8_t* buffer) override {
+    memcpy(buffer, hidGamepad_descriptor, sizeof(hidGamepad_descriptor));
+    return sizeof(hidGamepad_descriptor);
+  }
+};
+
+// Registered with TinyUSB when constructed, before USB.begin()
+static HidGamepadDevice Gamepad;
+
+void hidGamepad_begin() {
+  Gamepad.hid.begin();
+}
+
+bool hidGamepad_send(const HidGamepadReport* report) {
+  if (!Gamepad.hid.ready()) {
+    return false;
+  }
+  return Gamepad.hid.SendReport(HID_REPORT_ID_GAMEPAD, report, sizeof(HidGamepadReport));
+}
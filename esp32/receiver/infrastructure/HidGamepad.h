@@ -0,0 +1,23 @@
+#ifndef HID_GAMEPAD_H
+#define HID_GAMEPAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Joystick interface next to the HID keyboard (same HID interface, its own report ID) for
+// expression pedals: HID_GAMEPAD_AXES absolute 16-bit axes (X, Y, Z, Rx), 0..32767.
+// The device registers itself with TinyUSB when constructed, like the keyboard, so it is
+// part of the descriptor by the time keyboardService_init() starts USB.
+
+#define HID_GAMEPAD_AXES 4
+
+typedef struct __attribute__((packed)) {
+  uint16_t axes[HID_GAMEPAD_AXES];
+} HidGamepadReport;
+
+void hidGamepad_begin();
+
+// Send one report (HID output task); false if the host is not ready for it
+bool hidGamepad_send(const HidGamepadReport* report);
+
+#endif // HID_GAMEPAD_H
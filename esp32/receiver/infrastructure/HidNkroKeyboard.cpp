@@ -0,0 +1,74 @@
+#include "HidNkroKeyboard.h"
+#include <string.h>
+#include <USB.h>
+#include <USBHID.h>
+#include "../shared/config.h"
+
+// Constructing the device adds its report to the HID descriptor, so it only exists with NKRO on
+#if HID_KEYBOARD_NKRO
+
+static_assert(HID_NKRO_USAGE_COUNT % 8 == 0, "NKRO bitmap must be whole bytes");
+
+static const uint8_t hidNkroKeyboard_descriptor[] = {
+  0x05, 0x01,                         // Usage Page (Generic Desktop)
+  0x09, 0x06,                         // Usage (Keyboard)
+  0xA1, 0x01,                         // Collection (Application)
+  0x85, HID_REPORT_ID_NKRO_KEYBOARD,  //   Report ID
+  0x05, 0x07,                         //   Usage Page (Keyboard)
+  0x19, 0xE0,                         //   Usage Minimum (Left Control)
+  0x29, 0xE7,                         //   Usage Maximum (Right GUI)
+  0x15, 0x00,                         //   Logical Minimum (0)
+  0x25, 0x01,                         //   Logical Maximum (1)
+  0x75, 0x01,                         //   Report Size (1)
+  0x95, 0x08,                         //   Report Count (8)
+  0x81, 0x02,                         //   Input (Data, Variable, Absolute) - modifiers
+  0x19, 0x00,                         //   Usage Minimum (0)
+  0x29, HID_NKRO_USAGE_COUNT - 1,     //   Usage Maximum
+  0x95, HID_NKRO_USAGE_COUNT,         //   Report Count
+  0x81, 0x02,                         //   Input (Data, Variable, Absolute) - key bitmap
+  0xC0                                // End Collection
+};
+
+class HidNkroKeyboardDevice : public USBHIDDevice {
+public:
+  USBHID hid;
+
+  HidNkroKeyboardDevice() {
+    USBHID::addDevice(this, sizeof(hidNkroKeyboard_descriptor));
+  }
+
+  uint16_t _onGetDescriptor(uint8_t* buffer) override {
+    memcpy(buffer, hidNkroKeyboard_descriptor, sizeof(hidNkroKeyboard_descriptor));
+    return sizeof(hidNkroKeyboard_descriptor);
+  }
+};
+
+// Registered with TinyUSB when constructed, before USB.begin()
+static HidNkroKeyboardDevice NkroKeyboard;
+
+// Written from the USB event task
+static volatile bool hidNkroKeyboard_bootProtocol = false;
+
+static void hidNkroKeyboard_onHidEvent(void* arg, esp_event_base_t base, int32_t eventId, void* eventData) {
+  if (base != ARDUINO_USB_HID_EVENTS || eventId != ARDUINO_USB_HID_SET_PROTOCOL_EVENT) return;
+  const arduino_usb_hid_event_data_t* data = (const arduino_usb_hid_event_data_t*)eventData;
+  hidNkroKeyboard_bootProtocol = (data->set_protocol.protocol == 0);
+}
+
+void hidNkroKeyboard_begin() {
+  NkroKeyboard.hid.onEvent(ARDUINO_USB_HID_SET_PROTOCOL_EVENT, hidNkroKeyboard_onHidEvent);
+  NkroKeyboard.hid.begin();
+}
+
+bool hidNkroKeyboard_active() {
+  return !hidNkroKeyboard_bootProtocol;
+}
+
+bool hidNkroKeyboard_send(const HidNkroReport* report) {
+  if (!NkroKeyboard.hid.ready()) {
+    return false;
+  }
+  return NkroKeyboard.hid.SendReport(HID_REPORT_ID_NKRO_KEYBOARD, report, sizeof(HidNkroReport));
+}
+
+#endif // HID_KEYBOARD_NKRO
@@ -0,0 +1,26 @@
+#ifndef HID_NKRO_KEYBOARD_H
+#define HID_NKRO_KEYBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "HidReportBuilder.h"
+
+// N-key-rollover keyboard next to the stock 6-key keyboard (same HID interface, its own
+// report ID): modifiers plus a bit per usage 0x00..0x67, so any number of pedals can hold
+// keys at once. The stock report stays declared as the fallback - used when HID_KEYBOARD_NKRO
+// is 0, or while the host has switched the interface to the boot protocol (BIOS, some KVMs),
+// which only understands the 6-key form.
+// The device registers itself with TinyUSB when constructed, like the stock keyboard, and is
+// only compiled in with HID_KEYBOARD_NKRO so the descriptor matches the setting.
+
+#define HID_REPORT_ID_NKRO_KEYBOARD 7
+
+void hidNkroKeyboard_begin();
+
+// False while the host asks for the boot protocol
+bool hidNkroKeyboard_active();
+
+// Send one report (HID output task)
+bool hidNkroKeyboard_send(const HidNkroReport* report);
+
+#endif // HID_NKRO_KEYBOARD_H
@@ -0,0 +1,143 @@
+#include "HidReportBuilder.h"
+#include <string.h>
+
+// ASCII -> HID usage (keyboard page). Bit 7 set means the character needs Shift.
+#define HID_USAGE_SHIFT 0x80
+
+static const uint8_t asciiToHidUsage[128] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0x00-0x07
+  0x2A, 0x2B, 0x28, 0x00, 0x00, 0x28, 0x00, 0x00,  // 0x08-0x0F
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // 0x10-0x17
+  0x00, 0x00, 0x00, 0x29, 0x00, 0x00, 0x00, 0x00,  // 0x18-0x1F
+  0x2C, 0x9E, 0xB4, 0xA0, 0xA1, 0xA2, 0xA4, 0x34,  // 0x20-0x27
+  0xA6, 0xA7, 0xA5, 0xAE, 0x36, 0x2D, 0x37, 0x38,  // 0x28-0x2F
+  0x27, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24,  // 0x30-0x37
+  0x25, 0x26, 0xB3, 0x33, 0xB6, 0x2E, 0xB7, 0xB8,  // 0x38-0x3F
+  0x9F, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A,  // 0x40-0x47
+  0x8B, 0x8C, 0x8D, 0x8E, 0x8F, 0x90, 0x91, 0x92,  // 0x48-0x4F
+  0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A,  // 0x50-0x57
+  0x9B, 0x9C, 0x9D, 0x2F, 0x31, 0x30, 0xA3, 0xAD,  // 0x58-0x5F
+  0x35, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,  // 0x60-0x67
+  0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,  // 0x68-0x6F
+  0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A,  // 0x70-0x77
+  0x1B, 0x1C, 0x1D, 0xAF, 0xB1, 0xB0, 0xB5, 0x00,  // 0x78-0x7F
+};
+
+void hidReportBuilder_init(HidReportBuilder* builder) {
+  memset(builder, 0, sizeof(HidReportBuilder));
+}
+
+void hidReportBuilder_setFlush(HidReportBuilder* builder, HidReportFlush flush, void* context) {
+  builder->flush = flush;
+  builder->flushContext = context;
+}
+
+// First holder of a usage sets its bit, last one clears it
+static void hidReportBuilder_setUsage(HidReportBuilder* builder, uint8_t usage, bool pressed) {
+  uint8_t code = usage & ~HID_USAGE_SHIFT;
+  uint8_t* holders = &builder->usageHolders[code];
+  uint8_t bit = (uint8_t)(1u << (code & 7));
+  if (pressed) {
+    if ((*holders)++ == 0) builder->nkro.keys[code >> 3] |= bit;
+  } else {
+    if (--(*holders) == 0) builder->nkro.keys[code >> 3] &= (uint8_t)~bit;
+  }
+  
+  if (usage & HID_USAGE_SHIFT) {
+    builder->shiftHolders += pressed ? 1 : -1;
+    builder->nkro.modifiers = builder->shiftHolders ? HID_MODIFIER_LEFT_SHIFT : 0;
+  }
+}
+
+static bool hidReportBuilder_setKey(HidReportBuilder* builder, char key, bool pressed) {
+  uint8_t c = (uint8_t)key;
+  if (c >= 128 || asciiToHidUsage[c] == 0) return false;  // No HID usage for this character
+  
+  uint32_t* word = &builder->pressed[c >> 5];
+  uint32_t bit = 1u << (c & 31);
+  if (((*word & bit) != 0) == pressed) return false;
+  
+  // Undoing a change the host has not seen: send it first, or the two would cancel out
+  if (builder->changed[c >> 5] & bit) {
+    if (builder->flush && builder->flush(builder->flushContext)) {
+      builder->conflictFlushes++;
+    } else {
+      builder->conflictsFolded++;
+    }
+  }
+  
+  *word ^= bit;
+  builder->changed[c >> 5] |= bit;
+  hidReportBuilder_setUsage(builder, asciiToHidUsage[c], pressed);
+  builder->dirty = true;
+  builder->pendingChanges++;
+  return true;
+}
+
+bool hidReportBuilder_press(HidReportBuilder* builder, char key) {
+  return hidReportBuilder_setKey(builder, key, true);
+}
+
+bool hidReportBuilder_release(HidReportBuilder* builder, char key) {
+  return hidReportBuilder_setKey(builder, key, false);
+}
+
+bool hidReportBuilder_isPressed(const HidReportBuilder* builder, char key) {
+  uint8_t c = (uint8_t)key;
+  if (c >= 128) return false;
+  return (builder->pressed[c >> 5] & (1u << (c & 31))) != 0;
+}
+
+bool hidReportBuilder_isPending(const HidReportBuilder* builder, char key) {
+  uint8_t c = (uint8_t)key;
+  if (c >= 128) return false;
+  return (builder->changed[c >> 5] & (1u << (c & 31))) != 0;
+}
+
+static void hidReportBuilder_consume(HidReportBuilder* builder) {
+  if (builder->pendingChanges > 1) {
+    builder->changesCoalesced += builder->pendingChanges - 1;
+  }
+  builder->pendingChanges = 0;
+  memset(builder->changed, 0, sizeof(builder->changed));
+  builder->dirty = false;
+  builder->reportsBuilt++;
+}
+
+bool hidReportBuilder_build(HidReportBuilder* builder, HidKeyboardReport* report) {
+  if (!builder->dirty) return false;
+  
+  memset(report, 0, sizeof(HidKeyboardReport));
+  int slot = 0;
+  for (int w = 0; w < 4; w++) {
+    uint32_t bits = builder->pressed[w];
+    while (bits) {
+      int c = (w << 5) | __builtin_ctz(bits);
+      bits &= bits - 1;
+      
+      uint8_t usage = asciiToHidUsage[c];
+      if (usage & HID_USAGE_SHIFT) {
+        report->modifiers |= HID_MODIFIER_LEFT_SHIFT;
+      }
+      // Boot protocol carries at most 6 keys; extras stay held and appear once a slot frees
+      if (slot < HID_REPORT_MAX_KEYS) {
+        report->keys[slot++] = usage & ~HID_USAGE_SHIFT;
+      }
+    }
+  }
+  
+  hidReportBuilder_consume(builder);
+  return true;
+}
+
+bool hidReportBuilder_buildNkro(HidReportBuilder* builder, HidNkroReport* report) {
+  if (!builder->dirty) return false;
+  
+  *report = builder->nkro;
+  hidReportBuilder_consume(builder);
+  return true;
+}
+
+void hidReportBuilder_invalidate(HidReportBuilder* builder) {
+  builder->dirty = true;
+}
@@ -0,0 +1,71 @@
+#ifndef HID_REPORT_BUILDER_H
+#define HID_REPORT_BUILDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Collects key changes from one dispatch cycle into a single keyboard report. Held keys are
+// tracked as a bitset indexed by ASCII character. The N-key-rollover report (a bit per HID
+// usage) is kept up to date by each change - one bit flip - and building it is a copy; the
+// 6-key boot-protocol report is built from the bitset on demand, for hosts that need it.
+// Only changes that do not conflict share a report: a change that undoes one the host has
+// not seen yet (a press and release of one key in the same cycle) first sends the pending
+// report through the flush hook, so both edges reach the host.
+
+#define HID_REPORT_MAX_KEYS 6
+#define HID_MODIFIER_LEFT_SHIFT 0x02
+
+// NKRO bitmap covers keyboard usages 0x00..0x67 (every key the ASCII table maps to)
+#define HID_NKRO_USAGE_COUNT 0x68
+#define HID_NKRO_BITMAP_BYTES (HID_NKRO_USAGE_COUNT / 8)
+
+typedef struct {
+  uint8_t modifiers;
+  uint8_t reserved;
+  uint8_t keys[HID_REPORT_MAX_KEYS];
+} HidKeyboardReport;  // Same layout as the Arduino KeyReport
+
+typedef struct __attribute__((packed)) {
+  uint8_t modifiers;
+  uint8_t keys[HID_NKRO_BITMAP_BYTES];  // Bit (usage & 7) of byte (usage >> 3)
+} HidNkroReport;
+
+// Builds and sends the pending report. Returns false if it could not be sent (no host).
+typedef bool (*HidReportFlush)(void* context);
+
+typedef struct {
+  uint32_t pressed[4];      // One bit per ASCII character currently held
+  uint32_t changed[4];      // Characters changed since the last report was built
+  HidNkroReport nkro;       // Report for the held set, updated per change
+  uint8_t usageHolders[HID_NKRO_USAGE_COUNT];  // Held characters per usage ('a' and 'A' share one)
+  uint8_t shiftHolders;     // Held characters that need Shift
+  bool dirty;               // Held set changed since the last report was built
+  uint32_t pendingChanges;  // Key changes folded into the next report
+  uint32_t reportsBuilt;
+  uint32_t changesCoalesced;  // Key changes that shared a report with another change
+  HidReportFlush flush;       // May be NULL
+  void* flushContext;
+  uint32_t conflictFlushes;   // Reports sent early because a change undid a pending one
+  uint32_t conflictsFolded;   // Such changes folded anyway because the flush could not send
+} HidReportBuilder;
+
+void hidReportBuilder_init(HidReportBuilder* builder);
+void hidReportBuilder_setFlush(HidReportBuilder* builder, HidReportFlush flush, void* context);
+
+// Return true if the held set changed (pressing a held key or releasing a free one does not)
+bool hidReportBuilder_press(HidReportBuilder* builder, char key);
+bool hidReportBuilder_release(HidReportBuilder* builder, char key);
+bool hidReportBuilder_isPressed(const HidReportBuilder* builder, char key);
+
+// True if the key changed since the last report was built (the host has not seen it yet)
+bool hidReportBuilder_isPending(const HidReportBuilder* builder, char key);
+
+// Build the report for the current held set. Returns false (and leaves report untouched)
+// when nothing changed since the last build. Either form consumes the pending changes.
+bool hidReportBuilder_build(HidReportBuilder* builder, HidKeyboardReport* report);
+bool hidReportBuilder_buildNkro(HidReportBuilder* builder, HidNkroReport* report);
+
+// Next build returns the full held set even if nothing changed (e.g. the report form changed)
+void hidReportBuilder_invalidate(HidReportBuilder* builder);
+
+#endif // HID_REPORT_BUILDER_H
@@ -0,0 +1,67 @@
+#include "IngressQueue.h"
+#include <string.h>
+
+static_assert((INGRESS_QUEUE_CAPACITY & (INGRESS_QUEUE_CAPACITY - 1)) == 0,
+              "INGRESS_QUEUE_CAPACITY must be a power of two");
+
+#define INGRESS_INDEX_MASK (INGRESS_QUEUE_CAPACITY - 1)
+
+void ingressQueue_init(IngressQueue* queue) {
+  memset(queue, 0, sizeof(IngressQueue));
+}
+
+bool ingressQueue_push(IngressQueue* queue, const uint8_t* mac, const uint8_t* data, int len,
+                       uint8_t channel, int64_t rxTimeUs) {
+  if (len < 0 || len > INGRESS_MAX_FRAME_LEN) {
+    queue->oversized++;
+    return false;
+  }
+
+  // head is only written here; tail is published by the consumer with release semantics
+  uint32_t head = queue->head;
+  uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+  uint32_t fill = head - tail;
+  if (fill >= INGRESS_QUEUE_CAPACITY) {
+    queue->dropped++;
+    return false;
+  }
+
+  IngressFrame* frame = &queue->frames[head & INGRESS_INDEX_MASK];
+  frame->rxTimeUs = rxTimeUs;
+  memcpy(frame->mac, mac, 6);
+  frame->addr = macAddr_fromBytes(mac);
+  frame->channel = channel;
+  frame->len = (uint8_t)len;
+  memcpy(frame->data, data, len);
+
+  // Publish the frame only after its contents are written
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+
+  queue->enqueued++;
+  if (fill + 1 > queue->highWater) {
+    queue->highWater = fill + 1;
+  }
+  return true;
+}
+
+const IngressFrame* ingressQueue_peek(IngressQueue* queue) {
+  uint32_t tail = queue->tail;
+  uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    return nullptr;
+  }
+  return &queue->frames[tail & INGRESS_INDEX_MASK];
+}
+
+void ingressQueue_release(IngressQueue* queue) {
+  // Hand the slot back to the producer only after the consumer is done reading it
+  __atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+}
+
+bool ingressQueue_isEmpty(const IngressQueue* queue) {
+  return __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == queue->tail;
+}
+
+uint32_t ingressQueue_size(const IngressQueue* queue) {
+  return __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,45 @@
+#ifndef INGRESS_QUEUE_H
+#define INGRESS_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../shared/config.h"
+#include "../shared/domain/MacUtils.h"
+
+// Single-producer/single-consumer ring between the ESP-NOW receive callback (WiFi task)
+// and the receiver's dispatcher. The producer only copies the frame and never blocks:
+// when the ring is full the frame is dropped and counted.
+
+typedef struct {
+  int64_t rxTimeUs;  // esp_timer timestamp taken in the receive callback
+  MacAddr addr;      // Sender, packed once here for the lookups
+  uint8_t mac[6];    // Sender as received, for replies and peer registration
+  uint8_t channel;
+  uint8_t len;
+  uint8_t data[INGRESS_MAX_FRAME_LEN];
+} IngressFrame;
+
+typedef struct {
+  IngressFrame frames[INGRESS_QUEUE_CAPACITY];
+  volatile uint32_t head;       // Next slot to write (producer only)
+  volatile uint32_t tail;       // Next slot to read (consumer only)
+  volatile uint32_t enqueued;   // Frames accepted
+  volatile uint32_t dropped;    // Frames dropped because the ring was full
+  volatile uint32_t oversized;  // Frames dropped because they exceed INGRESS_MAX_FRAME_LEN
+  volatile uint32_t highWater;  // Maximum observed fill level
+} IngressQueue;
+
+void ingressQueue_init(IngressQueue* queue);
+
+// Producer side (ESP-NOW receive callback)
+bool ingressQueue_push(IngressQueue* queue, const uint8_t* mac, const uint8_t* data, int len,
+                       uint8_t channel, int64_t rxTimeUs);
+
+// Consumer side: peek at the oldest frame in place, then release it once handled
+const IngressFrame* ingressQueue_peek(IngressQueue* queue);
+void ingressQueue_release(IngressQueue* queue);
+
+bool ingressQueue_isEmpty(const IngressQueue* queue);
+uint32_t ingressQueue_size(const IngressQueue* queue);
+
+#endif // INGRESS_QUEUE_H
@@ -1,56 +1,126 @@
 #include "LEDService.h"
-#include <Adafruit_NeoPixel.h>
+#include <string.h>
 #include <Arduino.h>
-#include <math.h>
 
-Adafruit_NeoPixel pixels(NUM_LEDS, LED_PIN, NEO_GRB + NEO_KHZ800);
+// WS2812 timing at a 10 MHz RMT clock (100 ns ticks)
+#define LED_RMT_RESOLUTION_HZ 10000000
+#define LED_T0H 4   // 0.4 us
+#define LED_T0L 8   // 0.85 us
+#define LED_T1H 8   // 0.8 us
+#define LED_T1L 4   // 0.45 us
+
+#define LED_COLOR_GREEN 0x00FF00u
+#define LED_COLOR_BLUE 0x0000FFu
+
+// 30 + 225 * (sin(2 pi i / 64) + 1) / 2 - the old per-frame sin(), sampled once
+static const uint8_t breatheCurve[64] = {
+  142, 153, 164, 175, 185, 195, 205, 213, 222, 229, 236, 241, 246, 250, 252, 254,
+  255, 254, 252, 250, 246, 241, 236, 229, 222, 213, 205, 195, 185, 175, 164, 153,
+  142, 131, 120, 109,  99,  89,  79,  71,  62,  55,  48,  43,  38,  34,  32,  30,
+   30,  30,  32,  34,  38,  43,  48,  55,  62,  71,  79,  89,  99, 109, 120, 131,
+};
+
+static const uint8_t blinkCurve[2] = {255, 0};
+
+typedef struct {
+  const uint8_t* levels;
+  uint16_t length;
+  uint16_t periodMs;
+} LedCurve;
+
+// Indexed by LedPattern; NULL levels = constant
+static const LedCurve curves[LED_PATTERN_COUNT] = {
+  {NULL, 1, 0},                                   // OFF
+  {NULL, 1, 0},                                   // SOLID
+  {breatheCurve, sizeof(breatheCurve), 2000},     // BREATHE
+  {blinkCurve, sizeof(blinkCurve), 1000},         // BLINK
+};
+
+static uint32_t ledService_scale(uint32_t color, uint8_t level) {
+  uint32_t r = ((color >> 16) & 0xFF) * level / 255;
+  uint32_t g = ((color >> 8) & 0xFF) * level / 255;
+  uint32_t b = (color & 0xFF) * level / 255;
+  return (r << 16) | (g << 8) | b;
+}
+
+static uint32_t ledService_frameColor(const LEDService* service, unsigned long currentTime) {
+  if (service->pattern == LED_PATTERN_OFF) return 0;
+  const LedCurve* curve = &curves[service->pattern];
+  if (!curve->levels) return service->color;
+  
+  uint32_t phase = (currentTime - service->patternStart) % curve->periodMs;
+  return ledService_scale(service->color, curve->levels[phase * curve->length / curve->periodMs]);
+}
+
+static bool ledService_show(LEDService* service, uint32_t color) {
+  if (!service->rmtReady) return false;
+  if (!rmtTransmitCompleted(LED_PIN)) {
+    service->framesBusy++;
+    return false;
+  }
+  
+  // WS2812 takes GRB, most significant bit first
+  uint32_t grb = ((color & 0x00FF00) << 8) | ((color & 0xFF0000) >> 8) | (color & 0x0000FF);
+  for (int bit = 0; bit < 24; bit++) {
+    bool one = (grb >> (23 - bit)) & 1;
+    rmt_data_t* item = &service->bits[bit];
+    item->level0 = 1;
+    item->duration0 = one ? LED_T1H : LED_T0H;
+    item->level1 = 0;
+    item->duration1 = one ? LED_T1L : LED_T0L;
+  }
+  if (!rmtWriteAsync(LED_PIN, service->bits, 24 * NUM_LEDS)) {
+    return false;
+  }
+  service->shownColor = color;
+  service->framesSent++;
+  return true;
+}
 
 void ledService_init(LEDService* service, unsigned long bootTime) {
+  memset(service, 0, sizeof(LEDService));
   service->bootTime = bootTime;
-  service->lastLEDColor = 0;  // Off initially
-  pixels.begin();
-  pixels.clear();
-  pixels.show();
+  service->pattern = LED_PATTERN_OFF;
+  service->rmtReady = rmtInit(LED_PIN, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, LED_RMT_RESOLUTION_HZ);
+  // Force the first frame out so the LED starts dark whatever it showed before the reset
+  service->shownColor = ~0u;
+  ledService_show(service, 0);
 }
 
-void ledService_update(LEDService* service, unsigned long currentTime, bool gracePeriodDone, int slotsUsed, bool inInitialWait) {
+void ledService_setPattern(LEDService* service, LedPattern pattern, uint32_t color, unsigned long currentTime) {
+  if (pattern == service->pattern && color == service->color) return;
+  service->pattern = pattern;
+  service->color = color;
+  service->patternStart = currentTime;
+  ledService_renderFrame(service, currentTime);  // Show the change without waiting a frame
+}
+
+void ledService_renderFrame(LEDService* service, unsigned long currentTime) {
+  uint32_t color = ledService_frameColor(service, currentTime);
+  if (color == service->shownColor) {
+    service->framesUnchanged++;
+    return;
+  }
+  ledService_show(service, color);
+}
+
+bool ledService_update(LEDService* service, unsigned long currentTime, bool gracePeriodDone, int slotsUsed, bool inInitialWait) {
   unsigned long timeSinceBoot = currentTime - service->bootTime;
   
   // LED states:
   // - Green: During initial wait (waiting for known transmitters to respond)
   // - Blue (breathing): Grace period active, not timed out, and slots available
   // - Off: Grace period done or slots full
-  
-  uint32_t ledColor = 0;  // Off by default
-  
   if (inInitialWait) {
-    // Initial wait period - show solid green
-    ledColor = pixels.Color(0, 255, 0);  // Green
+    ledService_setPattern(service, LED_PATTERN_SOLID, LED_COLOR_GREEN, currentTime);
   } else if (!gracePeriodDone && 
              (timeSinceBoot < TRANSMITTER_TIMEOUT) && 
              (slotsUsed < MAX_PEDAL_SLOTS)) {
-    // Grace period active - show breathing blue
-    // Use sine wave for smooth breathing effect (2 second cycle)
-    float cycleTime = (currentTime % 2000) / 2000.0f;  // 0.0 to 1.0 over 2 seconds
-    float brightness = (sin(cycleTime * 2.0f * PI) + 1.0f) / 2.0f;  // 0.0 to 1.0
-    // Map to 30-255 brightness range (30 = minimum visible, 255 = full brightness)
-    uint8_t blueValue = 30 + (uint8_t)(brightness * 225);
-    ledColor = pixels.Color(0, 0, blueValue);
+    ledService_setPattern(service, LED_PATTERN_BREATHE, LED_COLOR_BLUE, currentTime);
   } else {
-    // Grace period done or slots full - off
-    ledColor = pixels.Color(0, 0, 0);  // Off
+    ledService_setPattern(service, LED_PATTERN_OFF, 0, currentTime);
   }
   
-  // Always update during grace period (breathing animation) or when color changes
-  bool isBreathing = (!gracePeriodDone && 
-                      (timeSinceBoot < TRANSMITTER_TIMEOUT) && 
-                      (slotsUsed < MAX_PEDAL_SLOTS) && 
-                      !inInitialWait);
-  
-  if (isBreathing || ledColor != service->lastLEDColor) {
-    service->lastLEDColor = ledColor;
-    pixels.setPixelColor(0, ledColor);
-    pixels.show();
-  }
+  // A frame that found the RMT busy is retried by the next frame timer tick
+  return ledService_isAnimated(service) || service->shownColor != ledService_frameColor(service, currentTime);
 }
-
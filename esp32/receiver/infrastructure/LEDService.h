@@ -3,19 +3,54 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <Arduino.h>
+#include "../shared/config.h"
 
 #define LED_PIN 48
 #define NUM_LEDS 1
-#define TRANSMITTER_TIMEOUT 30000  // 30 seconds
-#define MAX_PEDAL_SLOTS 2
+#define TRANSMITTER_TIMEOUT TRANSMITTER_TIMEOUT_MS
+
+// Status LED (WS2812). Patterns are integer lookup tables indexed by time, rendered by a
+// fixed-rate frame timer (LED_FRAME_INTERVAL_MS) instead of every loop pass. Frames go out
+// through the RMT peripheral without waiting for the transfer, and a frame equal to the
+// one already on the LED is not sent.
+
+typedef enum {
+  LED_PATTERN_OFF,
+  LED_PATTERN_SOLID,
+  LED_PATTERN_BREATHE,  // 2 s cycle, never fully dark
+  LED_PATTERN_BLINK,    // 1 s cycle, 50% duty
+  LED_PATTERN_COUNT
+} LedPattern;
 
 typedef struct {
   unsigned long bootTime;
-  uint32_t lastLEDColor;  // Track last LED color to avoid unnecessary updates
+  
+  LedPattern pattern;
+  uint32_t color;               // 0x00RRGGBB at full brightness
+  unsigned long patternStart;   // Curves start at their first entry
+  
+  uint32_t shownColor;          // Last frame handed to the RMT
+  bool rmtReady;
+  rmt_data_t bits[24 * NUM_LEDS];  // Owned by the RMT while a frame is in flight
+  
+  // Instrumentation
+  uint32_t framesSent;
+  uint32_t framesUnchanged;     // Rendered but equal to the LED's color - not sent
+  uint32_t framesBusy;          // Previous frame still in flight - retried next frame
 } LEDService;
 
 void ledService_init(LEDService* service, unsigned long bootTime);
-void ledService_update(LEDService* service, unsigned long currentTime, bool gracePeriodDone, int slotsUsed, bool inInitialWait);
+void ledService_setPattern(LEDService* service, LedPattern pattern, uint32_t color, unsigned long currentTime);
+// Pick the pattern for the pairing state (cheap when it is unchanged). Returns true while
+// the pattern is animated - call ledService_renderFrame() every LED_FRAME_INTERVAL_MS
+// until it returns false.
+bool ledService_update(LEDService* service, unsigned long currentTime, bool gracePeriodDone, int slotsUsed, bool inInitialWait);
+// Frame timer: compute the current frame and send it if it differs from the LED
+void ledService_renderFrame(LEDService* service, unsigned long currentTime);
 
-#endif // LED_SERVICE_H
+static inline bool ledService_isAnimated(const LEDService* service) {
+  return service->pattern == LED_PATTERN_BREATHE || service->pattern == LED_PATTERN_BLINK;
+}
 
+#endif // LED_SERVICE_H
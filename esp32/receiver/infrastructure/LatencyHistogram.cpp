@@ -0,0 +1,64 @@
+#include "LatencyHistogram.h"
+#include <stdio.h>
+#include <string.h>
+
+void latencyHistogram_init(LatencyHistogram* histogram) {
+  memset((void*)histogram, 0, sizeof(LatencyHistogram));
+}
+
+static int latencyHistogram_bucketFor(uint32_t latencyUs) {
+  int bucket = 0;
+  uint32_t bound = 64;
+  while (latencyUs >= bound && bucket < LATENCY_HISTOGRAM_BUCKETS - 1) {
+    bound <<= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void latencyHistogram_record(LatencyHistogram* histogram, uint32_t latencyUs) {
+  histogram->buckets[latencyHistogram_bucketFor(latencyUs)]++;
+  histogram->count++;
+  histogram->sumUs += latencyUs;
+  if (latencyUs > histogram->maxUs) {
+    histogram->maxUs = latencyUs;
+  }
+}
+
+uint32_t latencyHistogram_percentileUs(const LatencyHistogram* histogram, int percent) {
+  if (histogram->count == 0) return 0;
+  
+  uint32_t target = (uint32_t)(((uint64_t)histogram->count * percent + 99) / 100);
+  uint32_t seen = 0;
+  for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+    seen += histogram->buckets[i];
+    if (seen >= target) {
+      return (i == LATENCY_HISTOGRAM_BUCKETS - 1) ? histogram->maxUs : (64u << i);
+    }
+  }
+  return histogram->maxUs;
+}
+
+void latencyHistogram_format(const LatencyHistogram* histogram, char* buffer, size_t bufferSize) {
+  if (!buffer || bufferSize == 0) return;
+  
+  uint32_t count = histogram->count;
+  uint32_t avg = count ? (uint32_t)(histogram->sumUs / count) : 0;
+  int len = snprintf(buffer, bufferSize, "n=%lu avg=%luus p50<%luus p99<%luus max=%luus |",
+                     (unsigned long)count, (unsigned long)avg,
+                     (unsigned long)latencyHistogram_percentileUs(histogram, 50),
+                     (unsigned long)latencyHistogram_percentileUs(histogram, 99),
+                     (unsigned long)histogram->maxUs);
+  
+  // Append non-empty buckets as "<bound:count"
+  for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS && len > 0 && len < (int)bufferSize; i++) {
+    if (histogram->buckets[i] == 0) continue;
+    if (i == LATENCY_HISTOGRAM_BUCKETS - 1) {
+      len += snprintf(buffer + len, bufferSize - len, " >=%lu:%lu",
+                      (unsigned long)(32u << i), (unsigned long)histogram->buckets[i]);
+    } else {
+      len += snprintf(buffer + len, bufferSize - len, " <%lu:%lu",
+                      (unsigned long)(64u << i), (unsigned long)histogram->buckets[i]);
+    }
+  }
+}
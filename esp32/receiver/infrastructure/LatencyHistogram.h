@@ -0,0 +1,24 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Log2-bucketed latency histogram in microseconds.
+// Bucket 0 holds samples below 64us; bucket i (i > 0) holds [32 << i, 64 << i) us;
+// the last bucket also holds everything above its lower bound.
+#define LATENCY_HISTOGRAM_BUCKETS 12
+
+typedef struct {
+  volatile uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+  volatile uint32_t count;
+  volatile uint32_t maxUs;
+  volatile uint64_t sumUs;
+} LatencyHistogram;
+
+void latencyHistogram_init(LatencyHistogram* histogram);
+void latencyHistogram_record(LatencyHistogram* histogram, uint32_t latencyUs);
+uint32_t latencyHistogram_percentileUs(const LatencyHistogram* histogram, int percent);  // Upper bucket bound
+void latencyHistogram_format(const LatencyHistogram* histogram, char* buffer, size_t bufferSize);
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,35 @@
+#include "MessageDispatcher.h"
+#include <string.h>
+
+void messageDispatcher_init(MessageDispatcher* dispatcher) {
+  memset(dispatcher, 0, sizeof(MessageDispatcher));
+}
+
+void messageDispatcher_register(MessageDispatcher* dispatcher, uint8_t msgType, uint8_t expectedLen,
+                                MessageHandler handler) {
+  dispatcher->routes[msgType].handler = handler;
+  dispatcher->routes[msgType].expectedLen = expectedLen;
+}
+
+bool messageDispatcher_dispatch(MessageDispatcher* dispatcher, const IngressFrame* frame) {
+  if (frame->len < 1) {
+    dispatcher->badLength++;
+    return false;
+  }
+  
+  const MessageRoute* route = &dispatcher->routes[frame->data[0]];
+  if (route->expectedLen == 0) {
+    dispatcher->unknownType++;
+    return false;
+  }
+  if (frame->len != route->expectedLen) {
+    dispatcher->badLength++;
+    return false;
+  }
+  
+  dispatcher->dispatched++;
+  if (route->handler) {
+    route->handler(frame);
+  }
+  return true;
+}
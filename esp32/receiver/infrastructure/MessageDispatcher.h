@@ -0,0 +1,33 @@
+#ifndef MESSAGE_DISPATCHER_H
+#define MESSAGE_DISPATCHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "IngressQueue.h"
+
+// Constant-time message routing keyed by msgType (first byte of every frame).
+// Each route carries the exact wire length of its message from shared/messages.h,
+// so a frame reaches its handler after one table lookup and one length check.
+// A route with a NULL handler accepts its message without calling anything - for frames
+// whose only effect is what the caller does for every frame (e.g. renewing leases).
+
+typedef void (*MessageHandler)(const IngressFrame* frame);
+
+typedef struct {
+  MessageHandler handler;  // NULL = accept only
+  uint8_t expectedLen;     // 0 = no route
+} MessageRoute;
+
+typedef struct {
+  MessageRoute routes[256];
+  uint32_t dispatched;      // Frames delivered to a handler or accepted
+  uint32_t unknownType;     // Frames with no registered route
+  uint32_t badLength;       // Frames whose length does not match their route
+} MessageDispatcher;
+
+void messageDispatcher_init(MessageDispatcher* dispatcher);
+void messageDispatcher_register(MessageDispatcher* dispatcher, uint8_t msgType, uint8_t expectedLen,
+                                MessageHandler handler);
+bool messageDispatcher_dispatch(MessageDispatcher* dispatcher, const IngressFrame* frame);
+
+#endif // MESSAGE_DISPATCHER_H
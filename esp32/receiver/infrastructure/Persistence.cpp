@@ -1,83 +1,317 @@
 #include "Persistence.h"
 #include <Preferences.h>
 #include <string.h>
+#include <limits.h>
 #include <Arduino.h>
+#include "esp_rom_crc.h"
+#include "../shared/config.h"
+#include "../shared/domain/MacUtils.h"
+
+static const char* const copyKeys[2] = {"stateA", "stateB"};
+
+// Version 1 record: pairings and debug monitor only
+typedef struct __attribute__((packed)) {
+  uint8_t mac[6];
+  uint8_t pedalMode;
+} PersistedTransmitterV1;
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t length;
+  uint32_t sequence;
+  uint8_t debugMonitorPaired;
+  uint8_t debugMonitorMAC[6];
+  PersistedTransmitterV1 transmitters[MAX_PEDAL_SLOTS];
+  uint32_t crc;
+} PersistedRecordV1;
+
+// ============================================================================
+// NVS store
+// ============================================================================
 
 Preferences preferences;
 
-void persistence_save(TransmitterManager* manager) {
+static size_t persistence_nvsRead(void*, const char* key, void* buffer, size_t len) {
+  preferences.begin("pedal", true);
+  size_t read = (preferences.getBytesLength(key) == len) ? preferences.getBytes(key, buffer, len) : 0;
+  preferences.end();
+  return read;
+}
+
+static bool persistence_nvsWrite(void*, const char* key, const void* data, size_t len) {
   preferences.begin("pedal", false);
-  preferences.putInt("pairedCount", manager->count);
-  preferences.putInt("pedalSlotsUsed", manager->slotsUsed);
-  
-  for (int i = 0; i < manager->count; i++) {
-    char macKey[12];
-    char modeKey[12];
-    snprintf(macKey, sizeof(macKey), "mac%d", i);
-    snprintf(modeKey, sizeof(modeKey), "mode%d", i);
-    
-    for (int j = 0; j < 6; j++) {
-      char key[15];
-      snprintf(key, sizeof(key), "%s_%d", macKey, j);
-      preferences.putUChar(key, manager->transmitters[i].mac[j]);
-    }
-    preferences.putUChar(modeKey, manager->transmitters[i].pedalMode);
-  }
-  
+  size_t written = preferences.putBytes(key, data, len);
   preferences.end();
+  return written == len;
 }
 
-void persistence_load(TransmitterManager* manager) {
+static bool persistence_nvsRemove(void*, const char* key) {
+  preferences.begin("pedal", false);
+  bool removed = preferences.remove(key);
+  preferences.end();
+  return removed;
+}
+
+// Pre-blob layout: "pairedCount", "macN_j" per MAC byte, "modeN", "dbgmon_j" and
+// "dbgmon_paired"
+static bool persistence_nvsLoadLegacy(void*, PersistedRecord* record) {
   preferences.begin("pedal", true);
-  manager->count = preferences.getInt("pairedCount", 0);
-  // Don't restore slotsUsed - it will be calculated based on responsive transmitters
-  manager->slotsUsed = 0;
-  
-  for (int i = 0; i < manager->count && i < MAX_PEDAL_SLOTS; i++) {
-    char macKey[12];
-    char modeKey[12];
-    snprintf(macKey, sizeof(macKey), "mac%d", i);
-    snprintf(modeKey, sizeof(modeKey), "mode%d", i);
-    
-    for (int j = 0; j < 6; j++) {
+  bool found = preferences.isKey("pairedCount") || preferences.isKey("dbgmon_paired");
+  if (found) {
+    int count = preferences.getInt("pairedCount", 0);
+    for (int i = 0; i < count && i < MAX_PEDAL_SLOTS; i++) {
       char key[15];
-      snprintf(key, sizeof(key), "%s_%d", macKey, j);
-      manager->transmitters[i].mac[j] = preferences.getUChar(key, 0);
+      for (int j = 0; j < 6; j++) {
+        snprintf(key, sizeof(key), "mac%d_%d", i, j);
+        record->transmitters[i].mac[j] = preferences.getUChar(key, 0);
+      }
+      snprintf(key, sizeof(key), "mode%d", i);
+      record->transmitters[i].pedalMode = preferences.getUChar(key, 0);
+    }
+    if (preferences.getBool("dbgmon_paired", false)) {
+      for (int j = 0; j < 6; j++) {
+        char key[15];
+        snprintf(key, sizeof(key), "dbgmon_%d", j);
+        record->debugMonitorMAC[j] = preferences.getUChar(key, 0);
+      }
+      record->debugMonitorPaired = !macIsZero(record->debugMonitorMAC);
     }
-    manager->transmitters[i].pedalMode = preferences.getUChar(modeKey, 0);
-    manager->transmitters[i].seenOnBoot = false;  // Will be set to true when transmitter responds
-    manager->transmitters[i].lastSeen = 0;
   }
-  
   preferences.end();
+  return found;
 }
 
-void persistence_saveDebugMonitor(const uint8_t* mac) {
+static void persistence_nvsRemoveLegacy(void*) {
   preferences.begin("pedal", false);
+  int count = preferences.getInt("pairedCount", 0);
+  for (int i = 0; i < count && i < MAX_PEDAL_SLOTS; i++) {
+    char key[15];
+    for (int j = 0; j < 6; j++) {
+      snprintf(key, sizeof(key), "mac%d_%d", i, j);
+      preferences.remove(key);
+    }
+    snprintf(key, sizeof(key), "mode%d", i);
+    preferences.remove(key);
+  }
   for (int j = 0; j < 6; j++) {
     char key[15];
     snprintf(key, sizeof(key), "dbgmon_%d", j);
-    preferences.putUChar(key, mac[j]);
+    preferences.remove(key);
   }
-  preferences.putBool("dbgmon_paired", true);
+  preferences.remove("pairedCount");
+  preferences.remove("pedalSlotsUsed");
+  preferences.remove("dbgmon_paired");
   preferences.end();
 }
 
-void persistence_loadDebugMonitor(uint8_t* mac, bool* isPaired) {
-  preferences.begin("pedal", true);
-  bool dbgMonSaved = preferences.getBool("dbgmon_paired", false);
-  if (dbgMonSaved) {
-    bool allZero = true;
-    for (int j = 0; j < 6; j++) {
-      char key[15];
-      snprintf(key, sizeof(key), "dbgmon_%d", j);
-      mac[j] = preferences.getUChar(key, 0);
-      if (mac[j] != 0) allZero = false;
+static const PersistenceStore nvsStore = {
+  NULL,
+  persistence_nvsRead,
+  persistence_nvsWrite,
+  persistence_nvsRemove,
+  persistence_nvsLoadLegacy,
+  persistence_nvsRemoveLegacy,
+};
+
+const PersistenceStore* persistence_nvsStore() {
+  return &nvsStore;
+}
+
+// ============================================================================
+// Record
+// ============================================================================
+
+static uint32_t persistence_crc(const PersistedRecord* record) {
+  return esp_rom_crc32_le(0, (const uint8_t*)record, offsetof(PersistedRecord, crc));
+}
+
+static bool persistence_isValid(const PersistedRecord* record) {
+  return record->magic == PERSISTENCE_MAGIC &&
+         record->version == PERSISTENCE_VERSION &&
+         record->length == sizeof(PersistedRecord) &&
+         record->crc == persistence_crc(record);
+}
+
+static void persistence_initRecord(PersistedRecord* record) {
+  memset(record, 0, sizeof(PersistedRecord));
+  record->magic = PERSISTENCE_MAGIC;
+  record->version = PERSISTENCE_VERSION;
+  record->length = sizeof(PersistedRecord);
+}
+
+// Payload equality - ignores sequence and CRC
+static bool persistence_samePayload(const PersistedRecord* a, const PersistedRecord* b) {
+  size_t start = offsetof(PersistedRecord, debugMonitorPaired);
+  return memcmp((const uint8_t*)a + start, (const uint8_t*)b + start,
+                offsetof(PersistedRecord, crc) - start) == 0;
+}
+
+static void persistence_markChanged(Persistence* persistence, unsigned long now) {
+  if (persistence_samePayload(&persistence->record, &persistence->committed)) {
+    persistence->dirty = false;  // Changed back before the commit - nothing to write
+    return;
+  }
+  if (persistence->dirty) {
+    persistence->coalesced++;
+  }
+  persistence->dirty = true;
+  persistence->dirtySince = now;  // Restart the quiet period
+}
+
+void persistence_init(Persistence* persistence, const PersistenceStore* store) {
+  memset(persistence, 0, sizeof(Persistence));
+  persistence->store = store;
+  persistence->observedVersion = ~0u;
+  persistence_initRecord(&persistence->record);
+  persistence->committed = persistence->record;
+}
+
+// Newest version 1 copy, converted; no session state, so the boot is cold
+static bool persistence_loadV1(const PersistenceStore* store, PersistedRecord* record) {
+  PersistedRecordV1 copy;
+  bool found = false;
+  for (int i = 0; i < 2; i++) {
+    if (store->read(store->context, copyKeys[i], &copy, sizeof(copy)) != sizeof(copy) ||
+        copy.magic != PERSISTENCE_MAGIC || copy.version != 1 || copy.length != sizeof(copy) ||
+        copy.crc != esp_rom_crc32_le(0, (const uint8_t*)&copy, offsetof(PersistedRecordV1, crc))) {
+      continue;
+    }
+    if (found && (int32_t)(copy.sequence - record->sequence) <= 0) continue;
+    
+    found = true;
+    record->sequence = copy.sequence;
+    record->debugMonitorPaired = copy.debugMonitorPaired;
+    memcpy(record->debugMonitorMAC, copy.debugMonitorMAC, 6);
+    for (int j = 0; j < MAX_PEDAL_SLOTS; j++) {
+      memcpy(record->transmitters[j].mac, copy.transmitters[j].mac, 6);
+      record->transmitters[j].pedalMode = copy.transmitters[j].pedalMode;
     }
-    *isPaired = !allZero;
-  } else {
-    *isPaired = false;
   }
-  preferences.end();
+  return found;
 }
 
+int persistence_load(Persistence* persistence, TransmitterManager* manager) {
+  uint32_t start = micros();
+  const PersistenceStore* store = persistence->store;
+  
+  // Newest valid copy wins; the next write goes to the other one
+  PersistedRecord copies[2];
+  int newest = -1;
+  for (int i = 0; i < 2; i++) {
+    if (store->read(store->context, copyKeys[i], &copies[i], sizeof(PersistedRecord)) != sizeof(PersistedRecord) ||
+        !persistence_isValid(&copies[i])) {
+      continue;
+    }
+    if (newest < 0 || (int32_t)(copies[i].sequence - copies[newest].sequence) > 0) {
+      newest = i;
+    }
+  }
+  
+  if (newest >= 0) {
+    persistence->record = copies[newest];
+    persistence->committed = copies[newest];
+    persistence->nextCopy = (uint8_t)(1 - newest);
+  } else if (persistence_loadV1(store, &persistence->record)) {
+    // Rewritten as version 2 after the quiet period; the sequence carries on
+    persistence->committed.sequence = persistence->record.sequence;
+    persistence_markChanged(persistence, millis());
+  } else if (store->loadLegacy && store->loadLegacy(store->context, &persistence->record)) {
+    persistence->migrated = true;
+    persistence_markChanged(persistence, millis());
+  }
+  
+  uint32_t slotMasks[MAX_PEDAL_SLOTS];
+  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
+    memcpy(manager->transmitters[i].mac, persistence->record.transmitters[i].mac, 6);
+    manager->transmitters[i].pedalMode = persistence->record.transmitters[i].pedalMode;
+    manager->transmitters[i].seenOnBoot = false;  // Will be set to true when transmitter responds
+    manager->transmitters[i].lastSeen = 0;
+    slotMasks[i] = persistence->record.transmitters[i].slotMask;
+  }
+  transmitterManager_reindex(manager);
+  int restored = transmitterManager_restoreSession(manager, slotMasks, persistence->record.responsive, millis());
+  
+  // Next update compares the restored state with the record; it only writes if they differ
+  // (a migrated record, or a session that could not be restored as saved)
+  persistence->observedVersion = ~0u;
+  persistence->lastLoadUs = micros() - start;
+  return restored;
+}
+
+static bool persistence_commit(Persistence* persistence) {
+  uint32_t start = micros();
+  const PersistenceStore* store = persistence->store;
+  
+  PersistedRecord* record = &persistence->record;
+  record->sequence = persistence->committed.sequence + 1;
+  record->crc = persistence_crc(record);
+  
+  if (!store->write(store->context, copyKeys[persistence->nextCopy], record, sizeof(PersistedRecord))) {
+    persistence->commitFailures++;
+    return false;  // Stays dirty; retried after another quiet period
+  }
+  persistence->committed = *record;
+  persistence->nextCopy ^= 1;
+  persistence->dirty = false;
+  persistence->commits++;
+  
+  if (persistence->migrated && store->removeLegacy) {
+    store->removeLegacy(store->context);
+    persistence->migrated = false;
+  }
+  persistence->lastCommitUs = micros() - start;
+  return true;
+}
+
+bool persistence_update(Persistence* persistence, const TransmitterManager* manager, unsigned long now) {
+  if (persistence->observedVersion != manager->version) {
+    persistence->observedVersion = manager->version;
+    for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
+      memcpy(persistence->record.transmitters[i].mac, manager->transmitters[i].mac, 6);
+      persistence->record.transmitters[i].pedalMode = manager->transmitters[i].pedalMode;
+      persistence->record.transmitters[i].slotMask = manager->transmitters[i].slotMask;
+    }
+    // Responsiveness is session state: a transmitter coming or going is written too
+    persistence->record.responsive = manager->responsive;
+    persistence_markChanged(persistence, now);
+  }
+  
+  if (!persistence->dirty || now - persistence->dirtySince < PERSISTENCE_COMMIT_DELAY_MS) {
+    return false;
+  }
+  if (!persistence_commit(persistence)) {
+    persistence->dirtySince = now;
+    return false;
+  }
+  return true;
+}
+
+bool persistence_flush(Persistence* persistence) {
+  return persistence->dirty && persistence_commit(persistence);
+}
+
+unsigned long persistence_timeUntilCommitMs(const Persistence* persistence, unsigned long now) {
+  if (!persistence->dirty) {
+    return ULONG_MAX;
+  }
+  unsigned long elapsed = now - persistence->dirtySince;
+  return (elapsed >= PERSISTENCE_COMMIT_DELAY_MS) ? 0 : PERSISTENCE_COMMIT_DELAY_MS - elapsed;
+}
+
+void persistence_noteChannel(Persistence* persistence, uint8_t channel, unsigned long now) {
+  if (channel == 0 || channel == persistence->record.channel) return;
+  persistence->record.channel = channel;
+  persistence_markChanged(persistence, now);
+}
+
+void persistence_saveDebugMonitor(Persistence* persistence, const uint8_t* mac) {
+  persistence->record.debugMonitorPaired = 1;
+  memcpy(persistence->record.debugMonitorMAC, mac, 6);
+  persistence_markChanged(persistence, millis());
+}
+
+void persistence_loadDebugMonitor(const Persistence* persistence, uint8_t* mac, bool* isPaired) {
+  memcpy(mac, persistence->record.debugMonitorMAC, 6);
+  *isPaired = persistence->record.debugMonitorPaired && !macIsZero(mac);
+}
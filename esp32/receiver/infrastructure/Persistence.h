@@ -3,12 +3,94 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "../domain/TransmitterManager.h"
 
-void persistence_save(TransmitterManager* manager);
-void persistence_load(TransmitterManager* manager);
-void persistence_saveDebugMonitor(const uint8_t* mac);
-void persistence_loadDebugMonitor(uint8_t* mac, bool* isPaired);
+// Receiver pairing state as one versioned, CRC-protected blob. Two copies are kept
+// (A/B) and writes alternate between them, so a reset mid-write leaves the previous copy
+// intact. Changes are tracked against the last committed record and written after
+// PERSISTENCE_COMMIT_DELAY_MS of quiet, so bursts of pairing traffic cost one write and
+// unchanged state costs none.
+//
+// Besides the pairings, the record holds the last session (responsive set, slot masks,
+// radio channel) so a rebooted receiver can bring those transmitters back live at once.
 
-#endif // PERSISTENCE_H
+#define PERSISTENCE_MAGIC 0x53525050u  // "PPRS"
+#define PERSISTENCE_VERSION 2           // 1 had no session state; still loaded
+
+typedef struct __attribute__((packed)) {
+  uint8_t mac[6];
+  uint8_t pedalMode;
+  uint32_t slotMask;    // Slots held or preferred, so keys are the same after a reboot
+} PersistedTransmitter;
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t length;      // sizeof(PersistedRecord)
+  uint32_t sequence;    // Newer copy has the higher sequence
+  uint8_t debugMonitorPaired;
+  uint8_t debugMonitorMAC[6];
+  uint8_t channel;      // Radio channel transmitters were last heard on (0 = unknown)
+  uint32_t responsive;  // Transmitters live when last committed - restored live on boot
+  PersistedTransmitter transmitters[MAX_PEDAL_SLOTS];  // By table position, so keys stay put
+  uint32_t crc;         // CRC-32 of everything above
+} PersistedRecord;
+
+// Key-value backend. The NVS one is persistence_nvsStore(); a host fake only needs
+// read/write/remove over a map.
+typedef struct {
+  void* context;
+  size_t (*read)(void* context, const char* key, void* buffer, size_t len);  // Bytes read, 0 if absent
+  bool (*write)(void* context, const char* key, const void* data, size_t len);
+  bool (*remove)(void* context, const char* key);
+  // Fill record from the pre-blob per-byte layout; NULL if the store has none
+  bool (*loadLegacy)(void* context, PersistedRecord* record);
+  void (*removeLegacy)(void* context);
+} PersistenceStore;
+
+typedef struct {
+  const PersistenceStore* store;
+  PersistedRecord record;     // Current state (RAM)
+  PersistedRecord committed;  // Last state written, for change detection
+  uint8_t nextCopy;           // 0 = A, 1 = B
+  uint32_t observedVersion;   // TransmitterManager version last copied into record
+  bool dirty;
+  bool migrated;              // Loaded from legacy keys; removed after the first commit
+  unsigned long dirtySince;
+
+  // Instrumentation
+  uint32_t commits;
+  uint32_t coalesced;        // Changes absorbed into an already pending commit
+  uint32_t commitFailures;
+  uint32_t lastLoadUs;
+  uint32_t lastCommitUs;
+} Persistence;
+
+const PersistenceStore* persistence_nvsStore();
 
+void persistence_init(Persistence* persistence, const PersistenceStore* store);
+
+// Load the newest valid copy (or migrate a version 1 copy / legacy keys) into the manager.
+// Transmitters that were responsive in the last session come back responsive, holding the
+// same slots; returns how many.
+int persistence_load(Persistence* persistence, TransmitterManager* manager);
+
+// Loop side: pick up manager changes (O(1) when its version is unchanged) and commit once
+// PERSISTENCE_COMMIT_DELAY_MS passed without further changes. Returns true if it wrote.
+bool persistence_update(Persistence* persistence, const TransmitterManager* manager, unsigned long now);
+// Write now if anything is pending (e.g. before a restart)
+bool persistence_flush(Persistence* persistence);
+// Milliseconds until a pending commit is due (ULONG_MAX if nothing is pending)
+unsigned long persistence_timeUntilCommitMs(const Persistence* persistence, unsigned long now);
+
+// Channel of a frame from a known transmitter; written with the next commit if it changed
+void persistence_noteChannel(Persistence* persistence, uint8_t channel, unsigned long now);
+static inline uint8_t persistence_channel(const Persistence* persistence) {
+  return persistence->record.channel;
+}
+
+void persistence_saveDebugMonitor(Persistence* persistence, const uint8_t* mac);
+void persistence_loadDebugMonitor(const Persistence* persistence, uint8_t* mac, bool* isPaired);
+
+#endif // PERSISTENCE_H
@@ -0,0 +1,147 @@
+#include "Telemetry.h"
+#include <string.h>
+#include <limits.h>
+#include <Arduino.h>
+#include <USB.h>
+#include <USBCDC.h>
+#include <esp_timer.h>
+
+static_assert((TELEMETRY_BUFFER_SIZE & (TELEMETRY_BUFFER_SIZE - 1)) == 0,
+              "TELEMETRY_BUFFER_SIZE must be a power of two");
+static_assert(TELEMETRY_COUNTER_COUNT * 4 <= TELEMETRY_MAX_PAYLOAD, "Counter snapshot exceeds a frame");
+
+#define TELEMETRY_RING_MASK (TELEMETRY_BUFFER_SIZE - 1)
+
+// Second USB interface next to the keyboard; registered with TinyUSB when constructed
+USBCDC TelemetrySerial;
+
+Telemetry* g_telemetry = nullptr;
+
+static uint8_t telemetry_crc8(uint8_t crc, const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+void telemetry_init(Telemetry* telemetry) {
+  memset(telemetry, 0, sizeof(Telemetry));
+  telemetry->lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+void telemetry_begin(Telemetry* telemetry) {
+  // Never block the loop on a host that stopped reading; update() only writes what fits
+  TelemetrySerial.setTxTimeoutMs(0);
+  TelemetrySerial.begin();
+  telemetry->started = true;
+}
+
+bool telemetry_emit(Telemetry* telemetry, uint8_t type, const void* payload, uint8_t length) {
+  if (!telemetry || !telemetry->connected) return false;
+  if (length > TELEMETRY_MAX_PAYLOAD) {
+    length = TELEMETRY_MAX_PAYLOAD;
+  }
+  
+  uint8_t frame[TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + 1];
+  uint32_t timeUs = (uint32_t)esp_timer_get_time();
+  frame[0] = TELEMETRY_SYNC0;
+  frame[1] = TELEMETRY_SYNC1;
+  frame[2] = type;
+  frame[3] = length;
+  memcpy(&frame[4], &timeUs, 4);
+  memcpy(&frame[TELEMETRY_HEADER_SIZE], payload, length);
+  uint8_t crc = telemetry_crc8(0, &frame[2], 2);
+  crc = telemetry_crc8(crc, &frame[4], 4 + length);
+  frame[TELEMETRY_HEADER_SIZE + length] = crc;
+  uint32_t size = TELEMETRY_HEADER_SIZE + length + 1;
+  
+  bool staged = false;
+  portENTER_CRITICAL(&telemetry->lock);
+  uint32_t head = telemetry->head;
+  if (TELEMETRY_BUFFER_SIZE - (head - telemetry->tail) >= size) {
+    uint32_t start = head & TELEMETRY_RING_MASK;
+    uint32_t first = TELEMETRY_BUFFER_SIZE - start;
+    if (first > size) first = size;
+    memcpy(&telemetry->ring[start], frame, first);
+    memcpy(&telemetry->ring[0], frame + first, size - first);
+    telemetry->head = head + size;
+    telemetry->frames++;
+    staged = true;
+  } else {
+    telemetry->dropped++;
+  }
+  portEXIT_CRITICAL(&telemetry->lock);
+  return staged;
+}
+
+void telemetry_event(Telemetry* telemetry, uint8_t type, uint8_t a, uint8_t b, uint8_t c, uint32_t value) {
+  uint8_t payload[8] = {type, a, b, c};
+  memcpy(&payload[4], &value, 4);
+  telemetry_emit(telemetry, TELEMETRY_EVENT, payload, sizeof(payload));
+}
+
+void telemetry_latency(Telemetry* telemetry, uint32_t latencyUs) {
+  telemetry_emit(telemetry, TELEMETRY_LATENCY, &latencyUs, sizeof(latencyUs));
+}
+
+void telemetry_counters(Telemetry* telemetry, const uint32_t* counters) {
+  telemetry_emit(telemetry, TELEMETRY_COUNTERS, counters, TELEMETRY_COUNTER_COUNT * sizeof(uint32_t));
+}
+
+void telemetry_log(Telemetry* telemetry, const char* text) {
+  telemetry_emit(telemetry, TELEMETRY_LOG, text, (uint8_t)strnlen(text, TELEMETRY_MAX_PAYLOAD));
+}
+
+size_t telemetry_update(Telemetry* telemetry, unsigned long now) {
+  if (!telemetry->started) return 0;
+  
+  bool connected = (bool)TelemetrySerial;
+  if (connected != telemetry->connected) {
+    // Start each session with an empty ring so the reader never sees half a frame
+    portENTER_CRITICAL(&telemetry->lock);
+    telemetry->tail = telemetry->head;
+    telemetry->connected = connected;
+    portEXIT_CRITICAL(&telemetry->lock);
+    if (connected) {
+      uint8_t hello[2] = {TELEMETRY_VERSION, TELEMETRY_COUNTER_COUNT};
+      telemetry_emit(telemetry, TELEMETRY_HELLO, hello, sizeof(hello));
+    }
+  }
+  telemetry->lastDrain = now;
+  if (!connected) return 0;
+  
+  // Only the loop advances tail, so the staged bytes stay put while they are written
+  size_t written = 0;
+  uint32_t head = __atomic_load_n(&telemetry->head, __ATOMIC_ACQUIRE);
+  while (head != telemetry->tail) {
+    uint32_t start = telemetry->tail & TELEMETRY_RING_MASK;
+    uint32_t chunk = head - telemetry->tail;
+    if (chunk > TELEMETRY_BUFFER_SIZE - start) {
+      chunk = TELEMETRY_BUFFER_SIZE - start;
+    }
+    int room = TelemetrySerial.availableForWrite();
+    if (room <= 0) break;
+    if (chunk > (uint32_t)room) {
+      chunk = room;
+    }
+    size_t sent = TelemetrySerial.write(&telemetry->ring[start], chunk);
+    if (sent == 0) break;
+    portENTER_CRITICAL(&telemetry->lock);
+    telemetry->tail += sent;
+    portEXIT_CRITICAL(&telemetry->lock);
+    written += sent;
+  }
+  telemetry->bytesSent += written;
+  return written;
+}
+
+unsigned long telemetry_timeUntilDrainMs(const Telemetry* telemetry, unsigned long now) {
+  if (!telemetry->connected || telemetry->head == telemetry->tail) {
+    return ULONG_MAX;
+  }
+  unsigned long elapsed = now - telemetry->lastDrain;
+  return (elapsed >= TELEMETRY_DRAIN_INTERVAL_MS) ? 0 : TELEMETRY_DRAIN_INTERVAL_MS - elapsed;
+}
@@ -0,0 +1,94 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include "../shared/config.h"
+
+// Binary telemetry over a USB CDC interface next to the HID keyboard (composite device), so
+// a PC on the receiver's own USB cable sees events, latency samples, counters and debug
+// lines without a debug monitor and without using the radio. Decoded on the host by
+// tools/telemetry_reader.py.
+//
+// Frame (little-endian):
+//   0xA5 0x5A | type u8 | length u8 | timeUs u32 | payload[length] | crc8
+// timeUs is esp_timer_get_time() truncated to 32 bits; the CRC-8 (poly 0x07) covers type
+// through payload. A reader that loses sync scans for the next 0xA5 0x5A.
+//
+// Any task can stage frames (a spinlock-protected byte ring); the loop task drains the ring
+// into the CDC endpoint as far as the host takes it. With no host attached nothing is staged.
+
+#define TELEMETRY_SYNC0 0xA5
+#define TELEMETRY_SYNC1 0x5A
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_HEADER_SIZE 8
+#define TELEMETRY_MAX_PAYLOAD 200
+
+typedef enum {
+  TELEMETRY_HELLO = 1,     // version u8, then counter count u8 - sent when a host connects
+  TELEMETRY_EVENT = 2,     // Flight recorder event: type, a, b, c u8, value u32
+  TELEMETRY_LATENCY = 3,   // Frame arrival -> HID report, u32 microseconds
+  TELEMETRY_COUNTERS = 4,  // u32 per TelemetryCounter, in enum order
+  TELEMETRY_LOG = 5        // Debug line text, no terminator
+} TelemetryType;
+
+// Snapshot order of a TELEMETRY_COUNTERS payload. Append only - the reader names them by index.
+typedef enum {
+  TELEMETRY_COUNTER_INGRESS_FRAMES,
+  TELEMETRY_COUNTER_INGRESS_DROPPED,
+  TELEMETRY_COUNTER_DISPATCHED,
+  TELEMETRY_COUNTER_HID_REPORTS,
+  TELEMETRY_COUNTER_KEY_CHANGES_COALESCED,
+  TELEMETRY_COUNTER_LEASE_EXPIRIES,
+  TELEMETRY_COUNTER_CONTROL_DROPPED,
+  TELEMETRY_COUNTER_LOOP_WAKEUPS,
+  TELEMETRY_COUNTER_FLIGHT_EVENTS,
+  TELEMETRY_COUNTER_PERSISTENCE_COMMITS,
+  TELEMETRY_COUNTER_TELEMETRY_DROPPED,
+  TELEMETRY_COUNTER_PLAYOUT_DEFERRED,
+  TELEMETRY_COUNTER_PLAYOUT_LATE,
+  TELEMETRY_COUNTER_COUNT
+} TelemetryCounter;
+
+typedef struct {
+  bool started;
+  bool connected;          // Host has the port open (DTR) - loop's view
+  
+  uint8_t ring[TELEMETRY_BUFFER_SIZE];
+  uint32_t head;           // Producers
+  uint32_t tail;           // Loop
+  portMUX_TYPE lock;
+  unsigned long lastDrain;
+  
+  // Instrumentation
+  uint32_t frames;
+  uint32_t bytesSent;
+  volatile uint32_t dropped;  // Frames that did not fit in the ring
+} Telemetry;
+
+// Set once started, so other modules can emit without a handle (NULL-safe)
+extern Telemetry* g_telemetry;
+
+// Call before USB.begin() so the CDC interface is part of the composite device
+void telemetry_init(Telemetry* telemetry);
+void telemetry_begin(Telemetry* telemetry);
+
+static inline bool telemetry_isConnected(const Telemetry* telemetry) {
+  return telemetry && telemetry->connected;
+}
+
+// Any task. Returns false (frame dropped) when not connected or the ring is full.
+bool telemetry_emit(Telemetry* telemetry, uint8_t type, const void* payload, uint8_t length);
+void telemetry_event(Telemetry* telemetry, uint8_t type, uint8_t a, uint8_t b, uint8_t c, uint32_t value);
+void telemetry_latency(Telemetry* telemetry, uint32_t latencyUs);
+void telemetry_counters(Telemetry* telemetry, const uint32_t* counters);  // TELEMETRY_COUNTER_COUNT values
+void telemetry_log(Telemetry* telemetry, const char* text);
+
+// Loop task: track the host connection and write staged bytes. Returns bytes written.
+size_t telemetry_update(Telemetry* telemetry, unsigned long now);
+// Milliseconds until update() has bytes to write (ULONG_MAX if none are staged)
+unsigned long telemetry_timeUntilDrainMs(const Telemetry* telemetry, unsigned long now);
+
+#endif // TELEMETRY_H
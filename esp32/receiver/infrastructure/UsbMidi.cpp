@@ -0,0 +1,31 @@
+#include "UsbMidi.h"
+#include <USB.h>
+#include <USBMIDI.h>
+
+static USBMIDI UsbMidiPort;
+
+static bool usbMidi_send(void* context, uint8_t status, uint8_t data1, uint8_t data2) {
+  uint8_t channel = (uint8_t)((status & 0x0F) + 1);
+  switch (status & 0xF0) {
+    case 0x90:
+      UsbMidiPort.noteOn(data1, data2, channel);
+      return true;
+    case 0x80:
+      UsbMidiPort.noteOff(data1, data2, channel);
+      return true;
+    case 0xB0:
+      UsbMidiPort.controlChange(data1, data2, channel);
+      return true;
+    default:
+      return false;
+  }
+}
+
+void usbMidi_begin() {
+  UsbMidiPort.begin();
+}
+
+MidiSink usbMidi_sink() {
+  MidiSink sink = {usbMidi_send, nullptr};
+  return sink;
+}
@@ -0,0 +1,13 @@
+#ifndef USB_MIDI_H
+#define USB_MIDI_H
+
+#include "../application/MidiService.h"
+
+// USB MIDI interface next to the HID keyboard. The port registers itself with TinyUSB when
+// constructed, so it is part of the descriptor by the time keyboardService_init() starts USB.
+void usbMidi_begin();
+
+// Sink for MidiService: note on/off and control change messages, cable 0
+MidiSink usbMidi_sink();
+
+#endif // USB_MIDI_H
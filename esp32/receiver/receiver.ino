@@ -8,40 +8,82 @@
 #include "domain/TransmitterManager.h"
 #include "domain/SlotManager.h"
 #include "domain/SlotManager.cpp"  // Force compilation of SlotManager
+#include "domain/KeyBindings.h"
 #include "infrastructure/EspNowTransport.h"
+#include "infrastructure/MessageDispatcher.h"
 #include "infrastructure/Persistence.h"
 #include "infrastructure/LEDService.h"
 #include "infrastructure/DebugMonitor.h"
+#include "infrastructure/FlightRecorder.h"
+#include "infrastructure/Telemetry.h"
 #include "application/PairingService.h"
 #include "application/KeyboardService.h"
+#include "application/ExpressionAxes.h"
+#include "application/HidOutputTask.h"
+#include "shared/infrastructure/Scheduler.h"
 
 // Domain layer instances
 TransmitterManager transmitterManager;
 ReceiverEspNowTransport transport;
 LEDService ledService;
 DebugMonitor debugMonitor;
+Persistence persistence;
+FlightRecorder flightRecorder;
+Telemetry telemetry;
+MessageDispatcher messageDispatcher;
+KeyBindings keyBindings;
 
 // Application layer instances
 ReceiverPairingService pairingService;
 KeyboardService keyboardService;
+ExpressionAxes expressionAxes;
+HidOutputTask hidOutputTask;
+
+// Tap/double-tap/hold actions per pedal key (application/GestureRecognizer.h). A tap always
+// types the pedal's own key with no added latency; pedals not listed behave exactly as before.
+// Example: {'l', {'L', true}, {' ', true}} - double-tap the first pedal for 'L' instead of
+// "ll", hold it for a held space instead of 'l'.
+static const GestureBinding gestureBindings[] = {
+  {0}  // End of table
+};
+
+// Pedal keys that send USB MIDI instead of typing (application/MidiService.h), e.g. for a
+// DAW's sustain or looper control. Takes precedence over a gesture binding for the same key.
+// Example: {'l', MIDI_OUTPUT_CC, 1, 64, 127, 0} - first pedal is sustain (CC 64) on channel 1;
+// {'r', MIDI_OUTPUT_NOTE, 10, 36, 100, 0} - second pedal plays a kick drum on channel 10.
+static const MidiBinding midiBindings[] = {
+  {0}  // End of table
+};
 
 // System state
 unsigned long bootTime = 0;
-int cachedSlotsUsed = 0;  // Cache slot calculation to avoid recalculating every loop
-unsigned long lastSlotCalculationTime = 0;
-#define SLOT_CALCULATION_CACHE_MS 100  // Recalculate slots max once per 100ms
 
 // Heartbeat state
-unsigned long lastHeartbeatTime = 0;
+bool firstKeystrokeReported = false;
 #define HEARTBEAT_INTERVAL_MS 60000  // 1 minute
 
-// Invalidate slot cache when transmitters change
-static void invalidateSlotCache() {
-  lastSlotCalculationTime = 0;  // Force immediate recalculation
+// Loop scheduling - the loop blocks on the control queue until the next deadline
+Scheduler scheduler;
+int heartbeatTimer = -1;
+int ledFrameTimer = -1;
+int pairingTimer = -1;
+int persistenceTimer = -1;
+int flightFlushTimer = -1;
+int flightDumpTimer = -1;
+int telemetryCountersTimer = -1;
+int telemetryDrainTimer = -1;
+
+// Republish key bindings before the next pedal event (no-op if nothing changed)
+static void refreshKeyBindings() {
+  keyBindings_refresh(&keyBindings, &transmitterManager);
 }
 
-// Forward declaration
-void onMessageReceived(const uint8_t* senderMAC, const uint8_t* data, int len, uint8_t channel);
+// Forward declarations
+void onMessageReceived(const IngressFrame* frame);
+static void onHeartbeatTimer(void* context, unsigned long now);
+static void onFlightDumpTimer(void* context, unsigned long now);
+static void onLedFrameTimer(void* context, unsigned long now);
+static void onTelemetryCountersTimer(void* context, unsigned long now);
 
 // Wrapper function for debug callback
 void pairingServiceDebugCallback(const char* format, ...) {
@@ -53,227 +95,279 @@ void pairingServiceDebugCallback(const char* format, ...) {
   debugMonitor_print(&debugMonitor, "%s", buffer);
 }
 
-void onMessageReceived(const uint8_t* senderMAC, const uint8_t* data, int len, uint8_t channel) {
-  if (len < 1) return;
-  
-  uint8_t msgType = data[0];
+// Message handlers - routed by msgType through the dispatch table registered in setup().
+// All run on the loop (housekeeping) task from frames forwarded by the HID output task,
+// never from the WiFi task, and each receives a frame whose length already matches its
+// message struct exactly.
+
+static void handleDebugMonitorRequest(const IngressFrame* frame) {
+  debugMonitor_handleDiscoveryRequest(&debugMonitor, frame->mac, frame->channel);
   
-  // Handle debug monitor discovery request
-  if (msgType == MSG_DEBUG_MONITOR_REQ) {
-    debugMonitor_handleDiscoveryRequest(&debugMonitor, senderMAC, channel);
-    
-    // Send immediate confirmation that pairing succeeded
-    debugMonitor_print(&debugMonitor, "Debug monitor discovery request received and processed");
+  // Send immediate confirmation that pairing succeeded
+  debugMonitor_print(&debugMonitor, "Debug monitor discovery request received and processed");
+}
+
+// Transmitter online broadcast (only when transmitter comes online, not as response to MSG_PAIRING_CONFIRMED)
+static void handleTransmitterOnline(const IngressFrame* frame) {
+  int index = transmitterManager_findIndex(&transmitterManager, frame->addr);
+  if (index >= 0) {
+    debugMonitor_print(&debugMonitor, "Received MSG_TRANSMITTER_ONLINE from known transmitter %d", index);
+  } else {
+    debugMonitor_print(&debugMonitor, "Received MSG_TRANSMITTER_ONLINE from unknown transmitter");
+  }
+  receiverPairingService_handleTransmitterOnline(&pairingService, frame->mac, frame->channel);
+}
+
+// Pairing confirmed message from transmitter (requesting reconnection after deep sleep)
+static void handlePairingConfirmed(const IngressFrame* frame) {
+  const uint8_t* senderMAC = frame->mac;
+  int transmitterIndex = transmitterManager_findIndex(&transmitterManager, frame->addr);
+  if (transmitterIndex < 0) {
+    debugMonitor_print(&debugMonitor, "Received MSG_PAIRING_CONFIRMED from unknown transmitter");
     return;
   }
   
-  // Handle transmitter online broadcast (only when transmitter comes online, not as response to MSG_PAIRING_CONFIRMED)
-  if (len >= sizeof(transmitter_online_message)) {
-    transmitter_online_message* onlineMsg = (transmitter_online_message*)data;
-    if (onlineMsg->msgType == MSG_TRANSMITTER_ONLINE) {
-      int index = transmitterManager_findIndex(&transmitterManager, senderMAC);
-      if (index >= 0) {
-        debugMonitor_print(&debugMonitor, "Received MSG_TRANSMITTER_ONLINE from known transmitter %d", index);
-      } else {
-        debugMonitor_print(&debugMonitor, "Received MSG_TRANSMITTER_ONLINE from unknown transmitter");
-      }
-      receiverPairingService_handleTransmitterOnline(&pairingService, senderMAC, channel);
-      return;
-    }
-  }
+  // Known transmitter requesting reconnection - check if we can accept it
+  int slotsNeeded = getSlotsNeeded(transmitterManager.transmitters[transmitterIndex].pedalMode);
+  bool isCurrentlyPaired = transmitterManager.transmitters[transmitterIndex].seenOnBoot;
   
-  // Handle pairing confirmed message from transmitter (requesting reconnection after deep sleep)
-  if (len >= sizeof(pairing_confirmed_message)) {
-    pairing_confirmed_message* confirm = (pairing_confirmed_message*)data;
-    if (confirm->msgType == MSG_PAIRING_CONFIRMED) {
-      int transmitterIndex = transmitterManager_findIndex(&transmitterManager, senderMAC);
-      if (transmitterIndex >= 0) {
-        // Known transmitter requesting reconnection - check if we can accept it
-        int slotsNeeded = getSlotsNeeded(transmitterManager.transmitters[transmitterIndex].pedalMode);
-        bool isCurrentlyPaired = transmitterManager.transmitters[transmitterIndex].seenOnBoot;
-        
-        bool shouldRespond = false;
-        if (isCurrentlyPaired) {
-          // Currently paired - always accept (reclaiming own slots)
-          shouldRespond = true;
-          debugMonitor_print(&debugMonitor, "Known transmitter %d (currently paired) requesting reconnection - sending MSG_PAIRING_CONFIRMED_ACK", transmitterIndex);
-        } else {
-          // Not currently paired - check if slots available
-          SlotAvailabilityResult result = slotManager_checkReconnection(&transmitterManager, transmitterIndex, slotsNeeded);
-          if (result.canFit) {
-            shouldRespond = true;
-            debugMonitor_print(&debugMonitor, "Known transmitter %d (not currently paired) requesting reconnection - slots available, sending MSG_PAIRING_CONFIRMED_ACK", transmitterIndex);
-          } else {
-            debugMonitor_print(&debugMonitor, "Known transmitter %d requesting reconnection - slots full (%d + %d > %d), not responding", 
-                             transmitterIndex, result.currentSlotsUsed, slotsNeeded, MAX_PEDAL_SLOTS);
-          }
-        }
-        
-        if (shouldRespond) {
-          // Send MSG_PAIRING_CONFIRMED_ACK to acknowledge the reconnection request and confirm pairing
-          receiverEspNowTransport_addPeer(&transport, senderMAC, channel);
-          pairing_confirmed_ack_message ackMsg;
-          ackMsg.msgType = MSG_PAIRING_CONFIRMED_ACK;
-          WiFi.macAddress(ackMsg.receiverMAC);
-          
-          bool sent = receiverEspNowTransport_send(&transport, senderMAC, (uint8_t*)&ackMsg, sizeof(ackMsg));
-          if (sent) {
-            // Mark as seen after successful send
-            transmitterManager.transmitters[transmitterIndex].seenOnBoot = true;
-            transmitterManager.transmitters[transmitterIndex].lastSeen = millis();
-            invalidateSlotCache();
-            debugMonitor_print(&debugMonitor, "Sent MSG_PAIRING_CONFIRMED_ACK to known transmitter %d (reconnection accepted)", transmitterIndex);
-          }
-        } else {
-          // Just update last seen time even if we can't accept
-          transmitterManager.transmitters[transmitterIndex].lastSeen = millis();
-        }
-      } else {
-        debugMonitor_print(&debugMonitor, "Received MSG_PAIRING_CONFIRMED from unknown transmitter");
-      }
-      return;  // Don't process further - this is handled
+  bool shouldRespond = false;
+  if (isCurrentlyPaired) {
+    // Currently paired - always accept (reclaiming own slots)
+    shouldRespond = true;
+    debugMonitor_print(&debugMonitor, "Known transmitter %d (currently paired) requesting reconnection - sending MSG_PAIRING_CONFIRMED_ACK", transmitterIndex);
+  } else {
+    // Not currently paired - check if slots available
+    SlotAvailabilityResult result = slotManager_checkReconnection(&transmitterManager, transmitterIndex, slotsNeeded);
+    if (result.canFit) {
+      shouldRespond = true;
+      debugMonitor_print(&debugMonitor, "Known transmitter %d (not currently paired) requesting reconnection - slots available, sending MSG_PAIRING_CONFIRMED_ACK", transmitterIndex);
+    } else {
+      debugMonitor_print(&debugMonitor, "Known transmitter %d requesting reconnection - slots full (%d + %d > %d), not responding", 
+                       transmitterIndex, result.currentSlotsUsed, slotsNeeded, MAX_PEDAL_SLOTS);
     }
   }
   
-  // Handle pairing confirmed acknowledgment from transmitter (acknowledgment that it received our MSG_PAIRING_CONFIRMED)
-  if (len >= sizeof(pairing_confirmed_ack_message)) {
-    pairing_confirmed_ack_message* ack = (pairing_confirmed_ack_message*)data;
-    if (ack->msgType == MSG_PAIRING_CONFIRMED_ACK) {
-      int transmitterIndex = transmitterManager_findIndex(&transmitterManager, senderMAC);
-      if (transmitterIndex >= 0) {
-        // Known transmitter acknowledging our MSG_PAIRING_CONFIRMED - mark as seen
-        if (!transmitterManager.transmitters[transmitterIndex].seenOnBoot) {
-          transmitterManager.transmitters[transmitterIndex].seenOnBoot = true;
-          transmitterManager.transmitters[transmitterIndex].lastSeen = millis();
-          debugMonitor_print(&debugMonitor, "Known transmitter %d acknowledged MSG_PAIRING_CONFIRMED - marking as paired", transmitterIndex);
-          invalidateSlotCache();  // Invalidate cache when transmitter becomes responsive
-        } else {
-          // Already marked as seen - just update last seen time
-          transmitterManager.transmitters[transmitterIndex].lastSeen = millis();
-        }
-      } else {
-        debugMonitor_print(&debugMonitor, "Received MSG_PAIRING_CONFIRMED_ACK from unknown transmitter");
-      }
-      return;  // Don't process further - this is handled
+  if (shouldRespond) {
+    // Send MSG_PAIRING_CONFIRMED_ACK to acknowledge the reconnection request and confirm pairing
+    receiverEspNowTransport_addPeer(&transport, senderMAC, frame->channel);
+    pairing_confirmed_ack_message ackMsg;
+    ackMsg.msgType = MSG_PAIRING_CONFIRMED_ACK;
+    WiFi.macAddress(ackMsg.receiverMAC);
+    
+    bool sent = receiverEspNowTransport_send(&transport, senderMAC, (uint8_t*)&ackMsg, sizeof(ackMsg));
+    if (sent) {
+      // Mark as seen after successful send (takes its slots back)
+      transmitterManager_setResponsive(&transmitterManager, transmitterIndex, true);
+      transmitterManager_renewLease(&transmitterManager, transmitterIndex, millis());
+      refreshKeyBindings();
+      debugMonitor_print(&debugMonitor, "Sent MSG_PAIRING_CONFIRMED_ACK to known transmitter %d (reconnection accepted)", transmitterIndex);
     }
+  } else {
+    // Just update last seen time even if we can't accept
+    transmitterManager_renewLease(&transmitterManager, transmitterIndex, millis());
+  }
+}
+
+// Pairing confirmed acknowledgment from transmitter (acknowledgment that it received our MSG_PAIRING_CONFIRMED)
+static void handlePairingConfirmedAck(const IngressFrame* frame) {
+  int transmitterIndex = transmitterManager_findIndex(&transmitterManager, frame->addr);
+  if (transmitterIndex < 0) {
+    debugMonitor_print(&debugMonitor, "Received MSG_PAIRING_CONFIRMED_ACK from unknown transmitter");
+    return;
   }
   
-  // Handle transmitter paired broadcast
-  if (len >= sizeof(transmitter_paired_message)) {
-    transmitter_paired_message* pairedMsg = (transmitter_paired_message*)data;
-    if (pairedMsg->msgType == MSG_TRANSMITTER_PAIRED) {
-      debugMonitor_print(&debugMonitor, "Received MSG_TRANSMITTER_PAIRED");
-      receiverPairingService_handleTransmitterPaired(&pairingService, pairedMsg);
-      return;
-    }
+  // Known transmitter acknowledging our MSG_PAIRING_CONFIRMED - mark as seen
+  if (!transmitterManager.transmitters[transmitterIndex].seenOnBoot &&
+      transmitterManager_setResponsive(&transmitterManager, transmitterIndex, true)) {
+    transmitterManager_renewLease(&transmitterManager, transmitterIndex, millis());
+    debugMonitor_print(&debugMonitor, "Known transmitter %d acknowledged MSG_PAIRING_CONFIRMED - marking as paired", transmitterIndex);
+    refreshKeyBindings();
+  } else {
+    // Already marked as seen - just update last seen time
+    transmitterManager_renewLease(&transmitterManager, transmitterIndex, millis());
+  }
+}
+
+static void handleTransmitterPaired(const IngressFrame* frame) {
+  debugMonitor_print(&debugMonitor, "Received MSG_TRANSMITTER_PAIRED");
+  receiverPairingService_handleTransmitterPaired(&pairingService, (const transmitter_paired_message*)frame->data);
+}
+
+static void handleDeleteRecord(const IngressFrame* frame) {
+  int index = transmitterManager_findIndex(&transmitterManager, frame->addr);
+  if (index >= 0) {
+    debugMonitor_print(&debugMonitor, "Received delete record request from transmitter %d - removing", index);
+    transmitterManager_remove(&transmitterManager, index);
+    refreshKeyBindings();
   }
+}
+
+static void handleDiscoveryRequest(const IngressFrame* frame) {
+  const uint8_t* senderMAC = frame->mac;
+  const struct_message* msg = (const struct_message*)frame->data;
+  debugMonitor_print(&debugMonitor, "Discovery request from %02X:%02X:%02X:%02X:%02X:%02X (mode=%d)",
+                     senderMAC[0], senderMAC[1], senderMAC[2], senderMAC[3], senderMAC[4], senderMAC[5], msg->pedalMode);
+  receiverPairingService_handleDiscoveryRequest(&pairingService, senderMAC, msg->pedalMode, frame->channel, millis());
+  refreshKeyBindings();
+}
+
+// The key itself was already pressed/released (or buffered for playout) on the HID output
+// task; this only does the bookkeeping and logging that must not delay the HID report.
+// Timed pedal events come here too - they start with the struct_message fields.
+static void handlePedalEvent(const IngressFrame* frame) {
+  const uint8_t* senderMAC = frame->mac;
+  const struct_message* msg = (const struct_message*)frame->data;
+  KeyBindingAction action;
   
-  // Handle standard messages
-  if (len < sizeof(struct_message)) return;
-  
-  struct_message* msg = (struct_message*)data;
-  
-  switch (msg->msgType) {
-    case MSG_DELETE_RECORD: {
-      int index = transmitterManager_findIndex(&transmitterManager, senderMAC);
-      if (index >= 0) {
-        debugMonitor_print(&debugMonitor, "Received delete record request from transmitter %d - removing", index);
-        transmitterManager_remove(&transmitterManager, index);
-        persistence_save(&transmitterManager);
-        invalidateSlotCache();  // Invalidate cache when transmitter removed
-      }
-      break;
-    }
+  // If transmitter is unknown and we're in grace period, request discovery
+  if (!keyBindings_lookup(&keyBindings, frame->addr, msg->key, &action)) {
+    unsigned long currentTime = millis();
+    unsigned long timeSinceBoot = currentTime - bootTime;
+    bool inGracePeriod = (timeSinceBoot < TRANSMITTER_TIMEOUT);
     
-    case MSG_DISCOVERY_REQ: {
-      debugMonitor_print(&debugMonitor, "Discovery request from %02X:%02X:%02X:%02X:%02X:%02X (mode=%d)",
-                         senderMAC[0], senderMAC[1], senderMAC[2], senderMAC[3], senderMAC[4], senderMAC[5], msg->pedalMode);
-      receiverPairingService_handleDiscoveryRequest(&pairingService, senderMAC, msg->pedalMode, channel, millis());
-      persistence_save(&transmitterManager);
-      invalidateSlotCache();  // Invalidate cache when transmitter added/modified
-      break;
+    if (inGracePeriod && !receiverPairingService_isGracePeriodSkipped(&pairingService)) {
+      // Unknown transmitter sending pedal events during grace period - request discovery
+      receiverEspNowTransport_addPeer(&transport, senderMAC, frame->channel);
+      struct_message alive = {MSG_ALIVE, 0, false, 0};
+      receiverEspNowTransport_send(&transport, senderMAC, (uint8_t*)&alive, sizeof(alive));
+      
+      debugMonitor_print(&debugMonitor, "Unknown transmitter sent pedal event during grace period - requesting discovery");
     }
+  } else {
+    int transmitterIndex = action.transmitterIndex;
     
-    case MSG_PEDAL_EVENT: {
-      int transmitterIndex = transmitterManager_findIndex(&transmitterManager, senderMAC);
-      
-      // If transmitter is unknown and we're in grace period, request discovery
-      if (transmitterIndex < 0) {
-        unsigned long currentTime = millis();
-        unsigned long timeSinceBoot = currentTime - bootTime;
-        bool inGracePeriod = (timeSinceBoot < TRANSMITTER_TIMEOUT);
-        
-        if (inGracePeriod && !pairingService.gracePeriodSkipped) {
-          // Unknown transmitter sending pedal events during grace period - request discovery
-          receiverEspNowTransport_addPeer(&transport, senderMAC, channel);
-          struct_message alive = {MSG_ALIVE, 0, false, 0};
-          receiverEspNowTransport_send(&transport, senderMAC, (uint8_t*)&alive, sizeof(alive));
-          
-          debugMonitor_print(&debugMonitor, "Unknown transmitter sent pedal event during grace period - requesting discovery");
-        }
-      } else {
-        // Known transmitter - mark as seen (it's responding after receiving MSG_PAIRING_CONFIRMED)
-        if (!transmitterManager.transmitters[transmitterIndex].seenOnBoot) {
-          transmitterManager.transmitters[transmitterIndex].seenOnBoot = true;
-          transmitterManager.transmitters[transmitterIndex].lastSeen = millis();
-          debugMonitor_print(&debugMonitor, "Known transmitter %d responded with pedal event - marking as paired", transmitterIndex);
-        }
-        
-        // Handle pedal event normally
-        char keyToPress;
-        if (transmitterManager.transmitters[transmitterIndex].pedalMode == 0) {
-          keyToPress = (msg->key == '1') ? 'l' : 'r';
-        } else {
-          keyToPress = transmitterManager_getAssignedKey(&transmitterManager, transmitterIndex);
-        }
-        // Use standardized pedal event format: T%d: '%c' ▼/▲
-        debugMonitor_print(&debugMonitor, "T%d: '%c' %s", 
-                          transmitterIndex, keyToPress, msg->pressed ? "▼" : "▲");
-      }
-      
-      keyboardService_handlePedalEvent(&keyboardService, senderMAC, msg);
-      break;
+    // Known transmitter - mark as seen (it's responding after receiving MSG_PAIRING_CONFIRMED)
+    if (!transmitterManager.transmitters[transmitterIndex].seenOnBoot &&
+        transmitterManager_setResponsive(&transmitterManager, transmitterIndex, true)) {
+      transmitterManager_renewLease(&transmitterManager, transmitterIndex, millis());
+      debugMonitor_print(&debugMonitor, "Known transmitter %d responded with pedal event - marking as paired", transmitterIndex);
     }
     
-    case MSG_ALIVE: {
-      receiverPairingService_handleAlive(&pairingService, senderMAC);
-      break;
+    // Use standardized pedal event format: T%d: '%c' ▼/▲
+    if (action.key != 0) {
+      debugMonitor_print(&debugMonitor, "T%d: '%c' %s", 
+                        transmitterIndex, action.key, msg->pressed ? "▼" : "▲");
     }
   }
 }
 
+static void handleAlive(const IngressFrame* frame) {
+  receiverPairingService_handleAlive(&pairingService, frame->mac);
+}
+
+// Debug monitor asks for the flight recorder log - sent a line per FLIGHT_RECORDER_DUMP_INTERVAL_MS
+// so the monitor's receive queue keeps up
+static void handleFlightLogRequest(const IngressFrame* frame) {
+  if (!flightRecorder.mounted) {
+    debugMonitor_print(&debugMonitor, "Flight recorder not available (no flightrec partition)");
+    return;
+  }
+  flightRecorder_beginDump(&flightRecorder);
+  scheduler_armPeriodic(&scheduler, flightDumpTimer, millis(), FLIGHT_RECORDER_DUMP_INTERVAL_MS);
+}
+
+static void onFlightDumpTimer(void* context, unsigned long now) {
+  char line[160];
+  if (flightRecorder_dumpNext(&flightRecorder, line, sizeof(line))) {
+    debugMonitor_print(&debugMonitor, "%s", line);
+  } else {
+    scheduler_cancel(&scheduler, flightDumpTimer);
+  }
+}
+
+static void registerMessageRoutes() {
+  messageDispatcher_init(&messageDispatcher);
+  messageDispatcher_register(&messageDispatcher, MSG_PEDAL_EVENT, sizeof(struct_message), handlePedalEvent);
+  messageDispatcher_register(&messageDispatcher, MSG_PEDAL_EVENT_TIMED, sizeof(timed_pedal_message), handlePedalEvent);
+  messageDispatcher_register(&messageDispatcher, MSG_DISCOVERY_REQ, sizeof(struct_message), handleDiscoveryRequest);
+  messageDispatcher_register(&messageDispatcher, MSG_ALIVE, sizeof(struct_message), handleAlive);
+  // Keepalives only renew leases: the held-key lease on the HID output task, the liveness
+  // lease in onMessageReceived()
+  messageDispatcher_register(&messageDispatcher, MSG_KEEPALIVE, sizeof(keepalive_message), nullptr);
+  // Expression frames drive the joystick axes on the HID output task, which forwards one per
+  // EXPRESSION_LEASE_FORWARD_MS for the liveness lease
+  messageDispatcher_register(&messageDispatcher, MSG_EXPRESSION_VALUE, sizeof(expression_value_message), nullptr);
+  messageDispatcher_register(&messageDispatcher, MSG_EXPRESSION_DELTA, sizeof(expression_delta_message), nullptr);
+  messageDispatcher_register(&messageDispatcher, MSG_DELETE_RECORD, sizeof(struct_message), handleDeleteRecord);
+  messageDispatcher_register(&messageDispatcher, MSG_TRANSMITTER_ONLINE, sizeof(transmitter_online_message), handleTransmitterOnline);
+  messageDispatcher_register(&messageDispatcher, MSG_TRANSMITTER_PAIRED, sizeof(transmitter_paired_message), handleTransmitterPaired);
+  messageDispatcher_register(&messageDispatcher, MSG_PAIRING_CONFIRMED, sizeof(pairing_confirmed_message), handlePairingConfirmed);
+  messageDispatcher_register(&messageDispatcher, MSG_PAIRING_CONFIRMED_ACK, sizeof(pairing_confirmed_ack_message), handlePairingConfirmedAck);
+  messageDispatcher_register(&messageDispatcher, MSG_DEBUG_MONITOR_REQ, sizeof(debug_monitor_req_message), handleDebugMonitorRequest);
+  messageDispatcher_register(&messageDispatcher, MSG_FLIGHT_LOG_REQ, sizeof(flight_log_req_message), handleFlightLogRequest);
+}
+
+void onMessageReceived(const IngressFrame* frame) {
+  // Any frame from a known transmitter renews its liveness lease (and confirms it if it
+  // was restored warm)
+  int index = transmitterManager_findIndex(&transmitterManager, frame->addr);
+  if (index >= 0) {
+    transmitterManager_renewLease(&transmitterManager, index, millis());
+    receiverPairingService_noteFrame(&pairingService, index);
+    persistence_noteChannel(&persistence, frame->channel, millis());
+  }
+  messageDispatcher_dispatch(&messageDispatcher, frame);
+}
+
 void setup() {
   bootTime = millis();
   
+  // Flight recorder before anything that logs to it (keyboard, pairing, transport)
+  FlightRecorderFlash flightFlash;
+  if (flightRecorder_partitionFlash(&flightFlash) && flightRecorder_mount(&flightRecorder, &flightFlash)) {
+    g_flightRecorder = &flightRecorder;
+  }
+  
+  // Start USB first so host enumeration overlaps radio bring-up and pairing restore.
+  // Pedal events that beat the mount are queued and replayed by the keyboard service.
+  // The telemetry CDC and joystick interfaces must exist before the keyboard service starts USB
+  // (it adds the MIDI interface itself).
+  telemetry_init(&telemetry);
+  g_telemetry = &telemetry;
+  keyBindings_init(&keyBindings);
+  expressionAxes_init(&expressionAxes, &keyBindings);
+  hidGamepad_begin();
+  keyboardService_init(&keyboardService, &keyBindings);
+  keyboardService_setGestures(&keyboardService, gestureBindings);
+  keyboardService_setMidi(&keyboardService, midiBindings);
+  telemetry_begin(&telemetry);
+  
   // Initialize domain layer
   transmitterManager_init(&transmitterManager);
   
   // Initialize infrastructure layer first (needed for debug monitor)
   receiverEspNowTransport_init(&transport);
-  debugMonitor_init(&debugMonitor, &transport, bootTime);
+  
+  // Load persisted state (transmitters, last session and debug monitor pairing). The last
+  // session's transmitters are live - with the same keys - before the HID task starts.
+  persistence_init(&persistence, persistence_nvsStore());
+  int warmRestored = persistence_load(&persistence, &transmitterManager);
+  keyBindings_refresh(&keyBindings, &transmitterManager);
+  bool channelRestored = receiverEspNowTransport_setChannel(&transport, persistence_channel(&persistence));
+  
+  debugMonitor_init(&debugMonitor, &transport, &persistence, bootTime);
   debugMonitor_load(&debugMonitor);
   debugMonitor.espNowInitialized = true;
   
-  // Load persisted state
-  persistence_load(&transmitterManager);
-  
   ledService_init(&ledService, bootTime);
   
   // Initialize application layer
   receiverPairingService_init(&pairingService, &transmitterManager, &transport, bootTime);
   receiverPairingService_setDebugCallback(&pairingService, pairingServiceDebugCallback);
-  keyboardService_init(&keyboardService, &transmitterManager);
   
-  // Register message callback (must be before adding peers)
-  receiverEspNowTransport_registerReceiveCallback(&transport, onMessageReceived);
+  // Register message routes and start the HID output task, which owns the receive
+  // callback (must be before adding peers)
+  registerMessageRoutes();
+  hidOutputTask_start(&hidOutputTask, &transport, &keyboardService, &expressionAxes);
   
   // Add broadcast peer
   uint8_t broadcastMAC[] = BROADCAST_MAC;
   receiverEspNowTransport_addPeer(&transport, broadcastMAC, 0);
   
   // Add saved transmitters as peers
-  for (int i = 0; i < transmitterManager.count; i++) {
-    receiverEspNowTransport_addPeer(&transport, transmitterManager.transmitters[i].mac, 0);
+  for (uint32_t bits = transmitterManager.occupied; bits; bits &= bits - 1) {
+    receiverEspNowTransport_addPeer(&transport, transmitterManager.transmitters[__builtin_ctz(bits)].mac, 0);
   }
   
   // Add saved debug monitor as peer (if it was saved)
@@ -284,81 +378,225 @@ void setup() {
     
     // Send debug messages now that ESP-NOW is fully initialized
     debugMonitor_print(&debugMonitor, "ESP-NOW initialized");
-    debugMonitor_print(&debugMonitor, "Loaded %d transmitter(s) from EEPROM", transmitterManager.count);
+    debugMonitor_print(&debugMonitor, "Loaded %d transmitter(s) from EEPROM", transmitterManager_pairedCount(&transmitterManager));
     // Show slots used based on responsive transmitters only (not stored slotsUsed)
     int responsiveSlots = transmitterManager_calculateSlotsUsed(&transmitterManager);
     debugMonitor_print(&debugMonitor, "Pedal slots used: %d/%d (responsive transmitters only)", responsiveSlots, MAX_PEDAL_SLOTS);
+    debugMonitor_print(&debugMonitor, "Warm session: %d transmitter(s) live from boot, channel %d%s", warmRestored,
+                      persistence_channel(&persistence), channelRestored ? "" : " (not restored)");
   }
   
+  // Loop timers: the heartbeat, LED frames and flight log dump do their own work, the others
+  // only end the loop's wait
+  scheduler_init(&scheduler);
+  g_scheduler = &scheduler;
+  heartbeatTimer = scheduler_addTimer(&scheduler, onHeartbeatTimer, NULL);
+  ledFrameTimer = scheduler_addTimer(&scheduler, onLedFrameTimer, NULL);
+  pairingTimer = scheduler_addTimer(&scheduler, NULL, NULL);
+  persistenceTimer = scheduler_addTimer(&scheduler, NULL, NULL);
+  flightFlushTimer = scheduler_addTimer(&scheduler, NULL, NULL);
+  flightDumpTimer = scheduler_addTimer(&scheduler, onFlightDumpTimer, NULL);
+  telemetryCountersTimer = scheduler_addTimer(&scheduler, onTelemetryCountersTimer, NULL);
+  telemetryDrainTimer = scheduler_addTimer(&scheduler, NULL, NULL);
+  scheduler_armPeriodic(&scheduler, heartbeatTimer, millis() + HEARTBEAT_INTERVAL_MS, HEARTBEAT_INTERVAL_MS);
+  scheduler_armPeriodic(&scheduler, telemetryCountersTimer, millis() + TELEMETRY_COUNTERS_INTERVAL_MS,
+                        TELEMETRY_COUNTERS_INTERVAL_MS);
+  
   // Ping known transmitters immediately on boot (before pairing/grace period)
   // This restores previous pairings if transmitters are still online
   receiverPairingService_pingKnownTransmittersOnBoot(&pairingService);
   
+  if (flightRecorder.mounted) {
+    debugMonitor_print(&debugMonitor, "Flight recorder: %d sector(s), head %d (sequence %lu, %d record(s))",
+                      flightRecorder.sectorCount, flightRecorder.headSector,
+                      (unsigned long)flightRecorder.headSequence, flightRecorder.writeRecord - 1);
+  }
   debugMonitor_print(&debugMonitor, "=== Receiver Ready ===");
 }
 
+static void onLedFrameTimer(void* context, unsigned long now) {
+  ledService_renderFrame(&ledService, now);
+}
+
+// Counter snapshot for a USB telemetry host; also notices a host connecting while the loop idles
+static void onTelemetryCountersTimer(void* context, unsigned long now) {
+  telemetry_update(&telemetry, now);
+  if (!telemetry_isConnected(&telemetry)) return;
+  
+  uint32_t counters[TELEMETRY_COUNTER_COUNT];
+  counters[TELEMETRY_COUNTER_INGRESS_FRAMES] = transport.ingress.enqueued;
+  counters[TELEMETRY_COUNTER_INGRESS_DROPPED] = transport.ingress.dropped;
+  counters[TELEMETRY_COUNTER_DISPATCHED] = messageDispatcher.dispatched;
+  counters[TELEMETRY_COUNTER_HID_REPORTS] = keyboardService.report.reportsBuilt;
+  counters[TELEMETRY_COUNTER_KEY_CHANGES_COALESCED] = keyboardService.report.changesCoalesced;
+  counters[TELEMETRY_COUNTER_LEASE_EXPIRIES] = keyboardService.leaseExpiries;
+  counters[TELEMETRY_COUNTER_CONTROL_DROPPED] = hidOutputTask.controlDropped;
+  counters[TELEMETRY_COUNTER_LOOP_WAKEUPS] = scheduler.wakeups;
+  counters[TELEMETRY_COUNTER_FLIGHT_EVENTS] = flightRecorder.logged;
+  counters[TELEMETRY_COUNTER_PERSISTENCE_COMMITS] = persistence.commits;
+  counters[TELEMETRY_COUNTER_TELEMETRY_DROPPED] = telemetry.dropped;
+  counters[TELEMETRY_COUNTER_PLAYOUT_DEFERRED] = keyboardService.playout.deferred;
+  counters[TELEMETRY_COUNTER_PLAYOUT_LATE] = keyboardService.playout.late;
+  telemetry_counters(&telemetry, counters);
+}
+
+// Periodic heartbeat every minute with paired pedal count and counters
+static void onHeartbeatTimer(void* context, unsigned long now) {
+  // Count all stored transmitters, not just responsive ones, because a transmitter can be
+  // paired but not yet responded after coming back online
+  int pairedCount = transmitterManager_pairedCount(&transmitterManager);
+  int slotsUsed = transmitterManager_calculateSlotsUsed(&transmitterManager);
+  
+  debugMonitor_print(&debugMonitor, "Heartbeat: %d pedal(s) paired (%d/%d slots used)", 
+                    pairedCount, slotsUsed, MAX_PEDAL_SLOTS);
+  debugMonitor_print(&debugMonitor, "Ingress: %lu frame(s), %lu dropped, %lu oversized, high-water %lu/%d",
+                    (unsigned long)transport.ingress.enqueued, (unsigned long)transport.ingress.dropped,
+                    (unsigned long)transport.ingress.oversized, (unsigned long)transport.ingress.highWater,
+                    INGRESS_QUEUE_CAPACITY);
+  debugMonitor_print(&debugMonitor, "Dispatch: %lu handled, %lu unknown type, %lu bad length",
+                    (unsigned long)messageDispatcher.dispatched, (unsigned long)messageDispatcher.unknownType,
+                    (unsigned long)messageDispatcher.badLength);
+  debugMonitor_print(&debugMonitor, "Peers: %d/%d registered, %lu send(s) to a known peer, %lu registration(s), %lu eviction(s)",
+                    transport.peers.cache.count, PEER_CACHE_CAPACITY, (unsigned long)transport.peers.cache.hits,
+                    (unsigned long)transport.peers.cache.misses, (unsigned long)transport.peers.cache.evictions);
+  char latency[160];
+  latencyHistogram_format(&hidOutputTask.latency, latency, sizeof(latency));
+  debugMonitor_print(&debugMonitor, "HID latency: %s (control dropped %lu)",
+                    latency, (unsigned long)hidOutputTask.controlDropped);
+  debugMonitor_print(&debugMonitor, "HID reports: %lu sent, %lu key change(s) coalesced, %lu split by a reversed key, %lu held-key lease expiry(ies)",
+                    (unsigned long)keyboardService.report.reportsBuilt,
+                    (unsigned long)keyboardService.report.changesCoalesced,
+                    (unsigned long)keyboardService.report.conflictFlushes,
+                    (unsigned long)keyboardService.leaseExpiries);
+  debugMonitor_print(&debugMonitor, "Gestures: %d binding(s), %lu tap(s), %lu double-tap(s), %lu hold(s), %lu compensated",
+                    keyboardService.gestures.count, (unsigned long)keyboardService.gestures.taps,
+                    (unsigned long)keyboardService.gestures.doubleTaps, (unsigned long)keyboardService.gestures.holds,
+                    (unsigned long)keyboardService.gestures.compensations);
+  char midi[160];
+  midiService_format(&keyboardService.midi, midi, sizeof(midi));
+  debugMonitor_print(&debugMonitor, "MIDI: %s", midi);
+  char playout[160];
+  playoutBuffer_format(&keyboardService.playout, playout, sizeof(playout));
+  debugMonitor_print(&debugMonitor, "Playout: %s", playout);
+  latencyHistogram_format(&keyboardService.playout.rawJitter, latency, sizeof(latency));
+  debugMonitor_print(&debugMonitor, "Hold jitter as received: %s", latency);
+  latencyHistogram_format(&keyboardService.playout.playedJitter, latency, sizeof(latency));
+  debugMonitor_print(&debugMonitor, "Hold jitter as played: %s", latency);
+  char expression[160];
+  expressionAxes_format(&expressionAxes, expression, sizeof(expression));
+  debugMonitor_print(&debugMonitor, "Expression: %s", expression);
+  debugMonitor_print(&debugMonitor, "LED: %lu frame(s) sent, %lu unchanged, %lu busy",
+                    (unsigned long)ledService.framesSent, (unsigned long)ledService.framesUnchanged,
+                    (unsigned long)ledService.framesBusy);
+  char pairing[160];
+  pairingStateMachine_format(&pairingService.fsm, now, pairing, sizeof(pairing));
+  debugMonitor_print(&debugMonitor, "Pairing: %s", pairing);
+  debugMonitor_print(&debugMonitor, "Flight recorder: %lu event(s), %lu dropped, %lu page write(s), %lu sector erase(s), %lu flash error(s)",
+                    (unsigned long)flightRecorder.logged, (unsigned long)flightRecorder.dropped,
+                    (unsigned long)flightRecorder.pagesWritten, (unsigned long)flightRecorder.sectorsErased,
+                    (unsigned long)flightRecorder.flashErrors);
+  debugMonitor_print(&debugMonitor, "Telemetry: %s, %lu frame(s), %lu byte(s) sent, %lu dropped",
+                    telemetry.connected ? "host connected" : "no host", (unsigned long)telemetry.frames,
+                    (unsigned long)telemetry.bytesSent, (unsigned long)telemetry.dropped);
+  debugMonitor_print(&debugMonitor, "Persistence: %lu commit(s), %lu change(s) coalesced, %lu failure(s), load %lu us, last commit %lu us",
+                    (unsigned long)persistence.commits, (unsigned long)persistence.coalesced,
+                    (unsigned long)persistence.commitFailures, (unsigned long)persistence.lastLoadUs,
+                    (unsigned long)persistence.lastCommitUs);
+  uint32_t wakeups = scheduler_wakeupsPerSecondX10(&scheduler);
+  debugMonitor_print(&debugMonitor, "Loop: %lu.%lu wakeups/s (%lu timer, %lu event)",
+                    (unsigned long)(wakeups / 10), (unsigned long)(wakeups % 10),
+                    (unsigned long)scheduler.timerWakeups, (unsigned long)scheduler.eventWakeups);
+}
+
 void loop() {
+  // Handle frames forwarded by the HID output task since the last pass
+  IngressFrame frame;
+  while (hidOutputTask_receiveControlFrame(&hidOutputTask, &frame, 0)) {
+    onMessageReceived(&frame);
+  }
+  
   unsigned long currentTime = millis();
   
   // Update pairing service (handles beacons, pings, replacement logic)
   receiverPairingService_update(&pairingService, currentTime);
   
-  // Cache slot calculation - only recalculate periodically or when needed
-  // This avoids expensive iteration every loop iteration
-  if (currentTime - lastSlotCalculationTime >= SLOT_CALCULATION_CACHE_MS) {
-    cachedSlotsUsed = transmitterManager_calculateSlotsUsed(&transmitterManager);
-    lastSlotCalculationTime = currentTime;
-  }
+  // Catches slot changes made inside the pairing service
+  refreshKeyBindings();
+  int slotsUsed = transmitterManager_calculateSlotsUsed(&transmitterManager);
+  
+  // Pairing changes are written once they settle, never from a message handler
+  persistence_update(&persistence, &transmitterManager, currentTime);
+  flightRecorder_update(&flightRecorder, currentTime);
+  telemetry_update(&telemetry, currentTime);
   
   // Update LED status - green during initial wait (1s after ping sent), blue during grace period, off otherwise
-  bool inInitialWait = false;
-  if (pairingService.initialPingSent && pairingService.initialPingTime > 0) {
-    unsigned long timeSincePing = currentTime - pairingService.initialPingTime;
-    inInitialWait = (timeSincePing < INITIAL_PING_WAIT_MS);
+  bool inInitialWait = receiverPairingService_isInitialWait(&pairingService);
+  bool ledAnimating = ledService_update(&ledService, currentTime, receiverPairingService_isGracePeriodDone(&pairingService), slotsUsed, inInitialWait);
+  
+  // Report boot-to-first-keystroke once, after the first HID report went out
+  if (!firstKeystrokeReported && keyboardService.firstKeystrokeUs != 0) {
+    firstKeystrokeReported = true;
+    debugMonitor_print(&debugMonitor, "Time to first keystroke: %lu ms (USB mounted at %lu ms, %lu early event(s) replayed, %lu dropped, %d warm transmitter(s), %d released)",
+                      (unsigned long)(keyboardService.firstKeystrokeUs / 1000),
+                      (unsigned long)(keyboardService.usbMountedUs / 1000),
+                      (unsigned long)keyboardService.preReadyReplayed,
+                      (unsigned long)keyboardService.preReadyDropped,
+                      pairingService.warmRestored, pairingService.warmReleased);
   }
-  ledService_update(&ledService, currentTime, pairingService.gracePeriodCheckDone, cachedSlotsUsed, inInitialWait);
   
-  // Send periodic heartbeat every minute with paired pedal count
-  if (currentTime - lastHeartbeatTime >= HEARTBEAT_INTERVAL_MS) {
-    lastHeartbeatTime = currentTime;
-    
-    // Count paired transmitters (those with MAC addresses in slots)
-    // Note: We count all transmitters with MAC addresses, not just those with seenOnBoot=true,
-    // because a transmitter can be paired but not yet responded after coming back online
-    int pairedCount = 0;
-    for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
-      bool slotOccupied = false;
-      for (int j = 0; j < 6; j++) {
-        if (transmitterManager.transmitters[i].mac[j] != 0) {
-          slotOccupied = true;
-          break;
-        }
-      }
-      if (slotOccupied) {
-        pairedCount++;
-      }
-    }
-    
-    debugMonitor_print(&debugMonitor, "Heartbeat: %d pedal(s) paired (%d/%d slots used)", 
-                      pairedCount, cachedSlotsUsed, MAX_PEDAL_SLOTS);
+  // Heartbeat and any other due loop timers
+  scheduler_run(&scheduler, currentTime);
+  
+  // LED frames at a fixed rate, only while an animation runs
+  if (!ledAnimating) {
+    scheduler_cancel(&scheduler, ledFrameTimer);
+  } else if (!scheduler_isArmed(&scheduler, ledFrameTimer)) {
+    scheduler_armPeriodic(&scheduler, ledFrameTimer, currentTime + LED_FRAME_INTERVAL_MS, LED_FRAME_INTERVAL_MS);
   }
+  scheduler_armIn(&scheduler, pairingTimer, currentTime, receiverPairingService_timeUntilNextMs(&pairingService, currentTime));
+  scheduler_armIn(&scheduler, persistenceTimer, currentTime, persistence_timeUntilCommitMs(&persistence, currentTime));
+  scheduler_armIn(&scheduler, flightFlushTimer, currentTime, flightRecorder_timeUntilFlushMs(&flightRecorder, currentTime));
+  scheduler_armIn(&scheduler, telemetryDrainTimer, currentTime, telemetry_timeUntilDrainMs(&telemetry, currentTime));
   
-  // Adaptive delay: shorter during grace period (needs responsiveness), longer when idle
-  if (pairingService.gracePeriodCheckDone) {
-    // After grace period - use longer delay (50ms = 20Hz) since we're mostly idle
-    delay(50);
-  } else {
-    // During grace period - use shorter delay (10ms = 100Hz) for responsiveness
-    delay(10);
+  // Block until the next deadline. Pedal events never wait on this task; a forwarded
+  // frame ends the wait early.
+  unsigned long waitMs = scheduler_timeUntilNextMs(&scheduler, millis(), LOOP_MAX_SLEEP_MS);
+  bool received = hidOutputTask_receiveControlFrame(&hidOutputTask, &frame, waitMs);
+  scheduler_countWakeup(&scheduler, millis(), received);
+  if (received) {
+    onMessageReceived(&frame);
   }
 }
 
 // Include implementation files (Arduino IDE doesn't auto-compile .cpp files in subdirectories)
 #include "domain/TransmitterManager.cpp"
+#include "domain/MacIndex.cpp"
+#include "domain/SlotAllocator.cpp"
+#include "domain/KeyBindings.cpp"
+#include "domain/PairingStateMachine.cpp"
+#include "infrastructure/IngressQueue.cpp"
+#include "shared/domain/PeerCache.cpp"
+#include "shared/infrastructure/EspNowPeers.cpp"
 #include "infrastructure/EspNowTransport.cpp"
+#include "infrastructure/MessageDispatcher.cpp"
+#include "infrastructure/LatencyHistogram.cpp"
 #include "infrastructure/Persistence.cpp"
+#include "infrastructure/FlightRecorder.cpp"
+#include "infrastructure/Telemetry.cpp"
 #include "infrastructure/LEDService.cpp"
 #include "shared/debug_format.cpp"
 #include "infrastructure/DebugMonitor.cpp"
 #include "application/PairingService.cpp"
+#include "infrastructure/HidReportBuilder.cpp"
+#include "infrastructure/HidNkroKeyboard.cpp"
+#include "application/KeySequencer.cpp"
+#include "application/GestureRecognizer.cpp"
+#include "application/MidiService.cpp"
+#include "infrastructure/UsbMidi.cpp"
+#include "application/PlayoutBuffer.cpp"
 #include "application/KeyboardService.cpp"
+#include "infrastructure/HidGamepad.cpp"
+#include "shared/domain/ExpressionCodec.cpp"
+#include "application/ExpressionAxes.cpp"
+#include "application/HidOutputTask.cpp"
+#include "shared/infrastructure/Scheduler.cpp"
@@ -0,0 +1,36 @@
+#include "ExpressionService.h"
+#include "../config.h"
+#include <Arduino.h>
+
+void expressionService_init(ExpressionService* service, int pin, uint8_t input, PairingState* pairingState,
+                            EspNowTransport* transport, unsigned long* lastActivityTime) {
+  service->pairingState = pairingState;
+  service->transport = transport;
+  service->lastActivityTime = lastActivityTime;
+  service->pin = pin;
+  service->sendFailures = 0;
+  expressionEncoder_init(&service->encoder, input, EXPRESSION_RESOLUTION_BITS, EXPRESSION_DEADBAND);
+  analogReadResolution(EXPRESSION_ADC_BITS);
+}
+
+void expressionService_sample(ExpressionService* service, unsigned long now) {
+  // Nothing to send to; the first sample after pairing goes out as an absolute value
+  if (!pairingState_isPaired(service->pairingState)) {
+    expressionEncoder_requestKeyframe(&service->encoder);
+    return;
+  }
+  
+  uint8_t frame[EXPRESSION_MAX_FRAME_LEN];
+  int len = expressionEncoder_sample(&service->encoder, (uint16_t)analogRead(service->pin), (uint32_t)now, frame);
+  if (len == 0) {
+    return;
+  }
+  
+  if (!espNowTransport_send(service->transport, service->pairingState->pairedReceiverMAC, frame, len)) {
+    service->sendFailures++;
+  }
+  // Only movement keeps the transmitter awake, not the settle and refresh frames at rest
+  if (service->lastActivityTime && service->encoder.lastMoveMs == (uint32_t)now) {
+    *service->lastActivityTime = now;
+  }
+}
@@ -0,0 +1,31 @@
+#ifndef EXPRESSION_SERVICE_H
+#define EXPRESSION_SERVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../domain/ExpressionCodec.h"
+#include "../domain/PairingState.h"
+#include "../infrastructure/EspNowTransport.h"
+#include "../config.h"
+
+// Continuous (expression) pedal on an ADC pin. The sketch calls expressionService_sample()
+// from a periodic scheduler timer at EXPRESSION_SAMPLE_HZ; frames go to the paired receiver
+// only when the position moves (see ExpressionCodec.h). Movement counts as activity.
+// Sampling period for scheduler_armPeriodic()
+#define EXPRESSION_SAMPLE_INTERVAL_MS (1000 / EXPRESSION_SAMPLE_HZ)
+
+typedef struct {
+  PairingState* pairingState;
+  EspNowTransport* transport;
+  unsigned long* lastActivityTime;
+  int pin;
+  ExpressionEncoder encoder;
+  uint32_t sendFailures;
+} ExpressionService;
+
+void expressionService_init(ExpressionService* service, int pin, uint8_t input, PairingState* pairingState,
+                            EspNowTransport* transport, unsigned long* lastActivityTime);
+
+void expressionService_sample(ExpressionService* service, unsigned long now);
+
+#endif // EXPRESSION_SERVICE_H
@@ -3,7 +3,9 @@
 #include <esp_now.h>
 #include <string.h>
 #include <Arduino.h>
+#include <limits.h>
 #include "../messages.h"
+#include "../config.h"
 #include "../domain/MacUtils.h"
 #include "../domain/PedalSlots.h"
 #include "../infrastructure/TransmitterUtils.h"
@@ -221,7 +223,7 @@ bool pairingService_checkDiscoveryTimeout(PairingService* service, unsigned long
     return false;  // Not waiting
   }
   
-  if (currentTime - service->pairingState->discoveryRequestTime > 5000) {  // 5 second timeout
+  if (currentTime - service->pairingState->discoveryRequestTime > DISCOVERY_RESPONSE_TIMEOUT_MS) {
     service->pairingState->waitingForDiscoveryResponse = false;
     service->pairingState->discoveryRequestTime = 0;
     return true;  // Timeout occurred
@@ -230,6 +232,42 @@ bool pairingService_checkDiscoveryTimeout(PairingService* service, unsigned long
   return false;  // Still waiting
 }
 
+bool pairingService_checkPairingConfirmedTimeout(PairingService* service, unsigned long currentTime) {
+  if (!service->waitingForPairingConfirmedAck || service->pairingConfirmedSentTime == 0) {
+    return false;  // Not waiting
+  }
+  
+  if (currentTime - service->pairingConfirmedSentTime >= PAIRING_CONFIRMED_TIMEOUT_MS) {
+    service->waitingForPairingConfirmedAck = false;
+    service->pairingConfirmedSentTime = 0;
+    return true;  // Timeout occurred
+  }
+  
+  return false;  // Still waiting
+}
+
+static unsigned long pairingService_remainingMs(unsigned long startTime, unsigned long timeoutMs, unsigned long currentTime) {
+  unsigned long elapsed = currentTime - startTime;
+  return (elapsed >= timeoutMs) ? 0 : timeoutMs - elapsed;
+}
+
+unsigned long pairingService_timeUntilNextMs(const PairingService* service, unsigned long currentTime) {
+  unsigned long next = ULONG_MAX;
+  if (service->pairingState->waitingForDiscoveryResponse) {
+    // checkDiscoveryTimeout() fires once strictly more than the timeout has passed
+    next = pairingService_remainingMs(service->pairingState->discoveryRequestTime,
+                                      DISCOVERY_RESPONSE_TIMEOUT_MS + 1, currentTime);
+  }
+  if (service->waitingForPairingConfirmedAck && service->pairingConfirmedSentTime != 0) {
+    unsigned long ack = pairingService_remainingMs(service->pairingConfirmedSentTime,
+                                                   PAIRING_CONFIRMED_TIMEOUT_MS, currentTime);
+    if (ack < next) {
+      next = ack;
+    }
+  }
+  return next;
+}
+
 void pairingService_processPendingDiscovery(PairingService* service) {
   if (!service->hasPendingDiscovery) {
     return;
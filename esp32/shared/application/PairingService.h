@@ -30,6 +30,10 @@ void pairingService_initiatePairing(PairingService* service, const uint8_t* rece
 void pairingService_broadcastOnline(PairingService* service);
 void pairingService_broadcastPaired(PairingService* service, const uint8_t* receiverMAC);
 bool pairingService_checkDiscoveryTimeout(PairingService* service, unsigned long currentTime);
+// True once if MSG_PAIRING_CONFIRMED got no ACK within PAIRING_CONFIRMED_TIMEOUT_MS
+bool pairingService_checkPairingConfirmedTimeout(PairingService* service, unsigned long currentTime);
+// Milliseconds until the next pairing timeout (SCHEDULER_NO_DEADLINE-style ULONG_MAX if none)
+unsigned long pairingService_timeUntilNextMs(const PairingService* service, unsigned long currentTime);
 void pairingService_processPendingDiscovery(PairingService* service);  // Process deferred discovery request from main loop
 
 #endif // PAIRING_SERVICE_H
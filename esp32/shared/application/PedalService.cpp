@@ -3,8 +3,10 @@
 #include "../debug_format.h"
 #include <string.h>
 #include <stdarg.h>
+#include <limits.h>
 #include <Arduino.h>
 #include "../messages.h"
+#include "../config.h"
 
 // Forward declarations
 extern void debugPrint(const char* format, ...);
@@ -28,10 +30,11 @@ void pedalService_setLEDService(void* ledService) {
 }
 #endif
 
-void onPedalPress(char key) {
+void onPedalPress(char key, uint32_t edgeUs) {
   if (!g_pedalService) return;
   
   debugPrint("T0: '%c' ▼", key);
+  g_pedalService->heldMask |= (key == '1') ? 0x01 : 0x02;
   
   // If not paired, try to initiate pairing when pedal is pressed
   if (!pairingState_isPaired(g_pedalService->pairingState) && 
@@ -47,7 +50,7 @@ void onPedalPress(char key) {
   
   // Send pedal event if paired
   if (pairingState_isPaired(g_pedalService->pairingState)) {
-    pedalService_sendPedalEvent(g_pedalService, key, true);
+    pedalService_sendTimedPedalEvent(g_pedalService, key, true, edgeUs);
   }
   
   if (g_pedalService->onActivity) {
@@ -55,13 +58,14 @@ void onPedalPress(char key) {
   }
 }
 
-void onPedalRelease(char key) {
+void onPedalRelease(char key, uint32_t edgeUs) {
   if (!g_pedalService) return;
   
   debugPrint("T0: '%c' ▲", key);
+  g_pedalService->heldMask &= (key == '1') ? ~0x01 : ~0x02;
   
   if (pairingState_isPaired(g_pedalService->pairingState)) {
-    pedalService_sendPedalEvent(g_pedalService, key, false);
+    pedalService_sendTimedPedalEvent(g_pedalService, key, false, edgeUs);
   }
   
   if (g_pedalService->onActivity) {
@@ -76,17 +80,62 @@ void pedalService_init(PedalService* service, PedalReader* reader, PairingState*
   service->transport = transport;
   service->lastActivityTime = lastActivityTime;
   service->onActivity = nullptr;
+  service->heldMask = 0;
+  service->lastKeepaliveTime = 0;
   g_pedalService = service;
 }
 
+// While a pedal is held, renew the receiver's held-key lease so it can release the key
+// by itself if this transmitter disappears mid-press
+static bool pedalService_sendKeepaliveIfDue(PedalService* service) {
+  if (service->heldMask == 0 || !pairingState_isPaired(service->pairingState)) {
+    return false;
+  }
+  
+  unsigned long now = millis();
+  if (now - service->lastKeepaliveTime < KEEPALIVE_INTERVAL_MS) {
+    return false;
+  }
+  
+  keepalive_message keepalive = {MSG_KEEPALIVE, service->heldMask, {0, 0}};
+  espNowTransport_send(service->transport, service->pairingState->pairedReceiverMAC,
+                       (uint8_t*)&keepalive, sizeof(keepalive));
+  service->lastKeepaliveTime = now;
+  return true;
+}
+
+unsigned long pedalService_timeUntilNextMs(const PedalService* service, unsigned long now) {
+  if (service->heldMask == 0 || !pairingState_isPaired(service->pairingState)) {
+    return ULONG_MAX;
+  }
+  unsigned long elapsed = now - service->lastKeepaliveTime;
+  return (elapsed >= KEEPALIVE_INTERVAL_MS) ? 0 : KEEPALIVE_INTERVAL_MS - elapsed;
+}
+
 bool pedalService_update(PedalService* service) {
   bool hasWork = pedalReader_needsUpdate(service->reader);
   if (hasWork) {
     pedalReader_update(service->reader, onPedalPress, onPedalRelease);
   }
+  if (pedalService_sendKeepaliveIfDue(service)) {
+    hasWork = true;
+  }
   return hasWork;
 }
 
+static void pedalService_afterPedalEvent(PedalService* service, char key, bool pressed, bool sent) {
+  if (debugEnabled && !sent) {
+    debugPrint("Pedal event send FAILED: key='%c', %s\n", key, pressed ? "PRESSED" : "RELEASED");
+  }
+  
+  if (service->lastActivityTime) {
+    *service->lastActivityTime = millis();
+  }
+  if (pressed) {
+    service->lastKeepaliveTime = millis();  // The press itself starts the lease
+  }
+}
+
 void pedalService_sendPedalEvent(PedalService* service, char key, bool pressed) {
   if (!pairingState_isPaired(service->pairingState)) {
     return;
@@ -96,17 +145,32 @@ void pedalService_sendPedalEvent(PedalService* service, char key, bool pressed)
     .msgType = MSG_PEDAL_EVENT,
     .key = key,
     .pressed = pressed,
-    .pedalMode = service->reader->pedalMode
+    .pedalMode = (uint8_t)(service->reader->pedalMode | PEDAL_EVENT_FLAG_KEEPALIVE)
   };
   
   bool sent = espNowTransport_send(service->transport, service->pairingState->pairedReceiverMAC, 
                                    (uint8_t*)&msg, sizeof(msg));
-  
-  if (debugEnabled && !sent) {
-    debugPrint("Pedal event send FAILED: key='%c', %s\n", key, pressed ? "PRESSED" : "RELEASED");
+  pedalService_afterPedalEvent(service, key, pressed, sent);
+}
+
+void pedalService_sendTimedPedalEvent(PedalService* service, char key, bool pressed, uint32_t edgeUs) {
+#if PEDAL_EVENT_TIMESTAMPS
+  if (!pairingState_isPaired(service->pairingState)) {
+    return;
   }
   
-  if (service->lastActivityTime) {
-    *service->lastActivityTime = millis();
-  }
+  timed_pedal_message msg = {
+    .msgType = MSG_PEDAL_EVENT_TIMED,
+    .key = key,
+    .pressed = pressed,
+    .pedalMode = (uint8_t)(service->reader->pedalMode | PEDAL_EVENT_FLAG_KEEPALIVE),
+    .edgeUs = edgeUs
+  };
+  
+  bool sent = espNowTransport_send(service->transport, service->pairingState->pairedReceiverMAC, 
+                                   (uint8_t*)&msg, sizeof(msg));
+  pedalService_afterPedalEvent(service, key, pressed, sent);
+#else
+  pedalService_sendPedalEvent(service, key, pressed);
+#endif
 }
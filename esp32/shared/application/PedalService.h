@@ -15,13 +15,20 @@ typedef struct {
   EspNowTransport* transport;
   unsigned long* lastActivityTime;
   void (*onActivity)();
+  uint8_t heldMask;                // Bit 0 = pedal '1', bit 1 = pedal '2'
+  unsigned long lastKeepaliveTime;
 } PedalService;
 
 void pedalService_init(PedalService* service, PedalReader* reader, PairingState* pairingState, 
                        EspNowTransport* transport, unsigned long* lastActivityTime);
 void pedalService_setPairingService(PairingService* pairingService);
-bool pedalService_update(PedalService* service);  // Returns true if work was done (debouncing, etc.)
+bool pedalService_update(PedalService* service);  // Returns true if work was done (debouncing, keepalive, etc.)
+// Milliseconds until the next keepalive is due (ULONG_MAX while nothing is held)
+unsigned long pedalService_timeUntilNextMs(const PedalService* service, unsigned long now);
 void pedalService_sendPedalEvent(PedalService* service, char key, bool pressed);
+// Same, stamped with the ISR edge time so the receiver can replay the original spacing
+// (plain MSG_PEDAL_EVENT when PEDAL_EVENT_TIMESTAMPS is 0)
+void pedalService_sendTimedPedalEvent(PedalService* service, char key, bool pressed, uint32_t edgeUs);
 
 // Optional LED service support (only available if LEDService.h exists in project)
 #ifdef PEDAL_SERVICE_HAS_LED
@@ -5,8 +5,10 @@
 // System Configuration
 // ============================================================================
 
-// Maximum number of pedal slots supported by receiver
-#define MAX_PEDAL_SLOTS 2
+// Maximum number of pedal slots supported by receiver - the single capacity constant for
+// the receiver's transmitter table, MAC index and key pool. One slot per key: a DUAL
+// transmitter takes two, so this serves 16 DUAL up to 32 SINGLE transmitters.
+#define MAX_PEDAL_SLOTS 32
 
 // ============================================================================
 // Timing Configuration - Pairing & Discovery
@@ -30,6 +32,69 @@
 // Pairing confirmed timeout - if no ACK received within this time, send MSG_TRANSMITTER_ONLINE
 #define PAIRING_CONFIRMED_TIMEOUT_MS 1000  // 1 second
 
+// Discovery response timeout - transmitter stops waiting for MSG_DISCOVERY_RESP
+#define DISCOVERY_RESPONSE_TIMEOUT_MS 5000  // 5 seconds
+
+// ============================================================================
+// Timing Configuration - Leases
+// ============================================================================
+
+// Keepalive interval while a pedal is held (transmitter)
+#define KEEPALIVE_INTERVAL_MS 250
+
+// Held keys are released if a keepalive-capable transmitter goes quiet this long (receiver)
+#define HELD_KEY_LEASE_MS 1000  // 4 missed keepalives
+
+// Transmitter liveness lease, renewed by any frame. Longer than the transmitter's own
+// inactivity timeout, so an expired lease means the transmitter is asleep or gone.
+#define TRANSMITTER_LEASE_MS (INACTIVITY_TIMEOUT_MS + 30000)
+
+// ============================================================================
+// Pedal Event Timing
+// ============================================================================
+
+// Transmitters stamp pedal events with the ISR edge time (MSG_PEDAL_EVENT_TIMED). Set to 0
+// for receivers that predate it; they drop the timed message.
+#define PEDAL_EVENT_TIMESTAMPS 1
+
+// Receiver playout delay for timed pedal events: each edge is replayed this long after the
+// fastest delivery seen from its transmitter, so radio jitter up to this much does not
+// change press/release spacing. 0 plays events on arrival (jitter is still measured).
+#define PLAYOUT_DELAY_MS 8
+
+// Timed events waiting for their playout time (a full buffer plays events on arrival)
+#define PLAYOUT_BUFFER_CAPACITY 16
+
+// A transmitter silent this long gets its clock offset re-measured (sleep, reboot, drift)
+#define PLAYOUT_REANCHOR_MS 2000
+
+// ============================================================================
+// Expression Pedals
+// ============================================================================
+
+// ADC sampling rate of an expression input (transmitter); 1000 must divide evenly by it
+#define EXPRESSION_SAMPLE_HZ 200
+
+// Position resolution sent to the receiver (from the 12-bit ADC)
+#define EXPRESSION_RESOLUTION_BITS 10
+
+// A new position is sent only when it moves more than this many steps from the last one sent
+#define EXPRESSION_DEADBAND 2
+
+// One-pole low-pass on the raw samples: each sample moves the filter 1 / (1 << shift) of the way
+#define EXPRESSION_FILTER_SHIFT 2
+
+// Absolute value frame at least every this many frames while moving, once the pedal has
+// been still for EXPRESSION_SETTLE_MS and then every EXPRESSION_REFRESH_MS at rest, so a
+// receiver that missed a frame (or rebooted) converges
+#define EXPRESSION_KEYFRAME_FRAMES 32
+#define EXPRESSION_SETTLE_MS 100
+#define EXPRESSION_REFRESH_MS 1000
+
+// The HID output task consumes expression frames itself and passes at most one per
+// transmitter this often to the housekeeping task, to renew its liveness lease
+#define EXPRESSION_LEASE_FORWARD_MS 1000
+
 // ============================================================================
 // Timing Configuration - Power Management
 // ============================================================================
@@ -37,9 +102,19 @@
 // Inactivity timeout before entering deep sleep (transmitter)
 #define INACTIVITY_TIMEOUT_MS 300000  // 5 minutes
 
-// Idle loop delays (transmitter)
-#define IDLE_DELAY_PAIRED_MS 10      // When paired - responsive
-#define IDLE_DELAY_UNPAIRED_MS 200   // When not paired - power saving
+// ============================================================================
+// Loop Scheduling
+// ============================================================================
+
+// Longest a loop sleeps with no deadline armed (safety net; work is woken by events)
+#define LOOP_MAX_SLEEP_MS 1000
+
+// Window for the wakeups-per-second measurement
+#define SCHEDULER_STATS_WINDOW_MS 10000
+
+// Receiver LED frame interval while animating (breathing blue) - fixed, independent of how
+// often the loop wakes
+#define LED_FRAME_INTERVAL_MS 20
 
 // Debug monitor adaptive delays
 #define DEBUG_MONITOR_DELAY_ACTIVE_MS 20   // When messages are queued (50Hz)
@@ -55,9 +130,14 @@
 // Debug button debounce time
 #define DEBUG_BUTTON_DEBOUNCE_TIME_MS 50
 
-// ESP-NOW peer ready delay (ESP32-S3 requires this)
+// ESP-NOW peer ready delay after pairing registers a peer (ESP32-S3 requires this); the
+// send path registers peers without it
 #define ESPNOW_PEER_READY_DELAY_MS 2
 
+// ESP-NOW peers kept registered (at most ESP_NOW_MAX_TOTAL_PEER_NUM); the least recently
+// used one is removed to make room for a new peer
+#define PEER_CACHE_CAPACITY 20
+
 // WiFi initialization delays (receiver)
 #define WIFI_INIT_DELAY_MS 100
 #define WIFI_DISCONNECT_DELAY_MS 100
@@ -69,7 +149,95 @@
 // Heartbeat interval (receiver status updates)
 #define HEARTBEAT_INTERVAL_MS 60000  // 1 minute
 
-// Slot calculation cache duration (receiver)
-#define SLOT_CALCULATION_CACHE_MS 100
+// ============================================================================
+// Receiver Ingress
+// ============================================================================
+
+// Frames buffered between the ESP-NOW receive callback and the dispatcher (power of two)
+#define INGRESS_QUEUE_CAPACITY 32
+
+// Largest frame copied into the ingress ring (receiver messages are all well below this)
+#define INGRESS_MAX_FRAME_LEN 32
+
+// ============================================================================
+// Receiver Persistence
+// ============================================================================
+
+// Quiet time after the last pairing change before the state blob is written to NVS.
+// Bursts of changes (discovery, mode updates, deletes) are coalesced into one write.
+#define PERSISTENCE_COMMIT_DELAY_MS 2000
+
+// ============================================================================
+// Receiver Flight Recorder
+// ============================================================================
+
+// Events staged in RAM before the loop writes them to flash (power of two)
+#define FLIGHT_RECORDER_STAGE_CAPACITY 64
+
+// Staged events are written once a 256-byte page (16 events) fills, or after this long
+#define FLIGHT_RECORDER_FLUSH_MS 5000
+
+// Spacing of dump lines sent to the debug monitor (its receive queue holds 16 lines)
+#define FLIGHT_RECORDER_DUMP_INTERVAL_MS 20
+
+// ============================================================================
+// Receiver USB Telemetry
+// ============================================================================
+
+// Bytes staged for the CDC endpoint (power of two); frames that do not fit are dropped
+#define TELEMETRY_BUFFER_SIZE 4096
+
+// Staged frames are written to USB at most this long after they were queued
+#define TELEMETRY_DRAIN_INTERVAL_MS 10
+
+// Counter snapshot period while a host is connected
+#define TELEMETRY_COUNTERS_INTERVAL_MS 1000
+
+// ============================================================================
+// Receiver Keyboard Report
+// ============================================================================
+
+// 1 = N-key-rollover report (any number of pedal keys held at once), with the 6-key report
+// while the host asks for the boot protocol; 0 = 6-key report only (extra keys wait for a slot)
+#define HID_KEYBOARD_NKRO 1
+
+// ============================================================================
+// Receiver Gestures
+// ============================================================================
+
+// A press held this long becomes a hold (below typical host key-repeat delays, so the
+// speculative primary key has typed one character when it is replaced)
+#define GESTURE_LONG_PRESS_MS 400
+
+// A press this soon after a tap's release is a double-tap
+#define GESTURE_DOUBLE_TAP_MS 250
+
+// Spacing of the Backspace/upgrade keystrokes that compensate a speculative primary key
+#define GESTURE_STEP_MS 10
+
+// ============================================================================
+// Receiver Task Layout
+// ============================================================================
+
+// HID output task: drains the ingress ring and drives the keyboard. Runs on the core the
+// WiFi stack is not pinned to, above the Arduino loop task (priority 1) that keeps
+// pairing, LED and heartbeat work.
+#if defined(CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_1)
+#define HID_TASK_CORE 0
+#else
+#define HID_TASK_CORE 1
+#endif
+#define HID_TASK_PRIORITY 10
+#define HID_TASK_STACK_SIZE 4096
+#define HID_TASK_IDLE_WAIT_MS 1000   // Longest the HID task sleeps without a frame
+#define HID_REPORT_RETRY_MS 1        // Wait before resending a report the host was not ready for
+
+// Frames forwarded from the HID task to the housekeeping (loop) task
+#define CONTROL_QUEUE_LENGTH 32
+
+// Pedal events that arrive before the USB HID interface is mounted are held and replayed
+// on mount; older events are discarded rather than typed late
+#define PRE_READY_QUEUE_CAPACITY 16
+#define PRE_READY_MAX_AGE_MS 3000
 
 #endif // CONFIG_H
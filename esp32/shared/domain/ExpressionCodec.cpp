@@ -0,0 +1,161 @@
+#include "ExpressionCodec.h"
+#include "../config.h"
+#include <string.h>
+
+void expressionEncoder_init(ExpressionEncoder* encoder, uint8_t input, uint8_t resolutionBits, uint8_t deadband) {
+  memset(encoder, 0, sizeof(ExpressionEncoder));
+  encoder->input = input & 0x0F;
+  if (resolutionBits < 1) resolutionBits = 1;
+  if (resolutionBits > EXPRESSION_ADC_BITS) resolutionBits = EXPRESSION_ADC_BITS;
+  encoder->resolutionBits = resolutionBits;
+  encoder->deadband = deadband;
+  encoder->settled = true;
+}
+
+void expressionEncoder_requestKeyframe(ExpressionEncoder* encoder) {
+  encoder->sentValid = false;
+}
+
+// Round the filtered value to resolutionBits
+static uint16_t expressionEncoder_quantize(const ExpressionEncoder* encoder) {
+  int shift = 4 + EXPRESSION_ADC_BITS - encoder->resolutionBits;
+  uint32_t position = (encoder->filtered + (1u << (shift - 1))) >> shift;
+  uint32_t maxPosition = (1u << encoder->resolutionBits) - 1;
+  return (uint16_t)(position > maxPosition ? maxPosition : position);
+}
+
+static int expressionEncoder_valueFrame(ExpressionEncoder* encoder, uint16_t position, uint32_t nowMs, uint8_t* out) {
+  expression_value_message msg = {
+    .msgType = MSG_EXPRESSION_VALUE,
+    .inputSeq = EXPRESSION_INPUT_SEQ(encoder->input, encoder->sequence),
+    .value = position,
+    .resolutionBits = encoder->resolutionBits
+  };
+  memcpy(out, &msg, sizeof(msg));
+  encoder->sequence = (encoder->sequence + 1) & 0x0F;
+  encoder->sent = position;
+  encoder->sentValid = true;
+  encoder->sinceKeyframe = 0;
+  encoder->lastValueMs = nowMs;
+  encoder->valueFrames++;
+  return sizeof(msg);
+}
+
+static int expressionEncoder_deltaFrame(ExpressionEncoder* encoder, int delta, uint8_t* out) {
+  expression_delta_message msg = {
+    .msgType = MSG_EXPRESSION_DELTA,
+    .inputSeq = EXPRESSION_INPUT_SEQ(encoder->input, encoder->sequence),
+    .delta = (int8_t)delta
+  };
+  memcpy(out, &msg, sizeof(msg));
+  encoder->sequence = (encoder->sequence + 1) & 0x0F;
+  encoder->sent = (uint16_t)(encoder->sent + delta);
+  encoder->sinceKeyframe++;
+  encoder->deltaFrames++;
+  return sizeof(msg);
+}
+
+int expressionEncoder_sample(ExpressionEncoder* encoder, uint16_t raw, uint32_t nowMs, uint8_t* out) {
+  encoder->samples++;
+  if (raw >= (1u << EXPRESSION_ADC_BITS)) {
+    raw = (1u << EXPRESSION_ADC_BITS) - 1;
+  }
+
+  int32_t scaled = (int32_t)raw << 4;
+  if (!encoder->primed) {
+    encoder->filtered = (uint32_t)scaled;
+    encoder->primed = true;
+  } else {
+    encoder->filtered += (scaled - (int32_t)encoder->filtered) >> EXPRESSION_FILTER_SHIFT;
+  }
+
+  uint16_t position = expressionEncoder_quantize(encoder);
+  if (!encoder->sentValid) {
+    encoder->lastMoveMs = nowMs;
+    encoder->settled = false;
+    return expressionEncoder_valueFrame(encoder, position, nowMs, out);
+  }
+
+  int delta = (int)position - (int)encoder->sent;
+  if (delta > encoder->deadband || -delta > encoder->deadband) {
+    encoder->lastMoveMs = nowMs;
+    encoder->settled = false;
+    if (delta >= INT8_MIN && delta <= INT8_MAX && encoder->sinceKeyframe + 1 < EXPRESSION_KEYFRAME_FRAMES) {
+      return expressionEncoder_deltaFrame(encoder, delta, out);
+    }
+    return expressionEncoder_valueFrame(encoder, position, nowMs, out);
+  }
+
+  // At rest: an absolute frame once the pedal stops and then every EXPRESSION_REFRESH_MS,
+  // so a receiver that lost a frame on the way (or rebooted) converges
+  if (!encoder->settled && nowMs - encoder->lastMoveMs >= EXPRESSION_SETTLE_MS) {
+    encoder->settled = true;
+    return expressionEncoder_valueFrame(encoder, position, nowMs, out);
+  }
+  if (encoder->settled && nowMs - encoder->lastValueMs >= EXPRESSION_REFRESH_MS) {
+    return expressionEncoder_valueFrame(encoder, encoder->sent, nowMs, out);
+  }
+  return 0;
+}
+
+void expressionDecoder_init(ExpressionDecoder* decoder) {
+  memset(decoder, 0, sizeof(ExpressionDecoder));
+}
+
+// Count frames lost since the previous one; true if none were
+static bool expressionDecoder_sequence(ExpressionDecoder* decoder, uint8_t inputSeq) {
+  uint8_t sequence = EXPRESSION_SEQUENCE(inputSeq);
+  bool contiguous = !decoder->seen || sequence == decoder->nextSequence;
+  if (!contiguous) {
+    decoder->missed += (sequence - decoder->nextSequence) & 0x0F;
+  }
+  decoder->seen = true;
+  decoder->nextSequence = (sequence + 1) & 0x0F;
+  decoder->frames++;
+  return contiguous;
+}
+
+bool expressionDecoder_apply(ExpressionDecoder* decoder, const uint8_t* data, int len) {
+  uint16_t previous = decoder->value;
+
+  if (len == (int)sizeof(expression_value_message) && data[0] == MSG_EXPRESSION_VALUE) {
+    expression_value_message msg;
+    memcpy(&msg, data, sizeof(msg));
+    if (msg.resolutionBits < 1 || msg.resolutionBits > 16) {
+      return false;
+    }
+    expressionDecoder_sequence(decoder, msg.inputSeq);
+    uint32_t maxValue = (1u << msg.resolutionBits) - 1;
+    decoder->resolutionBits = msg.resolutionBits;
+    decoder->value = (uint16_t)(msg.value > maxValue ? maxValue : msg.value);
+    decoder->valid = true;
+    decoder->drifting = false;
+    return decoder->value != previous;
+  }
+
+  if (len == (int)sizeof(expression_delta_message) && data[0] == MSG_EXPRESSION_DELTA) {
+    expression_delta_message msg;
+    memcpy(&msg, data, sizeof(msg));
+    bool contiguous = expressionDecoder_sequence(decoder, msg.inputSeq);
+    if (!decoder->valid) {
+      decoder->skippedDeltas++;
+      return false;
+    }
+    if (!contiguous) {
+      decoder->drifting = true;  // Off by the missed deltas until the next value frame
+    }
+    int32_t maxValue = (1 << decoder->resolutionBits) - 1;
+    int32_t value = (int32_t)decoder->value + msg.delta;
+    decoder->value = (uint16_t)(value < 0 ? 0 : (value > maxValue ? maxValue : value));
+    return decoder->value != previous;
+  }
+  return false;
+}
+
+uint16_t expressionDecoder_axis(const ExpressionDecoder* decoder) {
+  if (decoder->resolutionBits == 0) {
+    return 0;
+  }
+  uint32_t maxValue = (1u << decoder->resolutionBits) - 1;
+  return (uint16_t)((uint32_t)decoder->value * EXPRESSION_AXIS_MAX / maxValue);
+}
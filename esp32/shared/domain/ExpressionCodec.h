@@ -0,0 +1,73 @@
+#ifndef EXPRESSION_CODEC_H
+#define EXPRESSION_CODEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../messages.h"
+
+// Expression pedal stream: the transmitter side low-passes ADC samples, quantizes them to
+// resolutionBits and produces a frame only when the position leaves the deadband around
+// the last one sent. Small moves go out as 3-byte delta frames; a 5-byte value frame is
+// sent first, every EXPRESSION_KEYFRAME_FRAMES frames, for moves that do not fit a delta,
+// once more when the pedal comes to rest and then every EXPRESSION_REFRESH_MS. The receiver
+// side keeps applying deltas across a missed frame (off by the missed move rather than
+// frozen) until the next value frame puts it back on the exact position, at the latest
+// EXPRESSION_SETTLE_MS after the pedal stops.
+// Pure logic: times are passed in by the caller.
+
+#define EXPRESSION_ADC_BITS 12
+#define EXPRESSION_MAX_FRAME_LEN ((int)sizeof(expression_value_message))
+#define EXPRESSION_AXIS_MAX 32767
+
+typedef struct {
+  uint8_t input;           // Expression input number on this transmitter (0..15)
+  uint8_t resolutionBits;  // 1..EXPRESSION_ADC_BITS
+  uint8_t deadband;        // Steps (at resolutionBits) a move must exceed to be sent
+  bool primed;             // Filter holds a sample
+  uint32_t filtered;       // Low-passed ADC value, 4 fractional bits
+  bool sentValid;          // Receiver has an absolute position from us (else send a value frame)
+  uint16_t sent;           // Position the receiver has
+  uint8_t sequence;        // Next frame's sequence number (mod 16)
+  uint8_t sinceKeyframe;   // Delta frames since the last value frame
+  bool settled;            // Value frame sent since the last move
+  uint32_t lastMoveMs;
+  uint32_t lastValueMs;
+
+  // Instrumentation
+  uint32_t samples;
+  uint32_t valueFrames;
+  uint32_t deltaFrames;
+} ExpressionEncoder;
+
+typedef struct {
+  bool valid;              // A value frame has arrived
+  bool drifting;           // A delta was missed since the last value frame
+  bool seen;               // nextSequence is meaningful
+  uint8_t nextSequence;
+  uint8_t resolutionBits;
+  uint16_t value;
+
+  // Instrumentation
+  uint32_t frames;
+  uint32_t missed;         // Frames lost, from sequence gaps
+  uint32_t skippedDeltas;  // Deltas that arrived before any value frame
+} ExpressionDecoder;
+
+void expressionEncoder_init(ExpressionEncoder* encoder, uint8_t input, uint8_t resolutionBits, uint8_t deadband);
+
+// Next frame is a value frame (e.g. the receiver changed or was just paired)
+void expressionEncoder_requestKeyframe(ExpressionEncoder* encoder);
+
+// Feed one raw ADC sample (0..4095). Writes a frame to out (EXPRESSION_MAX_FRAME_LEN bytes)
+// and returns its length, or returns 0 when there is nothing to send.
+int expressionEncoder_sample(ExpressionEncoder* encoder, uint16_t raw, uint32_t nowMs, uint8_t* out);
+
+void expressionDecoder_init(ExpressionDecoder* decoder);
+
+// Apply a MSG_EXPRESSION_VALUE / MSG_EXPRESSION_DELTA frame; returns true if the value changed
+bool expressionDecoder_apply(ExpressionDecoder* decoder, const uint8_t* data, int len);
+
+// Current value scaled to 0..EXPRESSION_AXIS_MAX
+uint16_t expressionDecoder_axis(const ExpressionDecoder* decoder);
+
+#endif // EXPRESSION_CODEC_H
@@ -5,29 +5,67 @@
 #include <stdbool.h>
 #include <string.h>
 
-static inline bool macIsZero(const uint8_t* mac) {
-  if (!mac) return true;
+// Packed 48-bit MAC address: mac[0] in bits 47..40, so values order like the printed
+// form. Compare, hash and copy it as one word; convert to uint8_t[6] only at the wire
+// (ESP-NOW callbacks, message structs, peer registration, NVS).
+typedef struct {
+  uint64_t bits;
+} MacAddr;
+
+#define MAC_ADDR_BROADCAST_BITS 0xFFFFFFFFFFFFull
+
+static constexpr MacAddr MAC_ADDR_ZERO = {0};
+static constexpr MacAddr MAC_ADDR_BROADCAST = {MAC_ADDR_BROADCAST_BITS};
+
+static inline constexpr MacAddr macAddr_fromBytes(const uint8_t* mac) {
+  return MacAddr{((uint64_t)mac[0] << 40) | ((uint64_t)mac[1] << 32) | ((uint64_t)mac[2] << 24) |
+                 ((uint64_t)mac[3] << 16) | ((uint64_t)mac[4] << 8) | (uint64_t)mac[5]};
+}
+
+static inline void macAddr_toBytes(MacAddr addr, uint8_t* mac) {
   for (int i = 0; i < 6; i++) {
-    if (mac[i] != 0) return false;
+    mac[i] = (uint8_t)(addr.bits >> (40 - 8 * i));
   }
-  return true;
+}
+
+static inline constexpr bool macAddr_equal(MacAddr a, MacAddr b) {
+  return a.bits == b.bits;
+}
+
+static inline constexpr bool macAddr_isZero(MacAddr addr) {
+  return addr.bits == 0;
+}
+
+static inline constexpr bool macAddr_isBroadcast(MacAddr addr) {
+  return addr.bits == MAC_ADDR_BROADCAST_BITS;
+}
+
+static inline constexpr bool macAddr_isValid(MacAddr addr) {
+  return !macAddr_isZero(addr) && !macAddr_isBroadcast(addr);
+}
+
+// Fibonacci hashing: vendor prefixes repeat, so mix all 48 bits into the top bits
+static inline constexpr uint32_t macAddr_hash(MacAddr addr) {
+  return (uint32_t)((addr.bits * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+// Byte-array helpers for wire buffers (NULL-safe)
+
+static inline bool macIsZero(const uint8_t* mac) {
+  return !mac || macAddr_isZero(macAddr_fromBytes(mac));
 }
 
 static inline bool macIsBroadcast(const uint8_t* mac) {
-  if (!mac) return false;
-  for (int i = 0; i < 6; i++) {
-    if (mac[i] != 0xFF) return false;
-  }
-  return true;
+  return mac && macAddr_isBroadcast(macAddr_fromBytes(mac));
 }
 
 static inline bool isValidMAC(const uint8_t* mac) {
-  return mac && !macIsZero(mac) && !macIsBroadcast(mac);
+  return mac && macAddr_isValid(macAddr_fromBytes(mac));
 }
 
 static inline bool macEqual(const uint8_t* mac1, const uint8_t* mac2) {
   if (!mac1 || !mac2) return false;
-  return memcmp(mac1, mac2, 6) == 0;
+  return macAddr_equal(macAddr_fromBytes(mac1), macAddr_fromBytes(mac2));
 }
 
 static inline void macCopy(uint8_t* dest, const uint8_t* src) {
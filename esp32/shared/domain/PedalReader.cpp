@@ -1,27 +1,33 @@
 #include "PedalReader.h"
 #include <Arduino.h>
+#include <esp_timer.h>
 #include "../config.h"
+#include "../infrastructure/Scheduler.h"
 
 // Global pointer to PedalReader instance (needed for ISR)
 PedalReader* g_pedalReader = nullptr;
 
-// Interrupt Service Routines - minimal ISRs that only set flags
+// Interrupt Service Routines - minimal ISRs that only set flags and stamp the first edge
 // GPIO reading and debouncing happen in main loop to avoid watchdog timeouts
 void IRAM_ATTR pedal1ISR() {
   if (g_pedalReader != nullptr) {
-    volatile bool* flag = &g_pedalReader->pedal1State.interruptFlag;
-    if (!*flag) {
-      *flag = true;
+    PedalState* state = &g_pedalReader->pedal1State;
+    if (!state->interruptFlag) {
+      state->edgeUs = (uint32_t)esp_timer_get_time();  // Later bounces keep the first edge
+      state->interruptFlag = true;
     }
+    scheduler_wakeFromISR(g_scheduler);
   }
 }
 
 void IRAM_ATTR pedal2ISR() {
   if (g_pedalReader != nullptr) {
-    volatile bool* flag = &g_pedalReader->pedal2State.interruptFlag;
-    if (!*flag) {
-      *flag = true;
+    PedalState* state = &g_pedalReader->pedal2State;
+    if (!state->interruptFlag) {
+      state->edgeUs = (uint32_t)esp_timer_get_time();  // Later bounces keep the first edge
+      state->interruptFlag = true;
     }
+    scheduler_wakeFromISR(g_scheduler);
   }
 }
 
@@ -33,12 +39,14 @@ void pedalReader_init(PedalReader* reader, uint8_t pedal1Pin, uint8_t pedal2Pin,
   // Initialize pedal 1 state
   reader->pedal1State.lastState = HIGH;
   reader->pedal1State.interruptFlag = false;
+  reader->pedal1State.edgeUs = 0;
   reader->pedal1State.lastDebounceTime = 0;
   reader->interruptAttached1 = false;
   
   // Initialize pedal 2 state
   reader->pedal2State.lastState = HIGH;
   reader->pedal2State.interruptFlag = false;
+  reader->pedal2State.edgeUs = 0;
   reader->pedal2State.lastDebounceTime = 0;
   reader->interruptAttached2 = false;
   
@@ -63,12 +71,13 @@ bool pedalReader_needsUpdate(PedalReader* reader) {
 }
 
 void pedalReader_processPedal(PedalReader* reader, uint8_t pin, PedalState* state, char key, 
-                               void (*onPedalPress)(char), void (*onPedalRelease)(char),
+                               void (*onPedalPress)(char, uint32_t), void (*onPedalRelease)(char, uint32_t),
                                bool* interruptAttached) {
   if (!state->interruptFlag) {
     return;
   }
   
+  uint32_t edgeUs = state->edgeUs;
   state->interruptFlag = false;
   
   // Read GPIO state (not done in ISR to avoid watchdog timeout)
@@ -91,14 +100,15 @@ void pedalReader_processPedal(PedalReader* reader, uint8_t pin, PedalState* stat
   
   if (currentState == LOW) {
     // Pedal pressed (HIGH -> LOW)
-    if (onPedalPress) onPedalPress(key);
+    if (onPedalPress) onPedalPress(key, edgeUs);
   } else {
     // Pedal released (LOW -> HIGH)
-    if (onPedalRelease) onPedalRelease(key);
+    if (onPedalRelease) onPedalRelease(key, edgeUs);
   }
 }
 
-void pedalReader_update(PedalReader* reader, void (*onPedalPress)(char key), void (*onPedalRelease)(char key)) {
+void pedalReader_update(PedalReader* reader, void (*onPedalPress)(char key, uint32_t edgeUs),
+                        void (*onPedalRelease)(char key, uint32_t edgeUs)) {
   if (!pedalReader_needsUpdate(reader)) {
     return;
   }
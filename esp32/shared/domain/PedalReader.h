@@ -7,6 +7,7 @@
 typedef struct {
   bool lastState;
   volatile bool interruptFlag;  // Set by ISR when interrupt occurs (GPIO read in main loop to avoid watchdog timeout)
+  volatile uint32_t edgeUs;     // esp_timer time of the first edge since the flag was last cleared
   unsigned long lastDebounceTime;  // Timestamp of last processed interrupt (for debouncing)
 } PedalState;
 
@@ -29,6 +30,8 @@ void IRAM_ATTR pedal2ISR();
 
 void pedalReader_init(PedalReader* reader, uint8_t pedal1Pin, uint8_t pedal2Pin, uint8_t pedalMode);
 bool pedalReader_needsUpdate(PedalReader* reader);  // Returns true if interrupt occurred
-void pedalReader_update(PedalReader* reader, void (*onPedalPress)(char key), void (*onPedalRelease)(char key));
+// Callbacks get the ISR time of the edge that started the transition (esp_timer, low 32 bits)
+void pedalReader_update(PedalReader* reader, void (*onPedalPress)(char key, uint32_t edgeUs),
+                        void (*onPedalRelease)(char key, uint32_t edgeUs));
 
 #endif // PEDAL_READER_H
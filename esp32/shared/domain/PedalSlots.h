@@ -3,9 +3,29 @@
 
 #include <stdint.h>
 
-// 0 = DUAL (2 slots), 1 = SINGLE (1 slot)
+// Pedal modes as sent in discovery requests
+#define PEDAL_MODE_DUAL   0  // Two pedals, keys '1' and '2'
+#define PEDAL_MODE_SINGLE 1  // One pedal, key '1'
+
+// Transmitters with any other number of inputs send PEDAL_MODE_INPUTS(n): keys '1'..'0'+n
+#define PEDAL_MODE_INPUTS_FLAG 0x40
+#define PEDAL_MODE_INPUTS(n) (PEDAL_MODE_INPUTS_FLAG | (n))
+#define MAX_PEDAL_INPUTS 8
+
+// One slot per input: DUAL = 2, SINGLE = 1, PEDAL_MODE_INPUTS(n) = n (capped at MAX_PEDAL_INPUTS)
 static inline int getSlotsNeeded(uint8_t pedalMode) {
-  return (pedalMode == 0) ? 2 : 1;
+  if (pedalMode & PEDAL_MODE_INPUTS_FLAG) {
+    int inputs = pedalMode & 0x3F;
+    if (inputs < 1) return 1;
+    return (inputs > MAX_PEDAL_INPUTS) ? MAX_PEDAL_INPUTS : inputs;
+  }
+  return (pedalMode == PEDAL_MODE_DUAL) ? 2 : 1;
+}
+
+// Input number of a pedal key ('1' -> 0), or -1 if out of range
+static inline int getPedalInput(char pedalKey) {
+  int input = pedalKey - '1';
+  return (input >= 0 && input < MAX_PEDAL_INPUTS) ? input : -1;
 }
 
 #endif // PEDAL_SLOTS_H
@@ -0,0 +1,101 @@
+#include "PeerCache.h"
+#include <string.h>
+
+static_assert((PEER_CACHE_BUCKETS & (PEER_CACHE_BUCKETS - 1)) == 0, "PEER_CACHE_BUCKETS must be a power of two");
+static_assert(PEER_CACHE_BUCKETS >= 2 * PEER_CACHE_CAPACITY, "PEER_CACHE_BUCKETS too small for PEER_CACHE_CAPACITY");
+
+#define PEER_CACHE_MASK (PEER_CACHE_BUCKETS - 1)
+
+static inline uint32_t peerCache_home(MacAddr mac) {
+  return (macAddr_hash(mac) >> 8) & PEER_CACHE_MASK;
+}
+
+void peerCache_init(PeerCache* cache) {
+  memset(cache, 0, sizeof(PeerCache));
+  memset(cache->buckets, -1, sizeof(cache->buckets));
+}
+
+// Bucket holding mac, or the empty bucket that ends its probe run
+static uint32_t peerCache_probe(const PeerCache* cache, MacAddr mac) {
+  uint32_t slot = peerCache_home(mac);
+  while (cache->buckets[slot] >= 0 && !macAddr_equal(cache->entries[cache->buckets[slot]].mac, mac)) {
+    slot = (slot + 1) & PEER_CACHE_MASK;
+  }
+  return slot;
+}
+
+bool peerCache_touch(PeerCache* cache, MacAddr mac) {
+  int entry = cache->buckets[peerCache_probe(cache, mac)];
+  if (entry < 0) {
+    cache->misses++;
+    return false;
+  }
+  cache->entries[entry].lastUse = ++cache->clock;
+  cache->hits++;
+  return true;
+}
+
+// Empty a bucket with backward-shift deletion, so probes never need tombstones
+static void peerCache_clearBucket(PeerCache* cache, uint32_t hole) {
+  for (uint32_t next = (hole + 1) & PEER_CACHE_MASK; cache->buckets[next] >= 0; next = (next + 1) & PEER_CACHE_MASK) {
+    uint32_t home = peerCache_home(cache->entries[cache->buckets[next]].mac);
+    // Entry at next may move to hole unless its home lies cyclically in (hole, next]
+    bool homeBetween = (hole <= next) ? (home > hole && home <= next) : (home > hole || home <= next);
+    if (!homeBetween) {
+      cache->buckets[hole] = cache->buckets[next];
+      hole = next;
+    }
+  }
+  cache->buckets[hole] = -1;
+}
+
+void peerCache_remove(PeerCache* cache, MacAddr mac) {
+  uint32_t slot = peerCache_probe(cache, mac);
+  int entry = cache->buckets[slot];
+  if (entry < 0) return;
+  peerCache_clearBucket(cache, slot);
+  
+  // Keep entries dense: the last one moves into the freed entry
+  int last = --cache->count;
+  if (entry != last) {
+    cache->entries[entry] = cache->entries[last];
+    cache->buckets[peerCache_probe(cache, cache->entries[entry].mac)] = (int8_t)entry;
+  }
+}
+
+MacAddr peerCache_oldest(const PeerCache* cache) {
+  if (cache->count == 0) return MAC_ADDR_ZERO;
+  // Only on a miss with a full table: a linear scan of at most PEER_CACHE_CAPACITY entries
+  int oldest = 0;
+  for (int i = 1; i < cache->count; i++) {
+    if ((int32_t)(cache->entries[i].lastUse - cache->entries[oldest].lastUse) < 0) {
+      oldest = i;
+    }
+  }
+  return cache->entries[oldest].mac;
+}
+
+void peerCache_evict(PeerCache* cache, MacAddr mac) {
+  if (cache->buckets[peerCache_probe(cache, mac)] < 0) return;
+  peerCache_remove(cache, mac);
+  cache->evictions++;
+}
+
+void peerCache_insert(PeerCache* cache, MacAddr mac, MacAddr* evicted) {
+  *evicted = MAC_ADDR_ZERO;
+  int existing = cache->buckets[peerCache_probe(cache, mac)];
+  if (existing >= 0) {
+    cache->entries[existing].lastUse = ++cache->clock;
+    return;
+  }
+  
+  if (cache->count >= PEER_CACHE_CAPACITY) {
+    *evicted = peerCache_oldest(cache);
+    peerCache_evict(cache, *evicted);
+  }
+  
+  int entry = cache->count++;
+  cache->entries[entry].mac = mac;
+  cache->entries[entry].lastUse = ++cache->clock;
+  cache->buckets[peerCache_probe(cache, mac)] = (int8_t)entry;
+}
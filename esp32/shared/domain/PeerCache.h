@@ -0,0 +1,53 @@
+#ifndef PEER_CACHE_H
+#define PEER_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "MacUtils.h"
+#include "../config.h"
+
+// Mirror of the ESP-NOW peer table, so the send path can tell "already registered" with a
+// hash probe instead of esp_now_get_peer(), and so the table never fills up: once
+// PEER_CACHE_CAPACITY peers are registered, the least recently used one is evicted (and
+// deleted from ESP-NOW) to make room. An evicted peer that is needed again is simply
+// registered again on its next send.
+// Pure bookkeeping; infrastructure/EspNowPeers makes the esp_now_* calls and serializes access.
+
+#define PEER_CACHE_BUCKETS 64  // Power of two, >= 2 * PEER_CACHE_CAPACITY
+
+typedef struct {
+  MacAddr mac;
+  uint32_t lastUse;     // Cache clock at the last send or registration
+} PeerCacheEntry;
+
+typedef struct {
+  PeerCacheEntry entries[PEER_CACHE_CAPACITY];
+  int count;
+  int8_t buckets[PEER_CACHE_BUCKETS];  // Entry index, -1 = empty (linear probing)
+  uint32_t clock;
+
+  // Instrumentation
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+} PeerCache;
+
+void peerCache_init(PeerCache* cache);
+
+// True if mac is registered (and marks it most recently used); counts a hit or a miss
+bool peerCache_touch(PeerCache* cache, MacAddr mac);
+
+// Record mac as registered. When the cache is full the least recently used peer makes room
+// and is returned in evicted (MAC_ADDR_ZERO otherwise) for the caller to delete.
+void peerCache_insert(PeerCache* cache, MacAddr mac, MacAddr* evicted);
+
+// Forget mac (registration failed, or ESP-NOW no longer knows it)
+void peerCache_remove(PeerCache* cache, MacAddr mac);
+
+// Least recently used peer (MAC_ADDR_ZERO if empty), the one insert would evict
+MacAddr peerCache_oldest(const PeerCache* cache);
+
+// Forget mac to make room for another peer; counted as an eviction
+void peerCache_evict(PeerCache* cache, MacAddr mac);
+
+#endif // PEER_CACHE_H
@@ -0,0 +1,90 @@
+#include "EspNowPeers.h"
+#include <esp_now.h>
+#include <string.h>
+
+void espNowPeers_init(EspNowPeers* peers) {
+  peerCache_init(&peers->cache);
+  peers->lock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+static esp_err_t espNowPeers_add(const uint8_t* mac, uint8_t channel) {
+  esp_now_peer_info_t peerInfo = {};
+  memcpy(peerInfo.peer_addr, mac, 6);
+  peerInfo.channel = channel;
+  peerInfo.encrypt = false;
+  esp_err_t result = esp_now_add_peer(&peerInfo);
+  return result == ESP_ERR_ESPNOW_EXIST ? ESP_OK : result;
+}
+
+static void espNowPeers_delete(MacAddr addr) {
+  uint8_t mac[6];
+  macAddr_toBytes(addr, mac);
+  esp_now_del_peer(mac);
+}
+
+// ESP_OK once mac is in the driver's peer table, else the driver's error
+static esp_err_t espNowPeers_registerResult(EspNowPeers* peers, const uint8_t* mac, uint8_t channel) {
+  MacAddr addr = macAddr_fromBytes(mac);
+  MacAddr oldest = MAC_ADDR_ZERO;
+  
+  portENTER_CRITICAL(&peers->lock);
+  bool known = peerCache_touch(&peers->cache, addr);
+  if (!known) {
+    oldest = peerCache_oldest(&peers->cache);
+  }
+  portEXIT_CRITICAL(&peers->lock);
+  if (known) return ESP_OK;
+  
+  esp_err_t result = espNowPeers_add(mac, channel);
+  MacAddr evicted = MAC_ADDR_ZERO;
+  if (result == ESP_ERR_ESPNOW_FULL && !macAddr_isZero(oldest)) {
+    // Make room with the least recently used peer; put it back if the add still fails
+    // (on the current channel - the cache does not keep the one it was added with)
+    espNowPeers_delete(oldest);
+    result = espNowPeers_add(mac, channel);
+    if (result == ESP_OK) {
+      evicted = oldest;
+    } else {
+      uint8_t oldestMac[6];
+      macAddr_toBytes(oldest, oldestMac);
+      espNowPeers_add(oldestMac, 0);
+    }
+  }
+  if (result != ESP_OK) return result;
+  
+  MacAddr displaced;
+  portENTER_CRITICAL(&peers->lock);
+  if (!macAddr_isZero(evicted)) {
+    peerCache_evict(&peers->cache, evicted);
+  }
+  peerCache_insert(&peers->cache, addr, &displaced);
+  portEXIT_CRITICAL(&peers->lock);
+  
+  // Cache full while the driver still had room (a peer deleted behind its back)
+  if (!macAddr_isZero(displaced)) {
+    espNowPeers_delete(displaced);
+  }
+  return ESP_OK;
+}
+
+bool espNowPeers_register(EspNowPeers* peers, const uint8_t* mac, uint8_t channel) {
+  return espNowPeers_registerResult(peers, mac, channel) == ESP_OK;
+}
+
+esp_err_t espNowPeers_send(EspNowPeers* peers, const uint8_t* mac, const uint8_t* data, int len) {
+  esp_err_t result = espNowPeers_registerResult(peers, mac, 0);
+  if (result != ESP_OK) return result;
+  
+  result = esp_now_send(mac, data, len);
+  if (result == ESP_ERR_ESPNOW_NOT_FOUND) {
+    // Deleted behind the cache's back - register it again and retry once
+    portENTER_CRITICAL(&peers->lock);
+    peerCache_remove(&peers->cache, macAddr_fromBytes(mac));
+    portEXIT_CRITICAL(&peers->lock);
+    result = espNowPeers_registerResult(peers, mac, 0);
+    if (result == ESP_OK) {
+      result = esp_now_send(mac, data, len);
+    }
+  }
+  return result;
+}
@@ -0,0 +1,29 @@
+#ifndef ESPNOW_PEERS_H
+#define ESPNOW_PEERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include "../domain/PeerCache.h"
+
+// Registered ESP-NOW peers of one transport: the PeerCache, the lock that guards it (receive
+// callbacks register peers from the WiFi task) and the esp_now_* calls that keep the
+// driver's peer table in step with it. A peer is only entered in the cache, and the least
+// recently used one only evicted, once esp_now_add_peer() has accepted the new one - a
+// failed registration leaves every working peer in place.
+typedef struct {
+  PeerCache cache;
+  portMUX_TYPE lock;
+} EspNowPeers;
+
+void espNowPeers_init(EspNowPeers* peers);
+
+// Make sure mac is in the ESP-NOW peer table (channel 0 = current WiFi channel)
+bool espNowPeers_register(EspNowPeers* peers, const uint8_t* mac, uint8_t channel);
+
+// esp_now_send() to mac, registering it first. A peer deleted behind the cache's back is
+// registered again and the send retried once. Returns the driver's result.
+esp_err_t espNowPeers_send(EspNowPeers* peers, const uint8_t* mac, const uint8_t* data, int len);
+
+#endif // ESPNOW_PEERS_H
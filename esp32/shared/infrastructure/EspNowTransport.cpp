@@ -5,6 +5,7 @@
 #include <Arduino.h>
 #include "../messages.h"
 #include "../config.h"
+#include "Scheduler.h"
 
 static MessageReceivedCallback g_receiveCallback = nullptr;
 
@@ -14,6 +15,8 @@ void OnDataRecvWrapper(const esp_now_recv_info_t *info, const uint8_t *data, int
     uint8_t channel = info->rx_ctrl ? info->rx_ctrl->channel : 0;
     g_receiveCallback(senderMAC, data, len, channel);
   }
+  // Handlers only record work for the loop (pending discovery, state flags) - run it now
+  scheduler_wake(g_scheduler);
 }
 
 void espNowTransport_init(EspNowTransport* transport) {
@@ -21,6 +24,8 @@ void espNowTransport_init(EspNowTransport* transport) {
   // ESP-NOW uses the WiFi radio hardware but operates independently
   WiFi.mode(WIFI_STA);
   
+  espNowPeers_init(&transport->peers);
+  
   if (esp_now_init() == ESP_OK) {
     transport->initialized = true;
   } else {
@@ -31,34 +36,14 @@ void espNowTransport_init(EspNowTransport* transport) {
 bool espNowTransport_send(EspNowTransport* transport, const uint8_t* mac, const uint8_t* data, int len) {
   if (!transport->initialized) return false;
   
-  // Ensure peer exists before sending (ESP-NOW requires peer to be added)
-  esp_now_peer_info_t peerInfo;
-  if (esp_now_get_peer(mac, &peerInfo) != ESP_OK) {
-    // Peer doesn't exist - add it with channel 0 (uses current WiFi channel)
-    espNowTransport_addPeer(transport, mac, 0);
-    delay(ESPNOW_PEER_READY_DELAY_MS);
-    
-    // Verify peer was added successfully
-    if (esp_now_get_peer(mac, &peerInfo) != ESP_OK) {
-      return false;
-    }
-  }
-  
-  // Send message (asynchronous - returns ESP_OK if queued successfully)
-  esp_err_t result = esp_now_send(mac, data, len);
+  // Registers the peer first if needed (channel 0 uses the current WiFi channel)
+  esp_err_t result = espNowPeers_send(&transport->peers, mac, data, len);
   return (result == ESP_OK);
 }
 
 bool espNowTransport_addPeer(EspNowTransport* transport, const uint8_t* mac, uint8_t channel) {
   if (!transport->initialized) return false;
-  
-  esp_now_peer_info_t peerInfo = {};
-  memcpy(peerInfo.peer_addr, mac, 6);
-  peerInfo.channel = channel;  // Channel 0 means use current WiFi channel
-  peerInfo.encrypt = false;
-  
-  esp_err_t result = esp_now_add_peer(&peerInfo);
-  return (result == ESP_OK || result == ESP_ERR_ESPNOW_EXIST);
+  return espNowPeers_register(&transport->peers, mac, channel);
 }
 
 void espNowTransport_registerReceiveCallback(EspNowTransport* transport, MessageReceivedCallback callback) {
@@ -73,14 +58,6 @@ void espNowTransport_broadcast(EspNowTransport* transport, const uint8_t* data,
   
   uint8_t broadcastMAC[] = BROADCAST_MAC;
   
-  // Ensure broadcast peer exists
-  esp_now_peer_info_t peerInfo;
-  if (esp_now_get_peer(broadcastMAC, &peerInfo) != ESP_OK) {
-    espNowTransport_addPeer(transport, broadcastMAC, 0);
-    // Small delay to ensure peer is ready
-    delay(5);
-  }
-  
   // Send broadcast (no error checking here - failures are silent to avoid recursion in debug functions)
   espNowTransport_send(transport, broadcastMAC, data, len);
 }
@@ -3,10 +3,15 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <freertos/FreeRTOS.h>
+#include "EspNowPeers.h"
 
 // ESP-NOW transport abstraction
+// Peers are registered on first use and tracked in a cache; the least recently used one is
+// dropped when the ESP-NOW peer table is full, and the send path never sleeps.
 typedef struct {
   bool initialized;
+  EspNowPeers peers;
 } EspNowTransport;
 
 typedef void (*MessageReceivedCallback)(const uint8_t* senderMAC, const uint8_t* data, int len, uint8_t channel);
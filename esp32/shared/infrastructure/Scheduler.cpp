@@ -0,0 +1,135 @@
+#include "Scheduler.h"
+#include <string.h>
+#include "../config.h"
+
+Scheduler* g_scheduler = nullptr;
+
+void scheduler_init(Scheduler* scheduler) {
+  memset(scheduler, 0, sizeof(Scheduler));
+  scheduler->owner = xTaskGetCurrentTaskHandle();
+  scheduler->windowStart = millis();
+}
+
+int scheduler_addTimer(Scheduler* scheduler, SchedulerCallback callback, void* context) {
+  if (scheduler->timerCount >= SCHEDULER_MAX_TIMERS) {
+    return -1;
+  }
+  int timer = scheduler->timerCount++;
+  scheduler->timers[timer].callback = callback;
+  scheduler->timers[timer].context = context;
+  scheduler->timers[timer].armed = false;
+  return timer;
+}
+
+void scheduler_arm(Scheduler* scheduler, int timer, unsigned long deadline) {
+  scheduler_armPeriodic(scheduler, timer, deadline, 0);
+}
+
+void scheduler_armPeriodic(Scheduler* scheduler, int timer, unsigned long firstDeadline, unsigned long periodMs) {
+  if (timer < 0 || timer >= scheduler->timerCount) return;
+  scheduler->timers[timer].deadline = firstDeadline;
+  scheduler->timers[timer].periodMs = periodMs;
+  scheduler->timers[timer].armed = true;
+}
+
+void scheduler_cancel(Scheduler* scheduler, int timer) {
+  if (timer < 0 || timer >= scheduler->timerCount) return;
+  scheduler->timers[timer].armed = false;
+}
+
+bool scheduler_isArmed(const Scheduler* scheduler, int timer) {
+  if (timer < 0 || timer >= scheduler->timerCount) return false;
+  return scheduler->timers[timer].armed;
+}
+
+void scheduler_armIn(Scheduler* scheduler, int timer, unsigned long now, unsigned long delayMs) {
+  if (delayMs == SCHEDULER_NO_DEADLINE) {
+    scheduler_cancel(scheduler, timer);
+  } else {
+    scheduler_arm(scheduler, timer, now + delayMs);
+  }
+}
+
+int scheduler_run(Scheduler* scheduler, unsigned long now) {
+  int run = 0;
+  for (int i = 0; i < scheduler->timerCount; i++) {
+    SchedulerTimer* timer = &scheduler->timers[i];
+    if (!timer->armed || (long)(now - timer->deadline) < 0) continue;
+
+    if (timer->periodMs > 0) {
+      // Skip missed periods instead of running a burst of catch-up callbacks
+      do {
+        timer->deadline += timer->periodMs;
+      } while ((long)(now - timer->deadline) >= 0);
+    } else {
+      timer->armed = false;
+    }
+    // Callback may re-arm or cancel its own timer
+    if (timer->callback) {
+      timer->callback(timer->context, now);
+    }
+    run++;
+  }
+  return run;
+}
+
+unsigned long scheduler_timeUntilNextMs(const Scheduler* scheduler, unsigned long now, unsigned long maxWaitMs) {
+  unsigned long next = maxWaitMs;
+  for (int i = 0; i < scheduler->timerCount; i++) {
+    const SchedulerTimer* timer = &scheduler->timers[i];
+    if (!timer->armed) continue;
+    long remaining = (long)(timer->deadline - now);
+    if (remaining <= 0) {
+      return 0;
+    }
+    if ((unsigned long)remaining < next) {
+      next = (unsigned long)remaining;
+    }
+  }
+  return next;
+}
+
+bool scheduler_sleep(Scheduler* scheduler, unsigned long maxWaitMs) {
+  unsigned long waitMs = scheduler_timeUntilNextMs(scheduler, millis(), maxWaitMs);
+  // Round up so a deadline is not missed by a partial tick
+  TickType_t ticks = (waitMs + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+  bool woken = ulTaskNotifyTake(pdTRUE, ticks) > 0;
+  scheduler_countWakeup(scheduler, millis(), woken);
+  return woken;
+}
+
+void scheduler_wake(Scheduler* scheduler) {
+  if (scheduler && scheduler->owner) {
+    xTaskNotifyGive(scheduler->owner);
+  }
+}
+
+void IRAM_ATTR scheduler_wakeFromISR(Scheduler* scheduler) {
+  if (scheduler && scheduler->owner) {
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(scheduler->owner, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken) {
+      portYIELD_FROM_ISR();
+    }
+  }
+}
+
+void scheduler_countWakeup(Scheduler* scheduler, unsigned long now, bool byEvent) {
+  scheduler->wakeups++;
+  if (byEvent) {
+    scheduler->eventWakeups++;
+  } else {
+    scheduler->timerWakeups++;
+  }
+
+  scheduler->windowWakeups++;
+  if (now - scheduler->windowStart >= SCHEDULER_STATS_WINDOW_MS) {
+    scheduler->lastWindowWakeups = scheduler->windowWakeups;
+    scheduler->windowWakeups = 0;
+    scheduler->windowStart = now;
+  }
+}
+
+uint32_t scheduler_wakeupsPerSecondX10(const Scheduler* scheduler) {
+  return (uint32_t)((uint64_t)scheduler->lastWindowWakeups * 10000 / SCHEDULER_STATS_WINDOW_MS);
+}
@@ -0,0 +1,75 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Deadline queue for the loop task. Modules register timers once and arm them with absolute
+// millis() deadlines; the loop runs the due ones and then sleeps until the earliest deadline
+// or until an ISR / radio callback calls scheduler_wake*(). Also counts loop wakeups so the
+// cost of the loop can be compared across builds.
+
+#define SCHEDULER_MAX_TIMERS 12
+#define SCHEDULER_NO_DEADLINE ULONG_MAX
+
+// Callback may be NULL for timers that only need to wake the loop
+typedef void (*SchedulerCallback)(void* context, unsigned long now);
+
+typedef struct {
+  SchedulerCallback callback;
+  void* context;
+  unsigned long deadline;
+  unsigned long periodMs;  // 0 = one-shot
+  bool armed;
+} SchedulerTimer;
+
+typedef struct {
+  SchedulerTimer timers[SCHEDULER_MAX_TIMERS];
+  int timerCount;
+  TaskHandle_t owner;  // Task that sleeps in scheduler_sleep()
+
+  // Wakeup accounting
+  uint32_t wakeups;          // Total loop passes
+  uint32_t timerWakeups;     // Passes started by a deadline
+  uint32_t eventWakeups;     // Passes started by scheduler_wake*() or an external event
+  unsigned long windowStart;
+  uint32_t windowWakeups;
+  uint32_t lastWindowWakeups;    // Wakeups in the last completed SCHEDULER_STATS_WINDOW_MS
+} Scheduler;
+
+// The loop's scheduler, for ISRs and radio callbacks (NULL until a sketch sets it)
+extern Scheduler* g_scheduler;
+
+// Call from the task that will sleep in scheduler_sleep()
+void scheduler_init(Scheduler* scheduler);
+
+// Returns a timer id, or -1 if SCHEDULER_MAX_TIMERS are in use
+int scheduler_addTimer(Scheduler* scheduler, SchedulerCallback callback, void* context);
+void scheduler_arm(Scheduler* scheduler, int timer, unsigned long deadline);
+void scheduler_armPeriodic(Scheduler* scheduler, int timer, unsigned long firstDeadline, unsigned long periodMs);
+void scheduler_cancel(Scheduler* scheduler, int timer);
+bool scheduler_isArmed(const Scheduler* scheduler, int timer);
+// Arm at now + delayMs, or cancel for SCHEDULER_NO_DEADLINE - for modules that report a
+// time-until-next-work
+void scheduler_armIn(Scheduler* scheduler, int timer, unsigned long now, unsigned long delayMs);
+
+// Run every due timer (periodic ones are re-armed); returns the number run
+int scheduler_run(Scheduler* scheduler, unsigned long now);
+// Milliseconds until the earliest armed deadline, at most maxWaitMs
+unsigned long scheduler_timeUntilNextMs(const Scheduler* scheduler, unsigned long now, unsigned long maxWaitMs);
+
+// Block until the earliest deadline (at most maxWaitMs) or a wake. Returns true if woken.
+bool scheduler_sleep(Scheduler* scheduler, unsigned long maxWaitMs);
+void scheduler_wake(Scheduler* scheduler);
+void IRAM_ATTR scheduler_wakeFromISR(Scheduler* scheduler);
+
+// For loops that block on something else (e.g. a queue): record one pass
+void scheduler_countWakeup(Scheduler* scheduler, unsigned long now, bool byEvent);
+// Wakeups per second over the last completed window, in tenths
+uint32_t scheduler_wakeupsPerSecondX10(const Scheduler* scheduler);
+
+#endif // SCHEDULER_H
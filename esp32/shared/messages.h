@@ -15,10 +15,15 @@
 #define MSG_PAIRING_CONFIRMED  0x07
 #define MSG_PAIRING_CONFIRMED_ACK 0x09
 #define MSG_DELETE_RECORD      0x08
+#define MSG_KEEPALIVE          0x0A
+#define MSG_PEDAL_EVENT_TIMED  0x0B
+#define MSG_EXPRESSION_VALUE   0x0C
+#define MSG_EXPRESSION_DELTA   0x0D
 
 // Debug/monitoring (0x50-0x5F)
 #define MSG_DEBUG              0x50
 #define MSG_DEBUG_MONITOR_REQ  0x51
+#define MSG_FLIGHT_LOG_REQ     0x52
 
 // Common message structure (must match between transmitter and receiver)
 typedef struct __attribute__((packed)) struct_message {
@@ -28,6 +33,49 @@ typedef struct __attribute__((packed)) struct_message {
   uint8_t pedalMode; // 0=DUAL, 1=SINGLE
 } struct_message;
 
+// Set in struct_message.pedalMode of MSG_PEDAL_EVENT by transmitters that send
+// MSG_KEEPALIVE while a pedal is held (the receiver only enforces held-key leases for them)
+#define PEDAL_EVENT_FLAG_KEEPALIVE 0x80
+
+// Pedal event with the time of the pin edge that caused it. Starts with the same fields as
+// struct_message; edgeUs is the transmitter's esp_timer clock (low 32 bits) captured in the
+// pedal ISR, so the receiver can reproduce press/release spacing whatever the radio did.
+typedef struct __attribute__((packed)) timed_pedal_message {
+  uint8_t msgType;        // 0x0B = MSG_PEDAL_EVENT_TIMED
+  char key;
+  bool pressed;
+  uint8_t pedalMode;      // As in struct_message, including PEDAL_EVENT_FLAG_KEEPALIVE
+  uint32_t edgeUs;
+} timed_pedal_message;
+
+// Expression (continuous) pedal stream. inputSeq packs the expression input number (low
+// nibble) and a per-input frame sequence (high nibble). A value frame carries the absolute
+// position; a delta frame the change since the previous frame, applied by the receiver
+// only if no frame was missed in between. See shared/domain/ExpressionCodec.h.
+#define EXPRESSION_INPUT_SEQ(input, sequence) ((uint8_t)(((sequence) << 4) | ((input) & 0x0F)))
+#define EXPRESSION_INPUT(inputSeq) ((inputSeq) & 0x0F)
+#define EXPRESSION_SEQUENCE(inputSeq) ((inputSeq) >> 4)
+
+typedef struct __attribute__((packed)) expression_value_message {
+  uint8_t msgType;        // 0x0C = MSG_EXPRESSION_VALUE
+  uint8_t inputSeq;
+  uint16_t value;         // 0 .. (1 << resolutionBits) - 1
+  uint8_t resolutionBits;
+} expression_value_message;
+
+typedef struct __attribute__((packed)) expression_delta_message {
+  uint8_t msgType;        // 0x0D = MSG_EXPRESSION_DELTA
+  uint8_t inputSeq;
+  int8_t delta;
+} expression_delta_message;
+
+// Keepalive sent periodically while at least one pedal is held
+typedef struct __attribute__((packed)) keepalive_message {
+  uint8_t msgType;        // 0x0A = MSG_KEEPALIVE
+  uint8_t heldMask;       // Bit 0 = pedal '1', bit 1 = pedal '2'
+  uint8_t reserved[2];
+} keepalive_message;
+
 // Beacon message structure
 typedef struct __attribute__((packed)) beacon_message {
   uint8_t msgType;        // 0x04 = MSG_BEACON
@@ -61,6 +109,18 @@ typedef struct __attribute__((packed)) pairing_confirmed_ack_message {
   uint8_t receiverMAC[6];  // Echo receiver's MAC to confirm
 } pairing_confirmed_ack_message;
 
+// Debug monitor discovery request structure (debug monitor asks receiver to pair with it)
+typedef struct __attribute__((packed)) debug_monitor_req_message {
+  uint8_t msgType;        // 0x51 = MSG_DEBUG_MONITOR_REQ
+  uint8_t reserved[3];
+} debug_monitor_req_message;
+
+// Flight log dump request (debug monitor asks receiver to send its flight recorder log)
+typedef struct __attribute__((packed)) flight_log_req_message {
+  uint8_t msgType;        // 0x52 = MSG_FLIGHT_LOG_REQ
+  uint8_t reserved[3];
+} flight_log_req_message;
+
 // Debug message structure
 typedef struct __attribute__((packed)) debug_message {
   uint8_t msgType;        // 0x50 = MSG_DEBUG
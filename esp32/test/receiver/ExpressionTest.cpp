@@ -0,0 +1,272 @@
+// Expression pedal stream (user-022): the transmitter's encoder against the receiver's
+// joystick axes. Checks the frame types and rest behaviour, axis assignment per
+// transmitter input, recovery after lost frames, the bounded rate at which frames go on to
+// renew the liveness lease, and prints frames per second, bytes per
+// second and tracking error against resolution and deadband for a simulated minute of
+// playing (idle, a slow swell, fast rocking) with ADC noise.
+#include "HostTest.h"
+#include <math.h>
+#include <random>
+#include <vector>
+#include "receiver/domain/MacIndex.cpp"
+#include "receiver/domain/SlotAllocator.cpp"
+#include "receiver/domain/TransmitterManager.cpp"
+#include "receiver/domain/KeyBindings.cpp"
+#include "shared/domain/ExpressionCodec.cpp"
+#include "receiver/application/ExpressionAxes.cpp"
+
+// Joystick: reports the HID output task would send
+static std::vector<HidGamepadReport> gamepadReports;
+
+void hidGamepad_begin() {}
+bool hidGamepad_send(const HidGamepadReport* report) {
+  gamepadReports.push_back(*report);
+  return true;
+}
+
+static const uint8_t MAC_A[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0A};
+static const uint8_t MAC_B[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0B};
+static const uint8_t MAC_UNPAIRED[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0F};
+
+static TransmitterManager manager;
+static KeyBindings bindings;
+static ExpressionAxes axes;
+
+static void setUp() {
+  transmitterManager_init(&manager);
+  keyBindings_init(&bindings);
+  transmitterManager_place(&manager, MAC_A, PEDAL_MODE_SINGLE);
+  transmitterManager_place(&manager, MAC_B, PEDAL_MODE_SINGLE);
+  keyBindings_refresh(&bindings, &manager);
+  expressionAxes_init(&axes, &bindings);
+  gamepadReports.clear();
+}
+
+// Raw 12-bit sample for a position 0..1
+static uint16_t rawFor(double position) {
+  return (uint16_t)lround(position * ((1 << EXPRESSION_ADC_BITS) - 1));
+}
+
+static void test_valueFrameFirstThenDeltas() {
+  ExpressionEncoder encoder;
+  expressionEncoder_init(&encoder, 0, 10, 2);
+  uint8_t frame[EXPRESSION_MAX_FRAME_LEN];
+
+  CHECK_EQ(expressionEncoder_sample(&encoder, rawFor(0.5), 0, frame), sizeof(expression_value_message));
+  CHECK_EQ(frame[0], MSG_EXPRESSION_VALUE);
+  CHECK_EQ(expressionEncoder_sample(&encoder, rawFor(0.5), 5, frame), 0);  // Inside the deadband
+
+  // A slow move goes out as deltas
+  int deltas = 0, values = 0;
+  for (int i = 1; i <= 40; i++) {
+    int len = expressionEncoder_sample(&encoder, rawFor(0.5 + i * 0.002), 5 + i * 5, frame);
+    if (len == (int)sizeof(expression_delta_message)) deltas++;
+    if (len == (int)sizeof(expression_value_message)) values++;
+  }
+  CHECK(deltas > 10);
+  CHECK_EQ(values, 0);
+
+  // A keyframe request (e.g. a new receiver) forces a value frame
+  expressionEncoder_requestKeyframe(&encoder);
+  CHECK_EQ(expressionEncoder_sample(&encoder, rawFor(0.58), 300, frame), sizeof(expression_value_message));
+}
+
+static void test_restSendsOnlyRefreshFrames() {
+  ExpressionEncoder encoder;
+  expressionEncoder_init(&encoder, 0, EXPRESSION_RESOLUTION_BITS, EXPRESSION_DEADBAND);
+  uint8_t frame[EXPRESSION_MAX_FRAME_LEN];
+  const uint32_t periodMs = 1000 / EXPRESSION_SAMPLE_HZ;
+  int frames = 0;
+  for (uint32_t ms = 0; ms < 10000; ms += periodMs) {
+    if (expressionEncoder_sample(&encoder, rawFor(0.3), ms, frame)) frames++;
+  }
+  // First value frame, the settle frame, then one refresh per EXPRESSION_REFRESH_MS
+  CHECK(frames >= 10 && frames <= 12);
+  CHECK_EQ(encoder.deltaFrames, 0);
+}
+
+static void test_axesFollowEachTransmitter() {
+  setUp();
+  ExpressionEncoder a, b, b2;
+  expressionEncoder_init(&a, 0, 10, 2);
+  expressionEncoder_init(&b, 0, 10, 2);
+  expressionEncoder_init(&b2, 1, 10, 2);
+  uint8_t frame[EXPRESSION_MAX_FRAME_LEN];
+
+  int len = expressionEncoder_sample(&b, rawFor(0.25), 0, frame);
+  CHECK(expressionAxes_handleFrame(&axes, macAddr_fromBytes(MAC_B), frame, len));
+  len = expressionEncoder_sample(&a, rawFor(1.0), 0, frame);
+  CHECK(expressionAxes_handleFrame(&axes, macAddr_fromBytes(MAC_A), frame, len));
+  len = expressionEncoder_sample(&b2, rawFor(0.5), 0, frame);
+  CHECK(expressionAxes_handleFrame(&axes, macAddr_fromBytes(MAC_B), frame, len));
+  CHECK_EQ(axes.count, 3);
+
+  // One report carries every axis that moved since the last one
+  CHECK(expressionAxes_flush(&axes));
+  CHECK(!expressionAxes_flush(&axes));
+  CHECK_EQ(gamepadReports.size(), 1);
+  const HidGamepadReport& report = gamepadReports.back();
+  CHECK(abs((int)report.axes[0] - EXPRESSION_AXIS_MAX / 4) < 40);  // First to send: X
+  CHECK_EQ(report.axes[1], EXPRESSION_AXIS_MAX);
+  CHECK(abs((int)report.axes[2] - EXPRESSION_AXIS_MAX / 2) < 40);
+
+  // Unpaired transmitters and a fifth input get no axis
+  ExpressionEncoder other;
+  expressionEncoder_init(&other, 2, 10, 2);
+  len = expressionEncoder_sample(&other, rawFor(0.5), 0, frame);
+  CHECK(!expressionAxes_handleFrame(&axes, macAddr_fromBytes(MAC_UNPAIRED), frame, len));
+  CHECK(expressionAxes_handleFrame(&axes, macAddr_fromBytes(MAC_A), frame, len));  // Rx
+  ExpressionEncoder fifth;
+  expressionEncoder_init(&fifth, 3, 10, 2);
+  len = expressionEncoder_sample(&fifth, rawFor(0.5), 0, frame);
+  CHECK(!expressionAxes_handleFrame(&axes, macAddr_fromBytes(MAC_A), frame, len));
+  CHECK_EQ(axes.count, HID_GAMEPAD_AXES);
+  CHECK_EQ(axes.unassigned, 2);
+}
+
+// A pedal rocked at the full sample rate reaches the housekeeping task once per
+// EXPRESSION_LEASE_FORWARD_MS per transmitter, starting with its first frame - also across
+// the millis() wrap
+static void test_leaseForwardedAtBoundedRate() {
+  setUp();
+  MacAddr a = macAddr_fromBytes(MAC_A);
+  MacAddr b = macAddr_fromBytes(MAC_B);
+  const uint32_t periodMs = 1000 / EXPRESSION_SAMPLE_HZ;
+  const uint32_t startMs = UINT32_MAX - 4000;
+  int forwardedA = 0, forwardedB = 0;
+  for (uint32_t elapsed = 0; elapsed < 10 * EXPRESSION_LEASE_FORWARD_MS; elapsed += periodMs) {
+    if (expressionAxes_forwardsLease(&axes, a, startMs + elapsed)) forwardedA++;
+    if (expressionAxes_forwardsLease(&axes, b, startMs + elapsed)) forwardedB++;
+    CHECK(!expressionAxes_forwardsLease(&axes, macAddr_fromBytes(MAC_UNPAIRED), startMs + elapsed));
+    if (elapsed == 0) {
+      CHECK_EQ(forwardedA, 1);
+      CHECK_EQ(forwardedB, 1);
+    }
+  }
+  CHECK_EQ(forwardedA, 10);
+  CHECK_EQ(forwardedB, 10);
+}
+
+// Deltas keep being applied across a lost frame; the value frame sent when the pedal comes
+// to rest puts the axis back on the exact position
+static void test_lostFramesConvergeAtRest() {
+  setUp();
+  ExpressionEncoder encoder;
+  expressionEncoder_init(&encoder, 0, EXPRESSION_RESOLUTION_BITS, EXPRESSION_DEADBAND);
+  uint8_t frame[EXPRESSION_MAX_FRAME_LEN];
+  const uint32_t periodMs = 1000 / EXPRESSION_SAMPLE_HZ;
+  int sent = 0;
+  uint32_t ms = 0;
+  for (; ms < 2000; ms += periodMs) {
+    double position = 0.5 + 0.4 * sin(ms / 1000.0 * 2 * M_PI);
+    int len = expressionEncoder_sample(&encoder, rawFor(position), ms, frame);
+    if (len && ++sent % 7 != 0) {  // Every 7th frame is lost
+      expressionAxes_handleFrame(&axes, macAddr_fromBytes(MAC_A), frame, len);
+    }
+  }
+  const ExpressionDecoder* decoder = &axes.axes[0].decoder;
+  CHECK(decoder->missed > 0);
+
+  uint32_t restStart = ms;
+  for (; ms < restStart + EXPRESSION_SETTLE_MS + 100; ms += periodMs) {
+    int len = expressionEncoder_sample(&encoder, rawFor(0.5), ms, frame);
+    if (len) expressionAxes_handleFrame(&axes, macAddr_fromBytes(MAC_A), frame, len);
+  }
+  CHECK(!decoder->drifting);
+  CHECK_EQ(decoder->value, encoder.sent);
+}
+
+// 60 s at EXPRESSION_SAMPLE_HZ: idle, an 8 s swell and 1.5 Hz rocking, twice
+static double pedalPosition(double t) {
+  double p = fmod(t, 30.0);
+  if (p < 8) return 0.2;
+  if (p < 16) return 0.2 + 0.7 * 0.5 * (1 - cos((p - 8) / 8 * 2 * M_PI));
+  if (p < 20) return 0.2 + 0.35 * (1 - cos((p - 16) * 2 * M_PI * 1.5));
+  return 0.2;
+}
+
+struct StreamStats {
+  double framesPerSecond;
+  double restFramesPerSecond;
+  double movingFramesPerSecond;
+  double bytesPerSecond;
+  double meanErrorPercent;
+  double maxErrorPercent;
+  double restErrorPercent;
+};
+
+static StreamStats simulate(int bits, int deadband, double noiseLsb, double loss) {
+  std::mt19937 rng(1);
+  std::normal_distribution<double> noise(0, noiseLsb);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  ExpressionEncoder encoder;
+  ExpressionDecoder decoder;
+  expressionEncoder_init(&encoder, 0, bits, deadband);
+  expressionDecoder_init(&decoder);
+  uint8_t frame[EXPRESSION_MAX_FRAME_LEN];
+
+  long frames = 0, restFrames = 0, movingFrames = 0, bytes = 0, samples = 0, restSamples = 0;
+  double restTime = 0, movingTime = 0, errorSum = 0, errorMax = 0, restErrorSum = 0;
+  const double dt = 1.0 / EXPRESSION_SAMPLE_HZ;
+  for (int i = 0; i < 60 * EXPRESSION_SAMPLE_HZ; i++) {
+    double t = i * dt;
+    double position = pedalPosition(t);
+    bool resting = pedalPosition(t + 0.2) == position && pedalPosition(t - 0.2) == position;
+    long raw = lround(position * 4095 + noise(rng));
+    raw = raw < 0 ? 0 : (raw > 4095 ? 4095 : raw);
+    int len = expressionEncoder_sample(&encoder, (uint16_t)raw, (uint32_t)(t * 1000), frame);
+    (resting ? restTime : movingTime) += dt;
+    if (len) {
+      frames++;
+      bytes += len;
+      (resting ? restFrames : movingFrames)++;
+      if (uniform(rng) >= loss) expressionDecoder_apply(&decoder, frame, len);
+    }
+    double error = fabs(expressionDecoder_axis(&decoder) / (double)EXPRESSION_AXIS_MAX - position) * 100;
+    if (t > 1) {
+      errorSum += error;
+      samples++;
+      if (error > errorMax) errorMax = error;
+    }
+    if (resting && fmod(t, 30.0) > 7) {
+      restErrorSum += error;
+      restSamples++;
+    }
+  }
+  return {frames / 60.0, restFrames / restTime, movingFrames / movingTime, bytes / 60.0,
+          errorSum / samples, errorMax, restErrorSum / restSamples};
+}
+
+static void bench_framesPerSecondByResolution() {
+  printf("  bits deadband | frames/s  at rest  moving | bytes/s | mean err  max err  rest err\n");
+  const int configs[][2] = {{6, 1}, {8, 1}, {10, 1}, {10, 2}, {12, 2}};
+  for (const auto& config : configs) {
+    StreamStats stats = simulate(config[0], config[1], 6, 0);
+    printf("  %4d %8d | %8.1f %8.1f %7.1f | %7.0f | %7.2f%% %7.2f%% %8.2f%%\n", config[0], config[1],
+           stats.framesPerSecond, stats.restFramesPerSecond, stats.movingFramesPerSecond,
+           stats.bytesPerSecond, stats.meanErrorPercent, stats.maxErrorPercent, stats.restErrorPercent);
+  }
+
+  // Defaults: a fraction of raw 200 Hz streaming, about one frame a second at rest
+  StreamStats defaults = simulate(EXPRESSION_RESOLUTION_BITS, EXPRESSION_DEADBAND, 6, 0);
+  CHECK(defaults.framesPerSecond < EXPRESSION_SAMPLE_HZ / 3);
+  CHECK(defaults.restFramesPerSecond < 1.5);
+  CHECK(defaults.meanErrorPercent < 1.0);
+
+  StreamStats lossy = simulate(EXPRESSION_RESOLUTION_BITS, EXPRESSION_DEADBAND, 6, 0.05);
+  printf("  %d bits, deadband %d, 5%% loss: mean err %.2f%%, max err %.2f%%, rest err %.2f%%\n",
+         EXPRESSION_RESOLUTION_BITS, EXPRESSION_DEADBAND, lossy.meanErrorPercent, lossy.maxErrorPercent,
+         lossy.restErrorPercent);
+  CHECK(lossy.meanErrorPercent < 1.5);
+  CHECK(lossy.restErrorPercent < 0.2);
+}
+
+int main() {
+  RUN_TEST(test_valueFrameFirstThenDeltas);
+  RUN_TEST(test_restSendsOnlyRefreshFrames);
+  RUN_TEST(test_axesFollowEachTransmitter);
+  RUN_TEST(test_leaseForwardedAtBoundedRate);
+  RUN_TEST(test_lostFramesConvergeAtRest);
+  RUN_TEST(bench_framesPerSecondByResolution);
+  return hostTest_finish();
+}
@@ -0,0 +1,365 @@
+// Flight recorder against a simulated NOR flash (user-016): erase sets a sector to 0xFF and
+// programming can only clear bits, so any byte written twice without an erase is counted.
+// Covers formatting blank flash, page batching and the flush timeout, remounting after the
+// last record, wrap-around with even sector wear, recovery from a torn sector header, stage
+// overflow, and decoding the "FLT" dump lines back into the logged events. Also writes a
+// dump capture and a raw image that CMake feeds to tools/flightlog_decode.py.
+#include "HostTest.h"
+#include <string>
+#include <vector>
+#include "receiver/infrastructure/FlightRecorder.cpp"
+
+// Telemetry.cpp needs the USB CDC stack; the recorder only forwards its live copy there
+Telemetry* g_telemetry = nullptr;
+void telemetry_event(Telemetry*, uint8_t, uint8_t, uint8_t, uint8_t, uint32_t) {}
+
+struct SimFlash {
+  std::vector<uint8_t> bytes;
+  std::vector<int> erases;  // Per sector
+  int reprogrammed = 0;     // Bytes programmed while not erased
+  int tearNextWrite = -1;   // >= 0: the next write programs only this many bytes, then fails
+};
+
+static bool simRead(void* context, uint32_t offset, void* buffer, uint32_t len) {
+  SimFlash* flash = (SimFlash*)context;
+  if (offset + len > flash->bytes.size()) return false;
+  memcpy(buffer, &flash->bytes[offset], len);
+  return true;
+}
+
+static bool simWrite(void* context, uint32_t offset, const void* data, uint32_t len) {
+  SimFlash* flash = (SimFlash*)context;
+  if (offset + len > flash->bytes.size()) return false;
+  bool torn = flash->tearNextWrite >= 0;
+  if (torn) {
+    len = std::min<uint32_t>(len, (uint32_t)flash->tearNextWrite);
+    flash->tearNextWrite = -1;
+  }
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (uint32_t i = 0; i < len; i++) {
+    if (flash->bytes[offset + i] != 0xFF) flash->reprogrammed++;
+    flash->bytes[offset + i] &= bytes[i];
+  }
+  return !torn;
+}
+
+static bool simErase(void* context, uint32_t offset) {
+  SimFlash* flash = (SimFlash*)context;
+  if (offset % FLIGHT_RECORDER_SECTOR_SIZE != 0 || offset >= flash->bytes.size()) return false;
+  memset(&flash->bytes[offset], 0xFF, FLIGHT_RECORDER_SECTOR_SIZE);
+  flash->erases[offset / FLIGHT_RECORDER_SECTOR_SIZE]++;
+  return true;
+}
+
+static SimFlash sim;
+static FlightRecorderFlash simBackend;
+static FlightRecorder recorder;
+
+static void blankFlash(int sectors) {
+  sim = SimFlash();
+  sim.bytes.assign((size_t)sectors * FLIGHT_RECORDER_SECTOR_SIZE, 0xFF);
+  sim.erases.assign(sectors, 0);
+  simBackend = {&sim, (uint32_t)sim.bytes.size(), simRead, simWrite, simErase};
+  hostClock_setUs(0);
+}
+
+// Pedal events numbered by value, 1 ms apart
+static uint32_t nextValue;
+
+static void logPedals(int count) {
+  for (int i = 0; i < count; i++) {
+    hostClock_advanceMs(1);
+    flightRecorder_log(&recorder, FLIGHT_EVENT_PEDAL, 0, 'l', (uint8_t)(nextValue & 1), nextValue);
+    nextValue++;
+  }
+}
+
+// Log in batches the stage can hold, flushing between them
+static void logAndFlush(int count) {
+  while (count > 0) {
+    int batch = std::min(count, FLIGHT_RECORDER_STAGE_CAPACITY / 2);
+    logPedals(batch);
+    flightRecorder_flush(&recorder);
+    count -= batch;
+  }
+}
+
+static std::vector<std::string> dumpLines() {
+  std::vector<std::string> lines;
+  char line[160];
+  flightRecorder_beginDump(&recorder);
+  while (flightRecorder_dumpNext(&recorder, line, sizeof(line))) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+// Same rule as records_from_dump() in tools/flightlog_decode.py: "FLT " followed by hex only
+static std::vector<FlightEvent> decodeDump(const std::vector<std::string>& lines) {
+  std::vector<uint8_t> data;
+  for (const std::string& line : lines) {
+    if (line.compare(0, 4, "FLT ") != 0) continue;
+    std::string hex = line.substr(4);
+    if (hex.empty() || hex.size() % 2 != 0 ||
+        hex.find_first_not_of("0123456789ABCDEFabcdef") != std::string::npos) {
+      continue;
+    }
+    for (size_t i = 0; i < hex.size(); i += 2) {
+      data.push_back((uint8_t)strtoul(hex.substr(i, 2).c_str(), nullptr, 16));
+    }
+  }
+  std::vector<FlightEvent> events(data.size() / FLIGHT_RECORD_SIZE);
+  if (!events.empty()) memcpy(events.data(), data.data(), events.size() * FLIGHT_RECORD_SIZE);
+  return events;
+}
+
+static std::vector<FlightEvent> dumpEvents() {
+  return decodeDump(dumpLines());
+}
+
+static int countType(const std::vector<FlightEvent>& events, uint8_t type) {
+  int count = 0;
+  for (const FlightEvent& event : events) {
+    if (event.type == type) count++;
+  }
+  return count;
+}
+
+// Pedal values must run first, first + 1, ... with nothing missing or repeated
+static bool pedalsConsecutive(const std::vector<FlightEvent>& events, uint32_t first, uint32_t last) {
+  uint32_t expected = first;
+  for (const FlightEvent& event : events) {
+    if (event.type != FLIGHT_EVENT_PEDAL) continue;
+    if (event.value != expected) return false;
+    expected++;
+  }
+  return expected == last + 1;
+}
+
+static void mountBlank(int sectors) {
+  blankFlash(sectors);
+  nextValue = 0;
+  CHECK(flightRecorder_mount(&recorder, &simBackend));
+}
+
+static void test_formatsBlankFlash() {
+  blankFlash(1);
+  CHECK(!flightRecorder_mount(&recorder, &simBackend));  // Needs a sector to erase ahead
+
+  mountBlank(4);
+  CHECK_EQ(recorder.sectorCount, 4);
+  CHECK_EQ(recorder.headSector, 0);
+  CHECK_EQ(recorder.headSequence, 1);
+  CHECK_EQ(recorder.sectorsErased, 1);
+  CHECK_EQ(sim.erases[0], 1);
+
+  FlightSectorHeader header;
+  memcpy(&header, sim.bytes.data(), sizeof(header));
+  CHECK_EQ(header.magic, FLIGHT_RECORDER_MAGIC);
+  CHECK_EQ(header.sequence, 1);
+  CHECK_EQ(header.check, ~1u);
+
+  CHECK_EQ(recorder.logged, 1);  // BOOT, staged until the first flush
+  CHECK_EQ(flightRecorder_flush(&recorder), 1);
+  std::vector<FlightEvent> events = dumpEvents();
+  CHECK_EQ(events.size(), 1);
+  CHECK_EQ(events[0].type, FLIGHT_EVENT_BOOT);
+  CHECK_EQ(events[0].value, 1);
+}
+
+static void test_waitsForFullPageOrTimeout() {
+  mountBlank(4);
+  logPedals(5);
+  unsigned long now = millis();
+  CHECK_EQ(flightRecorder_update(&recorder, now), 0);
+  CHECK(flightRecorder_timeUntilFlushMs(&recorder, now) > 0);
+  CHECK_EQ(recorder.pagesWritten, 0);
+
+  // BOOT was staged at time 0, so the timeout counts from there
+  hostClock_setUs((int64_t)FLIGHT_RECORDER_FLUSH_MS * 1000);
+  CHECK_EQ(flightRecorder_timeUntilFlushMs(&recorder, millis()), 0);
+  CHECK_EQ(flightRecorder_update(&recorder, millis()), 6);
+  CHECK_EQ(recorder.pagesWritten, 1);
+
+  logPedals(FLIGHT_RECORDS_PER_PAGE);  // A full page goes out at once
+  CHECK_EQ(flightRecorder_timeUntilFlushMs(&recorder, millis()), 0);
+  CHECK_EQ(flightRecorder_update(&recorder, millis()), FLIGHT_RECORDS_PER_PAGE);
+  CHECK_EQ(recorder.pagesWritten, 2);
+  CHECK_EQ(flightRecorder_timeUntilFlushMs(&recorder, millis()), ULONG_MAX);
+  CHECK_EQ(sim.reprogrammed, 0);
+}
+
+static void test_remountAppendsAfterLastRecord() {
+  mountBlank(4);
+  logAndFlush(40);
+  CHECK_EQ(recorder.writeRecord, 42);  // Header, BOOT, 40 pedals
+
+  CHECK(flightRecorder_mount(&recorder, &simBackend));
+  CHECK_EQ(recorder.headSector, 0);
+  CHECK_EQ(recorder.writeRecord, 42);
+  CHECK_EQ(recorder.sectorsErased, 0);
+  logAndFlush(3);
+
+  std::vector<FlightEvent> events = dumpEvents();
+  CHECK_EQ(events.size(), 45);
+  CHECK_EQ(countType(events, FLIGHT_EVENT_BOOT), 2);
+  CHECK_EQ(events[41].type, FLIGHT_EVENT_BOOT);
+  CHECK(pedalsConsecutive(events, 0, 42));
+  CHECK_EQ(sim.reprogrammed, 0);
+}
+
+static void test_wrapsAroundAndWearsEvenly() {
+  const int sectors = 4;
+  const int laps = 10;
+  mountBlank(sectors);
+  logAndFlush(laps * sectors * (FLIGHT_RECORDS_PER_SECTOR - 1) + 100);
+
+  int fewest = sim.erases[0], most = sim.erases[0];
+  for (int erases : sim.erases) {
+    fewest = std::min(fewest, erases);
+    most = std::max(most, erases);
+  }
+  CHECK(fewest >= laps);
+  CHECK(most - fewest <= 1);
+  CHECK_EQ(recorder.sectorsErased, laps * sectors + 1);
+  CHECK_EQ(sim.reprogrammed, 0);
+  CHECK_EQ(recorder.flashErrors, 0);
+
+  // The dump starts at the oldest surviving sector and ends with the newest record
+  std::vector<FlightEvent> events = dumpEvents();
+  int expected = (sectors - 1) * (FLIGHT_RECORDS_PER_SECTOR - 1) + recorder.writeRecord - 1;
+  CHECK_EQ(events.size(), expected);
+  CHECK_EQ(countType(events, FLIGHT_EVENT_BOOT), 0);  // Overwritten laps ago
+  CHECK(pedalsConsecutive(events, nextValue - expected, nextValue - 1));
+  for (size_t i = 1; i < events.size(); i++) {
+    CHECK(events[i].timeUs > events[i - 1].timeUs);
+  }
+}
+
+static void test_tornHeaderIsIgnoredAndReused() {
+  mountBlank(4);
+  logAndFlush(FLIGHT_RECORDS_PER_SECTOR - 2);  // BOOT + these fill sector 0
+  CHECK_EQ(recorder.writeRecord, FLIGHT_RECORDS_PER_SECTOR);
+
+  // Power fails while sector 1's header is programmed: magic and sequence land, check does not
+  logPedals(1);
+  sim.tearNextWrite = 8;
+  CHECK_EQ(flightRecorder_flush(&recorder), 0);
+  CHECK_EQ(recorder.flashErrors, 1);
+  CHECK_EQ(sim.erases[1], 1);
+
+  CHECK(flightRecorder_mount(&recorder, &simBackend));
+  CHECK_EQ(recorder.headSector, 0);  // Sector 1 has no valid header
+  CHECK_EQ(recorder.headSequence, 1);
+  CHECK_EQ(recorder.writeRecord, FLIGHT_RECORDS_PER_SECTOR);
+  CHECK_EQ(flightRecorder_flush(&recorder), 1);  // The new BOOT reopens sector 1
+  CHECK_EQ(recorder.headSector, 1);
+  CHECK_EQ(recorder.headSequence, 2);
+  CHECK_EQ(sim.erases[1], 2);
+  CHECK_EQ(sim.reprogrammed, 0);
+
+  std::vector<FlightEvent> events = dumpEvents();
+  CHECK_EQ(events.size(), FLIGHT_RECORDS_PER_SECTOR);  // The staged pedal died with the reset
+  CHECK_EQ(countType(events, FLIGHT_EVENT_BOOT), 2);
+  CHECK_EQ(events.back().type, FLIGHT_EVENT_BOOT);
+  CHECK(pedalsConsecutive(events, 0, FLIGHT_RECORDS_PER_SECTOR - 3));
+}
+
+static void test_fullStageDropsNewest() {
+  mountBlank(4);
+  logPedals(FLIGHT_RECORDER_STAGE_CAPACITY + 4);  // BOOT holds one slot
+  CHECK_EQ(recorder.logged, FLIGHT_RECORDER_STAGE_CAPACITY);
+  CHECK_EQ(recorder.dropped, 5);
+  CHECK_EQ(flightRecorder_flush(&recorder), FLIGHT_RECORDER_STAGE_CAPACITY);
+  CHECK_EQ(recorder.pagesWritten, FLIGHT_RECORDER_STAGE_CAPACITY / FLIGHT_RECORDS_PER_PAGE);
+
+  std::vector<FlightEvent> events = dumpEvents();
+  CHECK(pedalsConsecutive(events, 0, FLIGHT_RECORDER_STAGE_CAPACITY - 2));
+}
+
+static void test_dumpLinesDecodeToLoggedEvents() {
+  FlightRecorder unmounted;
+  memset(&unmounted, 0, sizeof(unmounted));
+  char line[160];
+  flightRecorder_beginDump(&unmounted);
+  CHECK(!flightRecorder_dumpNext(&unmounted, line, sizeof(line)));
+
+  mountBlank(4);
+  hostClock_advanceUs(123456);
+  flightRecorder_log(&recorder, FLIGHT_EVENT_PAIRING, 2, 3, 4, 0);
+  flightRecorder_log(&recorder, FLIGHT_EVENT_SEND_FAILED, 0x42, 0x0B, 0, 0xA1B2C3D4u);
+  flightRecorder_log(&recorder, FLIGHT_EVENT_GESTURE, 2, 'l', ' ', 400);
+  logAndFlush(FLIGHT_RECORDS_PER_SECTOR);  // Crosses into sector 1
+
+  std::vector<std::string> lines = dumpLines();
+  int total = 4 + FLIGHT_RECORDS_PER_SECTOR;
+  CHECK_EQ(lines.size(), 1 + (total + FLIGHT_RECORDS_PER_DUMP_LINE - 1) / FLIGHT_RECORDS_PER_DUMP_LINE + 1);
+  CHECK(lines.front() == "FLT BEGIN v1 4 sector(s)");
+  CHECK(lines.back() == "FLT END " + std::to_string(total) + " record(s)");
+  CHECK(!flightRecorder_dumpNext(&recorder, line, sizeof(line)));
+
+  std::vector<FlightEvent> events = decodeDump(lines);
+  CHECK_EQ(events.size(), total);
+  CHECK_EQ(events[0].type, FLIGHT_EVENT_BOOT);
+  CHECK_EQ(events[0].timeUs, 0);
+  CHECK_EQ(events[1].type, FLIGHT_EVENT_PAIRING);
+  CHECK_EQ(events[1].timeUs, 123456);
+  CHECK_EQ(events[1].a, 2);
+  CHECK_EQ(events[1].b, 3);
+  CHECK_EQ(events[1].c, 4);
+  CHECK_EQ(events[2].type, FLIGHT_EVENT_SEND_FAILED);
+  CHECK_EQ(events[2].value, 0xA1B2C3D4u);
+  CHECK_EQ(events[3].type, FLIGHT_EVENT_GESTURE);
+  CHECK_EQ(events[3].c, ' ');
+  CHECK_EQ(events[3].value, 400);
+  CHECK(pedalsConsecutive(events, 0, FLIGHT_RECORDS_PER_SECTOR - 1));
+  CHECK_EQ(events.back().timeUs, 123456 + FLIGHT_RECORDS_PER_SECTOR * 1000);
+}
+
+// Fixtures for the FlightLogDecode* tests: 1 BOOT + 299 pedals over two sectors
+static void test_writesDecoderFixtures() {
+  mountBlank(4);
+  logAndFlush(299);
+
+  FILE* file = fopen("flightlog_dump.txt", "w");
+  CHECK(file != nullptr);
+  if (file) {
+    fprintf(file, "[debug monitor] dump requested\n");  // Non-FLT lines are ignored
+    for (const std::string& line : dumpLines()) {
+      fprintf(file, "%s\n", line.c_str());
+    }
+    fclose(file);
+  }
+  file = fopen("flightlog.bin", "wb");
+  CHECK(file != nullptr);
+  if (file) {
+    CHECK_EQ(fwrite(sim.bytes.data(), 1, sim.bytes.size(), file), sim.bytes.size());
+    fclose(file);
+  }
+}
+
+static void bench_logAndFlush() {
+  mountBlank(16);
+  const int iterations = 200000;
+  double logNs = hostTest_nsPerOp(iterations, [&](int i) {
+    flightRecorder_log(&recorder, FLIGHT_EVENT_PEDAL, 0, 'l', (uint8_t)(i & 1), (uint32_t)i);
+    if ((i & (FLIGHT_RECORDS_PER_PAGE - 1)) == FLIGHT_RECORDS_PER_PAGE - 1) {
+      flightRecorder_flush(&recorder);
+    }
+  });
+  CHECK_EQ(recorder.dropped, 0);
+  printf("  log + page flush: %.0f ns per event (RAM flash; SPI program time not included)\n", logNs);
+}
+
+int main() {
+  RUN_TEST(test_formatsBlankFlash);
+  RUN_TEST(test_waitsForFullPageOrTimeout);
+  RUN_TEST(test_remountAppendsAfterLastRecord);
+  RUN_TEST(test_wrapsAroundAndWearsEvenly);
+  RUN_TEST(test_tornHeaderIsIgnoredAndReused);
+  RUN_TEST(test_fullStageDropsNewest);
+  RUN_TEST(test_dumpLinesDecodeToLoggedEvents);
+  RUN_TEST(test_writesDecoderFixtures);
+  RUN_TEST(bench_logAndFlush);
+  return hostTest_finish();
+}
@@ -0,0 +1,221 @@
+// Pedal gestures through the keyboard service (user-021). A bound pedal's key is in the
+// report sent while its press is handled - the same report, at the same time, as for an
+// unbound pedal - so a plain tap has no added latency. Double-taps and holds are upgraded
+// afterwards, with a Backspace first where the binding asks for one, and timed events are
+// recognized on their playout times rather than on radio arrival, and on their arrival
+// times when replayed after the host mounts.
+#include "HostTest.h"
+#include "KeyboardServiceHost.h"
+
+static const uint8_t MAC_A[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0A};
+static const uint8_t MAC_B[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0B};
+static const uint8_t MAC_C[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0C};
+
+static const GestureBinding gestureBindings[] = {
+  {'l', {'L', true}, {' ', true}},
+  {'r', {'R', false}, {0, false}},
+  {0, {0, false}, {0, false}},
+};
+
+// Reports as "<ms>:<held keys>", '<' for Backspace and '-' for none
+static std::string timeline;
+static size_t reportsSeen;
+
+static std::string describe(const HidNkroReport& report) {
+  static const char candidates[] = "\blrLR ";
+  bool shift = (report.modifiers & HID_MODIFIER_LEFT_SHIFT) != 0;
+  std::string keys;
+  for (const char* c = candidates; *c; c++) {
+    bool upper = *c >= 'A' && *c <= 'Z';
+    if (keyboardHost_isHeld(report, *c) && upper == shift) keys += (*c == '\b') ? '<' : *c;
+  }
+  return keys.empty() ? "-" : keys;
+}
+
+static void collect() {
+  for (; reportsSeen < hostNkro_reports.size(); reportsSeen++) {
+    timeline += " " + std::to_string(millis()) + ":" + describe(hostNkro_reports[reportsSeen]);
+  }
+}
+
+static void setUp() {
+  keyboardHost_reset();
+  keyboardHost_addTransmitter(MAC_A, PEDAL_MODE_SINGLE);
+  keyboardHost_addTransmitter(MAC_B, PEDAL_MODE_SINGLE);
+  keyboardService_setGestures(&keyboard, gestureBindings);
+  keyboardHost_mount();
+  hostClock_setUs(1000 * 1000);
+  timeline.clear();
+  reportsSeen = 0;
+}
+
+static void pedal(const uint8_t* mac, bool pressed) {
+  keyboardHost_pedal(mac, '1', pressed);
+  collect();
+}
+
+// Timer passes every millisecond up to ms, as the HID output task would wake for them
+static void runUntilMs(unsigned long ms) {
+  while (millis() < ms) {
+    hostClock_advanceMs(1);
+    keyboardHost_runTimers();
+    collect();
+  }
+}
+
+static void test_tapTypesInThePressReport() {
+  setUp();
+  CHECK_EQ(keyboardHost_keyFor(MAC_A, '1'), 'l');
+  CHECK_EQ(keyboardHost_keyFor(MAC_B, '1'), 'r');
+
+  pedal(MAC_A, true);
+  CHECK(timeline == " 1000:l");  // Sent while the press was handled, no timer pass needed
+  CHECK_EQ(keyboardService_timeUntilNextTimerMs(&keyboard, millis()), GESTURE_LONG_PRESS_MS);
+  runUntilMs(1080);
+  pedal(MAC_A, false);
+  CHECK(timeline == " 1000:l 1080:-");
+  CHECK_EQ(keyboard.gestures.taps, 1);
+
+  // Same reports and timing as a pedal without a gesture binding
+  keyboardHost_addTransmitter(MAC_C, PEDAL_MODE_SINGLE);
+  char keyC = keyboardHost_keyFor(MAC_C, '1');
+  CHECK(keyC != 0 && gestureRecognizer_find(&keyboard.gestures, keyC) < 0);
+  size_t before = hostNkro_reports.size();
+  keyboardHost_pedal(MAC_C, '1', true);
+  CHECK_EQ(hostNkro_reports.size(), before + 1);
+  CHECK(keyboardHost_isHeld(hostNkro_reports.back(), keyC));
+}
+
+static void test_doubleTapBackspacesThePrimary() {
+  setUp();
+  pedal(MAC_A, true);
+  runUntilMs(1080);
+  pedal(MAC_A, false);
+  runUntilMs(1200);
+  pedal(MAC_A, true);  // 120 ms after the tap
+  runUntilMs(1260);
+  pedal(MAC_A, false);
+  CHECK(timeline == " 1000:l 1080:- 1200:< 1210:- 1220:L 1260:-");
+  CHECK_EQ(keyboard.gestures.doubleTaps, 1);
+  CHECK_EQ(keyboard.gestures.compensations, 1);
+
+  // A third press is a plain press again
+  runUntilMs(1300);
+  pedal(MAC_A, true);
+  CHECK(timeline.substr(timeline.size() - 7) == " 1300:l");
+}
+
+static void test_holdUpgradesAtTheDeadline() {
+  setUp();
+  pedal(MAC_A, true);
+  runUntilMs(1460);
+  CHECK(timeline == " 1000:l 1400:< 1410:- 1420: ");
+  pedal(MAC_A, false);
+  CHECK(timeline == " 1000:l 1400:< 1410:- 1420:  1460:-");
+  CHECK_EQ(keyboard.gestures.holds, 1);
+}
+
+static void test_releaseDuringCompensationLeavesNothingHeld() {
+  setUp();
+  pedal(MAC_A, true);
+  runUntilMs(1401);  // Backspace down, not up yet
+  pedal(MAC_A, false);
+  runUntilMs(1500);
+  CHECK(timeline == " 1000:l 1400:< 1401:-");
+  CHECK_EQ(keyboard.sequencer.queued, 0);  // Cancelled, not left to type the hold key
+}
+
+static void test_slowSecondPressIsATap() {
+  setUp();
+  pedal(MAC_B, true);
+  runUntilMs(1050);
+  pedal(MAC_B, false);
+  runUntilMs(1450);  // 400 ms gap
+  pedal(MAC_B, true);
+  runUntilMs(1500);
+  pedal(MAC_B, false);
+  runUntilMs(1600);  // 100 ms gap, no compensation bound: 'R' instead of 'r'
+  pedal(MAC_B, true);
+  runUntilMs(1650);
+  pedal(MAC_B, false);
+  CHECK(timeline == " 1000:r 1050:- 1450:r 1500:- 1600:R 1650:-");
+  CHECK_EQ(keyboard.gestures.taps, 2);
+  CHECK_EQ(keyboard.gestures.doubleTaps, 1);
+}
+
+// 248 ms between the edges, 253 ms between arrivals: the playout buffer restores the edge
+// spacing, so the second press is a double-tap
+static void test_timedEventsUseEdgeSpacing() {
+  setUp();
+  uint32_t base = (uint32_t)esp_timer_get_time();
+  auto timed = [&](bool pressed, uint32_t edgeUs, uint32_t latencyUs) {
+    hostClock_setUs(base + edgeUs + latencyUs);
+    keyboardHost_timedPedal(MAC_B, '1', pressed, edgeUs);
+  };
+  timed(true, 0, 1000);
+  timed(false, 100000, 1000);
+  runUntilMs((base + 110000) / 1000);
+  timed(true, 348000, 6000);
+  runUntilMs((base + 360000) / 1000);
+  CHECK_EQ(keyboard.gestures.doubleTaps, 1);
+  CHECK(keyboardHost_isHeld(hostNkro_reports.back(), 'R'));
+}
+
+// A double-tap that happens before the host mounts is replayed through the recognizer with
+// its original timing, not typed as two plain taps
+static void test_preReadyDoubleTapIsRecognized() {
+  setUp();
+  keyboardHost_unmount();
+  pedal(MAC_A, true);
+  hostClock_advanceMs(80);
+  pedal(MAC_A, false);
+  hostClock_advanceMs(120);
+  pedal(MAC_A, true);
+  hostClock_advanceMs(60);
+  pedal(MAC_A, false);
+  CHECK(timeline.empty());
+  CHECK_EQ(keyboard.preReadyCount, 4);
+
+  hostClock_advanceMs(40);
+  keyboardHost_mount();
+  runUntilMs(1400);
+  CHECK_EQ(keyboard.preReadyReplayed, 4);
+  CHECK_EQ(keyboard.gestures.taps, 1);
+  CHECK_EQ(keyboard.gestures.doubleTaps, 1);
+  CHECK(timeline == " 1301:l 1301:- 1301:< 1301:L 1301:-");  // All on the first pass after mount
+}
+
+static void bench_pressPath() {
+  setUp();
+  keyboardHost_addTransmitter(MAC_C, PEDAL_MODE_SINGLE);
+  const int iterations = 200000;
+  auto tapNs = [&](const uint8_t* mac) {
+    MacAddr addr = macAddr_fromBytes(mac);
+    struct_message press = {MSG_PEDAL_EVENT, '1', true, PEDAL_MODE_SINGLE};
+    struct_message release = {MSG_PEDAL_EVENT, '1', false, PEDAL_MODE_SINGLE};
+    return hostTest_nsPerOp(iterations, [&](int) {
+      hostClock_advanceMs(300);  // Never a double-tap
+      keyboardService_handlePedalEvent(&keyboard, addr, &press, esp_timer_get_time());
+      keyboardService_flush(&keyboard);
+      keyboardService_handlePedalEvent(&keyboard, addr, &release, esp_timer_get_time());
+      keyboardService_flush(&keyboard);
+      hostNkro_reports.clear();
+    });
+  };
+  double boundNs = tapNs(MAC_B);
+  double plainNs = tapNs(MAC_C);
+  printf("  tap (press + release, two reports): %.0f ns with a gesture binding, %.0f ns without\n",
+         boundNs, plainNs);
+}
+
+int main() {
+  RUN_TEST(test_tapTypesInThePressReport);
+  RUN_TEST(test_doubleTapBackspacesThePrimary);
+  RUN_TEST(test_holdUpgradesAtTheDeadline);
+  RUN_TEST(test_releaseDuringCompensationLeavesNothingHeld);
+  RUN_TEST(test_slowSecondPressIsATap);
+  RUN_TEST(test_timedEventsUseEdgeSpacing);
+  RUN_TEST(test_preReadyDoubleTapIsRecognized);
+  RUN_TEST(bench_pressPath);
+  return hostTest_finish();
+}
@@ -0,0 +1,154 @@
+// Host test for the coalescing keyboard report builder (user-005): independent changes share
+// one report, while a change that undoes a pending one sends the pending report first so
+// a press and release in the same dispatch cycle still reach the host as two reports.
+#include "HostTest.h"
+#include <vector>
+#include <string>
+#include "receiver/infrastructure/HidReportBuilder.cpp"
+
+// Stands in for KeyboardService's send path: builds the report and records the held usages
+struct ReportLog {
+  HidReportBuilder* builder;
+  bool hostPresent;
+  bool nkro;
+  std::vector<std::string> reports;
+};
+
+static std::string describe(const HidKeyboardReport& report) {
+  std::string keys;
+  if (report.modifiers & HID_MODIFIER_LEFT_SHIFT) keys += "S+";
+  for (int i = 0; i < HID_REPORT_MAX_KEYS; i++) {
+    if (report.keys[i]) keys += std::to_string(report.keys[i]) + ",";
+  }
+  return keys;
+}
+
+static std::string describe(const HidNkroReport& report) {
+  std::string keys;
+  if (report.modifiers & HID_MODIFIER_LEFT_SHIFT) keys += "S+";
+  for (int usage = 0; usage < HID_NKRO_USAGE_COUNT; usage++) {
+    if (report.keys[usage >> 3] & (1u << (usage & 7))) keys += std::to_string(usage) + ",";
+  }
+  return keys;
+}
+
+static bool sendPending(ReportLog* log) {
+  if (log->nkro) {
+    HidNkroReport report;
+    if (!hidReportBuilder_buildNkro(log->builder, &report)) return false;
+    log->reports.push_back(describe(report));
+  } else {
+    HidKeyboardReport report;
+    if (!hidReportBuilder_build(log->builder, &report)) return false;
+    log->reports.push_back(describe(report));
+  }
+  return true;
+}
+
+static bool flushHook(void* context) {
+  ReportLog* log = (ReportLog*)context;
+  return log->hostPresent && sendPending(log);
+}
+
+static HidReportBuilder builder;
+
+static ReportLog setUp(bool nkro) {
+  hidReportBuilder_init(&builder);
+  ReportLog log = {&builder, true, nkro, {}};
+  return log;
+}
+
+static const std::string KEY_A = "4,";       // Usage 0x04
+static const std::string KEY_AB = "4,5,";
+static const std::string NONE = "";
+
+static void test_independentChangesShareOneReport() {
+  ReportLog log = setUp(false);
+  hidReportBuilder_setFlush(&builder, flushHook, &log);
+  CHECK(hidReportBuilder_press(&builder, 'a'));
+  CHECK(hidReportBuilder_press(&builder, 'b'));
+  CHECK(sendPending(&log));
+  CHECK(log.reports == std::vector<std::string>({KEY_AB}));
+  CHECK_EQ(builder.changesCoalesced, 1);
+  CHECK_EQ(builder.conflictFlushes, 0);
+
+  // Releasing keys pressed in an earlier report is not a conflict either
+  CHECK(hidReportBuilder_release(&builder, 'a'));
+  CHECK(hidReportBuilder_release(&builder, 'b'));
+  CHECK(sendPending(&log));
+  CHECK(log.reports == std::vector<std::string>({KEY_AB, NONE}));
+  CHECK_EQ(builder.conflictFlushes, 0);
+}
+
+static void checkTapInOneCycle(bool nkro) {
+  ReportLog log = setUp(nkro);
+  hidReportBuilder_setFlush(&builder, flushHook, &log);
+  CHECK(hidReportBuilder_press(&builder, 'a'));
+  CHECK(hidReportBuilder_release(&builder, 'a'));  // Sends the press first
+  CHECK(sendPending(&log));                        // End of the dispatch cycle
+  CHECK(log.reports == std::vector<std::string>({KEY_A, NONE}));
+  CHECK_EQ(builder.conflictFlushes, 1);
+  CHECK_EQ(builder.conflictsFolded, 0);
+  CHECK(!sendPending(&log));
+}
+
+static void test_tapInOneCycleSendsBothEdges() {
+  checkTapInOneCycle(false);
+}
+
+static void test_tapInOneCycleSendsBothEdgesNkro() {
+  checkTapInOneCycle(true);
+}
+
+// Press, release, press: three edges, three reports; the other key pressed alongside rides
+// with the first one
+static void test_repeatedReversalsSplitEveryTime() {
+  ReportLog log = setUp(false);
+  hidReportBuilder_setFlush(&builder, flushHook, &log);
+  hidReportBuilder_press(&builder, 'b');
+  hidReportBuilder_press(&builder, 'a');
+  hidReportBuilder_release(&builder, 'a');
+  hidReportBuilder_press(&builder, 'a');
+  sendPending(&log);
+  CHECK(log.reports == std::vector<std::string>({KEY_AB, "5,", KEY_AB}));
+  CHECK_EQ(builder.conflictFlushes, 2);
+}
+
+// 'a' and 'A' share usage 0x04 but are different keys: no conflict, one report
+static void test_sharedUsageIsNotAConflict() {
+  ReportLog log = setUp(true);
+  hidReportBuilder_setFlush(&builder, flushHook, &log);
+  hidReportBuilder_press(&builder, 'a');
+  hidReportBuilder_press(&builder, 'A');
+  sendPending(&log);
+  CHECK(log.reports == std::vector<std::string>({"S+4,"}));
+  CHECK_EQ(builder.conflictFlushes, 0);
+}
+
+// Without a host (or a hook) the reversal cannot be sent; the held set stays correct and
+// the fold is counted
+static void test_reversalWithoutHostIsFoldedAndCounted() {
+  ReportLog log = setUp(false);
+  log.hostPresent = false;
+  hidReportBuilder_setFlush(&builder, flushHook, &log);
+  hidReportBuilder_press(&builder, 'a');
+  hidReportBuilder_release(&builder, 'a');
+  CHECK(!hidReportBuilder_isPressed(&builder, 'a'));
+  CHECK_EQ(builder.conflictsFolded, 1);
+  CHECK(log.reports.empty());
+
+  hidReportBuilder_init(&builder);
+  hidReportBuilder_press(&builder, 'a');
+  hidReportBuilder_release(&builder, 'a');
+  CHECK_EQ(builder.conflictsFolded, 1);
+}
+
+int main() {
+  RUN_TEST(test_independentChangesShareOneReport);
+  RUN_TEST(test_tapInOneCycleSendsBothEdges);
+  RUN_TEST(test_tapInOneCycleSendsBothEdgesNkro);
+  RUN_TEST(test_repeatedReversalsSplitEveryTime);
+  RUN_TEST(test_sharedUsageIsNotAConflict);
+  RUN_TEST(test_reversalWithoutHostIsFoldedAndCounted);
+  return hostTest_finish();
+}
@@ -0,0 +1,169 @@
+// Host test for the ESP-NOW ingress ring (user-001): FIFO order, drop-on-full without
+// blocking the producer, and producer/consumer on separate threads.
+#include "HostTest.h"
+#include <stdlib.h>
+#include <thread>
+#include <atomic>
+#include "receiver/infrastructure/IngressQueue.cpp"
+
+static const uint8_t TEST_MAC[6] = {0x24, 0x6F, 0x28, 0x01, 0x02, 0x03};
+
+static void pushSequence(IngressQueue* queue, uint32_t seq) {
+  uint8_t data[4];
+  memcpy(data, &seq, sizeof(seq));
+  ingressQueue_push(queue, TEST_MAC, data, sizeof(data), 6, (int64_t)seq);
+}
+
+static uint32_t frameSequence(const IngressFrame* frame) {
+  uint32_t seq;
+  memcpy(&seq, frame->data, sizeof(seq));
+  return seq;
+}
+
+static IngressQueue queue;
+
+static void test_fifoOrderAndFields() {
+  ingressQueue_init(&queue);
+  for (uint32_t i = 0; i < 5; i++) pushSequence(&queue, i);
+  CHECK_EQ(ingressQueue_size(&queue), 5);
+
+  for (uint32_t i = 0; i < 5; i++) {
+    const IngressFrame* frame = ingressQueue_peek(&queue);
+    CHECK(frame != nullptr);
+    if (!frame) return;
+    CHECK_EQ(frameSequence(frame), i);
+    CHECK_EQ(frame->rxTimeUs, i);
+    CHECK_EQ(frame->channel, 6);
+    CHECK_EQ(frame->len, 4);
+    CHECK(macAddr_equal(frame->addr, macAddr_fromBytes(TEST_MAC)));
+    CHECK(memcmp(frame->mac, TEST_MAC, 6) == 0);
+    ingressQueue_release(&queue);
+  }
+  CHECK(ingressQueue_isEmpty(&queue));
+  CHECK(ingressQueue_peek(&queue) == nullptr);
+}
+
+static void test_fullRingDropsInsteadOfBlocking() {
+  ingressQueue_init(&queue);
+  for (uint32_t i = 0; i < INGRESS_QUEUE_CAPACITY; i++) pushSequence(&queue, i);
+  CHECK_EQ(queue.highWater, INGRESS_QUEUE_CAPACITY);
+
+  uint8_t data[4] = {0};
+  CHECK(!ingressQueue_push(&queue, TEST_MAC, data, sizeof(data), 1, 0));
+  CHECK_EQ(queue.dropped, 1);
+  CHECK_EQ(queue.enqueued, INGRESS_QUEUE_CAPACITY);
+
+  // Oldest frames are kept; freeing one slot lets the producer in again
+  CHECK_EQ(frameSequence(ingressQueue_peek(&queue)), 0);
+  ingressQueue_release(&queue);
+  CHECK(ingressQueue_push(&queue, TEST_MAC, data, sizeof(data), 1, 0));
+
+  uint8_t big[INGRESS_MAX_FRAME_LEN + 1] = {0};
+  CHECK(!ingressQueue_push(&queue, TEST_MAC, big, sizeof(big), 1, 0));
+  CHECK_EQ(queue.oversized, 1);
+}
+
+// The receive callback must never wait on the dispatcher: time pushes into a ring whose
+// consumer is stalled and check they stay in the same range as pushes into an empty ring.
+static void test_producerCostWithStalledConsumer() {
+  uint8_t data[16] = {0};
+  const int iterations = 200000;
+
+  double freeNs = hostTest_nsPerOp(iterations, [&](int) {
+    ingressQueue_init(&queue);
+    ingressQueue_push(&queue, TEST_MAC, data, sizeof(data), 1, 0);
+  });
+
+  ingressQueue_init(&queue);
+  for (int i = 0; i < INGRESS_QUEUE_CAPACITY; i++) {
+    ingressQueue_push(&queue, TEST_MAC, data, sizeof(data), 1, 0);
+  }
+  double fullNs = hostTest_nsPerOp(iterations, [&](int) {
+    ingressQueue_push(&queue, TEST_MAC, data, sizeof(data), 1, 0);
+  });
+  CHECK_EQ(queue.enqueued, INGRESS_QUEUE_CAPACITY);
+
+  printf("  push into empty ring (incl. init): %.1f ns, push into full ring: %.1f ns\n", freeNs, fullNs);
+  CHECK(fullNs < 1000.0);
+}
+
+// Bursty arrivals against a dispatcher that drains a random amount per pass: frames that
+// fit arrive exactly once and in order, and accepted + dropped accounts for every push.
+static void test_burstsAgainstSlowConsumer() {
+  ingressQueue_init(&queue);
+  srand(1);
+  uint32_t nextSeq = 0;
+  uint32_t lastSeq = 0;
+  uint32_t received = 0;
+  bool ordered = true;
+  for (int pass = 0; pass < 20000; pass++) {
+    int burst = rand() % (INGRESS_QUEUE_CAPACITY + 8);
+    for (int i = 0; i < burst; i++) pushSequence(&queue, nextSeq++);
+    int drain = rand() % (INGRESS_QUEUE_CAPACITY + 8);
+    for (int i = 0; i < drain; i++) {
+      const IngressFrame* frame = ingressQueue_peek(&queue);
+      if (!frame) break;
+      uint32_t seq = frameSequence(frame);
+      if (received > 0 && seq <= lastSeq) ordered = false;
+      lastSeq = seq;
+      received++;
+      ingressQueue_release(&queue);
+    }
+  }
+  received += ingressQueue_size(&queue);
+  CHECK(ordered);
+  CHECK_EQ(received, queue.enqueued);
+  CHECK_EQ(queue.enqueued + queue.dropped, nextSeq);
+  CHECK(queue.dropped > 0);
+}
+
+// Producer and consumer on separate threads (WiFi task and dispatcher). The producer never
+// waits: whatever the consumer gets must still be in order and intact.
+static void test_concurrentProducerConsumer() {
+  ingressQueue_init(&queue);
+  const uint32_t total = 200000;
+  std::atomic<bool> producerDone(false);
+
+  int64_t producerNs = 0;
+  std::thread producer([&] {
+    int64_t start = hostTest_nowNs();
+    for (uint32_t seq = 0; seq < total; seq++) pushSequence(&queue, seq);
+    producerNs = hostTest_nowNs() - start;
+    producerDone.store(true, std::memory_order_release);
+  });
+
+  uint32_t received = 0;
+  uint32_t lastSeq = 0;
+  bool ordered = true;
+  bool intact = true;
+  while (true) {
+    const IngressFrame* frame = ingressQueue_peek(&queue);
+    if (!frame) {
+      if (producerDone.load(std::memory_order_acquire) && ingressQueue_isEmpty(&queue)) break;
+      continue;
+    }
+    uint32_t seq = frameSequence(frame);
+    if (received > 0 && seq <= lastSeq) ordered = false;
+    if (frame->rxTimeUs != (int64_t)seq) intact = false;
+    lastSeq = seq;
+    received++;
+    ingressQueue_release(&queue);
+  }
+  producer.join();
+
+  CHECK(ordered);
+  CHECK(intact);
+  CHECK_EQ(received, queue.enqueued);
+  CHECK_EQ(queue.enqueued + queue.dropped, total);
+  printf("  producer: %.1f ns/push over %u pushes; consumer got %u, %u dropped\n",
+         (double)producerNs / total, total, received, queue.dropped);
+}
+
+int main() {
+  RUN_TEST(test_fifoOrderAndFields);
+  RUN_TEST(test_fullRingDropsInsteadOfBlocking);
+  RUN_TEST(test_producerCostWithStalledConsumer);
+  RUN_TEST(test_burstsAgainstSlowConsumer);
+  RUN_TEST(test_concurrentProducerConsumer);
+  return hostTest_finish();
+}
@@ -0,0 +1,146 @@
+// Host test for the double-buffered key bindings (user-004): lookups resolve from the
+// published table no matter what state the writer is in, a publish into a table that is
+// still being read is deferred rather than waited for, and concurrent lookups only ever see
+// a complete table.
+#include "HostTest.h"
+#include <thread>
+#include <atomic>
+#include "receiver/domain/MacIndex.cpp"
+#include "receiver/domain/SlotAllocator.cpp"
+#include "receiver/domain/TransmitterManager.cpp"
+#include "receiver/domain/KeyBindings.cpp"
+
+static const uint8_t MAC_A[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0A};
+static const uint8_t MAC_B[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0B};
+
+static TransmitterManager manager;
+static KeyBindings bindings;
+
+static char keyFor(const uint8_t* mac, char pedalKey) {
+  KeyBindingAction action;
+  if (!keyBindings_lookup(&bindings, macAddr_fromBytes(mac), pedalKey, &action)) return -1;
+  return action.key;
+}
+
+static void setUp() {
+  transmitterManager_init(&manager);
+  keyBindings_init(&bindings);
+}
+
+static void test_resolvesPublishedBindings() {
+  setUp();
+  int a = transmitterManager_place(&manager, MAC_A, PEDAL_MODE_DUAL);
+  CHECK(keyBindings_refresh(&bindings, &manager));
+  CHECK(!keyBindings_refresh(&bindings, &manager));  // Version unchanged
+
+  KeyBindingAction action;
+  CHECK(keyBindings_lookup(&bindings, macAddr_fromBytes(MAC_A), '1', &action));
+  CHECK_EQ(action.transmitterIndex, a);
+  CHECK_EQ(action.key, transmitterManager_getAssignedKey(&manager, a, '1'));
+  CHECK_EQ(keyFor(MAC_A, '2'), transmitterManager_getAssignedKey(&manager, a, '2'));
+  CHECK(keyFor(MAC_A, '1') != 0);
+  CHECK_EQ(keyFor(MAC_A, '3'), 0);
+  CHECK_EQ(keyFor(MAC_B, '1'), -1);
+}
+
+// A writer preempted half way through a rebuild has only touched the inactive table, so a
+// lookup neither retries nor sees the partial state.
+static void test_halfWrittenTableIsInvisible() {
+  setUp();
+  transmitterManager_place(&manager, MAC_A, PEDAL_MODE_DUAL);
+  keyBindings_refresh(&bindings, &manager);
+  char key1 = keyFor(MAC_A, '1');
+
+  uint32_t inactive = bindings.active ^ 1;
+  memset(&bindings.tables[inactive], 0xA5, sizeof(KeyBindingTable));
+  CHECK_EQ(keyFor(MAC_A, '1'), key1);
+  CHECK_EQ(keyFor(MAC_B, '1'), -1);
+  CHECK_EQ(bindings.readers[0] + bindings.readers[1], 0);
+}
+
+// A lookup that is still inside the inactive table holds off the next publish; the writer
+// does not wait for it but retries on its next refresh.
+static void test_publishDefersToInFlightLookup() {
+  setUp();
+  transmitterManager_place(&manager, MAC_A, PEDAL_MODE_DUAL);
+  keyBindings_refresh(&bindings, &manager);
+  transmitterManager_place(&manager, MAC_B, PEDAL_MODE_SINGLE);
+  keyBindings_refresh(&bindings, &manager);
+  CHECK(keyFor(MAC_B, '1') > 0);
+
+  uint32_t inactive = bindings.active ^ 1;
+  bindings.readers[inactive] = 1;  // Lookup that started before the last flip
+  transmitterManager_remove(&manager, transmitterManager_findIndex(&manager, macAddr_fromBytes(MAC_B)));
+  CHECK(!keyBindings_refresh(&bindings, &manager));
+  CHECK_EQ(bindings.deferred, 1);
+  CHECK(keyFor(MAC_B, '1') > 0);  // Still the published table
+
+  bindings.readers[inactive] = 0;
+  CHECK(keyBindings_refresh(&bindings, &manager));
+  CHECK_EQ(keyFor(MAC_B, '1'), -1);
+  CHECK(keyFor(MAC_A, '1') > 0);
+}
+
+static void test_unchangedBindingsAreNotRepublished() {
+  setUp();
+  int a = transmitterManager_place(&manager, MAC_A, PEDAL_MODE_DUAL);
+  keyBindings_refresh(&bindings, &manager);
+  uint32_t rebuilds = bindings.rebuilds;
+  uint32_t active = bindings.active;
+
+  transmitterManager_renewLease(&manager, a, 5000);
+  manager.version++;  // A change that does not affect bindings
+  CHECK(!keyBindings_refresh(&bindings, &manager));
+  CHECK_EQ(bindings.rebuilds, rebuilds);
+  CHECK_EQ(bindings.active, active);
+}
+
+// HID task and loop task on separate threads: the writer flips transmitter A between DUAL
+// and SINGLE while the reader resolves pedal '2', which is bound only in DUAL mode. Every
+// answer must come from one complete table.
+static void test_concurrentLookupsSeeCompleteTables() {
+  setUp();
+  int a = transmitterManager_place(&manager, MAC_A, PEDAL_MODE_DUAL);
+  keyBindings_refresh(&bindings, &manager);
+  char dualKey = keyFor(MAC_A, '2');
+  CHECK(dualKey > 0);
+
+  std::atomic<bool> done(false);
+  uint32_t lookups = 0;
+  uint32_t torn = 0;
+  std::thread reader([&] {
+    MacAddr addr = macAddr_fromBytes(MAC_A);
+    while (!done.load(std::memory_order_acquire)) {
+      KeyBindingAction action;
+      if (!keyBindings_lookup(&bindings, addr, '2', &action) || action.transmitterIndex != a ||
+          (action.key != dualKey && action.key != 0)) {
+        torn++;
+      }
+      lookups++;
+    }
+  });
+
+  for (int i = 0; i < 2000; i++) {
+    transmitterManager_setPedalMode(&manager, a, (i & 1) ? PEDAL_MODE_DUAL : PEDAL_MODE_SINGLE);
+    keyBindings_refresh(&bindings, &manager);
+    // Lets the reader run (and be preempted mid-lookup) between publishes on a single core
+    std::this_thread::sleep_for(std::chrono::microseconds(20));
+  }
+  done.store(true, std::memory_order_release);
+  reader.join();
+
+  CHECK_EQ(torn, 0);
+  CHECK(lookups > 0);
+  CHECK(bindings.rebuilds > 100);
+  CHECK_EQ(bindings.readers[0] + bindings.readers[1], 0);
+  printf("  %u lookups against %u publishes (%u deferred)\n", lookups, bindings.rebuilds, bindings.deferred);
+}
+
+int main() {
+  RUN_TEST(test_resolvesPublishedBindings);
+  RUN_TEST(test_halfWrittenTableIsInvisible);
+  RUN_TEST(test_publishDefersToInFlightLookup);
+  RUN_TEST(test_unchangedBindingsAreNotRepublished);
+  RUN_TEST(test_concurrentLookupsSeeCompleteTables);
+  return hostTest_finish();
+}
@@ -0,0 +1,112 @@
+// Host test for the key sequencer (user-006) on a fake millisecond clock. Steps due in the
+// same pass share a report, but a step that reverses a key still pending in the builder
+// waits for the next pass, so delay-0 and overdue press/release pairs reach the host as
+// separate reports. Later steps keep their stored deadlines.
+#include "HostTest.h"
+#include <vector>
+#include <string>
+#include "receiver/infrastructure/HidReportBuilder.cpp"
+#include "receiver/application/KeySequencer.cpp"
+
+static HidReportBuilder builder;
+static KeySequencer sequencer;
+static std::vector<std::string> sent;
+
+static void setUp() {
+  hidReportBuilder_init(&builder);
+  keySequencer_init(&sequencer, &builder);
+  sent.clear();
+}
+
+// One HID output task pass: run due steps, then send whatever changed
+static int pass(uint32_t nowMs) {
+  int applied = keySequencer_run(&sequencer, nowMs);
+  HidKeyboardReport report;
+  if (hidReportBuilder_build(&builder, &report)) {
+    std::string keys;
+    for (int i = 0; i < HID_REPORT_MAX_KEYS; i++) {
+      if (report.keys[i]) keys += std::to_string(report.keys[i]) + ",";
+    }
+    sent.push_back(keys);
+  }
+  return applied;
+}
+
+static void test_zeroDelayPairSendsPressThenRelease() {
+  setUp();
+  static const KeyStep tap[] = {{'a', true, 0}, {'a', false, 0}};
+  keySequencer_start(&sequencer, tap, 2, 1000);
+
+  CHECK_EQ(pass(1000), 1);
+  CHECK_EQ(sequencer.deferred, 1);
+  CHECK_EQ(keySequencer_timeUntilNextMs(&sequencer, 1000), 0);  // Release is due right away
+  CHECK_EQ(pass(1000), 1);
+  CHECK(sent == std::vector<std::string>({"4,", ""}));
+  CHECK_EQ(keySequencer_timeUntilNextMs(&sequencer, 1000), KEY_SEQUENCER_NO_DEADLINE);
+}
+
+// The task woke late: every step is overdue. The pair still splits, and the steps after
+// it are scheduled from the stored deadlines, not from the late wakeup.
+static void test_overduePairKeepsStoredDeadlines() {
+  setUp();
+  static const KeyStep steps[] = {
+    {'a', true, 10}, {'a', false, 30}, {'b', true, 50}, {'b', false, 100},
+  };
+  keySequencer_start(&sequencer, steps, 4, 0);  // Due at 10, 40, 90, 190
+
+  CHECK_EQ(pass(100), 1);
+  CHECK_EQ(pass(100), 2);  // Release 'a' and press 'b' do not conflict: one report
+  CHECK(sent == std::vector<std::string>({"4,", "5,"}));
+  CHECK_EQ(keySequencer_timeUntilNextMs(&sequencer, 100), 90);
+
+  CHECK_EQ(pass(189), 0);
+  CHECK_EQ(pass(190), 1);
+  CHECK(sent == std::vector<std::string>({"4,", "5,", ""}));
+}
+
+static void test_independentSequencesShareAReport() {
+  setUp();
+  static const KeyStep first[] = {{'a', true, 5}, {'a', false, 20}};
+  static const KeyStep second[] = {{'b', true, 5}, {'b', false, 20}};
+  keySequencer_start(&sequencer, first, 2, 0);
+  keySequencer_start(&sequencer, second, 2, 0);
+
+  CHECK_EQ(pass(5), 2);
+  CHECK_EQ(pass(25), 2);
+  CHECK(sent == std::vector<std::string>({"4,5,", ""}));
+  CHECK_EQ(sequencer.deferred, 0);
+}
+
+// A live pedal change earlier in the same cycle is pending too: a sequence step that
+// undoes it waits, and everything queued behind it keeps its order
+static void test_stepWaitsBehindPendingPedalChange() {
+  setUp();
+  static const KeyStep release[] = {{'a', false, 0}};
+  static const KeyStep pressB[] = {{'b', true, 0}};
+  hidReportBuilder_press(&builder, 'a');  // Pedal press in this dispatch cycle
+  keySequencer_start(&sequencer, release, 1, 0);
+  keySequencer_start(&sequencer, pressB, 1, 0);
+
+  CHECK_EQ(pass(0), 0);
+  CHECK_EQ(pass(0), 2);
+  CHECK(sent == std::vector<std::string>({"4,", "5,"}));
+}
+
+// Pressing a key that is already held is not a reversal and does not wait
+static void test_repeatedStateIsNotAConflict() {
+  setUp();
+  static const KeyStep steps[] = {{'a', true, 0}, {'a', true, 0}, {'a', false, 0}};
+  keySequencer_start(&sequencer, steps, 3, 0);
+  CHECK_EQ(pass(0), 2);
+  CHECK_EQ(pass(0), 1);
+  CHECK(sent == std::vector<std::string>({"4,", ""}));
+}
+
+int main() {
+  RUN_TEST(test_zeroDelayPairSendsPressThenRelease);
+  RUN_TEST(test_overduePairKeepsStoredDeadlines);
+  RUN_TEST(test_independentSequencesShareAReport);
+  RUN_TEST(test_stepWaitsBehindPendingPedalChange);
+  RUN_TEST(test_repeatedStateIsNotAConflict);
+  return hostTest_finish();
+}
@@ -0,0 +1,91 @@
+// MAC -> transmitter lookup cost as the receiver fills up (user-009): the open-addressed
+// MacIndex against the linear memcmp scan it replaced, at 2..32 transmitters. Also checks
+// the index against a plain array under random insert/remove churn.
+#include "HostTest.h"
+#include <stdlib.h>
+#include "receiver/domain/MacIndex.cpp"
+
+static void makeMac(int i, uint8_t* mac) {
+  // Same vendor prefix for all, as with a batch of boards from one supplier
+  uint8_t bytes[6] = {0x24, 0x6F, 0x28, (uint8_t)(i >> 2), (uint8_t)(i * 37), (uint8_t)(i * 101 + 1)};
+  memcpy(mac, bytes, 6);
+}
+
+static void test_matchesReferenceUnderChurn() {
+  srand(1);
+  uint8_t macs[MAX_PEDAL_SLOTS][6];
+  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) makeMac(i, macs[i]);
+
+  bool mismatch = false;
+  for (int round = 0; round < 200 && !mismatch; round++) {
+    MacIndex index;
+    macIndex_init(&index);
+    bool live[MAX_PEDAL_SLOTS] = {false};
+    for (int step = 0; step < 500 && !mismatch; step++) {
+      int i = rand() % MAX_PEDAL_SLOTS;
+      MacAddr addr = macAddr_fromBytes(macs[i]);
+      if (live[i]) {
+        macIndex_remove(&index, addr);
+      } else {
+        macIndex_insert(&index, addr, i);
+      }
+      live[i] = !live[i];
+      for (int j = 0; j < MAX_PEDAL_SLOTS; j++) {
+        if (macIndex_find(&index, macAddr_fromBytes(macs[j])) != (live[j] ? j : -1)) mismatch = true;
+      }
+    }
+  }
+  CHECK(!mismatch);
+
+  MacIndex index;
+  macIndex_init(&index);
+  CHECK_EQ(macIndex_find(&index, MAC_ADDR_ZERO), -1);
+  macIndex_insert(&index, macAddr_fromBytes(macs[3]), 3);
+  macIndex_insert(&index, macAddr_fromBytes(macs[3]), 7);  // Update in place
+  CHECK_EQ(macIndex_find(&index, macAddr_fromBytes(macs[3])), 7);
+  CHECK_EQ(index.count, 1);
+}
+
+typedef struct {
+  uint8_t mac[6];
+} ScannedEntry;
+
+// The lookup before the index: compare every stored MAC byte by byte
+__attribute__((noinline)) static int linearFind(const ScannedEntry* entries, int count, const uint8_t* mac) {
+  for (int i = 0; i < count; i++) {
+    if (memcmp(entries[i].mac, mac, 6) == 0) return i;
+  }
+  return -1;
+}
+
+static void bench_lookupCostByCount() {
+  const int iterations = 2000000;
+  static const int counts[] = {2, 8, 16, 32};
+  for (int n : counts) {
+    ScannedEntry entries[MAX_PEDAL_SLOTS];
+    MacAddr addrs[MAX_PEDAL_SLOTS];
+    MacIndex index;
+    macIndex_init(&index);
+    for (int i = 0; i < n; i++) {
+      makeMac(i, entries[i].mac);
+      addrs[i] = macAddr_fromBytes(entries[i].mac);
+      macIndex_insert(&index, addrs[i], i);
+    }
+
+    int found = 0;
+    double scanNs = hostTest_nsPerOp(iterations, [&](int i) {
+      found += linearFind(entries, n, entries[i % n].mac) >= 0;
+    });
+    double indexNs = hostTest_nsPerOp(iterations, [&](int i) {
+      found += macIndex_find(&index, addrs[i % n]) >= 0;
+    });
+    hostTest_keep(found);
+    printf("  %2d transmitters: linear scan %6.2f ns, MacIndex %5.2f ns\n", n, scanNs, indexNs);
+  }
+}
+
+int main() {
+  RUN_TEST(test_matchesReferenceUnderChurn);
+  RUN_TEST(bench_lookupCostByCount);
+  return hostTest_finish();
+}
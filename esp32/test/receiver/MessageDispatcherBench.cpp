@@ -0,0 +1,143 @@
+// Per-packet cost of the receiver's message routing (user-002): the original
+// onMessageReceived probe cascade against the msgType-keyed dispatch table. Handlers only
+// count, so the numbers are the routing overhead alone.
+#include "HostTest.h"
+#include "receiver/infrastructure/IngressQueue.cpp"
+#include "receiver/infrastructure/MessageDispatcher.cpp"
+#include "shared/messages.h"
+
+static volatile uint32_t handled[256];
+
+static void countFrame(const IngressFrame* frame) {
+  handled[frame->data[0]]++;
+}
+
+// The routing of the original onMessageReceived: each special message is tried as a cast
+// behind a len >= sizeof() check before the switch over struct_message types.
+__attribute__((noinline)) static void cascade_dispatch(const IngressFrame* frame) {
+  const uint8_t* data = frame->data;
+  int len = frame->len;
+  if (len < 1) return;
+  if (data[0] == MSG_DEBUG_MONITOR_REQ) { countFrame(frame); return; }
+  if (len >= (int)sizeof(transmitter_online_message) &&
+      ((const transmitter_online_message*)data)->msgType == MSG_TRANSMITTER_ONLINE) { countFrame(frame); return; }
+  if (len >= (int)sizeof(pairing_confirmed_message) &&
+      ((const pairing_confirmed_message*)data)->msgType == MSG_PAIRING_CONFIRMED) { countFrame(frame); return; }
+  if (len >= (int)sizeof(pairing_confirmed_ack_message) &&
+      ((const pairing_confirmed_ack_message*)data)->msgType == MSG_PAIRING_CONFIRMED_ACK) { countFrame(frame); return; }
+  if (len >= (int)sizeof(transmitter_paired_message) &&
+      ((const transmitter_paired_message*)data)->msgType == MSG_TRANSMITTER_PAIRED) { countFrame(frame); return; }
+  if (len < (int)sizeof(struct_message)) return;
+  switch (((const struct_message*)data)->msgType) {
+    case MSG_DELETE_RECORD:
+    case MSG_DISCOVERY_REQ:
+    case MSG_PEDAL_EVENT:
+    case MSG_ALIVE:
+      countFrame(frame);
+      break;
+    default:
+      break;
+  }
+}
+
+static MessageDispatcher dispatcher;
+
+static void registerRoutes() {
+  messageDispatcher_init(&dispatcher);
+  messageDispatcher_register(&dispatcher, MSG_PEDAL_EVENT, sizeof(struct_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_DISCOVERY_REQ, sizeof(struct_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_ALIVE, sizeof(struct_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_DELETE_RECORD, sizeof(struct_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_TRANSMITTER_ONLINE, sizeof(transmitter_online_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_TRANSMITTER_PAIRED, sizeof(transmitter_paired_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_PAIRING_CONFIRMED, sizeof(pairing_confirmed_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_PAIRING_CONFIRMED_ACK, sizeof(pairing_confirmed_ack_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_DEBUG_MONITOR_REQ, sizeof(debug_monitor_req_message), countFrame);
+  messageDispatcher_register(&dispatcher, MSG_KEEPALIVE, sizeof(keepalive_message), nullptr);
+}
+
+static IngressFrame makeFrame(uint8_t msgType, uint8_t len) {
+  IngressFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.data[0] = msgType;
+  frame.len = len;
+  return frame;
+}
+
+static void test_routesByTypeAndExactLength() {
+  registerRoutes();
+  memset((void*)handled, 0, sizeof(handled));
+
+  IngressFrame pedal = makeFrame(MSG_PEDAL_EVENT, sizeof(struct_message));
+  CHECK(messageDispatcher_dispatch(&dispatcher, &pedal));
+  CHECK_EQ(handled[MSG_PEDAL_EVENT], 1);
+
+  IngressFrame online = makeFrame(MSG_TRANSMITTER_ONLINE, sizeof(transmitter_online_message));
+  CHECK(messageDispatcher_dispatch(&dispatcher, &online));
+  CHECK_EQ(handled[MSG_TRANSMITTER_ONLINE], 1);
+
+  IngressFrame shortPedal = makeFrame(MSG_PEDAL_EVENT, sizeof(struct_message) - 1);
+  IngressFrame longPedal = makeFrame(MSG_PEDAL_EVENT, sizeof(struct_message) + 1);
+  IngressFrame empty = makeFrame(MSG_PEDAL_EVENT, 0);
+  CHECK(!messageDispatcher_dispatch(&dispatcher, &shortPedal));
+  CHECK(!messageDispatcher_dispatch(&dispatcher, &longPedal));
+  CHECK(!messageDispatcher_dispatch(&dispatcher, &empty));
+  CHECK_EQ(dispatcher.badLength, 3);
+
+  IngressFrame beacon = makeFrame(MSG_BEACON, sizeof(struct_message));
+  CHECK(!messageDispatcher_dispatch(&dispatcher, &beacon));
+  CHECK_EQ(dispatcher.unknownType, 1);
+  CHECK_EQ(dispatcher.dispatched, 2);
+  CHECK_EQ(handled[MSG_PEDAL_EVENT], 1);
+
+  // Accept-only route: counted as dispatched, length still checked
+  IngressFrame keepalive = makeFrame(MSG_KEEPALIVE, sizeof(keepalive_message));
+  IngressFrame longKeepalive = makeFrame(MSG_KEEPALIVE, sizeof(keepalive_message) + 1);
+  CHECK(messageDispatcher_dispatch(&dispatcher, &keepalive));
+  CHECK(!messageDispatcher_dispatch(&dispatcher, &longKeepalive));
+  CHECK_EQ(dispatcher.dispatched, 3);
+  CHECK_EQ(dispatcher.unknownType, 1);
+  CHECK_EQ(dispatcher.badLength, 4);
+}
+
+// Traffic as the receiver sees it in play: mostly pedal events, some keepalive-era pairing
+// chatter. Both routers must deliver the same frames.
+static void bench_perPacketCost() {
+  static const uint8_t mix[][2] = {
+    {MSG_PEDAL_EVENT, sizeof(struct_message)},
+    {MSG_PEDAL_EVENT, sizeof(struct_message)},
+    {MSG_PEDAL_EVENT, sizeof(struct_message)},
+    {MSG_PEDAL_EVENT, sizeof(struct_message)},
+    {MSG_ALIVE, sizeof(struct_message)},
+    {MSG_TRANSMITTER_ONLINE, sizeof(transmitter_online_message)},
+    {MSG_PAIRING_CONFIRMED, sizeof(pairing_confirmed_message)},
+    {MSG_DISCOVERY_REQ, sizeof(struct_message)},
+  };
+  const int mixCount = sizeof(mix) / sizeof(mix[0]);
+  IngressFrame frames[mixCount];
+  for (int i = 0; i < mixCount; i++) frames[i] = makeFrame(mix[i][0], mix[i][1]);
+  IngressFrame pedal = makeFrame(MSG_PEDAL_EVENT, sizeof(struct_message));
+
+  registerRoutes();
+  const int iterations = 2000000;
+
+  memset((void*)handled, 0, sizeof(handled));
+  double cascadePedal = hostTest_nsPerOp(iterations, [&](int) { cascade_dispatch(&pedal); });
+  double cascadeMix = hostTest_nsPerOp(iterations, [&](int i) { cascade_dispatch(&frames[i & 7]); });
+  uint32_t cascadeOnline = handled[MSG_TRANSMITTER_ONLINE];
+
+  memset((void*)handled, 0, sizeof(handled));
+  double tablePedal = hostTest_nsPerOp(iterations, [&](int) { messageDispatcher_dispatch(&dispatcher, &pedal); });
+  double tableMix = hostTest_nsPerOp(iterations, [&](int i) { messageDispatcher_dispatch(&dispatcher, &frames[i & 7]); });
+  CHECK_EQ(handled[MSG_TRANSMITTER_ONLINE], cascadeOnline);
+  CHECK_EQ(dispatcher.badLength + dispatcher.unknownType, 0);
+
+  printf("  pedal event:  cascade %.2f ns, table %.2f ns\n", cascadePedal, tablePedal);
+  printf("  traffic mix:  cascade %.2f ns, table %.2f ns\n", cascadeMix, tableMix);
+}
+
+int main() {
+  RUN_TEST(test_routesByTypeAndExactLength);
+  RUN_TEST(bench_perPacketCost);
+  return hostTest_finish();
+}
@@ -0,0 +1,179 @@
+// MIDI output for pedal keys (user-023): MidiService against a recording sink, and the
+// keyboard service routing bound keys to MIDI instead of the keyboard report - live
+// events, the pre-ready replay and held-key lease expiry.
+#include "HostTest.h"
+#include "KeyboardServiceHost.h"
+
+static const uint8_t MAC_A[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0A};
+static const uint8_t MAC_B[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0B};
+
+// Sustain on the first transmitter's pedal, a kick drum note on the second's
+static const MidiBinding midiBindings[] = {
+  {'l', MIDI_OUTPUT_CC, 1, 64, 127, 0},
+  {'r', MIDI_OUTPUT_NOTE, 10, 36, 100, 0},
+  {0, MIDI_OUTPUT_CC, 0, 0, 0, 0},
+};
+
+struct Recorder {
+  std::vector<HostMidiMessage> messages;
+  bool refuse;
+};
+
+static bool recorder_send(void* context, uint8_t status, uint8_t data1, uint8_t data2) {
+  Recorder* recorder = (Recorder*)context;
+  if (recorder->refuse) return false;
+  recorder->messages.push_back({status, data1, data2});
+  return true;
+}
+
+static bool sameMessages(const std::vector<HostMidiMessage>& got, std::initializer_list<HostMidiMessage> want) {
+  if (got.size() != want.size()) return false;
+  size_t i = 0;
+  for (const HostMidiMessage& w : want) {
+    const HostMidiMessage& g = got[i++];
+    if (g.status != w.status || g.data1 != w.data1 || g.data2 != w.data2) return false;
+  }
+  return true;
+}
+
+static void test_bindingsAreValidated() {
+  Recorder recorder = {};
+  MidiService midi;
+  midiService_init(&midi, {recorder_send, &recorder});
+  for (const MidiBinding* binding = midiBindings; binding->key; binding++) {
+    CHECK(midiService_bind(&midi, binding));
+  }
+  MidiBinding silentNote = {'x', MIDI_OUTPUT_NOTE, 1, 60, 0, 0};  // Velocity 0 is a note off
+  MidiBinding badChannel = {'x', MIDI_OUTPUT_CC, 17, 60, 1, 0};
+  MidiBinding badNumber = {'x', MIDI_OUTPUT_CC, 1, 128, 1, 0};
+  CHECK(!midiService_bind(&midi, &silentNote));
+  CHECK(!midiService_bind(&midi, &badChannel));
+  CHECK(!midiService_bind(&midi, &badNumber));
+  CHECK_EQ(midiService_find(&midi, 'x'), -1);
+  CHECK_EQ(midiService_find(&midi, 'l'), 0);
+  CHECK_EQ(midiService_find(&midi, 'r'), 1);
+
+  // Rebinding a key replaces its entry
+  MidiBinding expression = {'l', MIDI_OUTPUT_CC, 2, 11, 100, 20};
+  CHECK(midiService_bind(&midi, &expression));
+  CHECK_EQ(midi.count, 2);
+  CHECK_EQ(midi.bindings[0].number, 11);
+}
+
+static void test_messagesInEdgeOrder() {
+  Recorder recorder = {};
+  MidiService midi;
+  midiService_init(&midi, {recorder_send, &recorder});
+  for (const MidiBinding* binding = midiBindings; binding->key; binding++) {
+    midiService_bind(&midi, binding);
+  }
+  CHECK(midiService_pedal(&midi, 0, true));
+  CHECK(midiService_pedal(&midi, 1, true));
+  CHECK(midiService_pedal(&midi, 1, false));
+  CHECK(midiService_pedal(&midi, 0, false));
+  CHECK(recorder.messages.empty());  // Nothing until the flush
+  CHECK_EQ(midiService_flush(&midi), 4);
+  CHECK(sameMessages(recorder.messages, {{0xB0, 64, 127}, {0x99, 36, 100}, {0x89, 36, 0}, {0xB0, 64, 0}}));
+  CHECK_EQ(midi.sent, 4);
+}
+
+static void test_overflowAndRefusalsAreCounted() {
+  Recorder recorder = {};
+  MidiService midi;
+  midiService_init(&midi, {recorder_send, &recorder});
+  midiService_bind(&midi, &midiBindings[0]);
+  for (int i = 0; i < MIDI_QUEUE_CAPACITY + 4; i++) {
+    midiService_pedal(&midi, 0, i % 2 == 0);
+  }
+  CHECK_EQ(midi.dropped, 4);
+  CHECK_EQ(midiService_flush(&midi), MIDI_QUEUE_CAPACITY);
+
+  recorder.refuse = true;
+  midiService_pedal(&midi, 0, true);
+  CHECK_EQ(midiService_flush(&midi), 0);
+  CHECK_EQ(midi.dropped, 5);
+  CHECK_EQ(midi.queued, 0);  // Not retried
+
+  char buffer[96];
+  midiService_format(&midi, buffer, sizeof(buffer));
+  CHECK(strcmp(buffer, "1 binding(s), 16 message(s) sent, 5 dropped") == 0);
+}
+
+static void setUp() {
+  keyboardHost_reset();
+  keyboardHost_addTransmitter(MAC_A, PEDAL_MODE_SINGLE);
+  keyboardHost_addTransmitter(MAC_B, PEDAL_MODE_SINGLE);
+  keyboardService_setMidi(&keyboard, midiBindings);
+}
+
+// A bound pedal sends MIDI in the same pass and never touches the keyboard report
+static void test_boundPedalSendsMidiInsteadOfTyping() {
+  setUp();
+  keyboardHost_mount();
+  keyboardHost_pedal(MAC_A, '1', true);
+  CHECK(sameMessages(hostMidi_messages, {{0xB0, 64, 127}}));
+  keyboardHost_pedal(MAC_B, '1', true);
+  keyboardHost_pedal(MAC_B, '1', false);
+  keyboardHost_pedal(MAC_A, '1', false);
+  CHECK(sameMessages(hostMidi_messages, {{0xB0, 64, 127}, {0x99, 36, 100}, {0x89, 36, 0}, {0xB0, 64, 0}}));
+  CHECK(hostNkro_reports.empty());
+}
+
+// Edges from before the host mounted are replayed in order, MIDI and keys alike
+static void test_preReadyReplayKeepsMidiEdges() {
+  setUp();
+  keyboardHost_pedal(MAC_A, '1', true);
+  keyboardHost_pedal(MAC_A, '1', false);
+  CHECK(hostMidi_messages.empty());
+  CHECK_EQ(keyboard.preReadyCount, 2);
+
+  keyboardHost_mount();
+  keyboardHost_runTimers();
+  CHECK(sameMessages(hostMidi_messages, {{0xB0, 64, 127}, {0xB0, 64, 0}}));
+  CHECK_EQ(keyboard.preReadyReplayed, 2);
+}
+
+// A transmitter lost with the sustain down releases it when its held-key lease runs out
+static void test_leaseExpiryReleasesHeldCc() {
+  setUp();
+  keyboardHost_mount();
+  struct_message press = {MSG_PEDAL_EVENT, '1', true, PEDAL_MODE_SINGLE | PEDAL_EVENT_FLAG_KEEPALIVE};
+  keyboardService_handlePedalEvent(&keyboard, macAddr_fromBytes(MAC_A), &press, esp_timer_get_time());
+  keyboardService_flush(&keyboard);
+  CHECK(sameMessages(hostMidi_messages, {{0xB0, 64, 127}}));
+
+  hostClock_advanceMs(HELD_KEY_LEASE_MS - 1);
+  keyboardHost_runTimers();
+  CHECK_EQ(hostMidi_messages.size(), 1);
+  hostClock_advanceMs(1);
+  keyboardHost_runTimers();
+  CHECK(sameMessages(hostMidi_messages, {{0xB0, 64, 127}, {0xB0, 64, 0}}));
+  CHECK_EQ(keyboard.leaseExpiries, 1);
+}
+
+static void bench_midiEdge() {
+  setUp();
+  keyboardHost_mount();
+  MacAddr addr = macAddr_fromBytes(MAC_A);
+  struct_message press = {MSG_PEDAL_EVENT, '1', true, PEDAL_MODE_SINGLE};
+  struct_message release = {MSG_PEDAL_EVENT, '1', false, PEDAL_MODE_SINGLE};
+  double ns = hostTest_nsPerOp(200000, [&](int) {
+    keyboardService_handlePedalEvent(&keyboard, addr, &press, esp_timer_get_time());
+    keyboardService_flush(&keyboard);
+    keyboardService_handlePedalEvent(&keyboard, addr, &release, esp_timer_get_time());
+    keyboardService_flush(&keyboard);
+    hostMidi_messages.clear();
+  });
+  printf("  sustain press + release (two CC messages): %.0f ns\n", ns);
+}
+
+int main() {
+  RUN_TEST(test_bindingsAreValidated);
+  RUN_TEST(test_messagesInEdgeOrder);
+  RUN_TEST(test_overflowAndRefusalsAreCounted);
+  RUN_TEST(test_boundPedalSendsMidiInsteadOfTyping);
+  RUN_TEST(test_preReadyReplayKeepsMidiEdges);
+  RUN_TEST(test_leaseExpiryReleasesHeldCc);
+  RUN_TEST(bench_midiEdge);
+  return hostTest_finish();
+}
@@ -0,0 +1,98 @@
+// NKRO keyboard reports through the keyboard service (user-024): a report the host was not
+// ready for is resent on the next HID task pass with the whole held set, and the form
+// switch to and from the boot protocol clears the old form before the new one is used.
+#include "HostTest.h"
+#include "KeyboardServiceHost.h"
+
+static const uint8_t MAC_A[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0A};
+static const uint8_t MAC_B[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0B};
+
+static char keyA;
+static char keyB;
+
+static void setUp() {
+  keyboardHost_reset();
+  keyboardHost_addTransmitter(MAC_A, PEDAL_MODE_SINGLE);
+  keyboardHost_addTransmitter(MAC_B, PEDAL_MODE_SINGLE);
+  keyA = keyboardHost_keyFor(MAC_A, '1');
+  keyB = keyboardHost_keyFor(MAC_B, '1');
+  keyboardHost_mount();
+  hostClock_setUs(1000 * 1000);
+}
+
+static void test_pressesGoOutAsNkroReports() {
+  setUp();
+  keyboardHost_pedal(MAC_A, '1', true);
+  keyboardHost_pedal(MAC_B, '1', true);
+  CHECK_EQ(hostNkro_reports.size(), 2);
+  CHECK(keyboardHost_isHeld(hostNkro_reports.back(), keyA));
+  CHECK(keyboardHost_isHeld(hostNkro_reports.back(), keyB));
+  CHECK(hostUsb_keyReports.empty());
+  CHECK_EQ(keyboardService_timeUntilNextTimerMs(&keyboard, millis()), KEY_SEQUENCER_NO_DEADLINE);
+}
+
+// The failed report's changes were already built; the next pass sends them anyway
+static void test_failedSendIsResentNextPass() {
+  setUp();
+  hostNkro_failSends = 1;
+  keyboardHost_pedal(MAC_A, '1', true);
+  CHECK(hostNkro_reports.empty());
+  CHECK_EQ(keyboard.reportSendFailures, 1);
+  CHECK_EQ(keyboardService_timeUntilNextTimerMs(&keyboard, millis()), HID_REPORT_RETRY_MS);
+
+  hostClock_advanceMs(HID_REPORT_RETRY_MS);
+  keyboardHost_runTimers();
+  CHECK_EQ(hostNkro_reports.size(), 1);
+  CHECK(keyboardHost_isHeld(hostNkro_reports.back(), keyA));
+  CHECK_EQ(keyboardService_timeUntilNextTimerMs(&keyboard, millis()), KEY_SEQUENCER_NO_DEADLINE);
+}
+
+// A release whose report is lost must still reach the host, or the key stays down
+static void test_failedReleaseIsNotLost() {
+  setUp();
+  keyboardHost_pedal(MAC_A, '1', true);
+  keyboardHost_pedal(MAC_B, '1', true);
+  hostNkro_failSends = 3;
+  keyboardHost_pedal(MAC_A, '1', false);
+  keyboardHost_runTimers();
+  keyboardHost_runTimers();
+  CHECK_EQ(hostNkro_reports.size(), 2);
+  keyboardHost_runTimers();
+  CHECK_EQ(hostNkro_reports.size(), 3);
+  CHECK(keyboardHost_history(keyA) == "DU");
+  CHECK(keyboardHost_isHeld(hostNkro_reports.back(), keyB));
+  CHECK_EQ(keyboard.reportSendFailures, 3);
+}
+
+// Boot protocol: the NKRO form is cleared before the 6-key form takes over. If that clear
+// fails the switch waits for the next pass rather than leaving the NKRO key held
+static void test_switchToBootClearsNkroFirst() {
+  setUp();
+  keyboardHost_pedal(MAC_A, '1', true);
+  hostNkro_active = false;
+  hostNkro_failSends = 1;
+  keyboardHost_runTimers();
+  CHECK(hostUsb_keyReports.empty());
+  CHECK(keyboard.nkroReport);
+
+  keyboardHost_runTimers();
+  CHECK_EQ(hostNkro_reports.size(), 2);
+  CHECK(!keyboardHost_isHeld(hostNkro_reports.back(), keyA));
+  CHECK_EQ(hostUsb_keyReports.size(), 1);
+  CHECK(keyboardHost_isHeld(hostUsb_keyReports.back(), keyA));
+
+  // And back: the 6-key form is cleared, the NKRO report carries the held set
+  hostNkro_active = true;
+  keyboardHost_runTimers();
+  CHECK_EQ(hostUsb_keyReports.size(), 2);
+  CHECK(!keyboardHost_isHeld(hostUsb_keyReports.back(), keyA));
+  CHECK(keyboardHost_isHeld(hostNkro_reports.back(), keyA));
+}
+
+int main() {
+  RUN_TEST(test_pressesGoOutAsNkroReports);
+  RUN_TEST(test_failedSendIsResentNextPass);
+  RUN_TEST(test_failedReleaseIsNotLost);
+  RUN_TEST(test_switchToBootClearsNkroFirst);
+  return hostTest_finish();
+}
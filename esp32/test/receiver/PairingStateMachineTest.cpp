@@ -0,0 +1,169 @@
+// Scripted event sequences for the receiver pairing state machine (user-012). The table
+// has the receiver's rows (application/PairingService.cpp) with recording actions in place
+// of the radio work; time only moves to the next armed deadline, so every update posts
+// something - no polling passes.
+#include "HostTest.h"
+#include <string>
+#include <vector>
+#include "receiver/shared/config.h"
+#include "receiver/domain/PairingStateMachine.cpp"
+
+static PairingStateMachine fsm;
+static bool slotsFull;
+static int beacons;
+static std::vector<std::string> trace;
+static const unsigned long bootTime = 0;
+
+static PairingEvent onPingSent(void*, unsigned long now) {
+  pairingStateMachine_arm(&fsm, PAIRING_EVENT_INITIAL_WAIT_DONE, now + INITIAL_PING_WAIT_MS);
+  return PAIRING_EVENT_NONE;
+}
+
+static PairingEvent onInitialWaitDone(void*, unsigned long now) {
+  if (slotsFull) return PAIRING_EVENT_SLOTS_FULL;
+  pairingStateMachine_arm(&fsm, PAIRING_EVENT_GRACE_EXPIRED, bootTime + TRANSMITTER_TIMEOUT_MS);
+  pairingStateMachine_arm(&fsm, PAIRING_EVENT_BEACON_DUE, now);
+  return PAIRING_EVENT_NONE;
+}
+
+static PairingEvent onBeaconDue(void*, unsigned long now) {
+  beacons++;
+  pairingStateMachine_arm(&fsm, PAIRING_EVENT_BEACON_DUE, now + BEACON_INTERVAL_MS);
+  return PAIRING_EVENT_NONE;
+}
+
+static const PairingTransition transitions[] = {
+  {PAIRING_STATE_BOOT,         PAIRING_EVENT_PING_SENT,         PAIRING_STATE_INITIAL_WAIT,     onPingSent},
+  {PAIRING_STATE_INITIAL_WAIT, PAIRING_EVENT_INITIAL_WAIT_DONE, PAIRING_STATE_GRACE_PERIOD,     onInitialWaitDone},
+  {PAIRING_STATE_GRACE_PERIOD, PAIRING_EVENT_BEACON_DUE,        PAIRING_STATE_GRACE_PERIOD,     onBeaconDue},
+  {PAIRING_STATE_GRACE_PERIOD, PAIRING_EVENT_GRACE_EXPIRED,     PAIRING_STATE_NORMAL_OPERATION, nullptr},
+  {PAIRING_STATE_GRACE_PERIOD, PAIRING_EVENT_SLOTS_FULL,        PAIRING_STATE_SLOTS_FULL,       nullptr},
+};
+enum { ROW_PING, ROW_WAIT_DONE, ROW_BEACON, ROW_EXPIRED, ROW_FULL };
+
+static void recordTransition(void*, PairingState from, PairingState to, PairingEvent) {
+  trace.push_back(std::string(pairingStateMachine_stateName(from)) + ">" + pairingStateMachine_stateName(to));
+}
+
+static void setUp(bool full) {
+  slotsFull = full;
+  beacons = 0;
+  trace.clear();
+  pairingStateMachine_init(&fsm, transitions, sizeof(transitions) / sizeof(transitions[0]), nullptr,
+                           PAIRING_STATE_BOOT, bootTime);
+  pairingStateMachine_setObserver(&fsm, recordTransition);
+}
+
+// Jump straight to each deadline up to `until`; returns how many updates ran
+static int runUntil(unsigned long* now, unsigned long until) {
+  int updates = 0;
+  while (true) {
+    unsigned long wait = pairingStateMachine_timeUntilNextMs(&fsm, *now);
+    if (wait == ULONG_MAX || *now + wait > until) break;
+    *now += wait;
+    CHECK(pairingStateMachine_update(&fsm, *now) > 0);
+    updates++;
+  }
+  *now = until;
+  return updates;
+}
+
+static void test_bootThroughGracePeriod() {
+  setUp(false);
+  unsigned long now = bootTime;
+  CHECK(pairingStateMachine_post(&fsm, PAIRING_EVENT_PING_SENT, now));
+  CHECK_EQ(fsm.state, PAIRING_STATE_INITIAL_WAIT);
+  CHECK_EQ(pairingStateMachine_timeUntilNextMs(&fsm, now), INITIAL_PING_WAIT_MS);
+  CHECK_EQ(pairingStateMachine_update(&fsm, INITIAL_PING_WAIT_MS - 1), 0);
+
+  int updates = runUntil(&now, bootTime + TRANSMITTER_TIMEOUT_MS + 10000);
+  int expectedBeacons = (TRANSMITTER_TIMEOUT_MS - INITIAL_PING_WAIT_MS + BEACON_INTERVAL_MS - 1) / BEACON_INTERVAL_MS;
+  CHECK_EQ(fsm.state, PAIRING_STATE_NORMAL_OPERATION);
+  CHECK_EQ(beacons, expectedBeacons);
+  // Wait done (first beacon chained in the same update), then one per later beacon, then expiry
+  CHECK_EQ(updates, 1 + (expectedBeacons - 1) + 1);
+  CHECK_EQ(pairingStateMachine_timeUntilNextMs(&fsm, now), ULONG_MAX);
+
+  CHECK_EQ(fsm.transitionCounts[ROW_PING], 1);
+  CHECK_EQ(fsm.transitionCounts[ROW_WAIT_DONE], 1);
+  CHECK_EQ(fsm.transitionCounts[ROW_BEACON], expectedBeacons);
+  CHECK_EQ(fsm.transitionCounts[ROW_EXPIRED], 1);
+  CHECK_EQ(fsm.transitionCounts[ROW_FULL], 0);
+  CHECK_EQ(pairingStateMachine_dwellMs(&fsm, PAIRING_STATE_BOOT, now), 0);
+  CHECK_EQ(pairingStateMachine_dwellMs(&fsm, PAIRING_STATE_INITIAL_WAIT, now), INITIAL_PING_WAIT_MS);
+  CHECK_EQ(pairingStateMachine_dwellMs(&fsm, PAIRING_STATE_GRACE_PERIOD, now),
+           TRANSMITTER_TIMEOUT_MS - INITIAL_PING_WAIT_MS);
+  CHECK_EQ(pairingStateMachine_dwellMs(&fsm, PAIRING_STATE_NORMAL_OPERATION, now), 10000);
+  // Beacons re-enter GRACE_PERIOD without a state change, so the observer sees three
+  CHECK(trace == std::vector<std::string>({"BOOT>INITIAL_WAIT", "INITIAL_WAIT>GRACE_PERIOD",
+                                           "GRACE_PERIOD>NORMAL_OPERATION"}));
+
+  char line[200];
+  pairingStateMachine_format(&fsm, now, line, sizeof(line));
+  char expected[40];
+  snprintf(expected, sizeof(expected), "GRACE_PERIOD:%lums", (unsigned long)(TRANSMITTER_TIMEOUT_MS - INITIAL_PING_WAIT_MS));
+  CHECK(strstr(line, expected) != nullptr);
+}
+
+// Every slot came back during the initial wait: the follow-up event skips the grace period
+// in the same post, and no timer is left behind
+static void test_slotsFullAfterInitialWaitSkipsGracePeriod() {
+  setUp(true);
+  unsigned long now = bootTime;
+  pairingStateMachine_post(&fsm, PAIRING_EVENT_PING_SENT, now);
+  runUntil(&now, bootTime + TRANSMITTER_TIMEOUT_MS);
+  CHECK_EQ(fsm.state, PAIRING_STATE_SLOTS_FULL);
+  CHECK_EQ(beacons, 0);
+  CHECK_EQ(fsm.armed, 0);
+  CHECK(trace == std::vector<std::string>({"BOOT>INITIAL_WAIT", "INITIAL_WAIT>GRACE_PERIOD",
+                                           "GRACE_PERIOD>SLOTS_FULL"}));
+}
+
+// Slots fill up mid grace period: leaving the state disarms its beacon and expiry timers
+static void test_slotsFullMidGraceStopsBeacons() {
+  setUp(false);
+  unsigned long now = bootTime;
+  pairingStateMachine_post(&fsm, PAIRING_EVENT_PING_SENT, now);
+  runUntil(&now, 5000);
+  int beaconsBefore = beacons;
+  CHECK(pairingStateMachine_post(&fsm, PAIRING_EVENT_SLOTS_FULL, now));
+  CHECK_EQ(fsm.state, PAIRING_STATE_SLOTS_FULL);
+  CHECK_EQ(runUntil(&now, 60000), 0);
+  CHECK_EQ(beacons, beaconsBefore);
+}
+
+static void test_eventsWithoutARowAreIgnored() {
+  setUp(false);
+  CHECK(!pairingStateMachine_post(&fsm, PAIRING_EVENT_SLOTS_FULL, 10));
+  CHECK(!pairingStateMachine_post(&fsm, PAIRING_EVENT_GRACE_EXPIRED, 10));
+  CHECK_EQ(fsm.ignoredEvents, 2);
+  CHECK_EQ(fsm.state, PAIRING_STATE_BOOT);
+  CHECK(trace.empty());
+
+  // Arming NONE or an out-of-range event is refused
+  pairingStateMachine_arm(&fsm, PAIRING_EVENT_NONE, 0);
+  pairingStateMachine_arm(&fsm, PAIRING_EVENT_COUNT, 0);
+  CHECK_EQ(fsm.armed, 0);
+}
+
+// millis() wraps after ~49 days; deadlines are compared as signed differences
+static void test_timersSurviveMillisWrap() {
+  unsigned long start = ULONG_MAX - 500;
+  slotsFull = false;
+  beacons = 0;
+  pairingStateMachine_init(&fsm, transitions, 5, nullptr, PAIRING_STATE_BOOT, start);
+  pairingStateMachine_post(&fsm, PAIRING_EVENT_PING_SENT, start);
+  CHECK_EQ(pairingStateMachine_timeUntilNextMs(&fsm, start), INITIAL_PING_WAIT_MS);
+  CHECK_EQ(pairingStateMachine_update(&fsm, start + 999), 0);
+  CHECK(pairingStateMachine_update(&fsm, start + INITIAL_PING_WAIT_MS) > 0);
+  CHECK_EQ(fsm.state, PAIRING_STATE_GRACE_PERIOD);
+}
+
+int main() {
+  RUN_TEST(test_bootThroughGracePeriod);
+  RUN_TEST(test_slotsFullAfterInitialWaitSkipsGracePeriod);
+  RUN_TEST(test_slotsFullMidGraceStopsBeacons);
+  RUN_TEST(test_eventsWithoutARowAreIgnored);
+  RUN_TEST(test_timersSurviveMillisWrap);
+  return hostTest_finish();
+}
@@ -0,0 +1,268 @@
+// Receiver persistence against a map-backed fake NVS store (user-015): bursts coalesce into
+// one write after the quiet period, copies alternate A/B, a failed write is retried, the
+// newest valid copy wins on load and legacy keys are migrated once. Ends with load/save
+// timings for a full table.
+#include "HostTest.h"
+#include <map>
+#include <string>
+#include <vector>
+#include "receiver/domain/MacIndex.cpp"
+#include "receiver/domain/SlotAllocator.cpp"
+#include "receiver/domain/TransmitterManager.cpp"
+#include "receiver/infrastructure/Persistence.cpp"
+
+// NVS namespace as a map; counts writes and can fail the next ones
+struct FakeNvs {
+  std::map<std::string, std::vector<uint8_t>> values;
+  int writes = 0;
+  int failWrites = 0;
+  bool legacy = false;        // Pre-blob keys present
+  int legacyRemovals = 0;
+};
+
+static size_t fakeRead(void* context, const char* key, void* buffer, size_t len) {
+  FakeNvs* nvs = (FakeNvs*)context;
+  auto it = nvs->values.find(key);
+  if (it == nvs->values.end() || it->second.size() != len) return 0;
+  memcpy(buffer, it->second.data(), len);
+  return len;
+}
+
+static bool fakeWrite(void* context, const char* key, const void* data, size_t len) {
+  FakeNvs* nvs = (FakeNvs*)context;
+  nvs->writes++;
+  if (nvs->failWrites > 0) {
+    nvs->failWrites--;
+    return false;
+  }
+  nvs->values[key] = std::vector<uint8_t>((const uint8_t*)data, (const uint8_t*)data + len);
+  return true;
+}
+
+static bool fakeRemove(void* context, const char* key) {
+  return ((FakeNvs*)context)->values.erase(key) > 0;
+}
+
+static bool fakeLoadLegacy(void* context, PersistedRecord* record) {
+  FakeNvs* nvs = (FakeNvs*)context;
+  if (!nvs->legacy) return false;
+  uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x77};
+  memcpy(record->transmitters[0].mac, mac, 6);
+  record->transmitters[0].pedalMode = PEDAL_MODE_DUAL;
+  return true;
+}
+
+static void fakeRemoveLegacy(void* context) {
+  FakeNvs* nvs = (FakeNvs*)context;
+  nvs->legacy = false;
+  nvs->legacyRemovals++;
+}
+
+static FakeNvs nvs;
+static const PersistenceStore fakeStore = {&nvs, fakeRead, fakeWrite, fakeRemove, fakeLoadLegacy, fakeRemoveLegacy};
+
+static TransmitterManager manager;
+static Persistence persistence;
+
+static void makeMac(int i, uint8_t* mac) {
+  uint8_t bytes[6] = {0x24, 0x6F, 0x28, 0x00, (uint8_t)(i >> 8), (uint8_t)(i + 1)};
+  memcpy(mac, bytes, 6);
+}
+
+static void bootWith(FakeNvs initial) {
+  nvs = initial;
+  hostClock_setUs(0);
+  transmitterManager_init(&manager);
+  persistence_init(&persistence, &fakeStore);
+  persistence_load(&persistence, &manager);
+}
+
+static bool updateAfterMs(unsigned long ms) {
+  hostClock_advanceMs(ms);
+  return persistence_update(&persistence, &manager, millis());
+}
+
+static void test_burstCoalescesIntoOneWrite() {
+  bootWith(FakeNvs());
+  CHECK_EQ(manager.count, 0);
+  CHECK(!updateAfterMs(0));  // Loaded state matches the empty record
+
+  // Ten discovery requests from three transmitters, 100 ms apart
+  for (int i = 0; i < 10; i++) {
+    uint8_t mac[6];
+    makeMac(i % 3, mac);
+    if (transmitterManager_findIndex(&manager, macAddr_fromBytes(mac)) < 0) {
+      transmitterManager_add(&manager, mac, PEDAL_MODE_SINGLE);
+    } else {
+      manager.version++;  // Re-discovery touches the manager without changing the record
+    }
+    CHECK(!updateAfterMs(100));
+  }
+  CHECK_EQ(nvs.writes, 0);
+  CHECK(persistence.coalesced >= 2);
+  CHECK(persistence_timeUntilCommitMs(&persistence, millis()) > 0);
+
+  CHECK(updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS));
+  CHECK_EQ(nvs.writes, 1);
+  CHECK_EQ(persistence_timeUntilCommitMs(&persistence, millis()), ULONG_MAX);
+
+  // Nothing new: no further writes however long the loop runs
+  for (int i = 0; i < 10; i++) updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS);
+  CHECK_EQ(nvs.writes, 1);
+}
+
+static void test_changeRevertedBeforeCommitWritesNothing() {
+  bootWith(FakeNvs());
+  uint8_t mac[6];
+  makeMac(5, mac);
+  int index = transmitterManager_place(&manager, mac, PEDAL_MODE_SINGLE);
+  CHECK(!updateAfterMs(10));
+  transmitterManager_remove(&manager, index);
+  CHECK(!updateAfterMs(10));
+  CHECK(!persistence.dirty);
+  CHECK(!updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS * 2));
+  CHECK_EQ(nvs.writes, 0);
+}
+
+static void test_copiesAlternateAndNewestWins() {
+  bootWith(FakeNvs());
+  uint8_t mac[6];
+  makeMac(0, mac);
+  transmitterManager_add(&manager, mac, PEDAL_MODE_DUAL);
+  updateAfterMs(0);
+  CHECK(updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS));
+  CHECK(nvs.values.count("stateA") == 1 && nvs.values.count("stateB") == 0);
+
+  makeMac(1, mac);
+  transmitterManager_add(&manager, mac, PEDAL_MODE_SINGLE);
+  updateAfterMs(0);
+  CHECK(updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS));
+  CHECK(nvs.values.count("stateB") == 1);
+  uint32_t newestSequence = persistence.committed.sequence;
+
+  // Reboot: both transmitters back at their positions, live again with the same slots
+  TransmitterManager before = manager;
+  bootWith(nvs);
+  CHECK_EQ(persistence.committed.sequence, newestSequence);
+  CHECK_EQ(persistence.nextCopy, 0);  // B was newest, so A is overwritten next
+  CHECK_EQ(manager.occupied, before.occupied);
+  CHECK_EQ(manager.responsive, before.responsive);
+  for (int i = 0; i < 2; i++) {
+    CHECK(memcmp(manager.transmitters[i].mac, before.transmitters[i].mac, 6) == 0);
+    CHECK_EQ(manager.transmitters[i].slotMask, before.transmitters[i].slotMask);
+  }
+
+  // A torn newest copy (reset mid-write) falls back to the older one
+  FakeNvs torn = nvs;
+  torn.values["stateB"][20] ^= 0xFF;
+  bootWith(torn);
+  CHECK_EQ(persistence.committed.sequence, newestSequence - 1);
+  CHECK_EQ(transmitterManager_pairedCount(&manager), 1);
+  CHECK_EQ(persistence.nextCopy, 1);  // The torn copy is the one rewritten
+}
+
+static void test_failedWriteIsRetriedAfterQuietPeriod() {
+  bootWith(FakeNvs());
+  uint8_t mac[6];
+  makeMac(0, mac);
+  transmitterManager_add(&manager, mac, PEDAL_MODE_SINGLE);
+  updateAfterMs(0);
+
+  nvs.failWrites = 1;
+  CHECK(!updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS));
+  CHECK_EQ(persistence.commitFailures, 1);
+  CHECK(persistence.dirty);
+  CHECK(!updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS - 1));  // Waits a full quiet period again
+  CHECK(updateAfterMs(1));
+  CHECK_EQ(nvs.writes, 2);
+  CHECK_EQ(persistence.commits, 1);
+  CHECK(!persistence.dirty);
+
+  // The retried copy is the one that loads
+  bootWith(nvs);
+  CHECK_EQ(transmitterManager_pairedCount(&manager), 1);
+}
+
+static void test_legacyKeysMigrateOnce() {
+  FakeNvs legacy;
+  legacy.legacy = true;
+  bootWith(legacy);
+  CHECK_EQ(transmitterManager_pairedCount(&manager), 1);
+  CHECK(persistence.migrated);
+
+  updateAfterMs(0);  // First loop pass after boot
+  CHECK(updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS));
+  CHECK_EQ(nvs.legacyRemovals, 1);
+  CHECK(!persistence.migrated);
+
+  bootWith(nvs);
+  CHECK_EQ(transmitterManager_pairedCount(&manager), 1);
+  CHECK(!persistence.migrated);
+  CHECK_EQ(nvs.legacyRemovals, 1);
+}
+
+static void test_debugMonitorAndChannelRideAlong() {
+  bootWith(FakeNvs());
+  updateAfterMs(0);
+  uint8_t monitor[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+  persistence_saveDebugMonitor(&persistence, monitor);
+  persistence_noteChannel(&persistence, 6, millis());
+  CHECK(updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS));
+  CHECK_EQ(nvs.writes, 1);
+
+  bootWith(nvs);
+  uint8_t mac[6];
+  bool paired = false;
+  persistence_loadDebugMonitor(&persistence, mac, &paired);
+  CHECK(paired);
+  CHECK(memcmp(mac, monitor, 6) == 0);
+  CHECK_EQ(persistence_channel(&persistence), 6);
+}
+
+static void bench_fullTableLoadAndSave() {
+  bootWith(FakeNvs());
+  for (int i = 0; i < MAX_PEDAL_SLOTS; i++) {
+    uint8_t mac[6];
+    makeMac(i, mac);
+    transmitterManager_add(&manager, mac, PEDAL_MODE_SINGLE);
+  }
+  updateAfterMs(0);
+  CHECK(updateAfterMs(PERSISTENCE_COMMIT_DELAY_MS));
+  FakeNvs saved = nvs;
+
+  const int iterations = 20000;
+  double updateNs = hostTest_nsPerOp(iterations, [&](int) {
+    persistence_update(&persistence, &manager, millis());  // Version unchanged: O(1)
+  });
+  double changeNs = hostTest_nsPerOp(iterations, [&](int) {
+    persistence.observedVersion = ~0u;  // Force the record copy and payload compare
+    persistence_update(&persistence, &manager, millis());
+  });
+  double commitNs = hostTest_nsPerOp(iterations, [&](int) {
+    persistence.dirty = true;
+    persistence_flush(&persistence);
+  });
+  double loadNs = hostTest_nsPerOp(2000, [&](int) {
+    TransmitterManager loaded;
+    Persistence reader;
+    transmitterManager_init(&loaded);
+    persistence_init(&reader, &fakeStore);
+    persistence_load(&reader, &loaded);
+    hostTest_keep(loaded);
+  });
+  nvs = saved;
+  printf("  %d transmitters (%d-byte record): idle update %.0f ns, changed-state update %.0f ns,\n"
+         "  commit %.0f ns, load %.0f ns (fake store; NVS flash time not included)\n",
+         MAX_PEDAL_SLOTS, (int)sizeof(PersistedRecord), updateNs, changeNs, commitNs, loadNs);
+}
+
+int main() {
+  RUN_TEST(test_burstCoalescesIntoOneWrite);
+  RUN_TEST(test_changeRevertedBeforeCommitWritesNothing);
+  RUN_TEST(test_copiesAlternateAndNewestWins);
+  RUN_TEST(test_failedWriteIsRetriedAfterQuietPeriod);
+  RUN_TEST(test_legacyKeysMigrateOnce);
+  RUN_TEST(test_debugMonitorAndChannelRideAlong);
+  RUN_TEST(bench_fullTableLoadAndSave);
+  return hostTest_finish();
+}
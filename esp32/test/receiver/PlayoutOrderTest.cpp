@@ -0,0 +1,140 @@
+// Timed pedal events through the keyboard service (user-020): whatever path an event takes
+// - held until its playout time, played late, played early because the playout queue is
+// full, or replayed after an unmount - one input's press and release reach the host in edge
+// order, so a release never overtakes its press and leaves the key stuck.
+// Edge times are the transmitter's clock; the frame arrives at the current fake time.
+#include "HostTest.h"
+#include "KeyboardServiceHost.h"
+
+static const uint8_t MAC_A[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0A};
+static const uint8_t MAC_B[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x0B};
+
+static char keyA;
+static char keyB;
+
+static void setUp() {
+  keyboardHost_reset();
+  keyboardHost_addTransmitter(MAC_A, PEDAL_MODE_SINGLE);
+  keyboardHost_addTransmitter(MAC_B, PEDAL_MODE_SINGLE);
+  keyA = keyboardHost_keyFor(MAC_A, '1');
+  keyB = keyboardHost_keyFor(MAC_B, '1');
+  keyboardHost_mount();
+}
+
+static void frameAt(uint32_t rxUs, const uint8_t* mac, bool pressed, uint32_t edgeUs) {
+  hostClock_setUs(rxUs);
+  keyboardHost_timedPedal(mac, '1', pressed, edgeUs);
+}
+
+static void runTimersAt(uint32_t nowUs) {
+  hostClock_setUs(nowUs);
+  keyboardHost_runTimers();
+}
+
+static void test_eventsWaitForTheirPlayoutTime() {
+  setUp();
+  CHECK(keyA != 0 && keyB != 0 && keyA != keyB);
+  frameAt(2000, MAC_A, true, 0);  // Due at edge + fastest delivery + PLAYOUT_DELAY_MS
+  frameAt(4000, MAC_A, false, 1500);
+  CHECK(hostNkro_reports.empty());
+  CHECK_EQ(keyboard.playout.queued, 2);
+
+  runTimersAt(2000 + PLAYOUT_DELAY_MS * 1000);
+  CHECK(keyboardHost_history(keyA) == "D");
+  runTimersAt(2000 + PLAYOUT_DELAY_MS * 1000 + 1500);
+  CHECK(keyboardHost_history(keyA) == "DU");
+  CHECK_EQ(keyboard.playout.late + keyboard.playout.overflows, 0);
+}
+
+// Fill the queue behind A's press with B's edges, 100 us apart
+static void fillQueueWithB(uint32_t startRxUs) {
+  for (uint32_t rx = startRxUs; keyboard.playout.queued < PLAYOUT_BUFFER_CAPACITY; rx += 100) {
+    bool pressed = ((rx - startRxUs) / 100) % 2 == 0;
+    frameAt(rx, MAC_B, pressed, rx - 2000);
+  }
+}
+
+// The release finds the queue full: A's queued press is played ahead of time to make room,
+// never skipped by the release
+static void test_fullQueuePlaysEarlierEventsFirst() {
+  setUp();
+  frameAt(2000, MAC_A, true, 0);
+  fillQueueWithB(2100);
+  CHECK(hostNkro_reports.empty());
+
+  frameAt(3700, MAC_A, false, 1700);
+  CHECK(keyboardHost_history(keyA) == "D");  // Press went out early, release waits its turn
+  CHECK_EQ(keyboard.playout.overflows, 1);
+  CHECK_EQ(keyboard.playout.queued, PLAYOUT_BUFFER_CAPACITY);
+
+  runTimersAt(20000);
+  CHECK(keyboardHost_history(keyA) == "DU");
+  CHECK_EQ(keyboard.playout.queued, 0);
+}
+
+// A slow-delivered press due before everything queued is played at once: nothing of its
+// transmitter is waiting, so it overtakes nobody
+static void test_fullQueuePlaysEarliestArrivalNow() {
+  setUp();
+  frameAt(1000, MAC_A, true, 0);
+  frameAt(2000, MAC_A, false, 1000);
+  runTimersAt(10000);
+  CHECK(keyboardHost_history(keyA) == "DU");
+
+  fillQueueWithB(11000);
+  frameAt(13000, MAC_A, true, 9000);  // Due 18000, before B's first at 19000
+  CHECK(keyboardHost_history(keyA) == "DUD");
+  CHECK_EQ(keyboard.playout.overflows, 1);
+  CHECK_EQ(keyboard.playout.queued, PLAYOUT_BUFFER_CAPACITY);
+}
+
+// A release that arrives after its playout time while its press still waits in the queue
+// (the timer pass has not run yet) plays after that press
+static void test_lateReleaseWaitsForQueuedPress() {
+  setUp();
+  frameAt(2000, MAC_A, true, 0);  // Due 10000
+  frameAt(12000, MAC_A, false, 1000);  // Due 11000: late, press still queued
+  CHECK_EQ(keyboard.playout.late, 1);
+  CHECK(keyboardHost_history(keyA) == "DU");
+  CHECK_EQ(hostNkro_reports.size(), 2);  // Two reports, so the host sees the tap
+  CHECK_EQ(keyboard.playout.queued, 0);
+}
+
+// A faster delivery while A's release is still queued must not schedule A's next press
+// ahead of that release
+static void test_fasterDeliveryKeepsEdgeOrder() {
+  setUp();
+  frameAt(5000, MAC_A, true, 0);  // Offset 5000, due 13000
+  runTimersAt(13000);
+  frameAt(21000, MAC_A, false, 20000);  // Held 20 ms: due 33000
+  frameAt(21500, MAC_A, true, 21000);   // Offset now 500: would be due 29500
+  runTimersAt(40000);
+  CHECK(keyboardHost_history(keyA) == "DUD");
+}
+
+// Events still buffered when the host goes away reach the pre-ready queue before the next
+// one, so the replay after the remount keeps their order
+static void test_unmountKeepsBufferedOrder() {
+  setUp();
+  frameAt(2000, MAC_A, true, 0);
+  keyboardHost_unmount();
+  frameAt(3000, MAC_A, false, 1000);
+  CHECK_EQ(keyboard.playout.queued, 0);
+  CHECK_EQ(keyboard.preReadyCount, 2);
+
+  hostClock_setUs(4000);
+  keyboardHost_mount();
+  keyboardHost_runTimers();
+  CHECK_EQ(keyboard.preReadyReplayed, 2);
+  CHECK(keyboardHost_history(keyA) == "DU");
+}
+
+int main() {
+  RUN_TEST(test_eventsWaitForTheirPlayoutTime);
+  RUN_TEST(test_fullQueuePlaysEarlierEventsFirst);
+  RUN_TEST(test_fullQueuePlaysEarliestArrivalNow);
+  RUN_TEST(test_lateReleaseWaitsForQueuedPress);
+  RUN_TEST(test_fasterDeliveryKeepsEdgeOrder);
+  RUN_TEST(test_unmountKeepsBufferedOrder);
+  return hostTest_finish();
+}
@@ -0,0 +1,106 @@
+// Packed MacAddr value type (user-014): conversions and constants, then the cost of a full
+// 32-entry slot scan (count occupied entries, find one MAC) with byte-wise loops as the
+// receiver did before against packed 48-bit compares.
+#include "HostTest.h"
+#include "shared/domain/MacUtils.h"
+
+static constexpr uint8_t SAMPLE[6] = {0x24, 0x6F, 0x28, 0xAB, 0xCD, 0xEF};
+static_assert(macAddr_fromBytes(SAMPLE).bits == 0x246F28ABCDEFull, "mac[0] is the top byte");
+static_assert(macAddr_isZero(MAC_ADDR_ZERO) && !macAddr_isValid(MAC_ADDR_ZERO), "zero");
+static_assert(macAddr_isBroadcast(MAC_ADDR_BROADCAST) && !macAddr_isValid(MAC_ADDR_BROADCAST), "broadcast");
+
+static void test_conversionsAndPredicates() {
+  uint8_t bytes[6];
+  macAddr_toBytes(macAddr_fromBytes(SAMPLE), bytes);
+  CHECK(memcmp(bytes, SAMPLE, 6) == 0);
+
+  uint8_t other[6] = {0x24, 0x6F, 0x28, 0xAB, 0xCD, 0xEE};
+  CHECK(!macEqual(SAMPLE, other));
+  CHECK(macEqual(SAMPLE, SAMPLE));
+  CHECK(!macEqual(SAMPLE, nullptr));
+  CHECK(macIsZero(nullptr));
+  uint8_t broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  CHECK(macIsBroadcast(broadcast));
+  CHECK(!isValidMAC(broadcast));
+  CHECK(isValidMAC(SAMPLE));
+
+  // Same vendor prefix, consecutive serials: the hash still spreads them
+  uint32_t topBits = 0;
+  for (int i = 0; i < 32; i++) {
+    uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, (uint8_t)i};
+    topBits |= 1u << (macAddr_hash(macAddr_fromBytes(mac)) >> 27);
+  }
+  CHECK(__builtin_popcount(topBits) >= 16);
+}
+
+#define SCAN_SLOTS 32
+
+typedef struct {
+  uint8_t mac[6];
+} ByteSlot;
+
+__attribute__((noinline)) static int byteScan(const ByteSlot* slots, const uint8_t* mac, int* occupied) {
+  int found = -1;
+  int count = 0;
+  for (int i = 0; i < SCAN_SLOTS; i++) {
+    bool empty = true;
+    for (int j = 0; j < 6; j++) {
+      if (slots[i].mac[j] != 0) {
+        empty = false;
+        break;
+      }
+    }
+    if (!empty) count++;
+    if (found < 0 && memcmp(slots[i].mac, mac, 6) == 0) found = i;
+  }
+  *occupied = count;
+  return found;
+}
+
+__attribute__((noinline)) static int packedScan(const MacAddr* slots, MacAddr mac, int* occupied) {
+  int found = -1;
+  int count = 0;
+  for (int i = 0; i < SCAN_SLOTS; i++) {
+    if (!macAddr_isZero(slots[i])) count++;
+    if (found < 0 && macAddr_equal(slots[i], mac)) found = i;
+  }
+  *occupied = count;
+  return found;
+}
+
+static void bench_slotScan() {
+  ByteSlot bytes[SCAN_SLOTS];
+  MacAddr packed[SCAN_SLOTS];
+  for (int i = 0; i < SCAN_SLOTS; i++) {
+    uint8_t mac[6] = {0x24, 0x6F, 0x28, (uint8_t)i, (uint8_t)(i * 7), (uint8_t)(i * 13 + 1)};
+    if (i % 3 == 0) memset(mac, 0, 6);  // A third of the slots are free
+    memcpy(bytes[i].mac, mac, 6);
+    packed[i] = macAddr_fromBytes(mac);
+  }
+
+  int occupiedBytes = 0;
+  int occupiedPacked = 0;
+  int agree = 0;
+  for (int i = 0; i < SCAN_SLOTS; i++) {
+    agree += byteScan(bytes, bytes[i].mac, &occupiedBytes) == packedScan(packed, packed[i], &occupiedPacked);
+  }
+  CHECK_EQ(agree, SCAN_SLOTS);
+  CHECK_EQ(occupiedBytes, occupiedPacked);
+
+  const int iterations = 1000000;
+  int sink = 0;
+  double byteNs = hostTest_nsPerOp(iterations, [&](int i) {
+    sink += byteScan(bytes, bytes[i & (SCAN_SLOTS - 1)].mac, &occupiedBytes);
+  });
+  double packedNs = hostTest_nsPerOp(iterations, [&](int i) {
+    sink += packedScan(packed, packed[i & (SCAN_SLOTS - 1)], &occupiedPacked);
+  });
+  hostTest_keep(sink);
+  printf("  %d-slot scan: bytes %.1f ns, packed %.1f ns (%.1fx)\n", SCAN_SLOTS, byteNs, packedNs, byteNs / packedNs);
+}
+
+int main() {
+  RUN_TEST(test_conversionsAndPredicates);
+  RUN_TEST(bench_slotScan);
+  return hostTest_finish();
+}
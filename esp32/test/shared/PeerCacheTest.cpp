@@ -0,0 +1,213 @@
+// ESP-NOW peer cache (user-025): PeerCache against a reference LRU model under random
+// touch/insert/remove, then the shared transport on the fake driver - a send to a known
+// peer never asks the driver about the peer table, unknown senders beyond the table's
+// 20 peers evict the least recently used one instead of failing, and a peer deleted behind
+// the cache's back is registered again, and a registration the driver refuses leaves every
+// working peer registered. The bench compares the steady send path with the
+// esp_now_get_peer() check it replaced.
+#include "HostTest.h"
+#include <map>
+#include <random>
+#include "shared/domain/PeerCache.cpp"
+#include "shared/infrastructure/EspNowPeers.cpp"
+#include "shared/infrastructure/EspNowTransport.cpp"
+
+// Scheduler.cpp needs the loop task; the receive wrapper only wakes it
+Scheduler* g_scheduler = nullptr;
+void scheduler_wake(Scheduler*) {}
+
+static_assert(PEER_CACHE_CAPACITY <= ESP_NOW_MAX_TOTAL_PEER_NUM, "cache must fit the driver's table");
+
+static MacAddr macFor(uint8_t group, uint8_t serial) {
+  uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x00, group, serial};
+  return macAddr_fromBytes(mac);
+}
+
+// 120 MACs over 3 groups keep the table full and the probe runs long enough to exercise
+// the backward-shift deletion
+static void test_matchesReferenceLru() {
+  PeerCache cache;
+  peerCache_init(&cache);
+  std::map<uint64_t, uint32_t> reference;  // MAC -> last use
+  uint32_t clock = 0;
+  std::mt19937 rng(1);
+
+  for (int op = 0; op < 1000000; op++) {
+    MacAddr mac = macFor((uint8_t)(rng() % 3), (uint8_t)(rng() % 40));
+    bool known = reference.count(mac.bits) != 0;
+    switch (rng() % 3) {
+      case 0:
+        CHECK_EQ(peerCache_touch(&cache, mac), known);
+        if (known) reference[mac.bits] = ++clock;
+        break;
+      case 1: {
+        uint64_t oldest = 0;
+        if (!known && reference.size() >= PEER_CACHE_CAPACITY) {
+          uint32_t oldestUse = UINT32_MAX;
+          for (const auto& entry : reference) {
+            if (entry.second < oldestUse) {
+              oldestUse = entry.second;
+              oldest = entry.first;
+            }
+          }
+        }
+        MacAddr evicted;
+        peerCache_insert(&cache, mac, &evicted);
+        CHECK_EQ(evicted.bits, oldest);
+        if (oldest) reference.erase(oldest);
+        reference[mac.bits] = ++clock;
+        break;
+      }
+      default:
+        peerCache_remove(&cache, mac);
+        reference.erase(mac.bits);
+        break;
+    }
+    if ((int)reference.size() != cache.count) {
+      CHECK_EQ(cache.count, (int)reference.size());
+      return;
+    }
+  }
+  for (const auto& entry : reference) {
+    CHECK(peerCache_touch(&cache, MacAddr{entry.first}));
+  }
+  CHECK(cache.evictions > 0);
+}
+
+static EspNowTransport transport;
+static const uint8_t payload[8] = {0};
+
+static void setUp() {
+  hostClock_setUs(0);
+  hostEspNow_reset();
+  espNowTransport_init(&transport);
+}
+
+static void macBytes(uint8_t group, uint8_t serial, uint8_t* mac) {
+  macAddr_toBytes(macFor(group, serial), mac);
+}
+
+static void test_knownPeerSendsWithoutRegistering() {
+  setUp();
+  uint8_t mac[6];
+  macBytes(1, 1, mac);
+  CHECK(espNowTransport_send(&transport, mac, payload, sizeof(payload)));
+  CHECK(espNowTransport_send(&transport, mac, payload, sizeof(payload)));
+  CHECK_EQ(hostEspNow.adds, 1);
+  CHECK_EQ(hostEspNow.sent, 2);
+  CHECK_EQ(transport.peers.cache.hits, 1);
+  CHECK_EQ(transport.peers.cache.misses, 1);
+}
+
+// A burst of replies to unknown senders never fills the driver's table: the paired
+// transmitters lose their entries but are registered again on their next send
+static void test_unknownSendersEvictLeastRecentlyUsed() {
+  setUp();
+  uint8_t broadcast[] = BROADCAST_MAC;
+  espNowTransport_addPeer(&transport, broadcast, 0);
+  uint8_t paired[8][6];
+  for (int i = 0; i < 8; i++) {
+    macBytes(1, (uint8_t)i, paired[i]);
+    CHECK(espNowTransport_addPeer(&transport, paired[i], 0));
+  }
+
+  int failed = 0;
+  for (int i = 0; i < 40; i++) {
+    uint8_t stranger[6];
+    macBytes(2, (uint8_t)i, stranger);
+    if (!espNowTransport_send(&transport, stranger, payload, sizeof(payload))) failed++;
+  }
+  CHECK_EQ(failed, 0);
+  CHECK_EQ(hostEspNow.peers.size(), PEER_CACHE_CAPACITY);
+  CHECK_EQ(transport.peers.cache.evictions, 49 - PEER_CACHE_CAPACITY);
+  CHECK_EQ(hostClock_us, 0);  // Never slept
+
+  for (int i = 0; i < 8; i++) {
+    CHECK(espNowTransport_send(&transport, paired[i], payload, sizeof(payload)));
+  }
+  CHECK_EQ(hostEspNow.peers.size(), PEER_CACHE_CAPACITY);
+}
+
+static void test_peerDeletedBehindTheCacheIsRegisteredAgain() {
+  setUp();
+  uint8_t mac[6];
+  macBytes(1, 1, mac);
+  CHECK(espNowTransport_send(&transport, mac, payload, sizeof(payload)));
+  esp_now_del_peer(mac);
+  CHECK(espNowTransport_send(&transport, mac, payload, sizeof(payload)));
+  CHECK_EQ(hostEspNow.sendFailures, 1);
+  CHECK_EQ(hostEspNow.adds, 2);
+  CHECK_EQ(hostEspNow.sent, 2);
+}
+
+static bool driverHas(const uint8_t* mac) {
+  return hostEspNow_find(mac) != hostEspNow.peers.end();
+}
+
+// The driver's table is full and the new peer is refused even after the least recently
+// used one made room: that peer is put back and the cache keeps it
+static void test_refusedRegistrationKeepsWorkingPeers() {
+  setUp();
+  uint8_t paired[PEER_CACHE_CAPACITY][6];
+  for (int i = 0; i < PEER_CACHE_CAPACITY; i++) {
+    macBytes(1, (uint8_t)i, paired[i]);
+    CHECK(espNowTransport_addPeer(&transport, paired[i], 0));
+  }
+  uint8_t stranger[6];
+  macBytes(2, 0, stranger);
+  hostEspNow.failAdds = 1;
+  CHECK(!espNowTransport_send(&transport, stranger, payload, sizeof(payload)));
+  CHECK(!driverHas(stranger));
+  CHECK(driverHas(paired[0]));
+  CHECK_EQ(hostEspNow.peers.size(), PEER_CACHE_CAPACITY);
+  CHECK_EQ(transport.peers.cache.count, PEER_CACHE_CAPACITY);
+  CHECK_EQ(transport.peers.cache.evictions, 0);
+
+  uint32_t adds = hostEspNow.adds;
+  for (int i = 0; i < PEER_CACHE_CAPACITY; i++) {
+    CHECK(espNowTransport_send(&transport, paired[i], payload, sizeof(payload)));
+  }
+  CHECK_EQ(hostEspNow.adds, adds);  // All still cached, nothing registered again
+
+  // With room in the table a refused add evicts nothing at all
+  setUp();
+  CHECK(espNowTransport_addPeer(&transport, paired[0], 0));
+  hostEspNow.failAdds = 1;
+  CHECK(!espNowTransport_send(&transport, stranger, payload, sizeof(payload)));
+  CHECK_EQ(hostEspNow.deletes, 0);
+  CHECK_EQ(transport.peers.cache.count, 1);
+}
+
+// Paired transmitters, the debug monitor and broadcasts, round robin over 10 peers
+static void bench_steadySend() {
+  setUp();
+  uint8_t peers[10][6];
+  for (int i = 0; i < 10; i++) {
+    macBytes(1, (uint8_t)i, peers[i]);
+    espNowTransport_addPeer(&transport, peers[i], 0);
+  }
+  const int iterations = 2000000;
+  double cachedNs = hostTest_nsPerOp(iterations, [&](int i) {
+    hostTest_keep(espNowTransport_send(&transport, peers[i % 10], payload, sizeof(payload)));
+  });
+  double getPeerNs = hostTest_nsPerOp(iterations, [&](int i) {
+    esp_now_peer_info_t info;
+    if (esp_now_get_peer(peers[i % 10], &info) == ESP_OK) {
+      hostTest_keep(esp_now_send(peers[i % 10], payload, sizeof(payload)));
+    }
+  });
+  printf("  send to a known peer: %.0f ns with the cache probe, %.0f ns with esp_now_get_peer()\n",
+         cachedNs, getPeerNs);
+  printf("  (the fake get_peer is an unlocked list walk; the IDF one also takes the driver's lock)\n");
+  CHECK_EQ(hostEspNow.adds, 10);
+}
+
+int main() {
+  RUN_TEST(test_matchesReferenceLru);
+  RUN_TEST(test_knownPeerSendsWithoutRegistering);
+  RUN_TEST(test_unknownSendersEvictLeastRecentlyUsed);
+  RUN_TEST(test_peerDeletedBehindTheCacheIsRegisteredAgain);
+  RUN_TEST(test_refusedRegistrationKeepsWorkingPeers);
+  RUN_TEST(bench_steadySend);
+  return hostTest_finish();
+}
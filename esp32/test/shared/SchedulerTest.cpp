@@ -0,0 +1,149 @@
+// Loop task deadline queue (user-013): one-shot and periodic timers, callbacks that re-arm
+// or cancel themselves, the time-until-next the loop sleeps for, and deadlines on both
+// sides of the millis() wrap. Host unsigned long is 64 bits, so the wrap cases start just
+// below ULONG_MAX; the comparisons are the same at the device's 32 bits.
+#include "HostTest.h"
+#include <vector>
+#include "shared/infrastructure/Scheduler.cpp"
+
+static Scheduler scheduler;
+static std::vector<unsigned long> fired;
+
+static void record(void* context, unsigned long now) {
+  ((std::vector<unsigned long>*)context)->push_back(now);
+}
+
+static void setUp() {
+  hostClock_setUs(0);
+  scheduler_init(&scheduler);
+  fired.clear();
+}
+
+static void test_oneShotRunsOnceAtItsDeadline() {
+  setUp();
+  int timer = scheduler_addTimer(&scheduler, record, &fired);
+  CHECK(!scheduler_isArmed(&scheduler, timer));
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 0, 500), 500);
+
+  scheduler_arm(&scheduler, timer, 100);
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 40, 500), 60);
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 40, 20), 20);
+  CHECK_EQ(scheduler_run(&scheduler, 99), 0);
+  CHECK_EQ(scheduler_run(&scheduler, 100), 1);
+  CHECK_EQ(scheduler_run(&scheduler, 200), 0);
+  CHECK(fired == std::vector<unsigned long>({100}));
+  CHECK(!scheduler_isArmed(&scheduler, timer));
+
+  // Overdue deadlines are due now; armIn with no deadline cancels
+  scheduler_arm(&scheduler, timer, 150);
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 300, 500), 0);
+  scheduler_armIn(&scheduler, timer, 300, SCHEDULER_NO_DEADLINE);
+  CHECK(!scheduler_isArmed(&scheduler, timer));
+  scheduler_armIn(&scheduler, timer, 300, 25);
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 300, 500), 25);
+}
+
+// A late pass runs a periodic timer once and skips the periods it missed
+static void test_periodicSkipsMissedPeriods() {
+  setUp();
+  int timer = scheduler_addTimer(&scheduler, record, &fired);
+  scheduler_armPeriodic(&scheduler, timer, 100, 50);
+  scheduler_run(&scheduler, 100);
+  scheduler_run(&scheduler, 160);
+  scheduler_run(&scheduler, 390);
+  CHECK(fired == std::vector<unsigned long>({100, 160, 390}));
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 390, 500), 10);  // Next on the grid: 400
+  CHECK(scheduler_isArmed(&scheduler, timer));
+}
+
+static Scheduler* selfScheduler;
+static int selfTimer;
+static int selfRuns;
+
+static void cancelAfterThree(void*, unsigned long) {
+  if (++selfRuns == 3) scheduler_cancel(selfScheduler, selfTimer);
+}
+
+static void rearmOnce(void*, unsigned long now) {
+  if (++selfRuns == 1) scheduler_arm(selfScheduler, selfTimer, now + 30);
+}
+
+static void test_callbackOwnsItsTimer() {
+  setUp();
+  selfScheduler = &scheduler;
+  selfRuns = 0;
+  selfTimer = scheduler_addTimer(&scheduler, cancelAfterThree, nullptr);
+  scheduler_armPeriodic(&scheduler, selfTimer, 10, 10);
+  for (unsigned long now = 10; now <= 100; now += 10) scheduler_run(&scheduler, now);
+  CHECK_EQ(selfRuns, 3);
+  CHECK(!scheduler_isArmed(&scheduler, selfTimer));
+
+  setUp();
+  selfRuns = 0;
+  selfTimer = scheduler_addTimer(&scheduler, rearmOnce, nullptr);
+  scheduler_arm(&scheduler, selfTimer, 10);
+  scheduler_run(&scheduler, 10);
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 10, 500), 30);
+  scheduler_run(&scheduler, 40);
+  CHECK_EQ(selfRuns, 2);
+  CHECK(!scheduler_isArmed(&scheduler, selfTimer));
+
+  // Wake-only timers have no callback
+  int wakeOnly = scheduler_addTimer(&scheduler, nullptr, nullptr);
+  scheduler_arm(&scheduler, wakeOnly, 50);
+  CHECK_EQ(scheduler_run(&scheduler, 50), 1);
+}
+
+static void test_deadlinesAcrossTheWrap() {
+  setUp();
+  int oneShot = scheduler_addTimer(&scheduler, record, &fired);
+  int periodic = scheduler_addTimer(&scheduler, record, &fired);
+  unsigned long now = ULONG_MAX - 19;
+  scheduler_armIn(&scheduler, oneShot, now, 30);         // Deadline 10 past the wrap
+  scheduler_armPeriodic(&scheduler, periodic, now, 25);  // Due now, then 5 past the wrap
+
+  CHECK_EQ(scheduler_run(&scheduler, now), 1);
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, now, 500), 25);
+  CHECK_EQ(scheduler_run(&scheduler, ULONG_MAX), 0);  // Neither is due before the wrap
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, ULONG_MAX, 500), 6);
+  CHECK_EQ(scheduler_run(&scheduler, 5), 1);
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 5, 500), 5);
+  CHECK_EQ(scheduler_run(&scheduler, 10), 1);
+  CHECK(!scheduler_isArmed(&scheduler, oneShot));
+  CHECK(fired == std::vector<unsigned long>({ULONG_MAX - 19, 5, 10}));
+
+  // A deadline just before the wrap is overdue, not four billion milliseconds away
+  scheduler_arm(&scheduler, oneShot, ULONG_MAX - 5);
+  CHECK_EQ(scheduler_timeUntilNextMs(&scheduler, 10, 500), 0);
+  CHECK_EQ(scheduler_run(&scheduler, 10), 1);
+}
+
+static void test_timerTableAndWakeupWindow() {
+  setUp();
+  for (int i = 0; i < SCHEDULER_MAX_TIMERS; i++) {
+    CHECK_EQ(scheduler_addTimer(&scheduler, nullptr, nullptr), i);
+  }
+  CHECK_EQ(scheduler_addTimer(&scheduler, nullptr, nullptr), -1);
+  scheduler_arm(&scheduler, -1, 0);  // addTimer's failure value: ignored
+  CHECK(!scheduler_isArmed(&scheduler, -1));
+
+  for (int i = 0; i < 50; i++) {
+    scheduler_countWakeup(&scheduler, (unsigned long)i * 100, i % 5 == 0);
+  }
+  CHECK_EQ(scheduler.wakeups, 50);
+  CHECK_EQ(scheduler.eventWakeups, 10);
+  CHECK_EQ(scheduler_wakeupsPerSecondX10(&scheduler), 0);  // Window not complete yet
+  for (int i = 50; i <= SCHEDULER_STATS_WINDOW_MS / 100; i++) {
+    scheduler_countWakeup(&scheduler, (unsigned long)i * 100, false);
+  }
+  CHECK_EQ(scheduler_wakeupsPerSecondX10(&scheduler), 101);  // 101 passes in 10 s
+}
+
+int main() {
+  RUN_TEST(test_oneShotRunsOnceAtItsDeadline);
+  RUN_TEST(test_periodicSkipsMissedPeriods);
+  RUN_TEST(test_callbackOwnsItsTimer);
+  RUN_TEST(test_deadlinesAcrossTheWrap);
+  RUN_TEST(test_timerTableAndWakeupWindow);
+  return hostTest_finish();
+}
@@ -0,0 +1,38 @@
+#ifndef HOST_STUB_ARDUINO_H
+#define HOST_STUB_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_err.h"
+
+using std::max;
+using std::min;
+
+#define IRAM_ATTR
+
+static inline unsigned long millis() { return (unsigned long)(hostClock_us / 1000); }
+static inline unsigned long micros() { return (unsigned long)hostClock_us; }
+static inline void delay(unsigned long ms) { hostClock_us += (int64_t)ms * 1000; }
+static inline void delayMicroseconds(unsigned int us) { hostClock_us += us; }
+static inline void yield() {}
+
+// Serial output is discarded; tests assert on module state, not on log text
+struct HostSerial {
+  void begin(unsigned long) {}
+  size_t printf(const char*, ...) { return 0; }
+  template <typename T> size_t print(T) { return 0; }
+  template <typename T> size_t println(T) { return 0; }
+  size_t println() { return 0; }
+  operator bool() const { return true; }
+};
+inline HostSerial Serial;
+
+#endif // HOST_STUB_ARDUINO_H
@@ -0,0 +1,23 @@
+#ifndef HOST_STUB_PREFERENCES_H
+#define HOST_STUB_PREFERENCES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Empty NVS namespace. Host tests give Persistence their own PersistenceStore instead;
+// this only lets the NVS-backed store compile.
+class Preferences {
+public:
+  bool begin(const char*, bool = false) { return true; }
+  void end() {}
+  bool isKey(const char*) { return false; }
+  size_t getBytesLength(const char*) { return 0; }
+  size_t getBytes(const char*, void*, size_t) { return 0; }
+  size_t putBytes(const char*, const void*, size_t) { return 0; }
+  bool remove(const char*) { return false; }
+  int32_t getInt(const char*, int32_t defaultValue = 0) { return defaultValue; }
+  uint8_t getUChar(const char*, uint8_t defaultValue = 0) { return defaultValue; }
+  bool getBool(const char*, bool defaultValue = false) { return defaultValue; }
+};
+
+#endif // HOST_STUB_PREFERENCES_H
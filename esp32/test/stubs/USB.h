@@ -0,0 +1,35 @@
+#ifndef HOST_STUB_USB_H
+#define HOST_STUB_USB_H
+
+#include "Arduino.h"
+
+// USB device stack: keeps the event handler so a test can mount and unmount the host with
+// hostUsb_event()
+
+typedef const char* esp_event_base_t;
+typedef void (*esp_event_handler_t)(void* arg, esp_event_base_t base, int32_t eventId, void* eventData);
+
+static const esp_event_base_t ARDUINO_USB_EVENTS = "ARDUINO_USB_EVENTS";
+
+typedef enum {
+  ARDUINO_USB_ANY_EVENT = -1,
+  ARDUINO_USB_STARTED_EVENT = 0,
+  ARDUINO_USB_STOPPED_EVENT,
+  ARDUINO_USB_SUSPEND_EVENT,
+  ARDUINO_USB_RESUME_EVENT,
+} arduino_usb_event_t;
+
+class ESPUSB {
+public:
+  esp_event_handler_t handler = nullptr;
+  void onEvent(esp_event_handler_t callback) { handler = callback; }
+  bool begin() { return true; }
+};
+
+inline ESPUSB USB;
+
+static inline void hostUsb_event(int32_t eventId) {
+  if (USB.handler) USB.handler(nullptr, ARDUINO_USB_EVENTS, eventId, nullptr);
+}
+
+#endif // HOST_STUB_USB_H
@@ -0,0 +1,23 @@
+#ifndef HOST_STUB_USB_HID_KEYBOARD_H
+#define HOST_STUB_USB_HID_KEYBOARD_H
+
+#include <stdint.h>
+#include <vector>
+
+// Stock 6-key keyboard: every report sent is kept for the test to inspect
+
+typedef struct {
+  uint8_t modifiers;
+  uint8_t reserved;
+  uint8_t keys[6];
+} KeyReport;
+
+inline std::vector<KeyReport> hostUsb_keyReports;
+
+class USBHIDKeyboard {
+public:
+  void begin() {}
+  void sendReport(KeyReport* report) { hostUsb_keyReports.push_back(*report); }
+};
+
+#endif // HOST_STUB_USB_HID_KEYBOARD_H
@@ -0,0 +1,26 @@
+#ifndef HOST_STUB_WIFI_H
+#define HOST_STUB_WIFI_H
+
+#include "Arduino.h"
+
+// Station mode is all the ESP-NOW transport asks for
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA,
+  WIFI_AP,
+  WIFI_AP_STA,
+} wifi_mode_t;
+
+class WiFiClass {
+public:
+  wifi_mode_t currentMode = WIFI_OFF;
+  bool mode(wifi_mode_t mode) {
+    currentMode = mode;
+    return true;
+  }
+};
+
+inline WiFiClass WiFi;
+
+#endif // HOST_STUB_WIFI_H
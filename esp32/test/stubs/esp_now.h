@@ -0,0 +1,106 @@
+#ifndef HOST_STUB_ESP_NOW_H
+#define HOST_STUB_ESP_NOW_H
+
+#include <list>
+#include <array>
+#include "Arduino.h"
+
+// ESP-NOW driver modelled on esp_now.c: the peer table is a list that get/add/del/send
+// walk, ESP_NOW_MAX_TOTAL_PEER_NUM peers at most. Counts driver calls so tests can tell
+// what the transport asked of it, and can fail the next failAdds adds that would have
+// succeeded; hostEspNow_reset() empties it.
+
+#define ESP_ERR_ESPNOW_NO_MEM 0x3067
+#define ESP_ERR_ESPNOW_FULL 0x3068
+#define ESP_ERR_ESPNOW_NOT_FOUND 0x3069
+#define ESP_ERR_ESPNOW_EXIST 0x306B
+#define ESP_NOW_MAX_TOTAL_PEER_NUM 20
+
+typedef struct {
+  uint8_t peer_addr[6];
+  uint8_t channel;
+  bool encrypt;
+} esp_now_peer_info_t;
+
+typedef struct {
+  uint8_t channel;
+} wifi_pkt_rx_ctrl_t;
+
+typedef struct {
+  uint8_t* src_addr;
+  uint8_t* des_addr;
+  wifi_pkt_rx_ctrl_t* rx_ctrl;
+} esp_now_recv_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t* info, const uint8_t* data, int len);
+
+struct HostEspNow {
+  std::list<std::array<uint8_t, 6>> peers;
+  esp_now_recv_cb_t receive = nullptr;
+  int failAdds = 0;
+  uint32_t adds = 0;
+  uint32_t deletes = 0;
+  uint32_t sent = 0;
+  uint32_t sendFailures = 0;
+};
+
+inline HostEspNow hostEspNow;
+
+static inline void hostEspNow_reset() {
+  hostEspNow = HostEspNow();
+}
+
+static inline std::list<std::array<uint8_t, 6>>::iterator hostEspNow_find(const uint8_t* mac) {
+  for (auto it = hostEspNow.peers.begin(); it != hostEspNow.peers.end(); ++it) {
+    if (memcmp(it->data(), mac, 6) == 0) return it;
+  }
+  return hostEspNow.peers.end();
+}
+
+static inline esp_err_t esp_now_init() { return ESP_OK; }
+
+static inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback) {
+  hostEspNow.receive = callback;
+  return ESP_OK;
+}
+
+static inline esp_err_t esp_now_get_peer(const uint8_t* mac, esp_now_peer_info_t* info) {
+  if (hostEspNow_find(mac) == hostEspNow.peers.end()) return ESP_ERR_ESPNOW_NOT_FOUND;
+  memcpy(info->peer_addr, mac, 6);
+  return ESP_OK;
+}
+
+static inline esp_err_t esp_now_add_peer(const esp_now_peer_info_t* info) {
+  if (hostEspNow_find(info->peer_addr) != hostEspNow.peers.end()) return ESP_ERR_ESPNOW_EXIST;
+  if (hostEspNow.peers.size() >= ESP_NOW_MAX_TOTAL_PEER_NUM) return ESP_ERR_ESPNOW_FULL;
+  if (hostEspNow.failAdds > 0) {
+    hostEspNow.failAdds--;
+    return ESP_ERR_ESPNOW_NO_MEM;
+  }
+  std::array<uint8_t, 6> peer;
+  memcpy(peer.data(), info->peer_addr, 6);
+  hostEspNow.peers.push_back(peer);
+  hostEspNow.adds++;
+  return ESP_OK;
+}
+
+static inline esp_err_t esp_now_del_peer(const uint8_t* mac) {
+  auto it = hostEspNow_find(mac);
+  if (it == hostEspNow.peers.end()) return ESP_ERR_ESPNOW_NOT_FOUND;
+  hostEspNow.peers.erase(it);
+  hostEspNow.deletes++;
+  return ESP_OK;
+}
+
+static inline esp_err_t esp_now_send(const uint8_t* mac, const uint8_t* data, size_t len) {
+  (void)data;
+  (void)len;
+  if (hostEspNow_find(mac) == hostEspNow.peers.end()) {
+    hostEspNow.sendFailures++;
+    return ESP_ERR_ESPNOW_NOT_FOUND;
+  }
+  hostEspNow.sent++;
+  return ESP_OK;
+}
+
+#endif // HOST_STUB_ESP_NOW_H
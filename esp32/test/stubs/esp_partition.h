@@ -0,0 +1,35 @@
+#ifndef HOST_STUB_ESP_PARTITION_H
+#define HOST_STUB_ESP_PARTITION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Arduino.h"
+
+// No partition table on the host: the lookup fails, so the flight recorder's partition
+// backend stays unused and tests mount it on their own FlightRecorderFlash instead.
+
+typedef enum {
+  ESP_PARTITION_TYPE_APP = 0x00,
+  ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+
+typedef struct {
+  esp_partition_type_t type;
+  esp_partition_subtype_t subtype;
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+} esp_partition_t;
+
+static inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t,
+                                                              const char*) {
+  return nullptr;
+}
+
+static inline esp_err_t esp_partition_read(const esp_partition_t*, size_t, void*, size_t) { return ESP_FAIL; }
+static inline esp_err_t esp_partition_write(const esp_partition_t*, size_t, const void*, size_t) { return ESP_FAIL; }
+static inline esp_err_t esp_partition_erase_range(const esp_partition_t*, size_t, size_t) { return ESP_FAIL; }
+
+#endif // HOST_STUB_ESP_PARTITION_H
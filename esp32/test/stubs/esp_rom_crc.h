@@ -0,0 +1,19 @@
+#ifndef HOST_STUB_ESP_ROM_CRC_H
+#define HOST_STUB_ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+// Bitwise CRC-32 (IEEE, reflected) with the ROM function's conventions, so records written
+// by a host test verify the same way as on the device
+static inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+#endif // HOST_STUB_ESP_ROM_CRC_H
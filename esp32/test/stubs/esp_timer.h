@@ -0,0 +1,16 @@
+#ifndef HOST_STUB_ESP_TIMER_H
+#define HOST_STUB_ESP_TIMER_H
+
+#include <stdint.h>
+
+// Fake monotonic clock shared by esp_timer_get_time(), millis() and micros(). Tests move it
+// explicitly with hostClock_advanceUs()/hostClock_advanceMs(); delay() advances it too.
+inline int64_t hostClock_us = 0;
+
+static inline void hostClock_setUs(int64_t us) { hostClock_us = us; }
+static inline void hostClock_advanceUs(int64_t us) { hostClock_us += us; }
+static inline void hostClock_advanceMs(int64_t ms) { hostClock_us += ms * 1000; }
+
+static inline int64_t esp_timer_get_time(void) { return hostClock_us; }
+
+#endif // HOST_STUB_ESP_TIMER_H
@@ -0,0 +1,14 @@
+#ifndef HOST_STUB_FREERTOS_TASK_H
+#define HOST_STUB_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct tskTaskControlBlock* TaskHandle_t;
+
+static inline TaskHandle_t xTaskGetCurrentTaskHandle(void) { return nullptr; }
+static inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+static inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
+static inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+static inline void vTaskDelay(TickType_t) {}
+
+#endif // HOST_STUB_FREERTOS_TASK_H
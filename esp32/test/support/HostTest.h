@@ -0,0 +1,75 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+// Minimal check/bench helpers for the host tests. A failed CHECK reports and continues so
+// one run lists every broken expectation; hostTest_finish() turns the count into the exit code.
+
+static int hostTest_failures = 0;
+
+#define CHECK(cond)                                                                  \
+  do {                                                                               \
+    if (!(cond)) {                                                                   \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);       \
+      hostTest_failures++;                                                           \
+    }                                                                                \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                                   \
+  do {                                                                               \
+    long long a_ = (long long)(actual);                                              \
+    long long e_ = (long long)(expected);                                            \
+    if (a_ != e_) {                                                                  \
+      fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",              \
+              __FILE__, __LINE__, #actual, #expected, a_, e_);                       \
+      hostTest_failures++;                                                           \
+    }                                                                                \
+  } while (0)
+
+#define RUN_TEST(fn)                                                                 \
+  do {                                                                               \
+    int before_ = hostTest_failures;                                                 \
+    fn();                                                                            \
+    printf("%s %s\n", hostTest_failures == before_ ? "[ ok ]" : "[FAIL]", #fn);      \
+  } while (0)
+
+static inline int hostTest_finish() {
+  if (hostTest_failures > 0) {
+    printf("%d check(s) failed\n", hostTest_failures);
+    return 1;
+  }
+  return 0;
+}
+
+// Wall-clock time for benchmarks (the fake Arduino clock in the stubs does not advance by itself)
+static inline int64_t hostTest_nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Best-of-N nanoseconds per call of fn over `iterations` calls; the minimum filters out
+// scheduler noise on a shared host
+template <typename Fn>
+static double hostTest_nsPerOp(int iterations, Fn fn, int rounds = 5) {
+  double best = 1e30;
+  for (int r = 0; r < rounds; r++) {
+    int64_t start = hostTest_nowNs();
+    for (int i = 0; i < iterations; i++) {
+      fn(i);
+    }
+    double ns = (double)(hostTest_nowNs() - start) / iterations;
+    if (ns < best) best = ns;
+  }
+  return best;
+}
+
+// Keeps a benchmark result alive without the optimizer removing the loop
+template <typename T>
+static inline void hostTest_keep(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif // HOST_TEST_H
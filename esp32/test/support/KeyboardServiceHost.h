@@ -0,0 +1,161 @@
+#ifndef KEYBOARD_SERVICE_HOST_H
+#define KEYBOARD_SERVICE_HOST_H
+
+// The receiver's keyboard service built for the host: bindings from a real transmitter
+// table, a fake USB host that records every report in either form, and fakes for the
+// TinyUSB-backed NKRO and MIDI devices. Include once per test, after HostTest.h.
+
+#include <string>
+#include <vector>
+#include "receiver/domain/MacIndex.cpp"
+#include "receiver/domain/SlotAllocator.cpp"
+#include "receiver/domain/TransmitterManager.cpp"
+#include "receiver/domain/KeyBindings.cpp"
+#include "receiver/infrastructure/HidReportBuilder.cpp"
+#include "receiver/infrastructure/LatencyHistogram.cpp"
+#include "receiver/infrastructure/FlightRecorder.cpp"
+#include "receiver/application/KeySequencer.cpp"
+#include "receiver/application/GestureRecognizer.cpp"
+#include "receiver/application/MidiService.cpp"
+#include "receiver/application/PlayoutBuffer.cpp"
+#include "receiver/application/KeyboardService.cpp"
+
+// Telemetry.cpp needs the USB CDC stack; the flight recorder only forwards its live copy there
+Telemetry* g_telemetry = nullptr;
+void telemetry_event(Telemetry*, uint8_t, uint8_t, uint8_t, uint8_t, uint32_t) {}
+
+// NKRO keyboard: active unless the host asked for the boot protocol; sends can be failed
+static bool hostNkro_active = true;
+static int hostNkro_failSends = 0;
+static std::vector<HidNkroReport> hostNkro_reports;
+
+void hidNkroKeyboard_begin() {}
+bool hidNkroKeyboard_active() { return hostNkro_active; }
+bool hidNkroKeyboard_send(const HidNkroReport* report) {
+  if (hostNkro_failSends > 0) {
+    hostNkro_failSends--;
+    return false;
+  }
+  hostNkro_reports.push_back(*report);
+  return true;
+}
+
+// MIDI port: messages as status/data1/data2
+struct HostMidiMessage {
+  uint8_t status;
+  uint8_t data1;
+  uint8_t data2;
+};
+static std::vector<HostMidiMessage> hostMidi_messages;
+
+static inline bool hostMidi_send(void*, uint8_t status, uint8_t data1, uint8_t data2) {
+  hostMidi_messages.push_back({status, data1, data2});
+  return true;
+}
+
+void usbMidi_begin() {}
+MidiSink usbMidi_sink() {
+  MidiSink sink = {hostMidi_send, nullptr};
+  return sink;
+}
+
+static TransmitterManager hostManager;
+static KeyBindings hostBindings;
+static KeyboardService keyboard;
+
+// Fresh service at time 0, not mounted, no transmitters
+static inline void keyboardHost_reset() {
+  hostClock_setUs(0);
+  hostNkro_active = true;
+  hostNkro_failSends = 0;
+  hostNkro_reports.clear();
+  hostUsb_keyReports.clear();
+  hostMidi_messages.clear();
+  transmitterManager_init(&hostManager);
+  keyBindings_init(&hostBindings);
+  keyboardService_init(&keyboard, &hostBindings);
+}
+
+static inline void keyboardHost_mount() {
+  hostUsb_event(ARDUINO_USB_STARTED_EVENT);
+}
+
+static inline void keyboardHost_unmount() {
+  hostUsb_event(ARDUINO_USB_SUSPEND_EVENT);
+}
+
+static inline int keyboardHost_addTransmitter(const uint8_t* mac, uint8_t pedalMode) {
+  int index = transmitterManager_place(&hostManager, mac, pedalMode);
+  keyBindings_refresh(&hostBindings, &hostManager);
+  return index;
+}
+
+// Key typed for a transmitter's pedal key ('1', '2', ...), 0 if unbound
+static inline char keyboardHost_keyFor(const uint8_t* mac, char pedalKey) {
+  KeyBindingAction action;
+  if (!keyBindings_lookup(&hostBindings, macAddr_fromBytes(mac), pedalKey, &action)) return 0;
+  return action.key;
+}
+
+// One pass of the HID output task at the current fake time: the frame, then whatever
+// timers are due, then the report
+static inline void keyboardHost_pedal(const uint8_t* mac, char pedalKey, bool pressed) {
+  struct_message msg = {MSG_PEDAL_EVENT, pedalKey, pressed, PEDAL_MODE_SINGLE};
+  keyboardService_handlePedalEvent(&keyboard, macAddr_fromBytes(mac), &msg, esp_timer_get_time());
+  keyboardService_runTimers(&keyboard, millis());
+  keyboardService_flush(&keyboard);
+}
+
+static inline void keyboardHost_timedPedal(const uint8_t* mac, char pedalKey, bool pressed, uint32_t edgeUs) {
+  timed_pedal_message msg = {MSG_PEDAL_EVENT_TIMED, pedalKey, pressed, PEDAL_MODE_SINGLE, edgeUs};
+  keyboardService_handleTimedPedalEvent(&keyboard, macAddr_fromBytes(mac), &msg, esp_timer_get_time());
+  keyboardService_runTimers(&keyboard, millis());
+  keyboardService_flush(&keyboard);
+}
+
+// A pass of the HID output task with no frame
+static inline int keyboardHost_runTimers() {
+  int changes = keyboardService_runTimers(&keyboard, millis());
+  keyboardService_flush(&keyboard);
+  return changes;
+}
+
+static inline uint8_t keyboardHost_usage(char key) {
+  HidReportBuilder scratch;
+  HidNkroReport report;
+  hidReportBuilder_init(&scratch);
+  hidReportBuilder_press(&scratch, key);
+  hidReportBuilder_buildNkro(&scratch, &report);
+  for (int usage = 0; usage < HID_NKRO_USAGE_COUNT; usage++) {
+    if (report.keys[usage >> 3] & (1u << (usage & 7))) return (uint8_t)usage;
+  }
+  return 0;
+}
+
+static inline bool keyboardHost_isHeld(const HidNkroReport& report, char key) {
+  uint8_t usage = keyboardHost_usage(key);
+  return (report.keys[usage >> 3] & (1u << (usage & 7))) != 0;
+}
+
+static inline bool keyboardHost_isHeld(const KeyReport& report, char key) {
+  uint8_t usage = keyboardHost_usage(key);
+  for (int i = 0; i < 6; i++) {
+    if (report.keys[i] == usage) return true;
+  }
+  return false;
+}
+
+// What the host saw of one key in the NKRO reports: 'D' per press, 'U' per release
+static inline std::string keyboardHost_history(char key) {
+  std::string history;
+  bool held = false;
+  for (const HidNkroReport& report : hostNkro_reports) {
+    if (keyboardHost_isHeld(report, key) != held) {
+      held = !held;
+      history += held ? 'D' : 'U';
+    }
+  }
+  return history;
+}
+
+#endif // KEYBOARD_SERVICE_HOST_H
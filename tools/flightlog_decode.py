@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Decode the receiver flight recorder.
+
+Input is either debug-monitor output captured after pressing 'd' (the "FLT ..." lines,
+anything else on the line or in the file is ignored) or a raw dump of the "flightrec"
+partition, e.g.:
+
+    esptool.py read_flash 0x3E0000 0x10000 flightrec.bin
+    python3 tools/flightlog_decode.py flightrec.bin
+
+Record layout matches esp32/receiver/infrastructure/FlightRecorder.h.
+"""
+
+import re
+import struct
+import sys
+
+MAGIC = 0x52465050  # "PPFR"
+SECTOR_SIZE = 4096
+RECORD_SIZE = 16
+RECORD = struct.Struct("<qBBBBI")
+HEADER = struct.Struct("<IIIBB2x")
+
+EVENT_BOOT = 1
+EVENT_PEDAL = 2
+EVENT_PAIRING = 3
+EVENT_SEND_FAILED = 4
+EVENT_LEASE_EXPIRED = 5
+EVENT_GESTURE = 6
+EVENT_ERASED = 0xFF
+
+# receiver/domain/PairingStateMachine.h
+PAIRING_STATES = ["BOOT", "INITIAL_WAIT", "GRACE_PERIOD", "NORMAL_OPERATION", "SLOTS_FULL"]
+PAIRING_EVENTS = ["NONE", "PING_SENT", "INITIAL_WAIT_DONE", "BEACON_DUE", "GRACE_EXPIRED", "SLOTS_FULL"]
+
+# receiver/application/GestureRecognizer.h
+GESTURES = ["TAP", "DOUBLE_TAP", "HOLD"]
+
+
+def name(names, index):
+    return names[index] if index < len(names) else str(index)
+
+
+def key_name(code):
+    if 0x20 < code < 0x7F:
+        return "'%s'" % chr(code)
+    return "0x%02X" % code
+
+
+def describe(kind, a, b, c, value):
+    if kind == EVENT_BOOT:
+        return "BOOT           sector sequence %d" % value
+    if kind == EVENT_PEDAL:
+        who = "unbound" if a == 0xFF else "transmitter %d" % a
+        mapped = key_name(value) if value else "dropped"
+        return "PEDAL          %s key %s %s -> %s" % (who, key_name(b), "down" if c else "up", mapped)
+    if kind == EVENT_PAIRING:
+        return "PAIRING        %s -> %s on %s" % (name(PAIRING_STATES, a), name(PAIRING_STATES, b),
+                                                  name(PAIRING_EVENTS, c))
+    if kind == EVENT_SEND_FAILED:
+        return "SEND_FAILED    msg 0x%02X err 0x%02X to ..:%02X:%02X:%02X:%02X" % (
+            a, b, (value >> 24) & 0xFF, (value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF)
+    if kind == EVENT_LEASE_EXPIRED:
+        return "LEASE_EXPIRED  transmitter %d held mask 0x%02X" % (a, b)
+    if kind == EVENT_GESTURE:
+        return "GESTURE        %s on %s -> %s at press +%d ms" % (name(GESTURES, a), key_name(b),
+                                                                 key_name(c), value)
+    return "UNKNOWN(%d)     a=%d b=%d c=%d value=0x%08X" % (kind, a, b, c, value)
+
+
+def records_from_dump(text):
+    data = bytearray()
+    for match in re.finditer(r"FLT ([0-9A-Fa-f]+)\s*$", text, re.MULTILINE):
+        data += bytes.fromhex(match.group(1))
+    for offset in range(0, len(data) - RECORD_SIZE + 1, RECORD_SIZE):
+        yield RECORD.unpack_from(data, offset)
+
+
+def records_from_image(image):
+    sectors = []
+    for offset in range(0, len(image) - SECTOR_SIZE + 1, SECTOR_SIZE):
+        magic, sequence, check, version, record_size = HEADER.unpack_from(image, offset)
+        if magic == MAGIC and check == (~sequence & 0xFFFFFFFF) and record_size == RECORD_SIZE:
+            sectors.append((sequence, offset))
+    # Oldest first; the sequence only grows, so this also handles wrap-around of the ring
+    for _, offset in sorted(sectors):
+        for record in range(1, SECTOR_SIZE // RECORD_SIZE):
+            fields = RECORD.unpack_from(image, offset + record * RECORD_SIZE)
+            if fields[1] == EVENT_ERASED:
+                break
+            yield fields
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write("usage: %s <debug-monitor capture | flightrec.bin>\n" % argv[0])
+        return 2
+    with open(argv[1], "rb") as f:
+        raw = f.read()
+    if b"FLT " in raw:
+        records = records_from_dump(raw.decode("ascii", "replace"))
+    else:
+        records = records_from_image(raw)
+
+    boot = 0
+    count = 0
+    for time_us, kind, a, b, c, value in records:
+        if kind == EVENT_BOOT:
+            boot += 1
+            print("---- boot %d ----" % boot)
+        print("%4d %12.6f  %s" % (boot, time_us / 1e6, describe(kind, a, b, c, value)))
+        count += 1
+    print("%d record(s), %d boot(s)" % (count, boot))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""Read and summarize the receiver's USB telemetry stream.
+
+The receiver shows up as a keyboard plus a CDC serial port (e.g. /dev/ttyACM0). Opening
+the port starts the stream; debug lines then come over USB instead of the radio.
+
+    python3 tools/telemetry_reader.py /dev/ttyACM0              # live view, summary every 10 s
+    python3 tools/telemetry_reader.py /dev/ttyACM0 -q -s 60     # summaries only
+    python3 tools/telemetry_reader.py /dev/ttyACM0 -w run.bin   # also keep the raw stream
+    python3 tools/telemetry_reader.py run.bin                   # decode a saved stream
+
+Frame layout matches esp32/receiver/infrastructure/Telemetry.h. Event decoding is shared
+with tools/flightlog_decode.py.
+"""
+
+import argparse
+import os
+import stat
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from flightlog_decode import describe  # noqa: E402
+
+SYNC = b"\xA5\x5A"
+HEADER = struct.Struct("<BBI")  # type, length, timeUs (after the sync bytes)
+
+HELLO = 1
+EVENT = 2
+LATENCY = 3
+COUNTERS = 4
+LOG = 5
+
+# TelemetryCounter order
+COUNTER_NAMES = [
+    "ingress_frames", "ingress_dropped", "dispatched", "hid_reports", "key_changes_coalesced",
+    "lease_expiries", "control_dropped", "loop_wakeups", "flight_events", "persistence_commits",
+    "telemetry_dropped", "playout_deferred", "playout_late",
+]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+class Decoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.bad_crc = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        """Yield (type, timeUs, payload) for every complete frame."""
+        self.buffer += data
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                keep = 1 if self.buffer.endswith(SYNC[:1]) else 0
+                self.skipped += len(self.buffer) - keep
+                del self.buffer[:len(self.buffer) - keep]
+                return
+            if start:
+                self.skipped += start
+                del self.buffer[:start]
+            if len(self.buffer) < 2 + HEADER.size:
+                return
+            kind, length, time_us = HEADER.unpack_from(self.buffer, 2)
+            end = 2 + HEADER.size + length
+            if len(self.buffer) < end + 1:
+                return
+            if crc8(self.buffer[2:end]) != self.buffer[end]:
+                # Not a frame boundary after all - resync one byte later
+                self.bad_crc += 1
+                del self.buffer[:1]
+                continue
+            payload = bytes(self.buffer[2 + HEADER.size:end])
+            del self.buffer[:end + 1]
+            yield kind, time_us, payload
+
+
+def percentile(sorted_values, fraction):
+    if not sorted_values:
+        return 0
+    index = min(len(sorted_values) - 1, int(fraction * len(sorted_values)))
+    return sorted_values[index]
+
+
+class Summary:
+    def __init__(self):
+        self.reset()
+        self.first_counters = None
+        self.last_counters = None
+        self.counters_time = None
+
+    def reset(self):
+        self.latencies = []
+        self.events = {}
+        self.logs = 0
+        self.frames = 0
+        self.started = time.monotonic()
+
+    def add(self, kind, time_us, payload):
+        self.frames += 1
+        if kind == LATENCY and len(payload) == 4:
+            self.latencies.append(struct.unpack("<I", payload)[0])
+        elif kind == EVENT and len(payload) == 8:
+            self.events[payload[0]] = self.events.get(payload[0], 0) + 1
+        elif kind == LOG:
+            self.logs += 1
+        elif kind == COUNTERS:
+            values = struct.unpack("<%dI" % (len(payload) // 4), payload)
+            if self.first_counters is None:
+                self.first_counters = (time_us, values)
+            self.last_counters = (time_us, values)
+
+    def report(self, out):
+        elapsed = time.monotonic() - self.started
+        lat = sorted(self.latencies)
+        out.write("== %.1f s: %d frame(s), %d log line(s), %d event(s)\n"
+                  % (elapsed, self.frames, self.logs, sum(self.events.values())))
+        if lat:
+            out.write("   latency us: n=%d p50=%d p90=%d p99=%d max=%d\n"
+                      % (len(lat), percentile(lat, 0.5), percentile(lat, 0.9), percentile(lat, 0.99), lat[-1]))
+        if self.first_counters and self.last_counters and self.last_counters[0] != self.first_counters[0]:
+            span = ((self.last_counters[0] - self.first_counters[0]) & 0xFFFFFFFF) / 1e6
+            parts = []
+            for i, (a, b) in enumerate(zip(self.first_counters[1], self.last_counters[1])):
+                name = COUNTER_NAMES[i] if i < len(COUNTER_NAMES) else "counter%d" % i
+                parts.append("%s=%d (%+.1f/s)" % (name, b, ((b - a) & 0xFFFFFFFF) / span))
+            out.write("   counters: %s\n" % ", ".join(parts))
+        out.flush()
+        self.reset()
+
+
+def open_source(path):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if stat.S_ISCHR(os.fstat(fd).st_mode):
+        import termios
+        import tty
+        tty.setraw(fd)
+        attrs = termios.tcgetattr(fd)
+        attrs[2] |= termios.CLOCAL | termios.CREAD
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+        return fd, True
+    return fd, False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", help="CDC device (e.g. /dev/ttyACM0) or a saved stream")
+    parser.add_argument("-q", "--quiet", action="store_true", help="summaries only")
+    parser.add_argument("-s", "--summary", type=float, default=10.0, help="summary interval in seconds")
+    parser.add_argument("-w", "--write", help="append the raw stream to this file")
+    args = parser.parse_args()
+
+    fd, live = open_source(args.source)
+    raw = open(args.write, "ab") if args.write else None
+    decoder = Decoder()
+    summary = Summary()
+    out = sys.stdout
+    next_summary = time.monotonic() + args.summary
+    try:
+        while True:
+            data = os.read(fd, 4096)
+            if not data:
+                if live:
+                    continue
+                break
+            if raw:
+                raw.write(data)
+            for kind, time_us, payload in decoder.feed(data):
+                summary.add(kind, time_us, payload)
+                if args.quiet:
+                    continue
+                stamp = "%10.6f" % (time_us / 1e6)
+                if kind == LOG:
+                    out.write("%s  %s\n" % (stamp, payload.decode("utf-8", "replace")))
+                elif kind == EVENT and len(payload) == 8:
+                    event_type, a, b, c, value = struct.unpack("<BBBBI", payload)
+                    out.write("%s  %s\n" % (stamp, describe(event_type, a, b, c, value)))
+                elif kind == HELLO and len(payload) >= 2:
+                    out.write("%s  connected: telemetry v%d, %d counter(s)\n" % (stamp, payload[0], payload[1]))
+            if live and time.monotonic() >= next_summary:
+                summary.report(out)
+                next_summary += args.summary
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if raw:
+            raw.close()
+        os.close(fd)
+    summary.report(out)
+    if decoder.bad_crc or decoder.skipped:
+        out.write("   %d bad frame(s), %d byte(s) skipped while resyncing\n" % (decoder.bad_crc, decoder.skipped))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())